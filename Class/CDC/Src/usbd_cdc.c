@@ -21,12 +21,18 @@
   * limitations under the License.
   */
 #include <usbd_internal.h>
-#include <usbd_cdc.h>
+#include <usbd_cdc_private.h>
 
 #if (USBD_MAX_IF_COUNT < 2)
 #error "A single CDC interface takes up 2 device interface slots!"
 #endif
 
+/* The free-running buffer indexes wrap around consistently */
+#if (USBD_CDC_RX_BUFFER_COUNT > 1) && \
+    ((USBD_CDC_RX_BUFFER_COUNT & (USBD_CDC_RX_BUFFER_COUNT - 1)) != 0)
+#error "USBD_CDC_RX_BUFFER_COUNT has to be a power of 2!"
+#endif
+
 #if (USBD_CDC_NOTEP_USED == 1)
 #define CDC_NOT_INTR_INTERVAL                       1
 #else
@@ -189,6 +195,26 @@ static const USBD_ClassType cdc_cbks = {
  * @defgroup USBD_CDC_Private_Functions CDC Private Functions
  * @{ */
 
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+/**
+ * @brief Starts the reception to the next reception buffer,
+ *        unless it's already ongoing or all buffers are held by the application.
+ * @param itf: reference of the CDC interface
+ */
+static void cdc_receiveNext(USBD_CDC_IfHandleType *itf)
+{
+    USBD_CDC_RxBuffersType *rx = itf->RxBuffers;
+
+    if ((rx->Active == 0) &&
+        ((uint8_t)(rx->Head - rx->Tail) < USBD_CDC_RX_BUFFER_COUNT))
+    {
+        rx->Active = 1;
+        USBD_CDC_Receive(itf, rx->Buffer[rx->Head % USBD_CDC_RX_BUFFER_COUNT],
+                USBD_CDC_RX_BUFFER_SIZE);
+    }
+}
+#endif /* (USBD_CDC_RX_BUFFER_COUNT > 1) */
+
 #if (USBD_CDC_ALTSETTINGS != 0)
 /**
  * @brief Copies the interface descriptor to the destination buffer.
@@ -316,14 +342,34 @@ static void cdc_init(USBD_CDC_IfHandleType *itf)
     }
 
     /* Open EPs */
-    USBD_EpOpen(dev, itf->Config.InEpNum , USB_EP_TYPE_BULK, mps);
-    USBD_EpOpen(dev, itf->Config.OutEpNum, USB_EP_TYPE_BULK, mps);
+    USBD_EpOpen(dev, itf->Config.InEpNum , USB_EP_TYPE_BULK, mps,
+            USBD_EP_OPT_DOUBLE_BUFFER);
+    USBD_EpOpen(dev, itf->Config.OutEpNum, USB_EP_TYPE_BULK, mps,
+            USBD_EP_OPT_DOUBLE_BUFFER);
 #if (USBD_CDC_NOTEP_USED == 1)
-    USBD_EpOpen(dev, itf->Config.NotEpNum, USB_EP_TYPE_INTERRUPT, CDC_NOT_PACKET_SIZE);
+    USBD_EpOpen(dev, itf->Config.NotEpNum, USB_EP_TYPE_INTERRUPT, CDC_NOT_PACKET_SIZE,
+            USBD_EP_OPT_NONE);
 #endif
 
     /* Initialize application */
     USBD_SAFE_CALLBACK(CDC_APP(itf)->Init, );
+
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+    if (itf->Stream != NULL)
+    {
+        CDC_StreamInit(itf);
+    }
+#endif
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+    if (itf->RxBuffers != NULL)
+    {
+        /* The buffers are returned to the class */
+        itf->RxBuffers->Tail = itf->RxBuffers->Head;
+        itf->RxBuffers->Active = 0;
+
+        cdc_receiveNext(itf);
+    }
+#endif
 }
 
 /**
@@ -342,6 +388,13 @@ static void cdc_deinit(USBD_CDC_IfHandleType *itf)
     USBD_EpClose(dev, itf->Config.NotEpNum);
 #endif
 
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+    if (itf->Stream != NULL)
+    {
+        CDC_StreamDeinit(itf);
+    }
+#endif
+
     /* Deinitialize application */
     USBD_SAFE_CALLBACK(CDC_APP(itf)->Deinit, );
 
@@ -362,19 +415,19 @@ static USBD_ReturnType cdc_setupStage(USBD_CDC_IfHandleType *itf)
     USBD_ReturnType retval = USBD_E_INVALID;
     USBD_HandleType *dev = itf->Base.Device;
 
-    switch (dev->Setup.RequestType.Type)
+    switch (dev->Request.RequestType.Type)
     {
         case USB_REQ_TYPE_CLASS:
         {
             /* Data stage is upcoming */
-            if (dev->Setup.Length > 0)
+            if (dev->Request.Length > 0)
             {
-                if (dev->Setup.RequestType.Direction == USB_DIRECTION_IN)
+                if (dev->Request.RequestType.Direction == USB_DIRECTION_IN)
                 {
                     /* Get the data to send */
-                    CDC_APP(itf)->Control(&dev->Setup, dev->CtrlData);
+                    CDC_APP(itf)->Control(&dev->Request, dev->CtrlData);
 
-                    retval = USBD_CtrlSendData(dev, dev->CtrlData, dev->Setup.Length);
+                    retval = USBD_CtrlSendData(dev, dev->CtrlData, dev->Request.Length);
                 }
                 else
                 {
@@ -385,7 +438,7 @@ static USBD_ReturnType cdc_setupStage(USBD_CDC_IfHandleType *itf)
             else
             {
                 /* Simply pass the request with wValue */
-                CDC_APP(itf)->Control(&dev->Setup, (uint8_t*) &dev->Setup.Value);
+                CDC_APP(itf)->Control(&dev->Request, (uint8_t*) &dev->Request.Value);
 
                 /* Accept all class requests */
                 retval = USBD_E_OK;
@@ -408,10 +461,10 @@ static void cdc_dataStage(USBD_CDC_IfHandleType *itf)
 {
     USBD_HandleType *dev = itf->Base.Device;
 
-    if (dev->Setup.RequestType.Direction == USB_DIRECTION_OUT)
+    if (dev->Request.RequestType.Direction == USB_DIRECTION_OUT)
     {
         /* Hand over received data to App */
-        CDC_APP(itf)->Control(&dev->Setup, dev->CtrlData);
+        CDC_APP(itf)->Control(&dev->Request, dev->CtrlData);
     }
 }
 
@@ -422,8 +475,34 @@ static void cdc_dataStage(USBD_CDC_IfHandleType *itf)
  */
 static void cdc_outData(USBD_CDC_IfHandleType *itf, USBD_EpHandleType *ep)
 {
-    USBD_SAFE_CALLBACK(CDC_APP(itf)->Received,
-            ep->Transfer.Data - ep->Transfer.Length, ep->Transfer.Length);
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+    if (itf->Stream != NULL)
+    {
+        CDC_StreamOutData(itf, ep);
+    }
+    else
+#endif
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+    if (itf->RxBuffers != NULL)
+    {
+        /* The rearming overwrites the endpoint's transfer */
+        uint8_t *data = ep->Transfer.Data - ep->Transfer.Length;
+        uint16_t length = ep->Transfer.Length;
+
+        itf->RxBuffers->Head++;
+        itf->RxBuffers->Active = 0;
+
+        /* Rearm the endpoint before the application processes the data */
+        cdc_receiveNext(itf);
+
+        USBD_SAFE_CALLBACK(CDC_APP(itf)->Received, data, length);
+    }
+    else
+#endif
+    {
+        USBD_SAFE_CALLBACK(CDC_APP(itf)->Received,
+                ep->Transfer.Data - ep->Transfer.Length, ep->Transfer.Length);
+    }
 }
 
 /**
@@ -437,8 +516,17 @@ static void cdc_inData(USBD_CDC_IfHandleType *itf, USBD_EpHandleType *ep)
     if (ep == &itf->Base.Device->EP.IN[itf->Config.InEpNum & 0xF])
 #endif
     {
-        USBD_SAFE_CALLBACK(CDC_APP(itf)->Transmitted,
-                ep->Transfer.Data - ep->Transfer.Length, ep->Transfer.Length);
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+        if (itf->Stream != NULL)
+        {
+            CDC_StreamInData(itf, ep);
+        }
+        else
+#endif
+        {
+            USBD_SAFE_CALLBACK(CDC_APP(itf)->Transmitted,
+                    ep->Transfer.Data - ep->Transfer.Length, ep->Transfer.Length);
+        }
     }
 }
 
@@ -515,6 +603,24 @@ USBD_ReturnType USBD_CDC_Transmit(USBD_CDC_IfHandleType *itf, uint8_t *data, uin
     return USBD_EpSend(itf->Base.Device, itf->Config.InEpNum, data, length);
 }
 
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+/**
+ * @brief Transmits the data of multiple segments as a single transfer
+ *        through the CDC IN endpoint.
+ * @note  The segments shall remain valid until the transmission is completed,
+ *        which is notified with the first segment's data and the total length.
+ * @param itf: reference of the CDC interface
+ * @param segments: the data segments to send
+ * @param count: the number of segments
+ * @return BUSY if the previous transfer is still ongoing, OK if successful
+ */
+USBD_ReturnType USBD_CDC_TransmitVector(USBD_CDC_IfHandleType *itf,
+        const USBD_EpSegmentType *segments, uint8_t count)
+{
+    return USBD_EpSendVector(itf->Base.Device, itf->Config.InEpNum, segments, count);
+}
+#endif
+
 /**
  * @brief Receives data through the CDC OUT endpoint.
  * @param itf: reference of the CDC interface
@@ -527,4 +633,24 @@ USBD_ReturnType USBD_CDC_Receive(USBD_CDC_IfHandleType *itf, uint8_t *data, uint
     return USBD_EpReceive(itf->Base.Device, itf->Config.OutEpNum, data, length);
 }
 
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+/**
+ * @brief Returns the oldest reception buffer passed to
+ *        @ref USBD_CDC_AppType::Received to the CDC interface,
+ *        which continues the reception if it was held back.
+ * @note  The buffers shall be released in the order of reception.
+ * @param itf: reference of the CDC interface
+ */
+void USBD_CDC_ReceiveRelease(USBD_CDC_IfHandleType *itf)
+{
+    USBD_CDC_RxBuffersType *rx = itf->RxBuffers;
+
+    if (rx->Tail != rx->Head)
+    {
+        rx->Tail++;
+        cdc_receiveNext(itf);
+    }
+}
+#endif
+
 /** @} */
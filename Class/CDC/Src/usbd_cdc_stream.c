@@ -0,0 +1,284 @@
+/**
+  ******************************************************************************
+  * @file    usbd_cdc_stream.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB Communications Device Class
+  *          Buffered data stream with blocking access
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+#include <usbd_cdc_private.h>
+
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+
+/** @ingroup USBD_CDC
+ * @defgroup USBD_CDC_Private_Functions_Stream CDC Private Functions Stream
+ * @{ */
+
+/**
+ * @brief Signals the ring's event to wake up the waiting caller.
+ * @param stream: reference of the CDC stream
+ * @param ring: reference of the stream ring
+ */
+static void cdc_streamSignal(USBD_CDC_StreamType *stream, USBD_CDC_StreamRingType *ring)
+{
+    if ((stream->Os != NULL) && (stream->Os->Signal != NULL))
+    {   stream->Os->Signal(ring->Event); }
+}
+
+/**
+ * @brief Waits for a change of the ring.
+ * @param stream: reference of the CDC stream
+ * @param ring: reference of the stream ring
+ * @param timeout_ms: the wait timeout
+ * @return Non-zero if the ring has changed, 0 if the caller shall give up
+ */
+static int cdc_streamWait(USBD_CDC_StreamType *stream, USBD_CDC_StreamRingType *ring,
+        uint32_t timeout_ms)
+{
+    return (timeout_ms > 0) && (stream->Os != NULL) && (stream->Os->Wait != NULL) &&
+           (stream->Os->Wait(ring->Event, timeout_ms) != 0);
+}
+
+/**
+ * @brief Acquires the ring for the calling task.
+ * @param stream: reference of the CDC stream
+ * @param ring: reference of the stream ring
+ */
+static void cdc_streamLock(USBD_CDC_StreamType *stream, USBD_CDC_StreamRingType *ring)
+{
+    if ((stream->Os != NULL) && (stream->Os->Lock != NULL))
+    {   stream->Os->Lock(ring->Mutex); }
+}
+
+/**
+ * @brief Releases the ring from the calling task.
+ * @param stream: reference of the CDC stream
+ * @param ring: reference of the stream ring
+ */
+static void cdc_streamUnlock(USBD_CDC_StreamType *stream, USBD_CDC_StreamRingType *ring)
+{
+    if ((stream->Os != NULL) && (stream->Os->Unlock != NULL))
+    {   stream->Os->Unlock(ring->Mutex); }
+}
+
+/**
+ * @brief Starts the transmission of the contiguous stored data
+ *        unless a transfer is already ongoing.
+ * @param itf: reference of the CDC interface
+ */
+static void cdc_streamTransmit(USBD_CDC_IfHandleType *itf)
+{
+    USBD_CDC_StreamRingType *tx = &itf->Stream->Tx;
+    uint8_t *data;
+    uint16_t len = USBD_RingPeek(&tx->Ring, &data);
+
+    if ((tx->Active == 0) && (len > 0))
+    {
+        tx->Active = 1;
+        USBD_CDC_Transmit(itf, data, len);
+    }
+}
+
+/**
+ * @brief Prepares the reception to the ring whenever a full packet fits in,
+ *        unless the reception is already ongoing.
+ *        If the contiguous free space is shorter than a packet,
+ *        the packet buffer is used for the reception.
+ * @param itf: reference of the CDC interface
+ */
+static void cdc_streamReceive(USBD_CDC_IfHandleType *itf)
+{
+    USBD_CDC_StreamType *stream = itf->Stream;
+    USBD_CDC_StreamRingType *rx = &stream->Rx;
+    uint16_t mps = itf->Base.Device->EP.OUT[itf->Config.OutEpNum].MaxPacketSize;
+
+    if ((rx->Active == 0) && (USBD_RingSpace(&rx->Ring) >= mps))
+    {
+        uint8_t *data;
+        uint16_t len = USBD_RingReserve(&rx->Ring, &data);
+
+        if (len >= mps)
+        {
+            len -= len % mps;
+        }
+        else
+        {
+            data = stream->Packet;
+            len = mps;
+        }
+
+        rx->Active = 1;
+        USBD_CDC_Receive(itf, data, len);
+    }
+}
+
+/**
+ * @brief Starts the stream operation when the interface is initialized.
+ * @param itf: reference of the CDC interface
+ */
+void CDC_StreamInit(USBD_CDC_IfHandleType *itf)
+{
+    itf->Stream->Tx.Active = 0;
+    itf->Stream->Rx.Active = 0;
+
+    cdc_streamReceive(itf);
+    cdc_streamTransmit(itf);
+}
+
+/**
+ * @brief Stops the stream operation when the interface is deinitialized,
+ *        and wakes up the waiting callers.
+ * @note  The interrupted transmission is restarted from its beginning
+ *        when the interface is initialized again.
+ * @param itf: reference of the CDC interface
+ */
+void CDC_StreamDeinit(USBD_CDC_IfHandleType *itf)
+{
+    itf->Stream->Tx.Active = 0;
+    itf->Stream->Rx.Active = 0;
+
+    cdc_streamSignal(itf->Stream, &itf->Stream->Tx);
+    cdc_streamSignal(itf->Stream, &itf->Stream->Rx);
+}
+
+/**
+ * @brief Stores the received data in the ring, and prepares the next reception.
+ * @param itf: reference of the CDC interface
+ * @param ep: reference to the endpoint structure
+ */
+void CDC_StreamOutData(USBD_CDC_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    USBD_CDC_StreamType *stream = itf->Stream;
+    uint8_t *data = ep->Transfer.Data - ep->Transfer.Length;
+
+    if (data == stream->Packet)
+    {
+        USBD_RingPut(&stream->Rx.Ring, data, ep->Transfer.Length);
+    }
+    else
+    {
+        USBD_RingCommit(&stream->Rx.Ring, ep->Transfer.Length);
+    }
+
+    stream->Rx.Active = 0;
+    cdc_streamReceive(itf);
+
+    cdc_streamSignal(stream, &stream->Rx);
+}
+
+/**
+ * @brief Releases the transmitted data from the ring, and starts the next transmission.
+ *        A transfer of full packets is terminated by a ZLP when no more data follows.
+ * @param itf: reference of the CDC interface
+ * @param ep: reference to the endpoint structure
+ */
+void CDC_StreamInData(USBD_CDC_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    USBD_CDC_StreamType *stream = itf->Stream;
+    uint16_t len = ep->Transfer.Length;
+
+    USBD_RingRelease(&stream->Tx.Ring, len);
+    stream->Tx.Active = 0;
+
+    if ((len > 0) && ((len % ep->MaxPacketSize) == 0) &&
+        (USBD_RingCount(&stream->Tx.Ring) == 0))
+    {
+        stream->Tx.Active = 1;
+        USBD_CDC_Transmit(itf, stream->Tx.Ring.Buffer, 0);
+    }
+    else
+    {
+        cdc_streamTransmit(itf);
+    }
+
+    cdc_streamSignal(stream, &stream->Tx);
+}
+
+/** @} */
+
+/** @addtogroup USBD_CDC_Exported_Functions
+ * @{ */
+
+/**
+ * @brief Writes data to the transmit ring of the CDC stream, and starts the transmission.
+ *        Multiple tasks may write the stream, as the access is serialized by the OS mutex.
+ * @param itf: reference of the CDC interface
+ * @param data: the data to send
+ * @param length: the data length
+ * @param timeout_ms: the time limit of waiting for each ring space release,
+ *        0 to return immediately, or @ref USBD_CDC_STREAM_WAIT_FOREVER
+ * @return The number of bytes written
+ */
+uint16_t USBD_CDC_StreamWrite(USBD_CDC_IfHandleType *itf, const uint8_t *data,
+        uint16_t length, uint32_t timeout_ms)
+{
+    USBD_CDC_StreamType *stream = itf->Stream;
+    USBD_CDC_StreamRingType *tx = &stream->Tx;
+    uint16_t written = 0;
+
+    cdc_streamLock(stream, tx);
+
+    do
+    {
+        written += USBD_RingPut(&tx->Ring, &data[written], length - written);
+
+        cdc_streamTransmit(itf);
+    }
+    while ((written < length) && cdc_streamWait(stream, tx, timeout_ms));
+
+    cdc_streamUnlock(stream, tx);
+
+    return written;
+}
+
+/**
+ * @brief Reads data from the receive ring of the CDC stream.
+ *        The reception is continued as soon as the released space allows.
+ * @param itf: reference of the CDC interface
+ * @param data: the destination buffer
+ * @param length: the requested data length
+ * @param timeout_ms: the time limit of waiting for each data reception,
+ *        0 to return immediately, or @ref USBD_CDC_STREAM_WAIT_FOREVER
+ * @return The number of bytes read
+ */
+uint16_t USBD_CDC_StreamRead(USBD_CDC_IfHandleType *itf, uint8_t *data,
+        uint16_t length, uint32_t timeout_ms)
+{
+    USBD_CDC_StreamType *stream = itf->Stream;
+    USBD_CDC_StreamRingType *rx = &stream->Rx;
+    uint16_t read = 0;
+
+    cdc_streamLock(stream, rx);
+
+    do
+    {
+        read += USBD_RingGet(&rx->Ring, &data[read], length - read);
+
+        cdc_streamReceive(itf);
+    }
+    while ((read < length) && cdc_streamWait(stream, rx, timeout_ms));
+
+    cdc_streamUnlock(stream, rx);
+
+    return read;
+}
+
+/** @} */
+
+#endif /* (USBD_CDC_STREAM_SUPPORT == 1) */
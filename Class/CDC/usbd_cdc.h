@@ -29,6 +29,9 @@ extern "C"
 #endif
 
 #include <usbd_types.h>
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+#include <usbd_ring.h>
+#endif
 
 /** @ingroup USBD
  * @addtogroup USBD_Class USBD Classes
@@ -37,6 +40,39 @@ extern "C"
 /** @defgroup USBD_CDC Communications Device Class (CDC)
  * @{ */
 
+/** @defgroup USBD_CDC_Exported_Macros CDC Exported Macros
+ * @{ */
+
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+/* Timeout value for the stream functions to wait without time limit */
+#define USBD_CDC_STREAM_WAIT_FOREVER    0xFFFFFFFF
+
+/* The size of the stream's reception buffer for packets
+ * which don't fit in the contiguous free space of the ring */
+#ifndef USBD_CDC_STREAM_PACKET_SIZE
+#if (USBD_HS_SUPPORT == 1)
+#define USBD_CDC_STREAM_PACKET_SIZE     USB_EP_BULK_HS_MPS
+#else
+#define USBD_CDC_STREAM_PACKET_SIZE     USB_EP_BULK_FS_MPS
+#endif
+#endif
+#endif /* (USBD_CDC_STREAM_SUPPORT == 1) */
+
+/* When set to 2 or more, the interfaces with linked @ref USBD_CDC_RxBuffersType
+ * keep their OUT endpoint armed using this many reception buffers (a power of 2) */
+#ifndef USBD_CDC_RX_BUFFER_COUNT
+#define USBD_CDC_RX_BUFFER_COUNT        0
+#endif
+
+/* The size of each reception buffer, shall be a multiple of the max packet size */
+#if !defined(USBD_CDC_RX_BUFFER_SIZE) && (USBD_HS_SUPPORT == 1)
+#define USBD_CDC_RX_BUFFER_SIZE         USB_EP_BULK_HS_MPS
+#elif !defined(USBD_CDC_RX_BUFFER_SIZE)
+#define USBD_CDC_RX_BUFFER_SIZE         USB_EP_BULK_FS_MPS
+#endif
+
+/** @} */
+
 /** @defgroup USBD_CDC_Exported_Types CDC Exported Types
  * @{ */
 
@@ -109,12 +145,70 @@ typedef struct
 }USBD_CDC_ConfigType;
 
 
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+/** @brief CDC stream operating system primitives */
+typedef struct
+{
+    void (*Lock)        (void *mutex);      /*!< Acquire exclusive access of a stream direction */
+
+    void (*Unlock)      (void *mutex);      /*!< Release exclusive access of a stream direction */
+
+    int  (*Wait)        (void *event,
+                         uint32_t timeout_ms); /*!< Block until the event is signalled or the timeout
+                                                    elapses, return non-zero if signalled */
+
+    void (*Signal)      (void *event);      /*!< Signal the event, called from the USB context */
+}USBD_CDC_StreamOsType;
+
+
+/** @brief CDC stream direction ring buffer */
+typedef struct
+{
+    USBD_RingType Ring;             /*!< Ring of the direction's data */
+    volatile uint8_t  Active;       /*!< Set while the endpoint transfer is ongoing */
+    void *Event;                    /*!< OS event signalled when the ring changes */
+    void *Mutex;                    /*!< OS mutex of the callers */
+}USBD_CDC_StreamRingType;
+
+
+/** @brief CDC stream structure */
+typedef struct
+{
+    const USBD_CDC_StreamOsType *Os;/*!< OS primitives, set to NULL for non-blocking use only */
+    USBD_CDC_StreamRingType Tx;     /*!< Transmit ring, written by the application */
+    USBD_CDC_StreamRingType Rx;     /*!< Receive ring, read by the application */
+    uint8_t Packet[USBD_CDC_STREAM_PACKET_SIZE]; /*!< Reception buffer when the ring wraps */
+}USBD_CDC_StreamType;
+#endif /* (USBD_CDC_STREAM_SUPPORT == 1) */
+
+
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+/** @brief CDC reception buffers structure */
+typedef struct
+{
+    uint8_t Buffer[USBD_CDC_RX_BUFFER_COUNT][USBD_CDC_RX_BUFFER_SIZE]; /*!< Reception buffers */
+    volatile uint8_t Head;          /*!< Free-running index of the buffer under reception */
+    volatile uint8_t Tail;          /*!< Free-running index of the oldest unreleased buffer */
+    volatile uint8_t Active;        /*!< Set while the reception is ongoing */
+}USBD_CDC_RxBuffersType;
+#endif /* (USBD_CDC_RX_BUFFER_COUNT > 1) */
+
+
 /** @brief CDC class interface structure */
 typedef struct
 {
     USBD_IfHandleType Base;         /*!< Class-independent interface base */
     const USBD_CDC_AppType* App;    /*!< CDC application reference */
     USBD_CDC_ConfigType Config;     /*!< CDC interface configuration */
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+    USBD_CDC_StreamType* Stream;    /*!< When set, the data endpoints are served by the stream
+                                         instead of the application's Received and Transmitted */
+#endif
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+    USBD_CDC_RxBuffersType* RxBuffers;  /*!< When set, the OUT endpoint is continuously armed
+                                         with these buffers, which the application shall release
+                                         by @ref USBD_CDC_ReceiveRelease after each reception */
+#endif
 }USBD_CDC_IfHandleType;
 
 /** @} */
@@ -128,9 +222,31 @@ USBD_ReturnType USBD_CDC_Transmit       (USBD_CDC_IfHandleType *itf,
                                          uint8_t *data,
                                          uint16_t length);
 
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+USBD_ReturnType USBD_CDC_TransmitVector (USBD_CDC_IfHandleType *itf,
+                                         const USBD_EpSegmentType *segments,
+                                         uint8_t count);
+#endif
+
 USBD_ReturnType USBD_CDC_Receive        (USBD_CDC_IfHandleType *itf,
                                          uint8_t *data,
                                          uint16_t length);
+
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+void            USBD_CDC_ReceiveRelease (USBD_CDC_IfHandleType *itf);
+#endif
+
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+uint16_t        USBD_CDC_StreamWrite    (USBD_CDC_IfHandleType *itf,
+                                         const uint8_t *data,
+                                         uint16_t length,
+                                         uint32_t timeout_ms);
+
+uint16_t        USBD_CDC_StreamRead     (USBD_CDC_IfHandleType *itf,
+                                         uint8_t *data,
+                                         uint16_t length,
+                                         uint32_t timeout_ms);
+#endif
 /** @} */
 
 /** @} */
@@ -0,0 +1,47 @@
+/**
+  ******************************************************************************
+  * @file    usbd_cdc_private.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB Communications Device Class
+  *          Private cross-domain functions header
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_CDC_PRIVATE_H_
+#define __USBD_CDC_PRIVATE_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <usbd_cdc.h>
+
+#if (USBD_CDC_STREAM_SUPPORT == 1)
+void            CDC_StreamInit      (USBD_CDC_IfHandleType *itf);
+void            CDC_StreamDeinit    (USBD_CDC_IfHandleType *itf);
+void            CDC_StreamOutData   (USBD_CDC_IfHandleType *itf,
+                                     USBD_EpHandleType *ep);
+void            CDC_StreamInData    (USBD_CDC_IfHandleType *itf,
+                                     USBD_EpHandleType *ep);
+#endif
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_CDC_PRIVATE_H_ */
@@ -31,6 +31,23 @@
 #define DFU_APP(ITF)    ((USBD_DFU_AppType*)((ITF)->App))
 #endif
 
+/* The firmware blocks are transferred through the application buffer when it's provided */
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+#define DFU_BUFFER_AT(ITF, IDX)         ((ITF)->Config.Buffer + ((IDX) * (ITF)->Config.BufferSize))
+#define DFU_BUFFER(ITF)                 DFU_BUFFER_AT(ITF, (ITF)->RxIndex)
+#else
+#define DFU_BUFFER(ITF)                 (((ITF)->Config.Buffer != NULL) ? \
+        (ITF)->Config.Buffer : (ITF)->Base.Device->CtrlData)
+#endif
+#define DFU_TRANSFER_SIZE(ITF)          (((ITF)->Config.Buffer != NULL) ? \
+        (ITF)->Config.BufferSize : USBD_EP0_BUFFER_SIZE)
+
+#define DFU_CAN_UPLOAD(APP)             (((APP)->Read != NULL) || ((APP)->Firmware.MemoryMapped != 0))
+
+#define DFU_FIRMWARE_END(APP)           ((uint8_t*)((APP)->Firmware.Address + (APP)->Firmware.TotalSize))
+#define DFU_ERASE_SIZE(APP)             (((APP)->Firmware.EraseSize != 0) ? \
+        (APP)->Firmware.EraseSize : (APP)->Firmware.TotalSize)
+
 #define DFU_CLASS_REQ_COUNT (sizeof(dfu_validStates)/sizeof(dfu_validStates[0]))
 
 #define DFU_ATTR_WILL_DETACH            0x08
@@ -41,14 +58,18 @@
 #ifndef USBD_DFU_ST_EXTENSION
 #define USBD_DFU_ST_EXTENSION           0
 #endif
+
+#if (USBD_DFU_ASYNC_PROGRAM == 1) && (USBD_DFU_ST_EXTENSION != 0)
+#error "USBD_DFU_ASYNC_PROGRAM is not supported with USBD_DFU_ST_EXTENSION!"
+#endif
 /* DFU STMicroelectronics Extension (DFUSE) commands */
 #define DFUSE_CMD_GETCOMMANDS           0x00
 #define DFUSE_CMD_SETADDRESSPOINTER     0x21
 #define DFUSE_CMD_ERASE                 0x41
 #define DFUSE_CMD_READ_UNPROTECT        0x92
 
-#define DFUSE_GETADDRESS(ITF, DESC)     \
-    ((uint8_t*)((ITF)->Address + (((ITF)->BlockNum - 2) * (DESC)->DFUFD.wTransferSize)))
+#define DFUSE_GETADDRESS(ITF)           \
+    ((uint8_t*)((ITF)->Address + (((ITF)->BlockNum - 2) * DFU_TRANSFER_SIZE(ITF))))
 
 typedef struct {
     uint8_t  bLength;
@@ -205,6 +226,7 @@ static uint16_t dfu_getAltsDesc(USBD_DFU_IfHandleType *itf, uint8_t ifNum, uint8
     /* Copy the DFU func desc after the interface descriptors */
     memcpy(desc, &dfu_desc.DFUFD, sizeof(dfu_desc.DFUFD));
     desc->wDetachTimeOut = itf->Config.DetachTimeout_ms;
+    desc->wTransferSize  = DFU_TRANSFER_SIZE(itf);
 
     /* Copy the descriptors many times, add alternate setting indexes */
     for (as = 0; as < itf->Base.AltCount; as++)
@@ -218,7 +240,7 @@ static uint16_t dfu_getAltsDesc(USBD_DFU_IfHandleType *itf, uint8_t ifNum, uint8
         {
             desc->bmAttributes |= DFU_ATTR_CAN_DNLOAD;
         }
-        if (itf->App[as].Read != NULL)
+        if (DFU_CAN_UPLOAD(&itf->App[as]))
         {
             desc->bmAttributes |= DFU_ATTR_CAN_UPLOAD;
         }
@@ -248,13 +270,14 @@ static uint16_t dfu_getDesc(USBD_DFU_IfHandleType *itf, uint8_t ifNum, uint8_t *
 
     memcpy(dest, &dfu_desc, sizeof(dfu_desc));
     desc->DFUFD.wDetachTimeOut = itf->Config.DetachTimeout_ms;
+    desc->DFUFD.wTransferSize  = DFU_TRANSFER_SIZE(itf);
 
     /* Set attributes */
     if ((DFU_APP(itf)->Erase != NULL) && (DFU_APP(itf)->Write != NULL))
     {
         desc->DFUFD.bmAttributes |= DFU_ATTR_CAN_DNLOAD;
     }
-    if (DFU_APP(itf)->Read != NULL)
+    if (DFU_CAN_UPLOAD(DFU_APP(itf)))
     {
         desc->DFUFD.bmAttributes |= DFU_ATTR_CAN_UPLOAD;
     }
@@ -306,8 +329,16 @@ static void dfu_init(USBD_DFU_IfHandleType *itf)
     if (itf->DevStatus.State >= DFU_STATE_IDLE)
     {
         itf->Address = (uint8_t*)DFU_APP(itf)->Firmware.Address;
+        itf->EraseAddress = itf->Address;
         itf->BlockNum = 0;
         itf->BlockLength = 0;
+        itf->Digest.Value = 0;
+        itf->Digest.TrailerLength = 0;
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+        itf->Program.Length = 0;
+        itf->Program.Busy = 0;
+        itf->RxIndex = 0;
+#endif
 
         /* Initialize media */
         USBD_SAFE_CALLBACK(DFU_APP(itf)->Init, );
@@ -339,21 +370,25 @@ static USBD_ReturnType dfu_setupStage(USBD_DFU_IfHandleType *itf)
     USBD_ReturnType retval = USBD_E_INVALID;
     USBD_HandleType *dev = itf->Base.Device;
 
-    switch (dev->Setup.RequestType.Type)
+    switch (dev->Request.RequestType.Type)
     {
         case USB_REQ_TYPE_STANDARD:
         {
             /* DFU specific descriptors can be requested */
-            if (dev->Setup.Request == USB_REQ_GET_DESCRIPTOR)
+            if (dev->Request.Request == USB_REQ_GET_DESCRIPTOR)
             {
-                switch (dev->Setup.Value >> 8)
+                switch (dev->Request.Value >> 8)
                 {
                     /* Return DFU func. descriptor */
                     case DFU_DESC_TYPE_FUNCTIONAL:
                     {
-                        retval = USBD_CtrlSendData(dev,
-                                (uint8_t*)&dfu_desc.DFUFD,
-                                sizeof(dfu_desc.DFUFD));
+                        USBD_DFU_FuncDescType *desc = (USBD_DFU_FuncDescType*)dev->CtrlData;
+
+                        memcpy(desc, &dfu_desc.DFUFD, sizeof(dfu_desc.DFUFD));
+                        desc->wDetachTimeOut = itf->Config.DetachTimeout_ms;
+                        desc->wTransferSize  = DFU_TRANSFER_SIZE(itf);
+
+                        retval = USBD_CtrlSendData(dev, (uint8_t*)desc, sizeof(*desc));
                         break;
                     }
                     default:
@@ -365,7 +400,7 @@ static USBD_ReturnType dfu_setupStage(USBD_DFU_IfHandleType *itf)
 
         case USB_REQ_TYPE_CLASS:
         {
-            uint8_t reqId = dev->Setup.Request;
+            uint8_t reqId = dev->Request.Request;
             uint16_t stateMask = 1 << itf->DevStatus.State;
 
             /* Call the operation indexed by bRequest
@@ -434,34 +469,38 @@ static USBD_ReturnType dfu_download(USBD_DFU_IfHandleType *itf)
     USBD_ReturnType retval = USBD_E_INVALID;
     USBD_HandleType *dev = itf->Base.Device;
 
-    if (dev->Setup.Length > 0)
+    if (dev->Request.Length > 0)
     {
-        /* Check for download support */
-        if ((DFU_APP(itf)->Erase != NULL) && (DFU_APP(itf)->Write != NULL))
+        /* Check for download support and the block fitting the buffer */
+        if ((DFU_APP(itf)->Erase != NULL) && (DFU_APP(itf)->Write != NULL) &&
+            (dev->Request.Length <= DFU_TRANSFER_SIZE(itf)))
         {
 #if (USBD_DFU_ST_EXTENSION == 0)
             if (itf->DevStatus.State == DFU_STATE_IDLE)
             {
                 /* Initialize address at first block */
                 itf->Address = (uint8_t*)DFU_APP(itf)->Firmware.Address;
+                itf->EraseAddress = itf->Address;
                 itf->BlockNum = 0xFFFF;
+                itf->Digest.Value = 0;
+                itf->Digest.TrailerLength = 0;
             }
 
             /* Checks for valid sequence and overall length */
-            if (   ( dev->Setup.Value == ((itf->BlockNum + 1) & 0xFFFF))
-                && (((uint32_t)itf->Address + dev->Setup.Length) <
+            if (   ( dev->Request.Value == ((itf->BlockNum + 1) & 0xFFFF))
+                && (((uint32_t)itf->Address + dev->Request.Length) <
                     (DFU_APP(itf)->Firmware.Address + DFU_APP(itf)->Firmware.TotalSize)))
 #endif /* (USBD_DFU_ST_EXTENSION == 0) */
             {
                 /* Update the global length and block number */
-                itf->BlockNum    = dev->Setup.Value;
-                itf->BlockLength = dev->Setup.Length;
+                itf->BlockNum    = dev->Request.Value;
+                itf->BlockLength = dev->Request.Length;
 
                 /* Update the state machine */
                 itf->DevStatus.State = DFU_STATE_DNLOAD_SYNC;
 
-                /* Prepare the reception of the buffer over EP0 */
-                retval = USBD_CtrlReceiveData(dev, dev->CtrlData);
+                /* Prepare the reception of the block into the buffer */
+                retval = USBD_CtrlReceiveData(dev, DFU_BUFFER(itf));
             }
         }
     }
@@ -477,6 +516,28 @@ static USBD_ReturnType dfu_download(USBD_DFU_IfHandleType *itf)
     return retval;
 }
 
+/**
+ * @brief Provides a firmware block for uploading.
+ * @param itf: reference of the DFU interface
+ * @param addr: the firmware address of the block
+ * @param data: the buffer to read the block to
+ * @param len: the length of the block
+ * @return Reference of the block data, which is the firmware memory itself
+ *         when it's memory-mapped and no Read function is provided
+ */
+static uint8_t* dfu_readBlock(USBD_DFU_IfHandleType *itf, uint8_t *addr, uint8_t *data, uint16_t len)
+{
+    if (DFU_APP(itf)->Read != NULL)
+    {
+        DFU_APP(itf)->Read(addr, data, len);
+    }
+    else
+    {
+        data = addr;
+    }
+    return data;
+}
+
 /**
  * @brief Reads and sends a firmware block to the host.
  * @param itf: reference of the DFU interface
@@ -488,16 +549,23 @@ static USBD_ReturnType dfu_upload(USBD_DFU_IfHandleType *itf)
     USBD_HandleType *dev = itf->Base.Device;
 
     /* Send data to host if supported */
-    if ((dev->Setup.Length > 0) && (DFU_APP(itf)->Read != NULL))
+    if ((dev->Request.Length > 0) && DFU_CAN_UPLOAD(DFU_APP(itf)))
     {
-        uint8_t *data = dev->CtrlData;
+        uint8_t *data = DFU_BUFFER(itf);
+        uint16_t blockSize = dev->Request.Length;
+
+        /* The block is limited by the buffer size */
+        if (blockSize > DFU_TRANSFER_SIZE(itf))
+        {
+            blockSize = DFU_TRANSFER_SIZE(itf);
+        }
 #if (USBD_DFU_ST_EXTENSION != 0)
-        itf->BlockNum = dev->Setup.Value;
+        itf->BlockNum = dev->Request.Value;
 
         /* Get commands */
         if (itf->BlockNum == 0)
         {
-            itf->DevStatus.State = (dev->Setup.Length > sizeof(dfuse_cmds)) ?
+            itf->DevStatus.State = (dev->Request.Length > sizeof(dfuse_cmds)) ?
                     DFU_STATE_IDLE : DFU_STATE_UPLOAD_IDLE;
 
             /* Return with supported commands */
@@ -508,12 +576,12 @@ static USBD_ReturnType dfu_upload(USBD_DFU_IfHandleType *itf)
         {
             itf->DevStatus.State = DFU_STATE_UPLOAD_IDLE;
 
-            DFU_APP(itf)->Read(
-                    DFUSE_GETADDRESS(itf, &dfu_desc),
+            data = dfu_readBlock(itf,
+                    DFUSE_GETADDRESS(itf),
                     data,
-                    dev->Setup.Length);
+                    blockSize);
 
-            retval = USBD_CtrlSendData(dev, data, dev->Setup.Length);
+            retval = USBD_CtrlSendData(dev, data, blockSize);
         }
 #else
         /* The host sends DFU_UPLOAD requests to the device until it
@@ -529,29 +597,29 @@ static USBD_ReturnType dfu_upload(USBD_DFU_IfHandleType *itf)
         }
 
         /* Check for correct sequence */
-        if (dev->Setup.Value == ((itf->BlockNum + 1) & 0xFFFF))
+        if (dev->Request.Value == ((itf->BlockNum + 1) & 0xFFFF))
         {
             uint16_t len;
             uint32_t progress = (uint32_t)itf->Address - DFU_APP(itf)->Firmware.Address;
 
             /* Shorten the block size if it's the end of the firmware memory,
              * return to IDLE */
-            if ((progress + dev->Setup.Length) > DFU_APP(itf)->Firmware.TotalSize)
+            if ((progress + blockSize) > DFU_APP(itf)->Firmware.TotalSize)
             {
                 len = DFU_APP(itf)->Firmware.TotalSize - progress;
                 itf->DevStatus.State = DFU_STATE_IDLE;
             }
             else
             {
-                len = dev->Setup.Length;
+                len = blockSize;
                 itf->DevStatus.State = DFU_STATE_UPLOAD_IDLE;
             }
 
-            DFU_APP(itf)->Read(itf->Address, data, len);
+            data = dfu_readBlock(itf, itf->Address, data, len);
 
             /* Increment address for next block upload */
             itf->Address  += len;
-            itf->BlockNum  = dev->Setup.Value;
+            itf->BlockNum  = dev->Request.Value;
 
             retval = USBD_CtrlSendData(dev, data, len);
         }
@@ -565,6 +633,169 @@ static USBD_ReturnType dfu_upload(USBD_DFU_IfHandleType *itf)
     return retval;
 }
 
+#if (USBD_DFU_ST_EXTENSION == 0)
+/**
+ * @brief Accumulates a downloaded block to the image digest. The last bytes
+ *        are held back, as they might be the trailer of the image.
+ * @param itf: reference of the DFU interface
+ * @param data: the block data
+ * @param len: the length of the block
+ */
+static void dfu_digest(USBD_DFU_IfHandleType *itf, const uint8_t *data, uint16_t len)
+{
+    if (DFU_APP(itf)->Digest != NULL)
+    {
+        uint8_t held[2 * DFU_DIGEST_SIZE];
+        uint16_t heldLen = itf->Digest.TrailerLength;
+
+        if (len >= DFU_DIGEST_SIZE)
+        {
+            /* The previous trailer is part of the image */
+            itf->Digest.Value = DFU_APP(itf)->Digest(itf->Digest.Value,
+                    itf->Digest.Trailer, heldLen);
+            itf->Digest.Value = DFU_APP(itf)->Digest(itf->Digest.Value,
+                    data, len - DFU_DIGEST_SIZE);
+
+            memcpy(itf->Digest.Trailer, &data[len - DFU_DIGEST_SIZE], DFU_DIGEST_SIZE);
+            itf->Digest.TrailerLength = DFU_DIGEST_SIZE;
+        }
+        else
+        {
+            /* Short block, only the bytes which precede the new trailer are digested */
+            memcpy(held, itf->Digest.Trailer, heldLen);
+            memcpy(&held[heldLen], data, len);
+            heldLen += len;
+
+            if (heldLen > DFU_DIGEST_SIZE)
+            {
+                itf->Digest.Value = DFU_APP(itf)->Digest(itf->Digest.Value,
+                        held, heldLen - DFU_DIGEST_SIZE);
+
+                memcpy(itf->Digest.Trailer, &held[heldLen - DFU_DIGEST_SIZE], DFU_DIGEST_SIZE);
+                heldLen = DFU_DIGEST_SIZE;
+            }
+            else
+            {
+                memcpy(itf->Digest.Trailer, held, heldLen);
+            }
+            itf->Digest.TrailerLength = heldLen;
+        }
+    }
+}
+
+/**
+ * @brief Compares the digest of the downloaded image against its trailer.
+ * @param itf: reference of the DFU interface
+ * @return VERIFY error if the image is corrupted, NONE otherwise
+ */
+static USBD_DFU_StatusType dfu_verify(USBD_DFU_IfHandleType *itf)
+{
+    USBD_DFU_StatusType status = DFU_ERROR_NONE;
+
+    /* Only verify when an image has been downloaded */
+    if ((DFU_APP(itf)->Digest != NULL) && (itf->Digest.TrailerLength > 0))
+    {
+        uint32_t expected = 0;
+        uint8_t i;
+
+        for (i = 0; i < itf->Digest.TrailerLength; i++)
+        {
+            expected |= (uint32_t)itf->Digest.Trailer[i] << (8 * i);
+        }
+
+        if ((itf->Digest.TrailerLength < DFU_DIGEST_SIZE) ||
+            (expected != itf->Digest.Value))
+        {
+            status = DFU_ERROR_VERIFY;
+        }
+    }
+    return status;
+}
+#endif /* (USBD_DFU_ST_EXTENSION == 0) */
+
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+/**
+ * @brief Starts the next asynchronous programming operation if none is ongoing:
+ *        the erase of the next sector ahead of the write pointer,
+ *        or the write of the programmed block when its sectors are erased.
+ * @param itf: reference of the DFU interface
+ */
+static void dfu_program(USBD_DFU_IfHandleType *itf)
+{
+    USBD_DFU_StatusType status = DFU_ERROR_NONE;
+    uint8_t *end = DFU_FIRMWARE_END(DFU_APP(itf));
+    uint8_t *ahead;
+
+    if (itf->Program.Length > 0)
+    {
+        ahead = itf->Program.Address + itf->Program.Length;
+    }
+    else if ((itf->DevStatus.State >= DFU_STATE_DNLOAD_SYNC) &&
+             (itf->DevStatus.State <= DFU_STATE_DNLOAD_IDLE))
+    {
+        /* Erase for the next block while waiting for it */
+        ahead = itf->Address + DFU_TRANSFER_SIZE(itf);
+    }
+    else
+    {
+        ahead = itf->EraseAddress;
+    }
+
+    if (ahead > end)
+    {   ahead = end; }
+
+    if ((itf->Program.Busy == 0) && (itf->DevStatus.Status == DFU_ERROR_NONE))
+    {
+        if (itf->EraseAddress < ahead)
+        {
+            uint8_t *addr = itf->EraseAddress;
+
+            itf->EraseAddress += DFU_ERASE_SIZE(DFU_APP(itf));
+            itf->Program.Erase = 1;
+            itf->Program.Busy  = 1;
+
+            status = DFU_APP(itf)->Erase(addr);
+        }
+        else if (itf->Program.Length > 0)
+        {
+            itf->Program.Erase = 0;
+            itf->Program.Busy  = 1;
+
+            status = DFU_APP(itf)->Write(itf->Program.Address,
+                    DFU_BUFFER_AT(itf, itf->Program.Index),
+                    itf->Program.Length);
+        }
+
+        /* The operation couldn't be started */
+        if (status != DFU_ERROR_NONE)
+        {
+            itf->Program.Busy = 0;
+            itf->DevStatus.Status = status;
+        }
+    }
+}
+
+/**
+ * @brief Estimates the time until the ongoing programming operations are completed.
+ * @param itf: reference of the DFU interface
+ * @return The remaining time [ms]
+ */
+static uint16_t dfu_remainingTime(USBD_DFU_IfHandleType *itf)
+{
+    uint16_t time = 0;
+
+    if (DFU_APP(itf)->GetRemaining_ms != NULL)
+    {
+        time = DFU_APP(itf)->GetRemaining_ms();
+    }
+    else if (DFU_APP(itf)->GetTimeout_ms != NULL)
+    {
+        time = DFU_APP(itf)->GetTimeout_ms(itf->Program.Address, itf->Program.Length);
+    }
+    return time;
+}
+#endif /* (USBD_DFU_ASYNC_PROGRAM == 1) */
+
 /**
  * @brief Updates and sends the DFU Status through the control pipe.
  * @param itf: reference of the DFU interface
@@ -575,6 +806,51 @@ static USBD_ReturnType dfu_getStatus(USBD_DFU_IfHandleType *itf)
     USBD_HandleType *dev = itf->Base.Device;
     USBD_DFU_StateType nextState = itf->DevStatus.State;
 
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+    /* Report the failure of the asynchronous programming */
+    if ((itf->DevStatus.Status != DFU_ERROR_NONE) &&
+        (itf->DevStatus.State >= DFU_STATE_IDLE))
+    {
+        itf->DevStatus.State = nextState = DFU_STATE_ERROR;
+    }
+    else if (itf->DevStatus.State == DFU_STATE_DNLOAD_SYNC)
+    {
+        /* The received block is programmed as soon as the previous one is written,
+         * the next block is received to the other buffer meanwhile */
+        if ((itf->BlockLength > 0) && (itf->Program.Length == 0))
+        {
+            itf->Program.Address = itf->Address;
+            itf->Program.Length  = itf->BlockLength;
+            itf->Program.Index   = itf->RxIndex;
+            itf->RxIndex        ^= 1;
+
+            dfu_digest(itf, DFU_BUFFER_AT(itf, itf->Program.Index), itf->Program.Length);
+
+            itf->Address        += itf->BlockLength;
+            itf->BlockLength     = 0;
+        }
+
+        if (itf->BlockLength > 0)
+        {
+            /* Wait for the previous block */
+            itf->DevStatus.PollTimeout = dfu_remainingTime(itf);
+            nextState = DFU_STATE_DNLOAD_BUSY;
+        }
+        else
+        {
+            itf->DevStatus.PollTimeout = 0;
+            itf->DevStatus.State = nextState = DFU_STATE_DNLOAD_IDLE;
+        }
+    }
+    else if ((itf->DevStatus.State == DFU_STATE_MANIFEST_SYNC) &&
+             ((itf->Program.Busy != 0) || (itf->Program.Length > 0)))
+    {
+        /* Manifestation waits for the programming to finish */
+        itf->DevStatus.PollTimeout = dfu_remainingTime(itf);
+        nextState = DFU_STATE_MANIFEST;
+    }
+    else
+#endif /* (USBD_DFU_ASYNC_PROGRAM == 1) */
     /* Provide timeout values before starting download / manifestation */
     if ((itf->DevStatus.State == DFU_STATE_DNLOAD_SYNC) ||
         (itf->DevStatus.State == DFU_STATE_MANIFEST_SYNC))
@@ -623,6 +899,13 @@ static USBD_ReturnType dfu_clearStatus(USBD_DFU_IfHandleType *itf)
     itf->DevStatus.State = DFU_STATE_IDLE;
     itf->DevStatus.Status = DFU_ERROR_NONE;
     itf->DevStatus.PollTimeout = 0;
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+    /* Drop the block whose programming failed */
+    if ((itf->Program.Busy == 0) || (itf->Program.Erase != 0))
+    {
+        itf->Program.Length = 0;
+    }
+#endif
     return USBD_E_OK;
 }
 
@@ -649,6 +932,13 @@ static USBD_ReturnType dfu_abort(USBD_DFU_IfHandleType *itf)
     itf->DevStatus.PollTimeout = 0;
     itf->BlockNum    = 0;
     itf->BlockLength = 0;
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+    /* Only an ongoing write keeps its buffer */
+    if ((itf->Program.Busy == 0) || (itf->Program.Erase != 0))
+    {
+        itf->Program.Length = 0;
+    }
+#endif
     return USBD_E_OK;
 }
 
@@ -661,11 +951,24 @@ static void dfu_dataStage(USBD_DFU_IfHandleType *itf)
     USBD_HandleType *dev = itf->Base.Device;
 
     /* Perform after GetStatus request */
-    if ((dev->Setup.RequestType.Type == USB_REQ_TYPE_CLASS) &&
-        (dev->Setup.Request == DFU_REQ_GETSTATUS))
+    if ((dev->Request.RequestType.Type == USB_REQ_TYPE_CLASS) &&
+        (dev->Request.Request == DFU_REQ_GETSTATUS))
     {
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+        /* Continue programming with the newly accepted block */
+        dfu_program(itf);
+#endif
         switch (itf->DevStatus.State)
         {
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+            case DFU_STATE_DNLOAD_BUSY:
+            {
+                /* Poll again when the previous block is written */
+                itf->DevStatus.State = DFU_STATE_DNLOAD_SYNC;
+                itf->DevStatus.PollTimeout = 0;
+                break;
+            }
+#else
             case DFU_STATE_DNLOAD_BUSY:
             {
                 /* New state if no errors occur */
@@ -675,14 +978,14 @@ static void dfu_dataStage(USBD_DFU_IfHandleType *itf)
                 if (itf->BlockNum > 1)
                 {
                     itf->DevStatus.Status = DFU_APP(itf)->Write(
-                            DFUSE_GETADDRESS(itf, &dfu_desc),
-                            dev->CtrlData,
+                            DFUSE_GETADDRESS(itf),
+                            DFU_BUFFER(itf),
                             itf->BlockLength);
                 }
                 /* Execute special command */
                 else if (itf->BlockNum == 0)
                 {
-                    uint8_t cmd = dev->CtrlData[0], *data = dev->CtrlData + 1;
+                    uint8_t cmd = DFU_BUFFER(itf)[0], *data = DFU_BUFFER(itf) + 1;
 
                     switch (cmd)
                     {
@@ -715,20 +1018,25 @@ static void dfu_dataStage(USBD_DFU_IfHandleType *itf)
                     }
                 }
 #else
-                /* Erase firmware on the first block */
-                if (itf->Address == (uint8_t*)DFU_APP(itf)->Firmware.Address)
+                /* Erase the sectors of the block which aren't erased yet */
+                while ((itf->DevStatus.Status == DFU_ERROR_NONE) &&
+                       (itf->EraseAddress < (itf->Address + itf->BlockLength)))
                 {
                     itf->DevStatus.Status = DFU_APP(itf)->Erase(
-                            itf->Address);
+                            itf->EraseAddress);
+
+                    itf->EraseAddress += DFU_ERASE_SIZE(DFU_APP(itf));
                 }
                 /* Write after erase */
                 if (itf->DevStatus.Status == DFU_ERROR_NONE)
                 {
                     itf->DevStatus.Status = DFU_APP(itf)->Write(
                             itf->Address,
-                            dev->CtrlData,
+                            DFU_BUFFER(itf),
                             itf->BlockLength);
 
+                    dfu_digest(itf, DFU_BUFFER(itf), itf->BlockLength);
+
                     itf->Address += itf->BlockLength;
                 }
 #endif /* (USBD_DFU_ST_EXTENSION != 0) */
@@ -736,30 +1044,47 @@ static void dfu_dataStage(USBD_DFU_IfHandleType *itf)
                 itf->DevStatus.PollTimeout = 0;
                 break;
             }
+#endif /* (USBD_DFU_ASYNC_PROGRAM == 1) */
 
             case DFU_STATE_MANIFEST:
             {
-                /* Perform manifestation */
-                if (DFU_APP(itf)->Manifest != NULL)
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+                if ((itf->Program.Busy != 0) || (itf->Program.Length > 0))
                 {
-                    itf->DevStatus.Status = DFU_APP(itf)->Manifest();
+                    /* Poll again when the programming is finished */
+                    itf->DevStatus.State = DFU_STATE_MANIFEST_SYNC;
+                    itf->DevStatus.PollTimeout = 0;
                 }
-
-                if (itf->DevStatus.Status == DFU_ERROR_NONE)
+                else
+#endif
                 {
+#if (USBD_DFU_ST_EXTENSION == 0)
+                    /* Check the image integrity by its digest */
+                    itf->DevStatus.Status = dfu_verify(itf);
+#endif
+                    /* Perform manifestation */
+                    if ((itf->DevStatus.Status == DFU_ERROR_NONE) &&
+                        (DFU_APP(itf)->Manifest != NULL))
+                    {
+                        itf->DevStatus.Status = DFU_APP(itf)->Manifest();
+                    }
+
+                    if (itf->DevStatus.Status == DFU_ERROR_NONE)
+                    {
 #if (USBD_DFU_MANIFEST_TOLERANT != 0)
-                    itf->DevStatus.State = DFU_STATE_MANIFEST_SYNC;
-                    itf->BlockLength = 0;
-                    itf->DevStatus.PollTimeout = 0;
+                        itf->DevStatus.State = DFU_STATE_MANIFEST_SYNC;
+                        itf->BlockLength = 0;
+                        itf->DevStatus.PollTimeout = 0;
 #else
-                    itf->DevStatus.State = DFU_STATE_MANIFEST_WAIT_RESET;
+                        itf->DevStatus.State = DFU_STATE_MANIFEST_WAIT_RESET;
 
-                    /* Disconnect the USB device */
-                    USBD_Deinit(itf->Base.Device);
+                        /* Disconnect the USB device */
+                        USBD_Deinit(itf->Base.Device);
 
-                    /* Generate system reset to allow jumping to the user code */
-                    USBD_SAFE_CALLBACK(itf->Config.Reboot, );
+                        /* Generate system reset to allow jumping to the user code */
+                        USBD_SAFE_CALLBACK(itf->Config.Reboot, );
 #endif
+                    }
                 }
                 break;
             }
@@ -861,12 +1186,21 @@ void USBD_DFU_AppInit(USBD_DFU_IfHandleType *itf, uint16_t detachTimeout_ms)
  * @param itf: reference of the DFU interface
  * @param dev: reference of the USB Device
  * @return OK if the mounting was successful,
- *         ERROR if it failed due to occupied first interface
+ *         ERROR if it failed due to occupied first interface,
+ *         or the missing Config.Buffer when USBD_DFU_ASYNC_PROGRAM is set
  */
 USBD_ReturnType USBD_DFU_MountInterface(USBD_DFU_IfHandleType *itf, USBD_HandleType *dev)
 {
     USBD_ReturnType retval = USBD_E_ERROR;
 
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+    if ((itf->Config.Buffer == NULL) || (itf->Config.BufferSize == 0))
+    {
+        /* The blocks are downloaded while the previous one is written,
+         * so the double buffer is mandatory */
+    }
+    else
+#endif
     if (dev->IfCount < USBD_MAX_IF_COUNT)
     {
         /* Binding interfaces */
@@ -881,4 +1215,39 @@ USBD_ReturnType USBD_DFU_MountInterface(USBD_DFU_IfHandleType *itf, USBD_HandleT
     return retval;
 }
 
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+/**
+ * @brief Notifies the DFU interface that the application has completed the Erase or Write
+ *        operation which it has started, and continues programming the downloaded blocks.
+ * @note  This function shall be called from the USB device context, as it updates the
+ *        programming state shared with the GETSTATUS handling and starts the next operation:
+ *        from within the Erase or Write call, from an interrupt which has the same priority
+ *        as the USB device interrupt (so neither can preempt the other), or from the thread
+ *        calling @ref USBD_Process when USBD_DEFERRED_PROCESSING is set.
+ * @param itf: reference of the DFU interface
+ * @param status: the result of the operation
+ */
+void USBD_DFU_AppComplete(USBD_DFU_IfHandleType *itf, USBD_DFU_StatusType status)
+{
+    if (itf->Program.Busy != 0)
+    {
+        /* The written block's buffer is released */
+        if (itf->Program.Erase == 0)
+        {
+            itf->Program.Length = 0;
+        }
+        itf->Program.Busy = 0;
+
+        if (status != DFU_ERROR_NONE)
+        {
+            itf->DevStatus.Status = status;
+        }
+        else
+        {
+            dfu_program(itf);
+        }
+    }
+}
+#endif /* (USBD_DFU_ASYNC_PROGRAM == 1) */
+
 /** @} */
@@ -44,6 +44,17 @@ extern "C"
 
 #define DFU_MODE_TAG                0xB00770DFU /* BOOT TO DFU */
 
+/* When set to 1, the Erase and Write calls of the application only start the operations,
+ * which are completed by @ref USBD_DFU_AppComplete from the USB device context.
+ * Meanwhile the next block is downloaded to the other half of the (then mandatory)
+ * double sized Config.Buffer */
+#ifndef USBD_DFU_ASYNC_PROGRAM
+#define USBD_DFU_ASYNC_PROGRAM      0
+#endif
+
+/* The size of the digest trailer at the end of the downloaded image */
+#define DFU_DIGEST_SIZE             4
+
 /** @} */
 
 /** @defgroup USBD_DFU_Exported_Types DFU Exported Types
@@ -134,9 +145,12 @@ typedef struct
 
     void                (*Deinit)       (void); /*!< Shutdown request */
 
-    USBD_DFU_StatusType (*Manifest)     (void); /*!< Verify new firmware integrity, and set its validity */
+    USBD_DFU_StatusType (*Manifest)     (void); /*!< Verify new firmware integrity, and set its validity
+                                                     @note Only called when the Digest verification passed,
+                                                     the computed digest isn't passed on to it */
 
     USBD_DFU_StatusType (*Erase)        (uint8_t *addr);/*!< Erase any existing firmware at address
+                                                             (the entire firmware or one Firmware.EraseSize sector)
                                                              @note DFUSE variant should only erase one flash block */
 
     USBD_DFU_StatusType (*Write)        (uint8_t *addr,
@@ -145,7 +159,8 @@ typedef struct
 
     void                (*Read)         (uint8_t *addr,
                                          uint8_t *data,
-                                         uint32_t len); /*!< Read the firmware to the output buffer */
+                                         uint32_t len); /*!< Read the firmware to the output buffer
+                                                             @note Can be NULL if Firmware.MemoryMapped is set */
 
     uint16_t            (*GetTimeout_ms)(uint8_t *addr,
                                          uint32_t len); /*!< Get the required time [ms] for a (Erase +) Write or
@@ -154,7 +169,24 @@ typedef struct
     struct {
         uint32_t Address;   /*!< Start address of the application firmware */
         uint32_t TotalSize; /*!< Total size of the application firmware in bytes */
+        uint32_t EraseSize; /*!< Size of the erasable sectors, or 0 if the entire firmware
+                                 is erased at once */
+        uint8_t MemoryMapped; /*!< When set and Read is NULL, the firmware is uploaded
+                                   directly from its memory-mapped address */
     }Firmware;
+
+    uint32_t            (*Digest)       (uint32_t digest,
+                                         const uint8_t *data,
+                                         uint32_t len); /*!< Optional: accumulate the downloaded data to the
+                                                             running digest (e.g. a CRC peripheral), starting from 0.
+                                                             The image is accepted if its last DFU_DIGEST_SIZE bytes
+                                                             (little endian) equal the digest of the rest of it.
+                                                             @note Not used by the DFUSE variant */
+
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+    uint16_t            (*GetRemaining_ms)(void);/*!< Optional: get the remaining time [ms] of the ongoing
+                                                      Erase or Write operation */
+#endif
 }USBD_DFU_AppType;
 
 
@@ -169,6 +201,12 @@ typedef struct
 {
     USBD_DFU_RebootCbkType Reboot;      /*!< Function pointer to the system reboot method */
     uint16_t DetachTimeout_ms;          /*!< Required time for DFU detach sequence (reboot) [ms] */
+    uint8_t* Buffer;                    /*!< Firmware block buffer (e.g. a flash page), aligned to
+                                             USBD_DATA_ALIGNMENT, or NULL to use the control EP buffer
+                                             @note Twice the BufferSize is needed when
+                                             USBD_DFU_ASYNC_PROGRAM is set */
+    uint16_t BufferSize;                /*!< Size of the firmware block buffer,
+                                             advertised as the DFU transfer size */
 }USBD_DFU_ConfigType;
 
 
@@ -182,6 +220,22 @@ typedef struct
     uint16_t BlockNum;                  /*!< Current firmware transfer block number */
     uint16_t BlockLength;               /*!< Current firmware transfer block length */
     uint8_t* Address;                   /*!< Current firmware address for transfer */
+    uint8_t* EraseAddress;              /*!< Start of the firmware memory which isn't erased yet */
+    struct {
+        uint32_t Value;                 /*!< Running digest of the downloaded image */
+        uint8_t  Trailer[DFU_DIGEST_SIZE]; /*!< The last downloaded bytes, which aren't digested yet */
+        uint8_t  TrailerLength;         /*!< The number of downloaded bytes in Trailer */
+    }Digest;
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+    struct {
+        uint8_t* Address;               /*!< Firmware address of the programmed block */
+        uint16_t Length;                /*!< Length of the programmed block, 0 if there is none */
+        uint8_t  Index;                 /*!< Buffer index of the programmed block */
+        uint8_t  Erase;                 /*!< The ongoing operation is an erase */
+        volatile uint8_t Busy;          /*!< Erase or Write operation is ongoing */
+    }Program;
+    uint8_t RxIndex;                    /*!< Buffer index of the next downloaded block */
+#endif
     USBD_DFU_StatusDataType DevStatus;  /*!< Device DFU status */
 }USBD_DFU_IfHandleType;
 
@@ -207,6 +261,11 @@ void            USBD_DFU_AppInit        (USBD_DFU_IfHandleType *itf,
  * @{ */
 USBD_ReturnType USBD_DFU_MountInterface (USBD_DFU_IfHandleType *itf,
                                          USBD_HandleType *dev);
+
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+void            USBD_DFU_AppComplete    (USBD_DFU_IfHandleType *itf,
+                                         USBD_DFU_StatusType status);
+#endif
 /** @} */
 
 /** @} */
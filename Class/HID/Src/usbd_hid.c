@@ -22,9 +22,14 @@
   */
 #include <usbd_internal.h>
 #include <usbd_hid.h>
+#include <usbd_ring.h>
 
 #define HID_SUB_DESC_COUNT              1
 
+#if (USBD_HID_SCHEDULED_REPORTS > 0) && (USBD_SOF_SUPPORT != 1)
+#error "The HID report scheduler requires USBD_SOF_SUPPORT!"
+#endif
+
 #if (USBD_HID_ALTSETTINGS != 0)
 #define HID_APP(ITF)    ((USBD_HID_AppType*)(&(ITF)->App[(ITF)->Base.AltSelector]))
 #else
@@ -97,6 +102,12 @@ static void             hid_dataStage   (USBD_HID_IfHandleType *itf);
 #if (USBD_HID_OUT_SUPPORT == 1)
 static void             hid_outData     (USBD_HID_IfHandleType *itf, USBD_EpHandleType *ep);
 #endif
+#if (USBD_HID_SCHEDULED_REPORTS > 0) || (USBD_HID_REPORT_QUEUE == 1)
+static void             hid_inData      (USBD_HID_IfHandleType *itf, USBD_EpHandleType *ep);
+#endif
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+static void             hid_sof         (USBD_HID_IfHandleType *itf);
+#endif
 
 
 /* HID interface class callbacks structure */
@@ -114,6 +125,12 @@ static const USBD_ClassType hid_cbks = {
 #if (USBD_HID_OUT_SUPPORT == 1)
     .OutData        = (USBD_IfEpCbkType)    hid_outData,
 #endif
+#if (USBD_HID_SCHEDULED_REPORTS > 0) || (USBD_HID_REPORT_QUEUE == 1)
+    .InData         = (USBD_IfEpCbkType)    hid_inData,
+#endif
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+    .Sof            = (USBD_IfCbkType)      hid_sof,
+#endif
 };
 
 /** @ingroup USBD_HID
@@ -175,14 +192,12 @@ static uint16_t hid_getDesc(USBD_HID_IfHandleType *itf, uint8_t ifNum, uint8_t *
 
     /* Add endpoints */
     len += USBD_EpDesc(dev, itf->Config.InEp.Num, &dest[len]);
-    dest[len - 1] = itf->Config.InEp.Interval;
 
 #if (USBD_HID_OUT_SUPPORT == 1)
     if (itf->Config.OutEp.Size > 0)
     {
         desc->HID.bNumEndpoints = 2;
         len += USBD_EpDesc(dev, itf->Config.OutEp.Num, &dest[len]);
-        dest[len - 1] = itf->Config.OutEp.Interval;
     }
 #endif /* (USBD_HID_OUT_SUPPORT == 1) */
 
@@ -223,13 +238,13 @@ static void hid_init(USBD_HID_IfHandleType *itf)
 
     /* Open EPs */
     USBD_EpOpen(dev, itf->Config.InEp.Num,
-            USB_EP_TYPE_INTERRUPT, itf->Config.InEp.Size);
+            USB_EP_TYPE_INTERRUPT, itf->Config.InEp.Size, USBD_EP_OPT_NONE);
 
 #if (USBD_HID_OUT_SUPPORT == 1)
     if (itf->Config.OutEp.Size > 0)
     {
         USBD_EpOpen(dev, itf->Config.OutEp.Num,
-                USB_EP_TYPE_INTERRUPT, itf->Config.OutEp.Size);
+                USB_EP_TYPE_INTERRUPT, itf->Config.OutEp.Size, USBD_EP_OPT_NONE);
     }
 #endif /* (USBD_HID_OUT_SUPPORT == 1) */
 
@@ -237,6 +252,27 @@ static void hid_init(USBD_HID_IfHandleType *itf)
     itf->Request = 0;
     itf->IdleRate = itf->Config.InEp.Interval / 4;
 
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+    {
+        uint8_t i;
+
+        for (i = 0; i < USBD_HID_SCHEDULED_REPORTS; i++)
+        {
+            itf->Reports[i].Length     = 0;
+            itf->Reports[i].Elapsed_ms = 0;
+            itf->Reports[i].IdleRate   = itf->IdleRate;
+            itf->Reports[i].Pending    = 0;
+        }
+        itf->Sending = USBD_HID_SCHEDULED_REPORTS;
+        itf->Next = 0;
+        itf->Microframes = 0;
+    }
+#endif
+#if (USBD_HID_REPORT_QUEUE == 1)
+    itf->Queue.Head = itf->Queue.Tail = 0;
+    itf->Queue.InFlight = 0;
+#endif
+
     /* Initialize application */
     USBD_SAFE_CALLBACK(HID_APP(itf)->Init, );
 }
@@ -269,6 +305,136 @@ static void hid_deinit(USBD_HID_IfHandleType *itf)
 #endif /* (USBD_HID_OUT_SUPPORT == 1) */
 }
 
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+/**
+ * @brief Returns the scheduled input report of the report ID.
+ * @param itf: reference of the HID interface
+ * @param reportId: the report ID (ignored if the report IDs aren't used)
+ * @return Reference of the scheduled report, or NULL if the ID isn't scheduled
+ */
+static USBD_HID_ScheduledReportType* hid_scheduledReport(USBD_HID_IfHandleType *itf,
+        uint8_t reportId)
+{
+    uint8_t index = (HID_APP(itf)->Report.IDs == 0) ? 0 : (reportId - 1);
+
+    return (index < USBD_HID_SCHEDULED_REPORTS) ? &itf->Reports[index] : NULL;
+}
+
+/**
+ * @brief Sends the next scheduled input report which is either changed
+ *        or whose idle period has expired, if the IN endpoint is available.
+ *        The reports are checked in a circular order, so all of them get their turn.
+ * @param itf: reference of the HID interface
+ */
+static void hid_schedule(USBD_HID_IfHandleType *itf)
+{
+    uint8_t i;
+
+    for (i = 0; (i < USBD_HID_SCHEDULED_REPORTS) &&
+                (itf->Sending == USBD_HID_SCHEDULED_REPORTS); i++)
+    {
+        uint8_t index = (itf->Next + i) % USBD_HID_SCHEDULED_REPORTS;
+        USBD_HID_ScheduledReportType *report = &itf->Reports[index];
+
+        if ((report->Length > 0) &&
+            ((report->Pending != 0) ||
+             ((report->IdleRate != 0) && (report->Elapsed_ms >= (4 * report->IdleRate)))))
+        {
+            itf->Sending = index;
+
+            if (USBD_HID_ReportIn(itf, report->Data, report->Length) == USBD_E_OK)
+            {
+                report->Pending = 0;
+                report->Elapsed_ms = 0;
+                itf->Next = (index + 1) % USBD_HID_SCHEDULED_REPORTS;
+            }
+            else
+            {
+                /* The endpoint is occupied by the application, retry later */
+                itf->Sending = USBD_HID_SCHEDULED_REPORTS;
+                break;
+            }
+        }
+    }
+}
+#endif /* (USBD_HID_SCHEDULED_REPORTS > 0) */
+
+#if (USBD_HID_REPORT_QUEUE == 1)
+/**
+ * @brief Sends the queued input reports if the IN endpoint is available.
+ *        Up to Batch contiguously stored reports are packed into one transfer.
+ * @param itf: reference of the HID interface
+ */
+static void hid_queueSend(USBD_HID_IfHandleType *itf)
+{
+    uint16_t count = itf->Queue.Head - itf->Queue.Tail;
+
+    if ((itf->Queue.InFlight == 0) && (count > 0))
+    {
+        uint16_t index = itf->Queue.Tail & (itf->Config.Queue.Depth - 1);
+        uint16_t len = itf->Config.Queue.Depth - index;
+
+        USBD_RING_BARRIER();
+
+        if (len > count)
+        {   len = count; }
+        if (len > itf->Config.Queue.Batch)
+        {   len = (itf->Config.Queue.Batch > 0) ? itf->Config.Queue.Batch : 1; }
+
+        if (USBD_EpSend(itf->Base.Device, itf->Config.InEp.Num,
+                &itf->Config.Queue.Buffer[index * itf->Config.Queue.ReportSize],
+                len * itf->Config.Queue.ReportSize) == USBD_E_OK)
+        {
+            itf->Queue.InFlight = len;
+        }
+    }
+}
+#endif /* (USBD_HID_REPORT_QUEUE == 1) */
+
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+/**
+ * @brief Requests the next chunk of the report from the application.
+ * @param itf: reference of the HID interface
+ * @param data: the control endpoint buffer to fill
+ * @param offset: the offset of the chunk in the report
+ * @param len: the length of the chunk
+ * @return The length of the provided data
+ */
+static uint16_t hid_getReportChunk(USBD_HID_IfHandleType *itf,
+        uint8_t *data, uint16_t offset, uint16_t len)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint16_t retval;
+
+    itf->Request = dev->Request.Value >> 8;
+    retval = HID_APP(itf)->GetReportChunk((uint8_t)dev->Request.Value, data, offset, len);
+    itf->Request = 0;
+
+    return retval;
+}
+
+/**
+ * @brief Passes the received chunk of the report to the application.
+ * @param itf: reference of the HID interface
+ * @param data: the control endpoint buffer holding the chunk
+ * @param offset: the offset of the chunk in the report
+ * @param len: the length of the chunk
+ * @return The length of the accepted data
+ */
+static uint16_t hid_setReportChunk(USBD_HID_IfHandleType *itf,
+        uint8_t *data, uint16_t offset, uint16_t len)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint16_t retval;
+
+    itf->Request = dev->Request.Value >> 8;
+    retval = HID_APP(itf)->SetReportChunk((uint8_t)dev->Request.Value, data, offset, len);
+    itf->Request = 0;
+
+    return retval;
+}
+#endif /* (USBD_CTRL_CHUNK_SUPPORT == 1) */
+
 /**
  * @brief Performs the interface-specific setup request handling.
  * @param itf: reference of the HID interface
@@ -279,14 +445,14 @@ static USBD_ReturnType hid_setupStage(USBD_HID_IfHandleType *itf)
     USBD_ReturnType retval = USBD_E_ERROR;
     USBD_HandleType *dev = itf->Base.Device;
 
-    switch (dev->Setup.RequestType.Type)
+    switch (dev->Request.RequestType.Type)
     {
         case USB_REQ_TYPE_STANDARD:
         {
             /* HID specific descriptors can be requested */
-            if (dev->Setup.Request == USB_REQ_GET_DESCRIPTOR)
+            if (dev->Request.Request == USB_REQ_GET_DESCRIPTOR)
             {
-                switch (dev->Setup.Value >> 8)
+                switch (dev->Request.Value >> 8)
                 {
                     /* Return HID class descriptor */
                     case HID_DESC_TYPE_HID:
@@ -312,43 +478,75 @@ static USBD_ReturnType hid_setupStage(USBD_HID_IfHandleType *itf)
 
         case USB_REQ_TYPE_CLASS:
         {
-            uint8_t reportId = (uint8_t)dev->Setup.Value;
+            uint8_t reportId = (uint8_t)dev->Request.Value;
 
-            switch (dev->Setup.Request)
+            switch (dev->Request.Request)
             {
                 /* HID report IN */
                 case HID_REQ_GET_REPORT:
                 {
-                    /* Set flag, invoke callback which should provide data
-                     * via USBD_HID_ReportIn() */
-                    itf->Request = dev->Setup.Value >> 8;
-                    USBD_SAFE_CALLBACK(HID_APP(itf)->GetReport, reportId);
-
-                    if (itf->Request == 0)
-                    {   retval = USBD_E_OK; }
-                    itf->Request = 0;
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+                    /* The report is provided in chunks, so it can be longer
+                     * than the control endpoint buffer */
+                    if (HID_APP(itf)->GetReportChunk != NULL)
+                    {
+                        retval = USBD_CtrlSendChunked(dev, dev->Request.Length,
+                                (USBD_CtrlChunkCbkType)hid_getReportChunk, itf);
+                    }
+                    else
+#endif
+                    {
+                        /* Set flag, invoke callback which should provide data
+                         * via USBD_HID_ReportIn() */
+                        itf->Request = dev->Request.Value >> 8;
+                        USBD_SAFE_CALLBACK(HID_APP(itf)->GetReport, reportId);
+
+                        if (itf->Request == 0)
+                        {   retval = USBD_E_OK; }
+                        itf->Request = 0;
+                    }
                     break;
                 }
 
                 /* HID report OUT */
                 case HID_REQ_SET_REPORT:
                 {
-                    uint8_t* data = dev->CtrlData;
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+                    /* The report is consumed in chunks, so it can be longer
+                     * than the control endpoint buffer */
+                    if (HID_APP(itf)->SetReportChunk != NULL)
+                    {
+                        retval = USBD_CtrlReceiveChunked(dev,
+                                (USBD_CtrlChunkCbkType)hid_setReportChunk, itf);
+                    }
+                    else
+#endif
+                    {
+                        uint8_t* data = dev->CtrlData;
 
-                    /* If report IDs are used, the ID shall be placed
-                     * on the first byte */
-                    if (reportId != 0)
-                    {   data += 4; }
+                        /* If report IDs are used, the ID shall be placed
+                         * on the first byte */
+                        if (reportId != 0)
+                        {   data += 4; }
 
-                    retval = USBD_CtrlReceiveData(dev, data);
+                        retval = USBD_CtrlReceiveData(dev, data);
+                    }
                     break;
                 }
 
                 /* Send 1 byte idle rate */
                 case HID_REQ_GET_IDLE:
-                    retval = USBD_CtrlSendData(dev,
-                            &itf->IdleRate, sizeof(itf->IdleRate));
+                {
+                    uint8_t *idleRate = &itf->IdleRate;
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+                    USBD_HID_ScheduledReportType *report = hid_scheduledReport(itf, reportId);
+
+                    if ((reportId != 0) && (report != NULL))
+                    {   idleRate = &report->IdleRate; }
+#endif
+                    retval = USBD_CtrlSendData(dev, idleRate, sizeof(*idleRate));
                     break;
+                }
 
                 case HID_REQ_SET_IDLE:
                 {
@@ -359,14 +557,28 @@ static USBD_ReturnType hid_setupStage(USBD_HID_IfHandleType *itf)
                      * 0 - applies to all records
                      * x - record ID x only */
                     uint16_t idleRate_ms = HID_IDLE_RATE_INDEFINITE;
-                    uint8_t idleRate = dev->Setup.Value >> 8;
+                    uint8_t idleRate = dev->Request.Value >> 8;
 
                     /* Save only global config */
                     if (reportId == 0)
                     {   itf->IdleRate = idleRate; }
 
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+                    {
+                        USBD_HID_ScheduledReportType *report = hid_scheduledReport(itf, reportId);
+                        uint8_t i;
+
+                        /* The scheduler applies the idle rate per report ID */
+                        for (i = 0; i < USBD_HID_SCHEDULED_REPORTS; i++)
+                        {
+                            if ((reportId == 0) || (&itf->Reports[i] == report))
+                            {   itf->Reports[i].IdleRate = idleRate; }
+                        }
+                    }
+#endif
+
                     if (idleRate > 0)
-                    {   idleRate_ms = 4 * itf->IdleRate; }
+                    {   idleRate_ms = 4 * idleRate; }
 
                     USBD_SAFE_CALLBACK(HID_APP(itf)->SetIdle,
                             idleRate_ms, reportId);
@@ -402,21 +614,28 @@ static void hid_dataStage(USBD_HID_IfHandleType *itf)
 {
     USBD_HandleType *dev = itf->Base.Device;
 
-    if (dev->Setup.Request == HID_REQ_SET_REPORT)
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    if (HID_APP(itf)->SetReportChunk != NULL)
+    {
+        /* The chunks are already passed to the application */
+    }
+    else
+#endif
+    if (dev->Request.Request == HID_REQ_SET_REPORT)
     {
-        uint16_t len = dev->Setup.Length;
+        uint16_t len = dev->Request.Length;
         uint8_t* data = dev->CtrlData;
 
-        if ((dev->Setup.Value & 0xFF) != 0)
+        if ((dev->Request.Value & 0xFF) != 0)
         {
             /* First byte is report ID from setup */
             data += 3;
-            data[0] = (uint8_t)dev->Setup.Value;
+            data[0] = (uint8_t)dev->Request.Value;
             len++;
         }
 
         /* Set ctrl context and hand over received data to App */
-        itf->Request = dev->Setup.Value >> 8;
+        itf->Request = dev->Request.Value >> 8;
         USBD_SAFE_CALLBACK(HID_APP(itf)->SetReport, data, len);
         itf->Request = 0;
     }
@@ -435,6 +654,80 @@ static void hid_outData(USBD_HID_IfHandleType *itf, USBD_EpHandleType *ep)
 }
 #endif /* (USBD_HID_OUT_SUPPORT == 1) */
 
+#if (USBD_HID_SCHEDULED_REPORTS > 0) || (USBD_HID_REPORT_QUEUE == 1)
+/**
+ * @brief Releases the transmitted reports, and sends the next queued or due ones.
+ * @param itf: reference of the HID interface
+ * @param ep: reference to the endpoint structure
+ */
+static void hid_inData(USBD_HID_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    (void)ep;
+#if (USBD_HID_REPORT_QUEUE == 1)
+    if (itf->Queue.InFlight > 0)
+    {
+        USBD_RING_BARRIER();
+        itf->Queue.Tail += itf->Queue.InFlight;
+        itf->Queue.InFlight = 0;
+    }
+    hid_queueSend(itf);
+#endif
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+    itf->Sending = USBD_HID_SCHEDULED_REPORTS;
+
+    hid_schedule(itf);
+#endif
+}
+#endif
+
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+
+/**
+ * @brief Advances the idle timers of the scheduled reports by each frame,
+ *        and sends the next due report.
+ * @param itf: reference of the HID interface
+ */
+static void hid_sof(USBD_HID_IfHandleType *itf)
+{
+    uint8_t tick = 1;
+    uint8_t i;
+
+#if (USBD_HS_SUPPORT == 1)
+    /* A frame consists of 8 microframes at high speed */
+    if (itf->Base.Device->Speed == USB_SPEED_HIGH)
+    {
+        itf->Microframes = (itf->Microframes + 1) % 8;
+        tick = (itf->Microframes == 0);
+    }
+#endif
+
+    if (tick != 0)
+    {
+        for (i = 0; i < USBD_HID_SCHEDULED_REPORTS; i++)
+        {
+            if (itf->Reports[i].Elapsed_ms < 0xFFFF)
+            {   itf->Reports[i].Elapsed_ms++; }
+        }
+
+        hid_schedule(itf);
+    }
+}
+#endif /* (USBD_HID_SCHEDULED_REPORTS > 0) */
+
+/**
+ * @brief Sets the polling interval and the high speed bandwidth of the endpoint.
+ * @param ep: reference of the endpoint handle
+ * @param cfg: reference of the endpoint setup
+ */
+static void hid_epTiming(USBD_EpHandleType *ep, const USBD_HID_EpConfigType *cfg)
+{
+    ep->Interval        = cfg->Interval;
+#if (USBD_HS_SUPPORT == 1)
+    ep->IntervalHS      = (cfg->IntervalHS != 0) ? cfg->IntervalHS : cfg->Interval;
+    ep->Transactions    = cfg->Transactions;
+#endif
+}
+
 /** @} */
 
 /** @defgroup USBD_HID_Exported_Functions HID Exported Functions
@@ -468,6 +761,7 @@ USBD_ReturnType USBD_HID_MountInterface(USBD_HID_IfHandleType *itf, USBD_HandleT
             ep->Type            = USB_EP_TYPE_INTERRUPT;
             ep->MaxPacketSize   = itf->Config.InEp.Size;
             ep->IfNum           = dev->IfCount;
+            hid_epTiming(ep, &itf->Config.InEp);
 
 #if (USBD_HID_OUT_SUPPORT == 1)
             /* OUT EP is optional */
@@ -477,6 +771,7 @@ USBD_ReturnType USBD_HID_MountInterface(USBD_HID_IfHandleType *itf, USBD_HandleT
                 ep->Type            = USB_EP_TYPE_INTERRUPT;
                 ep->MaxPacketSize   = itf->Config.OutEp.Size;
                 ep->IfNum           = dev->IfCount;
+                hid_epTiming(ep, &itf->Config.OutEp);
             }
 #endif /* (USBD_HID_OUT_SUPPORT == 1) */
         }
@@ -502,7 +797,7 @@ USBD_ReturnType USBD_HID_ReportIn(USBD_HID_IfHandleType *itf, uint8_t *data, uin
 {
     USBD_ReturnType retval;
     USBD_HandleType *dev = itf->Base.Device;
-    uint8_t reportId = (uint8_t)dev->Setup.Value;
+    uint8_t reportId = (uint8_t)dev->Request.Value;
 
     /* If the function is invoked in the EP0 GetReport() callback context,
      * and the report ID matches, use EP0 to transfer the report */
@@ -531,6 +826,89 @@ USBD_ReturnType USBD_HID_ReportIn(USBD_HID_IfHandleType *itf, uint8_t *data, uin
     return retval;
 }
 
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+/**
+ * @brief Provides the current state of an input report to the scheduler.
+ *        The report is only sent when it differs from the last sent one,
+ *        otherwise it's repeated at the idle rate of its report ID.
+ * @note  This function shall not be interrupted by the USB device callbacks.
+ * @param itf: reference of the HID interface
+ * @param data: pointer to the report (starting with the report ID if they are used)
+ * @param length: length of the report
+ * @return INVALID if the report isn't scheduled, BUSY if its previous state is still
+ *         being transmitted, OK if successful
+ */
+USBD_ReturnType USBD_HID_ReportUpdate(USBD_HID_IfHandleType *itf, const uint8_t *data,
+        uint16_t length)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+    USBD_HID_ScheduledReportType *report = hid_scheduledReport(itf, data[0]);
+
+    if ((report == NULL) || (length == 0) || (length > USBD_HID_SCHEDULED_REPORT_SIZE))
+    {
+        /* Not a scheduled report */
+    }
+    else if (itf->Sending == (report - itf->Reports))
+    {
+        retval = USBD_E_BUSY;
+    }
+    else
+    {
+        /* Only the changes are transmitted immediately */
+        if ((report->Length != length) || (memcmp(report->Data, data, length) != 0))
+        {
+            memcpy(report->Data, data, length);
+            report->Length  = length;
+            report->Pending = 1;
+        }
+
+        hid_schedule(itf);
+        retval = USBD_E_OK;
+    }
+    return retval;
+}
+#endif /* (USBD_HID_SCHEDULED_REPORTS > 0) */
+
+#if (USBD_HID_REPORT_QUEUE == 1)
+/**
+ * @brief Appends an input report to the interface's queue, which is sent
+ *        as soon as the previously queued reports are collected by the host.
+ * @note  This function shall not preempt the USB device interrupt,
+ *        nor be interrupted by it.
+ * @param itf: reference of the HID interface
+ * @param data: pointer to the report
+ * @param length: length of the report, equal to the configured report size
+ * @return INVALID if the length doesn't match, BUSY if the queue is full, OK if successful
+ */
+USBD_ReturnType USBD_HID_ReportEnqueue(USBD_HID_IfHandleType *itf, const uint8_t *data,
+        uint16_t length)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+
+    if (length != itf->Config.Queue.ReportSize)
+    {
+        /* Only fixed size reports can be packed */
+    }
+    else if ((uint16_t)(itf->Queue.Head - itf->Queue.Tail) >= itf->Config.Queue.Depth)
+    {
+        retval = USBD_E_BUSY;
+    }
+    else
+    {
+        uint16_t index = itf->Queue.Head & (itf->Config.Queue.Depth - 1);
+
+        memcpy(&itf->Config.Queue.Buffer[index * length], data, length);
+
+        USBD_RING_BARRIER();
+        itf->Queue.Head++;
+
+        hid_queueSend(itf);
+        retval = USBD_E_OK;
+    }
+    return retval;
+}
+#endif /* (USBD_HID_REPORT_QUEUE == 1) */
+
 #if (USBD_HID_OUT_SUPPORT == 1)
 /**
  * @brief Receives a report through the HID OUT endpoint.
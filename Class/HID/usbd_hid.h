@@ -42,6 +42,24 @@ extern "C"
 
 #define HID_IDLE_RATE_INDEFINITE        0xFFFF
 
+/* When set to non-zero, the input reports of this many report IDs are scheduled
+ * by the start of frames (requires USBD_SOF_SUPPORT): @ref USBD_HID_ReportUpdate
+ * only sends the changed reports, and repeats the unchanged ones at their idle rate */
+#ifndef USBD_HID_SCHEDULED_REPORTS
+#define USBD_HID_SCHEDULED_REPORTS      0
+#endif
+
+/* The largest scheduled input report size, including the report ID */
+#ifndef USBD_HID_SCHEDULED_REPORT_SIZE
+#define USBD_HID_SCHEDULED_REPORT_SIZE  64
+#endif
+
+/* When set to 1, the input reports can be queued with @ref USBD_HID_ReportEnqueue,
+ * the queue is drained by the IN transfer completions */
+#ifndef USBD_HID_REPORT_QUEUE
+#define USBD_HID_REPORT_QUEUE           0
+#endif
+
 /** @} */
 
 /** @defgroup USBD_HID_Exported_Types HID Exported Types
@@ -101,6 +119,10 @@ typedef struct {
     uint8_t  Num;       /*!< Endpoint address */
     uint8_t  Interval;  /*!< Endpoint frame interval */
     uint16_t Size;      /*!< Endpoint max packet size */
+#if (USBD_HS_SUPPORT == 1)
+    uint8_t  IntervalHS;   /*!< Endpoint interval at high speed, 0 to use Interval */
+    uint8_t  Transactions; /*!< Additional transactions per microframe at high speed (0..2) */
+#endif
 }USBD_HID_EpConfigType;
 
 
@@ -108,7 +130,7 @@ typedef struct {
 typedef struct {
     const uint8_t*  Desc;   /*!< Pointer to the report descriptor */
     uint16_t        Length; /*!< Byte size of the report descriptor */
-    uint8_t         IDs;    /*!< unused */
+    uint8_t         IDs;    /*!< Number of report IDs, 0 if report IDs aren't used */
 }USBD_HID_ReportDescType;
 
 
@@ -130,9 +152,41 @@ typedef struct
                          uint8_t reportId); /*!< Limit the IN reporting frequency */
 
     USBD_HID_ReportDescType Report;         /*!< The Report descriptor */
+
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    uint16_t (*SetReportChunk)  (uint8_t reportId,
+                                 uint8_t * data,
+                                 uint16_t offset,
+                                 uint16_t length);  /*!< Process a part of a report received
+                                                         on the control pipe, return the accepted length
+                                                         @note Optional, replaces SetReport
+                                                         for the control pipe when set */
+
+    uint16_t (*GetReportChunk)  (uint8_t reportId,
+                                 uint8_t * data,
+                                 uint16_t offset,
+                                 uint16_t length);  /*!< Provide a part of a report requested
+                                                         on the control pipe, return the provided length
+                                                         (a shorter one ends the report)
+                                                         @note Optional, replaces GetReport when set */
+#endif
 }USBD_HID_AppType;
 
 
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+/** @brief HID scheduled input report */
+typedef struct
+{
+    uint8_t  Data[USBD_HID_SCHEDULED_REPORT_SIZE]
+                  __align(USBD_DATA_ALIGNMENT); /*!< The last provided report */
+    uint16_t Length;                            /*!< Length of the report, 0 if not provided yet */
+    uint16_t Elapsed_ms;                        /*!< Time since the report was last sent */
+    uint8_t  IdleRate;                          /*!< Idle rate of the report [4 ms], 0 is indefinite */
+    uint8_t  Pending;                           /*!< The changed report waits for transmission */
+}USBD_HID_ScheduledReportType;
+#endif
+
+
 /** @brief HID interface configuration */
 typedef struct
 {
@@ -140,6 +194,15 @@ typedef struct
 #if (USBD_HID_OUT_SUPPORT == 1)
     USBD_HID_EpConfigType OutEp; /*!< OUT endpoint setup */
 #endif
+#if (USBD_HID_REPORT_QUEUE == 1)
+    struct {
+        uint8_t *Buffer;         /*!< Storage of Depth * ReportSize bytes, aligned to USBD_DATA_ALIGNMENT */
+        uint16_t ReportSize;     /*!< Size of each queued input report */
+        uint8_t  Depth;          /*!< Number of reports the queue holds, a power of 2 */
+        uint8_t  Batch;          /*!< Maximal number of reports packed into one transfer,
+                                      when the report descriptor declares an array of samples */
+    }Queue;                      /*!< Input report queue setup */
+#endif
 }USBD_HID_ConfigType;
 
 
@@ -153,9 +216,24 @@ typedef struct
     /* HID class internal context */
     uint8_t IdleRate;               /*!< Contains the current idle rate
                                          @note Report ID separate idle rates are
-                                         not readable with the current API. */
+                                         only readable with the report scheduler. */
     volatile uint8_t Request;       /*!< Holds the @ref USBD_HID_ReportType during
                                          control report transfers, otherwise it is 0 */
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+    USBD_HID_ScheduledReportType Reports[USBD_HID_SCHEDULED_REPORTS]; /*!< Scheduled input reports,
+                                                                          indexed by report ID - 1 */
+    volatile uint8_t Sending;       /*!< Index of the report in transmission,
+                                         USBD_HID_SCHEDULED_REPORTS if none */
+    uint8_t Next;                   /*!< Index of the report which is checked first */
+    uint8_t Microframes;            /*!< High speed microframe counter */
+#endif
+#if (USBD_HID_REPORT_QUEUE == 1)
+    struct {
+        volatile uint16_t Head;     /*!< Free-running write index, modified by the producer */
+        volatile uint16_t Tail;     /*!< Free-running read index, modified by the IN completion */
+        volatile uint8_t InFlight;  /*!< Number of reports in the ongoing transfer */
+    }Queue;                         /*!< Input report queue state */
+#endif
 }USBD_HID_IfHandleType;
 
 /** @} */
@@ -169,6 +247,18 @@ USBD_ReturnType USBD_HID_ReportIn       (USBD_HID_IfHandleType *itf,
                                          uint8_t *data,
                                          uint16_t length);
 
+#if (USBD_HID_SCHEDULED_REPORTS > 0)
+USBD_ReturnType USBD_HID_ReportUpdate   (USBD_HID_IfHandleType *itf,
+                                         const uint8_t *data,
+                                         uint16_t length);
+#endif
+
+#if (USBD_HID_REPORT_QUEUE == 1)
+USBD_ReturnType USBD_HID_ReportEnqueue  (USBD_HID_IfHandleType *itf,
+                                         const uint8_t *data,
+                                         uint16_t length);
+#endif
+
 #if (USBD_HID_OUT_SUPPORT == 1)
 USBD_ReturnType USBD_HID_ReportOut      (USBD_HID_IfHandleType *itf,
                                          uint8_t *data,
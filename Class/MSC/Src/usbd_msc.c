@@ -121,6 +121,21 @@ static uint16_t MSC_GetDesc(USBD_MSC_IfHandleType *itf, uint8_t ifNum, uint8_t *
     }
 #endif
 
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    /* UAS alternate setting */
+    {
+        USB_InterfaceDescType *uasDesc = (USB_InterfaceDescType*)&dest[len];
+
+        memcpy(uasDesc, desc, sizeof(msc_desc));
+        uasDesc->bAlternateSetting  = 1;
+        uasDesc->bNumEndpoints      = 4;
+        uasDesc->bInterfaceProtocol = MSC_PROT_UAS;
+        len += sizeof(msc_desc);
+
+        len += MSC_UAS_EpDesc(itf, &dest[len]);
+    }
+#endif
+
     return len;
 }
 
@@ -136,6 +151,32 @@ static const char* MSC_GetString(USBD_MSC_IfHandleType *itf, uint8_t intNum)
     return MSC_GetLU(itf,0)->Inquiry->ProductId;
 }
 
+#if (USBD_MSC_CACHE_LINES > 0)
+/**
+ * @brief Writes back the cached data of all LUs, if it was requested by a BOT reset.
+ * @param itf: reference of the MSC interface
+ */
+static void MSC_CacheFlushPending(USBD_MSC_IfHandleType *itf)
+{
+    if (itf->CacheFlushPending != 0)
+    {
+        uint8_t lun;
+
+        itf->CacheFlushPending = 0;
+
+        for (lun = 0; lun <= itf->Config.MaxLUN; lun++)
+        {
+            const USBD_MSC_LUType *LU = MSC_GetLU(itf, lun);
+
+            if (MSC_CacheUsable(LU) != 0)
+            {
+                (void)MSC_CacheFlush(LU);
+            }
+        }
+    }
+}
+#endif /* (USBD_MSC_CACHE_LINES > 0) */
+
 /**
  * @brief Initiate the reception of the CBW through the OUT pipe.
  * @param itf: reference of the MSC interface
@@ -160,6 +201,40 @@ static void MSC_SendCSW(USBD_MSC_IfHandleType *itf)
     MSC_ReceiveCBW(itf);
 }
 
+/**
+ * @brief Terminates the block data transport when the SCSI layer has finished it:
+ *        sends the CSW when all data is written, or STALLs the data endpoint
+ *        after a failure once its ongoing transfer is completed.
+ * @param itf: reference of the MSC interface
+ */
+static void MSC_DataTransport(USBD_MSC_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+
+    if (itf->CSW.bStatus != MSC_CSW_CMD_PASSED)
+    {
+        if (itf->SCSI.XferBusy != 0)
+        {
+            /* STALL when the ongoing transfer completes */
+        }
+        else if (itf->State == MSC_STATE_DATA_OUT)
+        {
+            itf->State = MSC_STATE_STALL;
+            USBD_EpSetStall(dev, itf->Config.OutEpNum);
+        }
+        else
+        {
+            itf->State = MSC_STATE_STALL;
+            USBD_EpSetStall(dev, itf->Config.InEpNum);
+        }
+    }
+    /* Write completed, send status */
+    else if ((itf->State == MSC_STATE_DATA_OUT) && (itf->SCSI.RemLength == 0))
+    {
+        MSC_SendCSW(itf);
+    }
+}
+
 /**
  * @brief Initializes the interface by opening its endpoints.
  * @param itf: reference of the MSC interface
@@ -181,14 +256,38 @@ static void MSC_Init(USBD_MSC_IfHandleType *itf)
     }
 
     /* Open EPs */
-    USBD_EpOpen(dev, itf->Config.InEpNum , USB_EP_TYPE_BULK, mps);
-    USBD_EpOpen(dev, itf->Config.OutEpNum, USB_EP_TYPE_BULK, mps);
+    USBD_EpOpen(dev, itf->Config.InEpNum , USB_EP_TYPE_BULK, mps,
+            USBD_EP_OPT_DOUBLE_BUFFER);
+    USBD_EpOpen(dev, itf->Config.OutEpNum, USB_EP_TYPE_BULK, mps,
+            USBD_EP_OPT_DOUBLE_BUFFER);
 
-    /* Initialize BOT layer */
-    itf->Status = MSC_STATUS_NORMAL;
-    itf->CSW.dSignature = MSC_CSW_SIGNATURE;
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    if (itf->Base.AltSelector != 0)
+    {
+        USBD_EpOpen(dev, itf->Config.StatusEpNum, USB_EP_TYPE_BULK, mps,
+                USBD_EP_OPT_NONE);
+        USBD_EpOpen(dev, itf->Config.CmdEpNum   , USB_EP_TYPE_BULK, mps,
+                USBD_EP_OPT_NONE);
 
-    MSC_ReceiveCBW(itf);
+        /* Initialize UAS layer */
+        MSC_UAS_Init(itf);
+    }
+    else
+#endif
+    {
+        /* Initialize BOT layer */
+        itf->Status = MSC_STATUS_NORMAL;
+#if (USBD_MSC_CACHE_LINES > 0)
+        itf->CacheFlushPending = 0;
+#endif
+#if (USBD_MSC_UAS_SUPPORT == 1)
+        /* The commands use the buffers of the first UAS queue slot */
+        itf->Buffer = itf->UAS.Buffers;
+#endif
+        itf->CSW.dSignature = MSC_CSW_SIGNATURE;
+
+        MSC_ReceiveCBW(itf);
+    }
 }
 
 /**
@@ -203,10 +302,22 @@ static void MSC_Deinit(USBD_MSC_IfHandleType *itf)
     USBD_EpClose(dev, itf->Config.InEpNum);
     USBD_EpClose(dev, itf->Config.OutEpNum);
 
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    if (itf->Base.AltSelector != 0)
+    {
+        USBD_EpClose(dev, itf->Config.StatusEpNum);
+        USBD_EpClose(dev, itf->Config.CmdEpNum);
+    }
+#endif
+
 #if (USBD_HS_SUPPORT == 1)
     /* Reset the endpoint MPS to the desired size */
     dev->EP.IN [itf->Config.InEpNum  & 0xF].MaxPacketSize =
     dev->EP.OUT[itf->Config.OutEpNum      ].MaxPacketSize = MSC_DATA_PACKET_SIZE;
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    dev->EP.IN [itf->Config.StatusEpNum & 0xF].MaxPacketSize =
+    dev->EP.OUT[itf->Config.CmdEpNum        ].MaxPacketSize = MSC_DATA_PACKET_SIZE;
+#endif
 #endif
 }
 
@@ -220,11 +331,11 @@ static USBD_ReturnType MSC_SetupStage(USBD_MSC_IfHandleType *itf)
     USBD_ReturnType retval = USBD_E_INVALID;
     USBD_HandleType *dev = itf->Base.Device;
 
-    switch (dev->Setup.RequestType.Type)
+    switch (dev->Request.RequestType.Type)
     {
         case USB_REQ_TYPE_CLASS:
         {
-            switch (dev->Setup.Request)
+            switch (dev->Request.Request)
             {
                 case MSC_BOT_GET_MAX_LUN:
                 {
@@ -234,6 +345,11 @@ static USBD_ReturnType MSC_SetupStage(USBD_MSC_IfHandleType *itf)
                 }
                 case MSC_BOT_RESET:
                 {
+#if (USBD_MSC_CACHE_LINES > 0)
+                    /* The write-back takes too long for the control request,
+                     * it's performed before the next command */
+                    itf->CacheFlushPending = 1;
+#endif
                     itf->Status = MSC_STATUS_RECOVERY;
                     retval = USBD_E_OK;
                     break;
@@ -255,8 +371,14 @@ static USBD_ReturnType MSC_SetupStage(USBD_MSC_IfHandleType *itf)
  */
 static void MSC_InData(USBD_MSC_IfHandleType *itf, USBD_EpHandleType *ep)
 {
-    USBD_HandleType *dev = itf->Base.Device;
-
+    (void)ep;
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    if (itf->Base.AltSelector != 0)
+    {
+        MSC_UAS_InData(itf, ep);
+    }
+    else
+#endif
     switch (itf->State)
     {
         /* Keep sending the read data */
@@ -265,11 +387,7 @@ static void MSC_InData(USBD_MSC_IfHandleType *itf, USBD_EpHandleType *ep)
             /* Continue with READ10 command */
             SCSI_ProcessRead(itf);
 
-            if (itf->CSW.bStatus != MSC_CSW_CMD_PASSED)
-            {
-                itf->State = MSC_STATE_STALL;
-                USBD_EpSetStall(dev, itf->Config.InEpNum);
-            }
+            MSC_DataTransport(itf);
             break;
         }
 
@@ -299,6 +417,13 @@ static void MSC_OutData(USBD_MSC_IfHandleType *itf, USBD_EpHandleType *ep)
 {
     USBD_HandleType *dev = itf->Base.Device;
 
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    if (itf->Base.AltSelector != 0)
+    {
+        MSC_UAS_OutData(itf, ep);
+    }
+    else
+#endif
     switch (itf->State)
     {
         /* Command Transport */
@@ -316,6 +441,12 @@ static void MSC_OutData(USBD_MSC_IfHandleType *itf, USBD_EpHandleType *ep)
                 (itf->CBW.bCBLength > 0) &&
                 (itf->CBW.bCBLength <= 16))
             {
+#if (USBD_MSC_CACHE_LINES > 0)
+                MSC_CacheFlushPending(itf);
+#endif
+                /* A terminated transport's LU access isn't waited for */
+                itf->SCSI.MediaBusy = 0;
+
                 SCSI_ProcessCommand(itf);
 
                 /* Send command status */
@@ -323,6 +454,12 @@ static void MSC_OutData(USBD_MSC_IfHandleType *itf, USBD_EpHandleType *ep)
                 {
                     MSC_SendCSW(itf);
                 }
+                /* Block data transport is started */
+                else if ((itf->State == MSC_STATE_DATA_IN) ||
+                         (itf->State == MSC_STATE_DATA_OUT))
+                {
+                    MSC_DataTransport(itf);
+                }
                 /* Treat rejected command */
                 else if (itf->CSW.bStatus != MSC_CSW_CMD_PASSED)
                 {
@@ -360,16 +497,7 @@ static void MSC_OutData(USBD_MSC_IfHandleType *itf, USBD_EpHandleType *ep)
             /* Continue with WRITE10 command */
             SCSI_ProcessWrite(itf);
 
-            if (itf->CSW.bStatus != MSC_CSW_CMD_PASSED)
-            {
-                itf->State = MSC_STATE_STALL;
-                USBD_EpSetStall(dev, itf->Config.OutEpNum);
-            }
-            /* Write completed, send status */
-            else if (itf->CSW.dDataResidue == 0)
-            {
-                MSC_SendCSW(itf);
-            }
+            MSC_DataTransport(itf);
             break;
         }
 
@@ -414,17 +542,41 @@ const USBD_MSC_LUType* MSC_GetLU(USBD_MSC_IfHandleType *itf, uint8_t lun)
  * @param dev: reference of the USB Device
  * @return OK if the mounting was successful,
  *         ERROR if it failed due to insufficient device interface slots
+ *         (or insufficient arena space for the block buffers)
  */
 USBD_ReturnType USBD_MSC_MountInterface(USBD_MSC_IfHandleType *itf, USBD_HandleType *dev)
 {
     USBD_ReturnType retval = USBD_E_ERROR;
 
+#if (USBD_ARENA_BLOCK_COUNT > 0) && (USBD_MSC_UAS_SUPPORT == 1)
+    /* The block buffers of each queue slot are allocated at the first mounting */
+    if (itf->UAS.Buffers == NULL)
+    {
+        itf->UAS.Buffers = USBD_ArenaAlloc(sizeof(*itf->UAS.Buffers) *
+                USBD_MSC_BUFFER_COUNT * USBD_MSC_UAS_QUEUE_DEPTH);
+    }
+
+    if ((dev->IfCount < USBD_MAX_IF_COUNT) && (itf->UAS.Buffers != NULL))
+#elif (USBD_ARENA_BLOCK_COUNT > 0)
+    /* The block buffers are allocated at the first mounting */
+    if (itf->Buffer == NULL)
+    {
+        itf->Buffer = USBD_ArenaAlloc(sizeof(*itf->Buffer) * USBD_MSC_BUFFER_COUNT);
+    }
+
+    if ((dev->IfCount < USBD_MAX_IF_COUNT) && (itf->Buffer != NULL))
+#else
     if (dev->IfCount < USBD_MAX_IF_COUNT)
+#endif
     {
         /* Binding interfaces */
         itf->Base.Device = dev;
         itf->Base.Class  = &msc_cbks;
+#if (USBD_MSC_UAS_SUPPORT == 1)
+        itf->Base.AltCount = 2;
+#else
         itf->Base.AltCount = 1;
+#endif
         itf->Base.AltSelector = 0;
 
         {
@@ -439,6 +591,18 @@ USBD_ReturnType USBD_MSC_MountInterface(USBD_MSC_IfHandleType *itf, USBD_HandleT
             ep->Type            = USB_EP_TYPE_BULK;
             ep->MaxPacketSize   = MSC_DATA_PACKET_SIZE;
             ep->IfNum           = dev->IfCount;
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+            ep = &dev->EP.IN [itf->Config.StatusEpNum & 0xF];
+            ep->Type            = USB_EP_TYPE_BULK;
+            ep->MaxPacketSize   = MSC_DATA_PACKET_SIZE;
+            ep->IfNum           = dev->IfCount;
+
+            ep = &dev->EP.OUT[itf->Config.CmdEpNum];
+            ep->Type            = USB_EP_TYPE_BULK;
+            ep->MaxPacketSize   = MSC_DATA_PACKET_SIZE;
+            ep->IfNum           = dev->IfCount;
+#endif
         }
 
         dev->IF[dev->IfCount] = (USBD_IfHandleType*)itf;
@@ -450,4 +614,40 @@ USBD_ReturnType USBD_MSC_MountInterface(USBD_MSC_IfHandleType *itf, USBD_HandleT
     return retval;
 }
 
+/**
+ * @brief Notifies the MSC interface that the LU has completed the block access
+ *        which it has accepted by returning BUSY from its Read or Write call,
+ *        and continues the block data transport.
+ * @note  This function shall not be called from within the LU Read or Write call,
+ *        and it shall not preempt the USB device interrupt.
+ * @param itf: reference of the MSC interface
+ * @param status: OK if the block access was successful, ERROR otherwise
+ */
+void USBD_MSC_LUComplete(USBD_MSC_IfHandleType *itf, USBD_ReturnType status)
+{
+    if (itf->SCSI.MediaBusy == 0)
+    {
+        /* Not expected */
+    }
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    else if (itf->Base.AltSelector != 0)
+    {
+        /* The LU access belongs to one of the queued commands */
+        MSC_UAS_MediaComplete(itf, status);
+    }
+#endif
+    else if ((itf->State == MSC_STATE_DATA_IN) ||
+             (itf->State == MSC_STATE_DATA_OUT))
+    {
+        SCSI_MediaComplete(itf, status);
+
+        MSC_DataTransport(itf);
+    }
+    else
+    {
+        /* The transport has been terminated in the meantime */
+        itf->SCSI.MediaBusy = 0;
+    }
+}
+
 /** @} */
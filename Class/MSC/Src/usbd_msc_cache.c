@@ -0,0 +1,352 @@
+/**
+  ******************************************************************************
+  * @file    usbd_msc_cache.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Mass Storage Class
+  *          Logical Unit write-back cache
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+#include <usbd_msc_private.h>
+
+#if (USBD_MSC_CACHE_LINES > 0)
+
+/** @ingroup USBD_MSC
+ * @defgroup USBD_MSC_Private_Functions_Cache MSC Private Functions Cache
+ * @{ */
+
+/**
+ * @brief Returns the number of blocks stored in a cache line.
+ * @param LU: reference of the logical unit
+ * @return The number of blocks per line
+ */
+static inline uint32_t MSC_CacheLineBlocks(const USBD_MSC_LUType *LU)
+{
+    return USBD_MSC_CACHE_LINE_SIZE / LU->Status->BlockSize;
+}
+
+/**
+ * @brief Returns the bitmask of a block range within a cache line.
+ * @param offset: the first block's index in the line
+ * @param blockLen: the number of blocks
+ * @return The bitmask of the blocks
+ */
+static inline uint32_t MSC_CacheMask(uint32_t offset, uint32_t blockLen)
+{
+    uint32_t mask = (blockLen < 32) ? ((1UL << blockLen) - 1) : 0xFFFFFFFF;
+
+    return mask << offset;
+}
+
+/**
+ * @brief Looks up the cache line which holds the selected line of the LU.
+ * @param LU: reference of the logical unit
+ * @param tag: the line index in the LU
+ * @return Reference of the cache line, or NULL if the line isn't cached
+ */
+static USBD_MSC_CacheLineType* MSC_CacheFind(const USBD_MSC_LUType *LU, uint32_t tag)
+{
+    USBD_MSC_CacheLineType *line = NULL;
+    uint32_t i;
+
+    for (i = 0; i < USBD_MSC_CACHE_LINES; i++)
+    {
+        if ((LU->Cache->Line[i].ValidMask != 0) &&
+            (LU->Cache->Line[i].Tag == tag))
+        {
+            line = &LU->Cache->Line[i];
+            break;
+        }
+    }
+    return line;
+}
+
+/**
+ * @brief Writes the dirty cache line to the LU. The blocks of the line
+ *        which haven't been written are read beforehand, so the entire
+ *        (erase sector sized) line is written at once.
+ * @param LU: reference of the logical unit
+ * @param line: reference of the cache line
+ * @return Result of the LU access
+ */
+static USBD_ReturnType MSC_CacheLineFlush(const USBD_MSC_LUType *LU,
+        USBD_MSC_CacheLineType *line)
+{
+    USBD_ReturnType retval = USBD_E_OK;
+    uint32_t blocks = MSC_CacheLineBlocks(LU);
+    uint32_t blockAddr = line->Tag * blocks;
+    uint32_t i;
+
+    if (line->Dirty != 0)
+    {
+        /* The last line might exceed the LU */
+        if (blocks > (LU->Status->BlockCount - blockAddr))
+        {   blocks = LU->Status->BlockCount - blockAddr; }
+
+        for (i = 0; (i < blocks) && (retval == USBD_E_OK); i++)
+        {
+            if ((line->ValidMask & MSC_CacheMask(i, 1)) == 0)
+            {
+                retval = LU->Read(&line->Data[i * LU->Status->BlockSize],
+                        blockAddr + i, 1);
+            }
+        }
+
+        if (retval == USBD_E_OK)
+        {
+            line->ValidMask = MSC_CacheMask(0, blocks);
+
+            retval = LU->Write(line->Data, blockAddr, blocks);
+        }
+
+        if (retval == USBD_E_OK)
+        {
+            line->Dirty = 0;
+        }
+        else
+        {
+            retval = USBD_E_ERROR;
+        }
+    }
+    return retval;
+}
+
+/**
+ * @brief Provides a cache line for the selected line of the LU,
+ *        by evicting the least recently used line if necessary.
+ * @param LU: reference of the logical unit
+ * @param tag: the line index in the LU
+ * @return Reference of the cache line, or NULL if the eviction failed
+ */
+static USBD_MSC_CacheLineType* MSC_CacheAlloc(const USBD_MSC_LUType *LU, uint32_t tag)
+{
+    USBD_MSC_CacheLineType *line = MSC_CacheFind(LU, tag);
+    uint32_t i;
+
+    if (line == NULL)
+    {
+        line = &LU->Cache->Line[0];
+
+        /* Select an empty or the least recently used line */
+        for (i = 1; (i < USBD_MSC_CACHE_LINES) && (line->ValidMask != 0); i++)
+        {
+            if ((LU->Cache->Line[i].ValidMask == 0) ||
+                ((LU->Cache->UseCount - LU->Cache->Line[i].LastUse) >
+                 (LU->Cache->UseCount - line->LastUse)))
+            {
+                line = &LU->Cache->Line[i];
+            }
+        }
+
+        if (MSC_CacheLineFlush(LU, line) == USBD_E_OK)
+        {
+            line->Tag = tag;
+            line->ValidMask = 0;
+        }
+        else
+        {
+            line = NULL;
+        }
+    }
+    return line;
+}
+
+/**
+ * @brief Reads blocks from the LU, using the cached data where available.
+ * @param LU: reference of the logical unit
+ * @param dest: the destination buffer
+ * @param blockAddr: the first block's address
+ * @param blockLen: the number of blocks to read
+ * @return Result of the block read operation
+ */
+USBD_ReturnType MSC_CacheRead(const USBD_MSC_LUType *LU,
+        uint8_t *dest, uint32_t blockAddr, uint16_t blockLen)
+{
+    USBD_ReturnType retval = USBD_E_OK;
+    uint32_t blocks = MSC_CacheLineBlocks(LU);
+    uint16_t blockSize = LU->Status->BlockSize;
+
+    while ((blockLen > 0) && (retval == USBD_E_OK))
+    {
+        uint32_t offset = blockAddr % blocks;
+        uint32_t len = blocks - offset;
+        USBD_MSC_CacheLineType *line = MSC_CacheFind(LU, blockAddr / blocks);
+
+        if (len > blockLen)
+        {   len = blockLen; }
+
+        if (line == NULL)
+        {
+            /* Line isn't cached, read directly */
+            retval = LU->Read(dest, blockAddr, len);
+        }
+        else
+        {
+            uint32_t i;
+
+            line->LastUse = ++LU->Cache->UseCount;
+
+            for (i = 0; (i < len) && (retval == USBD_E_OK); i++)
+            {
+                if ((line->ValidMask & MSC_CacheMask(offset + i, 1)) != 0)
+                {
+                    memcpy(&dest[i * blockSize],
+                            &line->Data[(offset + i) * blockSize], blockSize);
+                }
+                else
+                {
+                    retval = LU->Read(&dest[i * blockSize], blockAddr + i, 1);
+                }
+            }
+        }
+
+        dest      += len * blockSize;
+        blockAddr += len;
+        blockLen  -= len;
+    }
+    return (retval == USBD_E_OK) ? USBD_E_OK : USBD_E_ERROR;
+}
+
+/**
+ * @brief Writes blocks to the cache, merging them with the already
+ *        cached data of their lines.
+ * @param LU: reference of the logical unit
+ * @param src: the source buffer
+ * @param blockAddr: the first block's address
+ * @param blockLen: the number of blocks to write
+ * @return Result of the block write operation
+ */
+USBD_ReturnType MSC_CacheWrite(const USBD_MSC_LUType *LU,
+        uint8_t *src, uint32_t blockAddr, uint16_t blockLen)
+{
+    USBD_ReturnType retval = USBD_E_OK;
+    uint32_t blocks = MSC_CacheLineBlocks(LU);
+    uint16_t blockSize = LU->Status->BlockSize;
+
+    while ((blockLen > 0) && (retval == USBD_E_OK))
+    {
+        uint32_t offset = blockAddr % blocks;
+        uint32_t len = blocks - offset;
+        USBD_MSC_CacheLineType *line = MSC_CacheAlloc(LU, blockAddr / blocks);
+
+        if (len > blockLen)
+        {   len = blockLen; }
+
+        if (line == NULL)
+        {
+            retval = USBD_E_ERROR;
+        }
+        else
+        {
+            memcpy(&line->Data[offset * blockSize], src, len * blockSize);
+
+            line->ValidMask |= MSC_CacheMask(offset, len);
+            line->Dirty = 1;
+            line->LastUse = ++LU->Cache->UseCount;
+        }
+
+        src       += len * blockSize;
+        blockAddr += len;
+        blockLen  -= len;
+    }
+    return retval;
+}
+
+/**
+ * @brief Writes all dirty cache lines to the LU.
+ * @param LU: reference of the logical unit
+ * @return Result of the block write operations
+ */
+USBD_ReturnType MSC_CacheFlush(const USBD_MSC_LUType *LU)
+{
+    USBD_ReturnType retval = USBD_E_OK;
+    uint32_t i;
+
+    for (i = 0; i < USBD_MSC_CACHE_LINES; i++)
+    {
+        if (MSC_CacheLineFlush(LU, &LU->Cache->Line[i]) != USBD_E_OK)
+        {
+            retval = USBD_E_ERROR;
+        }
+    }
+    return retval;
+}
+
+/**
+ * @brief Drops the cache lines which are entirely within the discarded block range,
+ *        so their data isn't written back to the LU.
+ * @param LU: reference of the logical unit
+ * @param blockAddr: the first block's address
+ * @param blockLen: the number of discarded blocks
+ */
+void MSC_CacheDiscard(const USBD_MSC_LUType *LU, uint32_t blockAddr, uint32_t blockLen)
+{
+    uint32_t blocks = MSC_CacheLineBlocks(LU);
+    uint32_t i;
+
+    for (i = 0; i < USBD_MSC_CACHE_LINES; i++)
+    {
+        USBD_MSC_CacheLineType *line = &LU->Cache->Line[i];
+        uint32_t lineAddr = line->Tag * blocks;
+
+        if ((line->ValidMask != 0) && (lineAddr >= blockAddr) &&
+            ((lineAddr - blockAddr + blocks) <= blockLen))
+        {
+            line->ValidMask = 0;
+            line->Dirty = 0;
+        }
+    }
+}
+
+/**
+ * @brief Checks whether the cache of the LU can be used with its current block size.
+ *        The lines cached with a different block size are dropped,
+ *        as their blocks are no longer addressable.
+ * @param LU: reference of the logical unit
+ * @return 1 if the LU has a cache which holds 1 to 32 blocks per line, 0 otherwise
+ */
+uint8_t MSC_CacheUsable(const USBD_MSC_LUType *LU)
+{
+    uint32_t blockSize = LU->Status->BlockSize;
+    uint8_t usable = 0;
+
+    if (LU->Cache != NULL)
+    {
+        if (LU->Cache->BlockSize != blockSize)
+        {
+            uint32_t i;
+
+            /* The geometry of the LU changed */
+            for (i = 0; i < USBD_MSC_CACHE_LINES; i++)
+            {
+                LU->Cache->Line[i].ValidMask = 0;
+                LU->Cache->Line[i].Dirty = 0;
+            }
+            LU->Cache->BlockSize = blockSize;
+        }
+
+        usable = (blockSize != 0) &&
+                 (blockSize <= USBD_MSC_CACHE_LINE_SIZE) &&
+                 ((USBD_MSC_CACHE_LINE_SIZE / blockSize) <= 32);
+    }
+    return usable;
+}
+
+/** @} */
+
+#endif /* (USBD_MSC_CACHE_LINES > 0) */
@@ -28,6 +28,115 @@
  * @defgroup USBD_MSC_Private_Functions_SCSI MSC Private Functions SCSI
  * @{ */
 
+/**
+ * @brief Reads a big-endian 16-bit field of a SCSI command or parameter list.
+ * @param src: the field's location
+ * @return The field value
+ */
+static inline uint16_t SCSI_Get16(const uint8_t *src)
+{
+    return ((uint16_t)src[0] << 8) | src[1];
+}
+
+/**
+ * @brief Reads a big-endian 32-bit field of a SCSI command or parameter list.
+ * @param src: the field's location
+ * @return The field value
+ */
+static inline uint32_t SCSI_Get32(const uint8_t *src)
+{
+    return ((uint32_t)SCSI_Get16(&src[0]) << 16) | SCSI_Get16(&src[2]);
+}
+
+/**
+ * @brief Reads a big-endian 64-bit field of a SCSI command or parameter list.
+ * @param src: the field's location
+ * @return The field value
+ */
+static inline uint64_t SCSI_Get64(const uint8_t *src)
+{
+    return ((uint64_t)SCSI_Get32(&src[0]) << 32) | SCSI_Get32(&src[4]);
+}
+
+/**
+ * @brief Writes a big-endian 16-bit field of a SCSI response.
+ * @param dest: the field's location
+ * @param value: the field value
+ */
+static inline void SCSI_Put16(uint8_t *dest, uint16_t value)
+{
+    dest[0] = value >> 8;
+    dest[1] = value;
+}
+
+/**
+ * @brief Writes a big-endian 32-bit field of a SCSI response.
+ * @param dest: the field's location
+ * @param value: the field value
+ */
+static inline void SCSI_Put32(uint8_t *dest, uint32_t value)
+{
+    SCSI_Put16(&dest[0], value >> 16);
+    SCSI_Put16(&dest[2], value);
+}
+
+/**
+ * @brief Writes a big-endian 64-bit field of a SCSI response.
+ * @param dest: the field's location
+ * @param value: the field value
+ */
+static inline void SCSI_Put64(uint8_t *dest, uint64_t value)
+{
+    SCSI_Put32(&dest[0], value >> 32);
+    SCSI_Put32(&dest[4], value);
+}
+
+/**
+ * @brief Decodes the block range of the current READ, WRITE or VERIFY command.
+ * @param itf: reference of the MSC interface
+ * @param blockAddr: the first block's address
+ * @param blockLen: the number of blocks
+ */
+static void SCSI_GetBlockRange(USBD_MSC_IfHandleType *itf,
+        uint64_t *blockAddr, uint32_t *blockLen)
+{
+    const uint8_t *cb = itf->CBW.CB;
+
+    switch (cb[0])
+    {
+        case SCSI_READ16:
+        case SCSI_WRITE16:
+            *blockAddr = SCSI_Get64(&cb[2]);
+            *blockLen  = SCSI_Get32(&cb[10]);
+            break;
+
+        case SCSI_READ12:
+        case SCSI_WRITE12:
+            *blockAddr = SCSI_Get32(&cb[2]);
+            *blockLen  = SCSI_Get32(&cb[6]);
+            break;
+
+        default: /* 10 byte commands */
+            *blockAddr = SCSI_Get32(&cb[2]);
+            *blockLen  = SCSI_Get16(&cb[7]);
+            break;
+    }
+}
+
+/**
+ * @brief Checks whether the block range is within the LU.
+ * @param LU: reference of the logical unit
+ * @param blockAddr: the first block's address
+ * @param blockLen: the number of blocks
+ * @return Non-zero if the range is valid
+ */
+static inline int SCSI_BlockRangeValid(const USBD_MSC_LUType *LU,
+        uint64_t blockAddr, uint32_t blockLen)
+{
+    return (blockAddr <= LU->Status->BlockCount) &&
+           (blockLen <= (LU->Status->BlockCount - blockAddr));
+}
+
 /**
  * @brief Returns the reference of the last SCSI Sense data.
  * @param itf: reference of the MSC interface
@@ -54,89 +163,599 @@ void SCSI_PutSenseCode(USBD_MSC_IfHandleType *itf,
 }
 
 /**
- * @brief Reads data from the current block to the transfer buffer
- *        and sends it over the IN endpoint.
+ * @brief Sets up the fixed format sense data of the last SCSI sense code.
  * @param itf: reference of the MSC interface
- * @return Result of the current block read operation
+ * @param dest: the destination of the sense data
+ * @return The length of the sense data
  */
-USBD_ReturnType SCSI_ProcessRead(USBD_MSC_IfHandleType *itf)
+uint32_t SCSI_GetSenseData(USBD_MSC_IfHandleType *itf, uint8_t *dest)
+{
+    struct {
+        uint8_t ResponseCode;
+        uint8_t __reserved0;
+        uint8_t SenseKey;
+        uint8_t Information[4];
+        uint8_t AddLength;
+        uint8_t CmdSpecific[4];
+        uint8_t ASC;
+        uint8_t ASCQ;
+        uint8_t FRUC;
+        uint8_t SenseKeySpecific[3];
+    }*data = (void*)dest;
+    USBD_SCSI_SenseType* sense = SCSI_GetSenseCode(itf);
+
+    memset(data, 0, sizeof(*data));
+    data->ResponseCode = 0x70;
+    data->AddLength    = sizeof(*data) - 7;
+
+    if (sense != NULL)
+    {
+        data->SenseKey = sense->Key;
+        data->ASC      = sense->ASC;
+    }
+
+    return sizeof(*data);
+}
+
+/**
+ * @brief Returns the index of the transfer buffer which follows
+ *        the current USB transfer buffer by the given offset.
+ * @param itf: reference of the MSC interface
+ * @param offset: number of buffers to step forward
+ * @return The index of the transfer buffer
+ */
+static inline uint8_t SCSI_BufferIndex(USBD_MSC_IfHandleType *itf, uint8_t offset)
+{
+    return (itf->SCSI.BufIndex + offset) % USBD_MSC_BUFFER_COUNT;
+}
+
+/**
+ * @brief Evaluates the result of a block read or write operation.
+ *        A successful access advances the block range, a failure sets the sense data,
+ *        while a BUSY result indicates that the LU completes the operation asynchronously.
+ * @param itf: reference of the MSC interface
+ * @param retval: the result of the LU access
+ * @return OK if the access is completed or ongoing, ERROR if it failed
+ */
+static USBD_ReturnType SCSI_MediaResult(USBD_MSC_IfHandleType *itf, USBD_ReturnType retval)
+{
+    if (retval == USBD_E_BUSY)
+    {
+        /* Wait for USBD_MSC_LUComplete() */
+        itf->SCSI.MediaBusy = 1;
+        retval = USBD_E_OK;
+    }
+    else
+    {
+        itf->SCSI.MediaBusy = 0;
+
+        if (retval == USBD_E_OK)
+        {
+            const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+            uint32_t len = sizeof(itf->Buffer[0]);
+
+            if (len > itf->SCSI.RemLength)
+            {   len = itf->SCSI.RemLength; }
+
+            itf->SCSI.Address += len / LU->Status->BlockSize;
+            itf->SCSI.RemLength -= len;
+
+            /* The read buffer is filled, or the written buffer is released */
+            if (itf->State == MSC_STATE_DATA_IN)
+            {   itf->SCSI.BufPending++; }
+            else
+            {   itf->SCSI.BufPending--; }
+        }
+        else if (itf->State == MSC_STATE_DATA_IN)
+        {
+            SCSI_PutSenseCode(itf, SCSI_SKEY_HARDWARE_ERROR,
+                    SCSI_ASC_UNRECOVERED_READ_ERROR);
+        }
+        else
+        {
+            SCSI_PutSenseCode(itf, SCSI_SKEY_HARDWARE_ERROR,
+                    SCSI_ASC_WRITE_FAULT);
+        }
+    }
+    return retval;
+}
+
+/**
+ * @brief Reads the next data chunk from the current block
+ *        to the first free transfer buffer.
+ * @param itf: reference of the MSC interface
+ * @return Result of the block read operation
+ */
+static USBD_ReturnType SCSI_MediaRead(USBD_MSC_IfHandleType *itf)
 {
     USBD_ReturnType retval;
     const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
-    uint32_t len = sizeof(itf->Buffer);
+    uint8_t *data = itf->Buffer[SCSI_BufferIndex(itf, itf->SCSI.BufPending)];
+    uint32_t len = sizeof(itf->Buffer[0]);
 
     if (len > itf->SCSI.RemLength)
     {   len = itf->SCSI.RemLength; }
 
-    retval = LU->Read(itf->Buffer,
-            itf->SCSI.Address / LU->Status->BlockSize,
-            len / LU->Status->BlockSize);
+#if (USBD_MSC_CACHE_LINES > 0)
+    if (MSC_CACHE_USED(itf))
+    {
+        retval = MSC_CacheRead(LU, data,
+                itf->SCSI.Address,
+                len / LU->Status->BlockSize);
+    }
+    else
+#endif
+    {
+        retval = LU->Read(data,
+                itf->SCSI.Address,
+                len / LU->Status->BlockSize);
+    }
+    return SCSI_MediaResult(itf, retval);
+}
+
+/**
+ * @brief Writes the oldest received data chunk to the current block.
+ * @param itf: reference of the MSC interface
+ * @return Result of the block write operation
+ */
+static USBD_ReturnType SCSI_MediaWrite(USBD_MSC_IfHandleType *itf)
+{
+    USBD_ReturnType retval;
+    const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    uint8_t *data = itf->Buffer[SCSI_BufferIndex(itf,
+            USBD_MSC_BUFFER_COUNT - itf->SCSI.BufPending)];
+    uint32_t len = sizeof(itf->Buffer[0]);
+
+    if (len > itf->SCSI.RemLength)
+    {   len = itf->SCSI.RemLength; }
+
+#if (USBD_MSC_CACHE_LINES > 0)
+    if (MSC_CACHE_USED(itf))
+    {
+        retval = MSC_CacheWrite(LU, data,
+                itf->SCSI.Address,
+                len / LU->Status->BlockSize);
+    }
+    else
+#endif
+    {
+        retval = LU->Write(data,
+                itf->SCSI.Address,
+                len / LU->Status->BlockSize);
+    }
+    return SCSI_MediaResult(itf, retval);
+}
+
+/**
+ * @brief Returns the length of the next directly transferred data chunk,
+ *        which is the largest possible transfer of whole blocks.
+ * @param itf: reference of the MSC interface
+ * @return The length of the data chunk
+ */
+static uint32_t SCSI_DirectLength(USBD_MSC_IfHandleType *itf)
+{
+    const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    uint32_t len = 0xFFFF - (0xFFFF % LU->Status->BlockSize);
+
+    if (len > itf->SCSI.RemLength)
+    {   len = itf->SCSI.RemLength; }
+
+    return len;
+}
+
+/**
+ * @brief Transfers the next data chunk of the current block directly
+ *        from or to the LU memory, if it's accessible and properly aligned.
+ * @param itf: reference of the MSC interface
+ * @return OK if the direct transfer is started, INVALID if the chunk
+ *         has to be transferred through the buffers
+ */
+static USBD_ReturnType SCSI_DirectNext(USBD_MSC_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+    const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    uint32_t len = SCSI_DirectLength(itf);
+    uint8_t *data = NULL;
+
+#if (USBD_MSC_CACHE_LINES > 0)
+    if (MSC_CACHE_USED(itf))
+    {
+        /* The cached data is only accessible through the buffers */
+    }
+    else
+#endif
+    if (LU->GetBlock != NULL)
+    {
+        data = LU->GetBlock(itf->SCSI.Address,
+                len / LU->Status->BlockSize, itf->State == MSC_STATE_DATA_OUT);
+    }
+
+    if ((data != NULL) && (((uintptr_t)data % USBD_DATA_ALIGNMENT) == 0))
+    {
+        itf->SCSI.XferBusy = 1;
+        itf->SCSI.Direct = 1;
+
+        if (itf->State == MSC_STATE_DATA_OUT)
+        {
+            USBD_EpReceive(itf->Base.Device, itf->Config.OutEpNum, data, len);
+        }
+        else
+        {
+            USBD_EpSend(itf->Base.Device, itf->Config.InEpNum, data, len);
+
+            itf->CSW.dDataResidue -= len;
+
+            if (itf->CSW.dDataResidue == 0)
+            {
+                /* Next transfer is CSW */
+                itf->State = MSC_STATE_STATUS_IN;
+            }
+        }
+        retval = USBD_E_OK;
+    }
+    return retval;
+}
+
+/**
+ * @brief Completes the direct transfer of the current data chunk.
+ * @param itf: reference of the MSC interface
+ */
+static void SCSI_DirectComplete(USBD_MSC_IfHandleType *itf)
+{
+    const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    uint32_t len = SCSI_DirectLength(itf);
+
+    itf->SCSI.Address += len / LU->Status->BlockSize;
+    itf->SCSI.RemLength -= len;
+    itf->SCSI.Direct = 0;
+}
+
+/**
+ * @brief Sends the buffered data chunks over the IN endpoint, and reads
+ *        the following chunks to the free transfer buffers, as long as
+ *        neither the endpoint nor the LU is busy.
+ * @param itf: reference of the MSC interface
+ * @return Result of the block read operations
+ */
+static USBD_ReturnType SCSI_ReadNext(USBD_MSC_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_OK;
+
+    do
+    {
+        /* Bypass the buffers when the memory is directly accessible */
+        if ((itf->SCSI.XferBusy == 0) && (itf->SCSI.MediaBusy == 0) &&
+            (itf->SCSI.BufPending == 0) && (itf->SCSI.RemLength > 0) &&
+            (SCSI_DirectNext(itf) == USBD_E_OK))
+        {
+            break;
+        }
+
+        /* Send the oldest filled buffer when the endpoint is idle */
+        if ((itf->SCSI.XferBusy == 0) && (itf->SCSI.BufPending > 0) &&
+            (itf->CSW.dDataResidue > 0))
+        {
+            uint32_t len = sizeof(itf->Buffer[0]);
+
+            if (len > itf->CSW.dDataResidue)
+            {   len = itf->CSW.dDataResidue; }
+
+            itf->SCSI.XferBusy = 1;
+            USBD_EpSend(itf->Base.Device, itf->Config.InEpNum,
+                    itf->Buffer[itf->SCSI.BufIndex], len);
+
+            itf->CSW.dDataResidue -= len;
+
+            if (itf->CSW.dDataResidue == 0)
+            {
+                /* Next transfer is CSW */
+                itf->State = MSC_STATE_STATUS_IN;
+            }
+        }
+
+        /* Fill the next free buffer when the LU is idle */
+        if ((itf->SCSI.MediaBusy == 0) && (itf->SCSI.RemLength > 0) &&
+            (itf->SCSI.BufPending < USBD_MSC_BUFFER_COUNT))
+        {
+            retval = SCSI_MediaRead(itf);
+        }
+        else
+        {
+            break;
+        }
+    }
+    while (retval == USBD_E_OK);
+
+    return retval;
+}
+
+/**
+ * @brief Prepares the OUT endpoint to receive the next data chunk to a free buffer,
+ *        and writes the received chunks to the current block, as long as
+ *        neither the endpoint nor the LU is busy.
+ * @param itf: reference of the MSC interface
+ * @return Result of the block write operations
+ */
+static USBD_ReturnType SCSI_WriteNext(USBD_MSC_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_OK;
+
+    do
+    {
+        /* Bypass the buffers when the memory is directly accessible */
+        if ((itf->SCSI.XferBusy == 0) && (itf->SCSI.MediaBusy == 0) &&
+            (itf->SCSI.BufPending == 0) && (itf->SCSI.RemLength > 0) &&
+            (SCSI_DirectNext(itf) == USBD_E_OK))
+        {
+            break;
+        }
+
+        /* Receive to the next free buffer when the endpoint is idle */
+        if ((itf->SCSI.XferBusy == 0) && (itf->CSW.dDataResidue > 0) &&
+            (itf->SCSI.BufPending < USBD_MSC_BUFFER_COUNT))
+        {
+            uint32_t len = sizeof(itf->Buffer[0]);
+
+            if (len > itf->CSW.dDataResidue)
+            {   len = itf->CSW.dDataResidue; }
+
+            itf->SCSI.XferBusy = 1;
+            USBD_EpReceive(itf->Base.Device, itf->Config.OutEpNum,
+                    itf->Buffer[itf->SCSI.BufIndex], len);
+        }
+
+        /* Write the oldest received buffer when the LU is idle */
+        if ((itf->SCSI.MediaBusy == 0) && (itf->SCSI.BufPending > 0))
+        {
+            retval = SCSI_MediaWrite(itf);
+        }
+        else
+        {
+            break;
+        }
+    }
+    while (retval == USBD_E_OK);
+
+    return retval;
+}
+
+/**
+ * @brief Releases the buffer of the completed IN transfer,
+ *        and continues the block read operation.
+ * @param itf: reference of the MSC interface
+ * @return Result of the current block read operation
+ */
+USBD_ReturnType SCSI_ProcessRead(USBD_MSC_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_ERROR;
+
+    itf->SCSI.XferBusy = 0;
 
-    if (retval != USBD_E_OK)
+    if (itf->SCSI.Direct != 0)
     {
-        SCSI_PutSenseCode(itf, SCSI_SKEY_HARDWARE_ERROR,
-                SCSI_ASC_UNRECOVERED_READ_ERROR);
+        SCSI_DirectComplete(itf);
     }
     else
     {
-        USBD_HandleType *dev = itf->Base.Device;
+        itf->SCSI.BufPending--;
+        itf->SCSI.BufIndex = SCSI_BufferIndex(itf, 1);
+    }
+
+    if (itf->CSW.bStatus == MSC_CSW_CMD_PASSED)
+    {
+        retval = SCSI_ReadNext(itf);
+    }
+    return retval;
+}
+
+/**
+ * @brief Discards the block ranges of the received UNMAP parameter list.
+ *        No blocks are discarded if any of the ranges is invalid.
+ * @param itf: reference of the MSC interface
+ */
+static void SCSI_UnmapData(USBD_MSC_IfHandleType *itf)
+{
+    const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    const uint8_t *data = itf->Buffer[0];
+    uint32_t len = itf->SCSI.RemLength;
+    uint32_t i, last = 8;
+
+    itf->CSW.dDataResidue -= len;
+    itf->SCSI.RemLength = 0;
+
+    /* Unmap block descriptors follow the 8 byte header */
+    if (len >= 8)
+    {
+        last += SCSI_Get16(&data[2]);
+
+        if (last > len)
+        {   last = len; }
+    }
+
+    for (i = 8; ((i + 16) <= last) && (itf->CSW.bStatus == MSC_CSW_CMD_PASSED); i += 16)
+    {
+        if (!SCSI_BlockRangeValid(LU, SCSI_Get64(&data[i]), SCSI_Get32(&data[i + 8])))
+        {
+            SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                    SCSI_ASC_ADDRESS_OUT_OF_RANGE);
+        }
+    }
 
-        USBD_EpSend(dev, itf->Config.InEpNum, itf->Buffer, len);
+    for (i = 8; ((i + 16) <= last) && (itf->CSW.bStatus == MSC_CSW_CMD_PASSED); i += 16)
+    {
+        uint32_t blockAddr = SCSI_Get64(&data[i]);
+        uint32_t blockLen  = SCSI_Get32(&data[i + 8]);
 
-        itf->SCSI.Address += len;
-        itf->SCSI.RemLength -= len;
+        if (blockLen == 0)
+        {
+            /* Empty range */
+        }
+        else
+        {
+#if (USBD_MSC_CACHE_LINES > 0)
+            if (MSC_CACHE_USED(itf))
+            {
+                MSC_CacheDiscard(LU, blockAddr, blockLen);
+            }
+#endif
+            if (LU->Trim(blockAddr, blockLen) != USBD_E_OK)
+            {
+                SCSI_PutSenseCode(itf, SCSI_SKEY_MEDIUM_ERROR,
+                        SCSI_ASC_WRITE_FAULT);
+            }
+        }
+    }
+}
+
+/**
+ * @brief Queues the received data for writing to the current block,
+ *        and continues or terminates further block data reception.
+ * @param itf: reference of the MSC interface
+ * @return Result of the current block write operation
+ */
+USBD_ReturnType SCSI_ProcessWrite(USBD_MSC_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_ERROR;
+
+    itf->SCSI.XferBusy = 0;
+
+    if (itf->CBW.CB[0] == SCSI_UNMAP)
+    {
+        /* The parameter list is received, no further data is expected */
+        SCSI_UnmapData(itf);
+    }
+    else if (itf->SCSI.Direct != 0)
+    {
+        /* The data is already in place */
+        itf->CSW.dDataResidue -= SCSI_DirectLength(itf);
+        SCSI_DirectComplete(itf);
+    }
+    else
+    {
+        uint32_t len = sizeof(itf->Buffer[0]);
+
+        if (len > itf->CSW.dDataResidue)
+        {   len = itf->CSW.dDataResidue; }
+
+        itf->CSW.dDataResidue -= len;
+        itf->SCSI.BufPending++;
+        itf->SCSI.BufIndex = SCSI_BufferIndex(itf, 1);
+    }
+
+    if (itf->CSW.bStatus == MSC_CSW_CMD_PASSED)
+    {
+        retval = SCSI_WriteNext(itf);
+    }
+    return retval;
+}
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+/**
+ * @brief Continues the block data transport of the current command,
+ *        when the LU is no longer busy with the access of another command.
+ * @param itf: reference of the MSC interface
+ * @return Result of the current block operation
+ */
+USBD_ReturnType SCSI_ProcessNext(USBD_MSC_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_OK;
+
+    if (itf->CSW.bStatus != MSC_CSW_CMD_PASSED)
+    {
+        /* The transport is being terminated */
+    }
+    else if (itf->State == MSC_STATE_DATA_IN)
+    {
+        retval = SCSI_ReadNext(itf);
+    }
+    else if (itf->State == MSC_STATE_DATA_OUT)
+    {
+        retval = SCSI_WriteNext(itf);
+    }
+    return retval;
+}
+#endif /* (USBD_MSC_UAS_SUPPORT == 1) */
 
-        itf->CSW.dDataResidue -= len;
+/**
+ * @brief Evaluates the result of the completed asynchronous LU access,
+ *        and continues the current block operation.
+ * @param itf: reference of the MSC interface
+ * @param status: the result of the LU access
+ * @return Result of the current block operation
+ */
+USBD_ReturnType SCSI_MediaComplete(USBD_MSC_IfHandleType *itf, USBD_ReturnType status)
+{
+    USBD_ReturnType retval = SCSI_MediaResult(itf,
+            (status == USBD_E_OK) ? USBD_E_OK : USBD_E_ERROR);
 
-        if (itf->SCSI.RemLength == 0)
-        {
-            /* Next transfer is CSW */
-            itf->State = MSC_STATE_STATUS_IN;
-        }
+    if (retval == USBD_E_OK)
+    {
+        if (itf->State == MSC_STATE_DATA_IN)
+        {   retval = SCSI_ReadNext(itf); }
+        else
+        {   retval = SCSI_WriteNext(itf); }
     }
     return retval;
 }
 
 /**
- * @brief Writes the received data to the current block, and continues or terminates
- *        further block data reception.
+ * @brief Sets up the requested Vital Product Data page.
  * @param itf: reference of the MSC interface
- * @return Result of the current block write operation
+ * @param pageCode: the requested @ref USBD_SCSI_VPDPageType
+ * @param dest: the destination of the VPD page
+ * @return The length of the VPD page
  */
-USBD_ReturnType SCSI_ProcessWrite(USBD_MSC_IfHandleType *itf)
+static uint32_t SCSI_InquiryVPD(USBD_MSC_IfHandleType *itf, uint8_t pageCode, uint8_t *dest)
 {
-    USBD_ReturnType retval;
     const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
-    uint32_t len = sizeof(itf->Buffer);
+    uint32_t len = 4;
 
-    if (len > itf->SCSI.RemLength)
-    {   len = itf->SCSI.RemLength; }
+    memset(dest, 0, 64);
 
-    retval = LU->Write(itf->Buffer,
-                itf->SCSI.Address / LU->Status->BlockSize,
-                len / LU->Status->BlockSize);
+    /* Peripheral qualifier and device type */
+    dest[0] = LU->Inquiry->__reserved[0];
+    dest[1] = pageCode;
 
-    if (retval != USBD_E_OK)
-    {
-        SCSI_PutSenseCode(itf, SCSI_SKEY_HARDWARE_ERROR,
-                SCSI_ASC_WRITE_FAULT);
-    }
-    else
+    switch (pageCode)
     {
-        itf->SCSI.Address += len;
-        itf->SCSI.RemLength -= len;
+        case SCSI_VPD_SUPPORTED_PAGES:
+            dest[len++] = SCSI_VPD_SUPPORTED_PAGES;
+            dest[len++] = SCSI_VPD_BLOCK_LIMITS;
+            dest[len++] = SCSI_VPD_LB_PROVISIONING;
+            break;
 
-        itf->CSW.dDataResidue -= len;
+        case SCSI_VPD_BLOCK_LIMITS:
+            len += 0x3C;
+            if (LU->Trim != NULL)
+            {
+                /* Maximum unmap LBA count: unlimited */
+                SCSI_Put32(&dest[20], 0xFFFFFFFF);
+                /* Maximum unmap block descriptor count: limited by the buffer */
+                SCSI_Put32(&dest[24], (sizeof(itf->Buffer[0]) - 8) / 16);
+            }
+            break;
 
-        if (itf->SCSI.RemLength > 0)
-        {
-            USBD_HandleType *dev = itf->Base.Device;
+        case SCSI_VPD_LB_PROVISIONING:
+            len += 4;
+            if (LU->Trim != NULL)
+            {
+                /* UNMAP is supported on a thin provisioned LU */
+                dest[5] = 0x80;
+                dest[6] = 0x02;
+            }
+            break;
 
-            /* Prepare EP to receive next packet */
-            USBD_EpReceive(dev, itf->Config.OutEpNum, itf->Buffer, len);
-        }
+        default:
+            SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                    SCSI_ASC_INVALID_FIELD_IN_COMMAND);
+            len = 0;
+            break;
     }
-    return retval;
+
+    if (len > 0)
+    {   SCSI_Put16(&dest[2], len - 4); }
+
+    return len;
 }
 
 /**
@@ -150,18 +769,17 @@ static uint32_t SCSI_Inquiry(USBD_MSC_IfHandleType *itf)
         uint8_t OpCode;
         uint8_t EVPD;
         uint8_t PageCode;
-        uint16_t AllocLength;
+        uint8_t AllocLength[2];
         uint8_t Control;
     }__packed *cmd = (void*)itf->CBW.CB;
-    uint8_t* data = itf->Buffer;
+    uint8_t* data = itf->Buffer[0];
     const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
     uint32_t respLen;
 
-    if (cmd->EVPD != 0)
+    if ((cmd->EVPD & 1) != 0)
     {
         /* (Enable) Vital Product Data: */
-        respLen = 5;
-        memset(data, 0, respLen);
+        respLen = SCSI_InquiryVPD(itf, cmd->PageCode, data);
     }
     else
     {
@@ -169,8 +787,8 @@ static uint32_t SCSI_Inquiry(USBD_MSC_IfHandleType *itf)
         memcpy(data, LU->Inquiry, respLen);
     }
 
-    if (respLen > cmd->AllocLength)
-    {   respLen = cmd->AllocLength; }
+    if (respLen > SCSI_Get16(cmd->AllocLength))
+    {   respLen = SCSI_Get16(cmd->AllocLength); }
 
     return respLen;
 }
@@ -191,9 +809,9 @@ static uint32_t SCSI_ReadCapacity10(USBD_MSC_IfHandleType *itf)
         uint8_t Control;
     }__packed *cmd = (void*)itf->CBW.CB;
     struct {
-        uint32_t BlockCount;
-        uint32_t BlockLength;
-    }__packed *data = (void*)itf->Buffer;
+        uint8_t BlockCount[4];
+        uint8_t BlockLength[4];
+    }__packed *data = (void*)itf->Buffer[0];
     const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
     uint32_t respLen = 0;
 
@@ -204,9 +822,65 @@ static uint32_t SCSI_ReadCapacity10(USBD_MSC_IfHandleType *itf)
     }
     else
     {
-        data->BlockCount  = LU->Status->BlockCount - 1;
-        data->BlockLength = LU->Status->BlockSize;
+        SCSI_Put32(data->BlockCount,  LU->Status->BlockCount - 1);
+        SCSI_Put32(data->BlockLength, LU->Status->BlockSize);
+        respLen = sizeof(*data);
+    }
+
+    return respLen;
+}
+
+/**
+ * @brief Sets up the READ CAPACITY(16) data for transmission.
+ * @param itf: reference of the MSC interface
+ * @return The length of the response data
+ */
+static uint32_t SCSI_ReadCapacity16(USBD_MSC_IfHandleType *itf)
+{
+    struct {
+        uint8_t OpCode;
+        uint8_t ServiceAction;
+        uint8_t LogicalBlockAddr[8];
+        uint8_t AllocLength[4];
+        uint8_t PMI;
+        uint8_t Control;
+    }__packed *cmd = (void*)itf->CBW.CB;
+    struct {
+        uint8_t BlockCount[8];
+        uint8_t BlockLength[4];
+        uint8_t Protection;
+        uint8_t Exponents;
+        uint8_t Provisioning[2];
+        uint8_t __reserved[16];
+    }__packed *data = (void*)itf->Buffer[0];
+    const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    uint32_t respLen = 0;
+
+    if ((cmd->ServiceAction & 0x1F) != SCSI_SA_READ_CAPACITY16)
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                SCSI_ASC_INVALID_FIELD_IN_COMMAND);
+    }
+    else if (!LU->Status->Ready)
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_NOT_READY,
+                SCSI_ASC_MEDIUM_NOT_PRESENT);
+    }
+    else
+    {
+        memset(data, 0, sizeof(*data));
+        SCSI_Put64(data->BlockCount,  LU->Status->BlockCount - 1);
+        SCSI_Put32(data->BlockLength, LU->Status->BlockSize);
+
+        if (LU->Trim != NULL)
+        {
+            /* Logical block provisioning management enabled */
+            data->Provisioning[0] = 0x80;
+        }
         respLen = sizeof(*data);
+
+        if (respLen > SCSI_Get32(cmd->AllocLength))
+        {   respLen = SCSI_Get32(cmd->AllocLength); }
     }
 
     return respLen;
@@ -229,34 +903,62 @@ static uint32_t SCSI_ReadFormatCapacity(USBD_MSC_IfHandleType *itf)
             uint8_t b;
         };
         uint8_t __reserved0[5];
-        uint16_t AllocLength;
+        uint8_t AllocLength[2];
         uint8_t __reserved1[3];
     }__packed *cmd = (void*)itf->CBW.CB;
     struct {
         uint8_t __reserved0[3];
         uint8_t CapacityListLength;
         struct {
-            uint32_t BlockCount;
-            uint8_t  DescriptorCode;
-            uint8_t  __reserved1;
-            uint16_t BlockLength;
+            uint8_t BlockCount[4];
+            uint8_t DescriptorCode;
+            uint8_t __reserved1;
+            uint8_t BlockLength[2];
         }__packed Capacity[1];
-    }*data = (void*)itf->Buffer;
+    }*data = (void*)itf->Buffer[0];
     const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
     uint32_t respLen = sizeof(*data);
 
     memset(data, 0, sizeof(*data));
     data->CapacityListLength = 8;
-    data->Capacity[0].BlockCount     = LU->Status->BlockCount - 1;
+    SCSI_Put32(data->Capacity[0].BlockCount, LU->Status->BlockCount - 1);
     data->Capacity[0].DescriptorCode = 2; /* Formatted Media */
-    data->Capacity[0].BlockLength    = LU->Status->BlockSize;
+    SCSI_Put16(data->Capacity[0].BlockLength, LU->Status->BlockSize);
 
-    if (respLen > cmd->AllocLength)
-    {   respLen = cmd->AllocLength; }
+    if (respLen > SCSI_Get16(cmd->AllocLength))
+    {   respLen = SCSI_Get16(cmd->AllocLength); }
 
     return respLen;
 }
 
+/**
+ * @brief Sets up the requested mode pages for MODE SENSE.
+ * @param pageCode: the requested @ref USBD_SCSI_ModePageType
+ * @param writeCache: whether the LU uses its write-back cache
+ * @param dest: the destination of the mode pages
+ * @return The length of the mode pages
+ */
+static uint32_t SCSI_ModePages(uint8_t pageCode, uint8_t writeCache, uint8_t *dest)
+{
+    uint32_t len = 0;
+
+    if ((pageCode == SCSI_MODE_PAGE_CACHING) || (pageCode == SCSI_MODE_PAGE_ALL))
+    {
+        uint8_t (*page)[20] = (void*)&dest[len];
+
+        memset(page, 0, sizeof(*page));
+        (*page)[0] = SCSI_MODE_PAGE_CACHING;
+        (*page)[1] = sizeof(*page) - 2;
+        if (writeCache != 0)
+        {
+            /* Write Cache Enable */
+            (*page)[2] = 0x04;
+        }
+        len += sizeof(*page);
+    }
+    return len;
+}
+
 /**
  * @brief Sets up MODE SENSE(6) data for transmission.
  * @param itf: reference of the MSC interface
@@ -280,10 +982,15 @@ static uint32_t SCSI_ModeSense6(USBD_MSC_IfHandleType *itf)
         uint8_t AllocLength;
         uint8_t Control;
     }__packed *cmd = (void*)itf->CBW.CB;
-    uint8_t (*data)[8] = (void*)itf->Buffer;
-    uint32_t respLen = sizeof(*data);
+    uint8_t *data = itf->Buffer[0];
+    uint32_t respLen = 4;
 
-    memset(data, 0, sizeof(*data));
+    /* Mode parameter header */
+    memset(data, 0, respLen);
+
+    respLen += SCSI_ModePages(cmd->PageCode,
+            MSC_CACHE_USED(itf), &data[respLen]);
+    data[0] = respLen - 1;
 
     if (respLen > cmd->AllocLength)
     {   respLen = cmd->AllocLength; }
@@ -313,17 +1020,21 @@ static uint32_t SCSI_ModeSense10(USBD_MSC_IfHandleType *itf)
         };
         uint8_t SubpageCode;
         uint8_t __reserved1[2];
-        uint16_t AllocLength;
+        uint8_t AllocLength[2];
         uint8_t Control;
     }__packed *cmd = (void*)itf->CBW.CB;
-    uint8_t (*data)[8] = (void*)itf->Buffer;
-    uint32_t respLen = sizeof(*data);
+    uint8_t *data = itf->Buffer[0];
+    uint32_t respLen = 8;
 
-    memset(data, 0, sizeof(*data));
-    *data[1] = 0x06;
+    /* Mode parameter header */
+    memset(data, 0, respLen);
 
-    if (respLen > cmd->AllocLength)
-    {   respLen = cmd->AllocLength; }
+    respLen += SCSI_ModePages(cmd->PageCode,
+            MSC_CACHE_USED(itf), &data[respLen]);
+    SCSI_Put16(&data[0], respLen - 2);
+
+    if (respLen > SCSI_Get16(cmd->AllocLength))
+    {   respLen = SCSI_Get16(cmd->AllocLength); }
 
     return respLen;
 }
@@ -342,30 +1053,7 @@ static uint32_t SCSI_RequestSense(USBD_MSC_IfHandleType *itf)
         uint8_t AllocLength;
         uint8_t Control;
     }__packed *cmd = (void*)itf->CBW.CB;
-    struct {
-        uint8_t ResponseCode;
-        uint8_t __reserved0;
-        uint8_t SenseKey;
-        uint8_t Information[4];
-        uint8_t AddLength;
-        uint8_t CmdSpecific[4];
-        uint8_t ASC;
-        uint8_t ASCQ;
-        uint8_t FRUC;
-        uint8_t SenseKeySpecific[3];
-    }*data = (void*)itf->Buffer;
-    USBD_SCSI_SenseType* sense = SCSI_GetSenseCode(itf);
-    uint32_t respLen = sizeof(*data);
-
-    memset(data, 0, sizeof(*data));
-    data->ResponseCode = 0x70;
-    data->AddLength    = sizeof(*data) - 7;
-
-    if (sense != NULL)
-    {
-        data->SenseKey = sense->Key;
-        data->ASC      = sense->ASC;
-    }
+    uint32_t respLen = SCSI_GetSenseData(itf, itf->Buffer[0]);
 
     if (respLen > cmd->AllocLength)
     {   respLen = cmd->AllocLength; }
@@ -400,6 +1088,16 @@ static uint32_t SCSI_StartStopUnit(USBD_MSC_IfHandleType *itf)
     switch (cmd->POWERCONDITION)
     {
         case 0:  /* POWERCONDITION ignored, use START and LOEJ */
+#if (USBD_MSC_CACHE_LINES > 0)
+            /* Write back the cached data before the media state changes */
+            if (MSC_CACHE_USED(itf) &&
+                (MSC_CacheFlush(LU) != USBD_E_OK))
+            {
+                SCSI_PutSenseCode(itf, SCSI_SKEY_MEDIUM_ERROR,
+                        SCSI_ASC_WRITE_FAULT);
+            }
+            else
+#endif
             /* Start or stop LUN depending on START bit */
             if (cmd->START != 0)
             {
@@ -421,6 +1119,32 @@ static uint32_t SCSI_StartStopUnit(USBD_MSC_IfHandleType *itf)
     return 0;
 }
 
+/**
+ * @brief Writes the cached data of the LUN to the media.
+ * @note  The entire cache is written regardless of the requested block range.
+ * @param itf: reference of the MSC interface
+ * @return The length of the response data: 0
+ */
+static uint32_t SCSI_SynchronizeCache10(USBD_MSC_IfHandleType *itf)
+{
+    const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+
+    if (!LU->Status->Ready)
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_NOT_READY,
+                SCSI_ASC_MEDIUM_NOT_PRESENT);
+    }
+#if (USBD_MSC_CACHE_LINES > 0)
+    else if (MSC_CACHE_USED(itf) &&
+             (MSC_CacheFlush(LU) != USBD_E_OK))
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_MEDIUM_ERROR,
+                SCSI_ASC_WRITE_FAULT);
+    }
+#endif
+    return 0;
+}
+
 /**
  * @brief Handles medium removal requests.
  * @param itf: reference of the MSC interface
@@ -496,12 +1220,16 @@ static uint32_t SCSI_Verify10(USBD_MSC_IfHandleType *itf)
             };
             uint8_t __reserved;
         };
-        uint32_t BlockAddr;
+        uint8_t BlockAddr[4];
         uint8_t GroupNr;
-        uint16_t TransferLength;
+        uint8_t TransferLength[2];
         uint8_t Control;
     }__packed *cmd = (void*)itf->CBW.CB;
     const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    uint64_t blockAddr;
+    uint32_t blockLen;
+
+    SCSI_GetBlockRange(itf, &blockAddr, &blockLen);
 
     /* byte-by-byte comparison is not supported (it requires 2 buffers) */
     if (cmd->BYTCHK != 0)
@@ -509,7 +1237,7 @@ static uint32_t SCSI_Verify10(USBD_MSC_IfHandleType *itf)
         SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
                 SCSI_ASC_INVALID_FIELD_IN_COMMAND);
     }
-    else if ((itf->SCSI.Address + itf->SCSI.RemLength) > LU->Status->BlockCount)
+    else if (!SCSI_BlockRangeValid(LU, blockAddr, blockLen))
     {
         SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
                 SCSI_ASC_ADDRESS_OUT_OF_RANGE);
@@ -518,31 +1246,17 @@ static uint32_t SCSI_Verify10(USBD_MSC_IfHandleType *itf)
 }
 
 /**
- * @brief Checks if a block read operation is possible, and starts it.
+ * @brief Checks if a block read operation (READ 10, 12 or 16) is possible, and starts it.
  * @param itf: reference of the MSC interface
  * @return The length of the response data
  */
-static uint32_t SCSI_Read10(USBD_MSC_IfHandleType *itf)
+static uint32_t SCSI_Read(USBD_MSC_IfHandleType *itf)
 {
-    struct {
-        uint8_t OpCode;
-        union {
-            struct {
-                uint8_t : 1;
-                uint8_t FUA_NV : 1;
-                uint8_t : 1;
-                uint8_t FUA : 1;
-                uint8_t DPO : 1;
-                uint8_t RDPROTECT : 3;
-            };
-            uint8_t __reserved;
-        };
-        uint32_t BlockAddr;
-        uint8_t GroupNr;
-        uint16_t TransferLength;
-        uint8_t Control;
-    }__packed *cmd = (void*)itf->CBW.CB;
     const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    uint64_t blockAddr;
+    uint32_t blockLen;
+
+    SCSI_GetBlockRange(itf, &blockAddr, &blockLen);
 
     /* case (10): Ho <> Di */
     if (itf->CBW.bmFlags == 0)
@@ -555,57 +1269,49 @@ static uint32_t SCSI_Read10(USBD_MSC_IfHandleType *itf)
         SCSI_PutSenseCode(itf, SCSI_SKEY_NOT_READY,
                 SCSI_ASC_MEDIUM_NOT_PRESENT);
     }
-    else if ((cmd->BlockAddr + cmd->TransferLength) > LU->Status->BlockCount)
+    else if (!SCSI_BlockRangeValid(LU, blockAddr, blockLen))
     {
         SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
                 SCSI_ASC_ADDRESS_OUT_OF_RANGE);
     }
     else
     {
-        itf->SCSI.Address = cmd->BlockAddr * LU->Status->BlockSize;
-        itf->SCSI.RemLength = cmd->TransferLength * LU->Status->BlockSize;
+        itf->SCSI.Address = blockAddr;
+        itf->SCSI.RemLength = blockLen * LU->Status->BlockSize;
 
         /* cases 4,5 : Hi <> Dn */
-        if (itf->CBW.dDataLength != itf->SCSI.RemLength)
+        if (((uint64_t)blockLen * LU->Status->BlockSize) != itf->CBW.dDataLength)
         {
             SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
                     SCSI_ASC_INVALID_CDB);
         }
-        else
+        else if (itf->SCSI.RemLength > 0)
         {
-            SCSI_ProcessRead(itf);
+            itf->SCSI.BufIndex = 0;
+            itf->SCSI.BufPending = 0;
+            itf->SCSI.XferBusy = 0;
+            itf->SCSI.Direct = 0;
+            itf->State = MSC_STATE_DATA_IN;
+
+            SCSI_ReadNext(itf);
         }
     }
     return itf->CBW.dDataLength;
 }
 
 /**
- * @brief Checks if a block write operation is possible, and starts it.
+ * @brief Checks if a block write operation (WRITE 10, 12 or 16) is possible, and starts it.
  * @param itf: reference of the MSC interface
  * @return The length of the response data
  */
-static uint32_t SCSI_Write10(USBD_MSC_IfHandleType *itf)
+static uint32_t SCSI_Write(USBD_MSC_IfHandleType *itf)
 {
-    struct {
-        uint8_t OpCode;
-        union {
-            struct {
-                uint8_t : 1;
-                uint8_t FUA_NV : 1;
-                uint8_t : 1;
-                uint8_t FUA : 1;
-                uint8_t DPO : 1;
-                uint8_t WRPROTECT : 3;
-            };
-            uint8_t __reserved;
-        };
-        uint32_t BlockAddr;
-        uint8_t GroupNr;
-        uint16_t TransferLength;
-        uint8_t Control;
-    }__packed *cmd = (void*)itf->CBW.CB;
     const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
-    uint32_t respLen = sizeof(itf->Buffer);
+    uint32_t respLen = sizeof(itf->Buffer[0]);
+    uint64_t blockAddr;
+    uint32_t blockLen;
+
+    SCSI_GetBlockRange(itf, &blockAddr, &blockLen);
 
     /* case 8 : Hi <> Do */
     if (itf->CBW.bmFlags != 0)
@@ -623,36 +1329,166 @@ static uint32_t SCSI_Write10(USBD_MSC_IfHandleType *itf)
         SCSI_PutSenseCode(itf, SCSI_SKEY_NOT_READY,
                 SCSI_ASC_WRITE_PROTECTED);
     }
-    else if ((cmd->BlockAddr + cmd->TransferLength) > LU->Status->BlockCount)
+    else if (!SCSI_BlockRangeValid(LU, blockAddr, blockLen))
     {
         SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
                 SCSI_ASC_ADDRESS_OUT_OF_RANGE);
     }
     else
     {
-        itf->SCSI.Address = cmd->BlockAddr * LU->Status->BlockSize;
-        itf->SCSI.RemLength = cmd->TransferLength * LU->Status->BlockSize;
+        itf->SCSI.Address = blockAddr;
+        itf->SCSI.RemLength = blockLen * LU->Status->BlockSize;
 
         /* cases 3,11,13 : Hn,Ho <> D0 */
-        if (itf->CBW.dDataLength != itf->SCSI.RemLength)
+        if (((uint64_t)blockLen * LU->Status->BlockSize) != itf->CBW.dDataLength)
         {
             SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
                     SCSI_ASC_INVALID_CDB);
         }
-        else
+        else if (itf->SCSI.RemLength > 0)
         {
-            USBD_HandleType *dev = itf->Base.Device;
-
             if (respLen > itf->SCSI.RemLength)
             {   respLen = itf->SCSI.RemLength; }
 
+            itf->SCSI.BufIndex = 0;
+            itf->SCSI.BufPending = 0;
+            itf->SCSI.XferBusy = 0;
+            itf->SCSI.Direct = 0;
             itf->State = MSC_STATE_DATA_OUT;
-            USBD_EpReceive(dev, itf->Config.OutEpNum, itf->Buffer, respLen);
+
+            SCSI_WriteNext(itf);
         }
     }
     return respLen;
 }
 
+/**
+ * @brief Checks if the LU can discard blocks, and starts the reception
+ *        of the UNMAP parameter list.
+ * @param itf: reference of the MSC interface
+ * @return The length of the response data: 0
+ */
+static uint32_t SCSI_Unmap(USBD_MSC_IfHandleType *itf)
+{
+    struct {
+        uint8_t OpCode;
+        uint8_t ANCHOR;
+        uint8_t __reserved0[4];
+        uint8_t GroupNr;
+        uint8_t ParamListLength[2];
+        uint8_t Control;
+    }__packed *cmd = (void*)itf->CBW.CB;
+    const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+    uint32_t paramLen = SCSI_Get16(cmd->ParamListLength);
+
+    if (LU->Trim == NULL)
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                SCSI_ASC_INVALID_CDB);
+    }
+    /* case 8 : Hi <> Do */
+    else if ((itf->CBW.bmFlags != 0) && (paramLen > 0))
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                SCSI_ASC_INVALID_CDB);
+    }
+    else if (!LU->Status->Ready)
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_NOT_READY,
+                SCSI_ASC_MEDIUM_NOT_PRESENT);
+    }
+    else if (!LU->Status->Writable)
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_NOT_READY,
+                SCSI_ASC_WRITE_PROTECTED);
+    }
+    else if (paramLen > sizeof(itf->Buffer[0]))
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                SCSI_ASC_PARAMETER_LIST_LENGTH_ERROR);
+    }
+    /* cases 3,11,13 : Hn,Ho <> D0 */
+    else if (itf->CBW.dDataLength != paramLen)
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                SCSI_ASC_INVALID_CDB);
+    }
+    else if (paramLen > 0)
+    {
+        /* The parameter list is processed by SCSI_ProcessWrite() */
+        itf->SCSI.RemLength = paramLen;
+        itf->SCSI.BufIndex = 0;
+        itf->SCSI.BufPending = 0;
+        itf->SCSI.XferBusy = 1;
+        itf->SCSI.Direct = 0;
+        itf->State = MSC_STATE_DATA_OUT;
+
+        USBD_EpReceive(itf->Base.Device, itf->Config.OutEpNum,
+                itf->Buffer[0], paramLen);
+    }
+    return 0;
+}
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+/**
+ * @brief Determines the expected data transfer length and direction
+ *        of the current command from its operation code, for transports
+ *        which don't provide them.
+ * @param itf: reference of the MSC interface
+ * @return The expected length of the data transfer
+ */
+uint32_t SCSI_GetDataLength(USBD_MSC_IfHandleType *itf)
+{
+    uint32_t len = 0;
+
+    /* Data-in is assumed for response data */
+    itf->CBW.bmFlags = USB_DIRECTION_IN << 7;
+
+    switch (itf->CBW.CB[0])
+    {
+        case SCSI_READ10:
+        case SCSI_READ12:
+        case SCSI_READ16:
+        case SCSI_WRITE10:
+        case SCSI_WRITE12:
+        case SCSI_WRITE16:
+        {
+            const USBD_MSC_LUType *LU = MSC_GetLU(itf, itf->CBW.bLUN);
+            uint64_t blockAddr;
+            uint32_t blockLen;
+
+            SCSI_GetBlockRange(itf, &blockAddr, &blockLen);
+            len = blockLen * LU->Status->BlockSize;
+
+            if ((itf->CBW.CB[0] == SCSI_WRITE10) ||
+                (itf->CBW.CB[0] == SCSI_WRITE12) ||
+                (itf->CBW.CB[0] == SCSI_WRITE16))
+            {   itf->CBW.bmFlags = USB_DIRECTION_OUT << 7; }
+            break;
+        }
+
+        case SCSI_UNMAP:
+            len = SCSI_Get16(&itf->CBW.CB[7]);
+            itf->CBW.bmFlags = USB_DIRECTION_OUT << 7;
+            break;
+
+        /* No data transfer */
+        case SCSI_TEST_UNIT_READY:
+        case SCSI_START_STOP_UNIT:
+        case SCSI_PREVENT_ALLOW_MEDIUM_REMOVAL:
+        case SCSI_VERIFY10:
+        case SCSI_SYNCHRONIZE_CACHE10:
+            break;
+
+        /* The response length is limited by the command's allocation length */
+        default:
+            len = sizeof(itf->Buffer[0]);
+            break;
+    }
+    return len;
+}
+#endif /* (USBD_MSC_UAS_SUPPORT == 1) */
+
 /**
  * @brief Routes the SCSI command to its handler based on the operation code.
  * @param itf: reference of the MSC interface
@@ -661,21 +1497,38 @@ void SCSI_ProcessCommand(USBD_MSC_IfHandleType *itf)
 {
     uint32_t respLen = 0;
 
+#if (USBD_MSC_CACHE_LINES > 0)
+    /* The LU geometry may have changed since the previous command */
+    itf->SCSI.Cached = MSC_CacheUsable(MSC_GetLU(itf, itf->CBW.bLUN));
+#endif
+
     /* OPERATION CODE */
     switch (itf->CBW.CB[0])
     {
         case SCSI_READ10:
-            respLen = SCSI_Read10(itf);
+        case SCSI_READ12:
+        case SCSI_READ16:
+            respLen = SCSI_Read(itf);
             break;
 
         case SCSI_WRITE10:
-            respLen = SCSI_Write10(itf);
+        case SCSI_WRITE12:
+        case SCSI_WRITE16:
+            respLen = SCSI_Write(itf);
+            break;
+
+        case SCSI_UNMAP:
+            respLen = SCSI_Unmap(itf);
             break;
 
         case SCSI_VERIFY10:
             respLen = SCSI_Verify10(itf);
             break;
 
+        case SCSI_SYNCHRONIZE_CACHE10:
+            respLen = SCSI_SynchronizeCache10(itf);
+            break;
+
         case SCSI_INQUIRY:
             respLen = SCSI_Inquiry(itf);
             break;
@@ -712,6 +1565,10 @@ void SCSI_ProcessCommand(USBD_MSC_IfHandleType *itf)
             respLen = SCSI_ReadCapacity10(itf);
             break;
 
+        case SCSI_READ_CAPACITY16:
+            respLen = SCSI_ReadCapacity16(itf);
+            break;
+
         default:
             SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
                     SCSI_ASC_INVALID_CDB);
@@ -726,7 +1583,7 @@ void SCSI_ProcessCommand(USBD_MSC_IfHandleType *itf)
         (itf->State == MSC_STATE_COMMAND_OUT) && (respLen > 0))
     {
         /* Send command response */
-        USBD_EpSend(itf->Base.Device, itf->Config.InEpNum, itf->Buffer, respLen);
+        USBD_EpSend(itf->Base.Device, itf->Config.InEpNum, itf->Buffer[0], respLen);
 
         itf->CSW.dDataResidue -= respLen;
 
@@ -0,0 +1,839 @@
+/**
+  ******************************************************************************
+  * @file    usbd_msc_uas.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Mass Storage Class
+  *          USB Attached SCSI Protocol
+  *
+  * @details
+  * The received command IUs are queued by their tags, and each queue slot
+  * stores the SCSI context and the block buffers of its command. The contexts
+  * are swapped into the interface as the transfers of their commands progress,
+  * so a command which waits for its LU (which returned BUSY) yields to the next
+  * tags. As without USB 3.x streams, a READ or WRITE READY IU announces which
+  * command transfers its data on the data-in or data-out pipe, until the Sense IU
+  * of that command is queued. The LU is accessed for one command at a time,
+  * and the ORDERED tasks, as well as the commands accessing the LU outside of
+  * the block data transport, are executed alone.
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+#include <usbd_msc_private.h>
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+
+#define UAS_DESC_TYPE_PIPE_USAGE    0x24
+
+#define UAS_PIPE_COMMAND            1
+#define UAS_PIPE_STATUS             2
+#define UAS_PIPE_DATA_IN            3
+#define UAS_PIPE_DATA_OUT           4
+
+#define UAS_TMF_IU_SIZE             16
+
+#define UAS_TASK_ATTR_MASK          0x07
+#define UAS_TASK_ATTR_HEAD_OF_QUEUE 0x01
+#define UAS_TASK_ATTR_ORDERED       0x02
+
+#define UAS_SLOT_NONE               0xFF
+#define UAS_SLOT_FREE               0   /* Slot is available for reception */
+#define UAS_SLOT_QUEUED             1   /* Command is waiting for execution */
+#define UAS_SLOT_ACTIVE             2   /* Command is being executed */
+#define UAS_SLOT_DONE               3   /* Command status is being sent */
+
+#define UAS_FLAG_DATA               0x01    /* Command has a data phase */
+#define UAS_FLAG_DATA_IN            0x02    /* The data phase uses the data-in pipe */
+#define UAS_FLAG_EXCLUSIVE          0x04    /* Command is executed alone */
+
+#define UAS_STATUS_RESPONSE         0x01
+#define UAS_STATUS_READY            0x02
+#define UAS_STATUS_SENSE            0x04
+
+#define SCSI_STATUS_GOOD            0x00
+#define SCSI_STATUS_CHECK_CONDITION 0x02
+
+/** @brief Returns the index of the data pipe used by the command */
+#define UAS_DATA_PIPE(FLAGS)        \
+    ((((FLAGS) & UAS_FLAG_DATA_IN) != 0) ? USB_DIRECTION_IN : USB_DIRECTION_OUT)
+
+/** @brief UAS Task Management Information Unit structure */
+typedef struct
+{
+    uint8_t  bIUID;         /*!< Information Unit ID */
+    uint8_t  __reserved0;
+    uint16_t wTag;          /*!< Tag of the task management request */
+    uint8_t  bFunction;     /*!< @ref USBD_UAS_TaskMgmtType */
+    uint8_t  __reserved1;
+    uint16_t wTaskTag;      /*!< Tag of the managed command */
+    uint8_t  LUN[8];        /*!< Logical Unit Number */
+}UAS_TaskMgmtIUType;
+
+
+/** @brief UAS Pipe Usage descriptor structure */
+typedef struct
+{
+    uint8_t bLength;
+    uint8_t bDescriptorType;
+    uint8_t bPipeID;
+    uint8_t __reserved;
+}UAS_PipeUsageDescType;
+
+/** @ingroup USBD_MSC
+ * @defgroup USBD_MSC_Private_Functions_UAS MSC Private Functions UAS
+ * @{ */
+
+/**
+ * @brief Looks up the queued or executed command with the given tag.
+ * @param itf: reference of the MSC interface
+ * @param tag: the command tag
+ * @return The queue slot of the command, or UAS_SLOT_NONE if not found
+ */
+static uint8_t uas_findTag(USBD_MSC_IfHandleType *itf, uint16_t tag)
+{
+    uint8_t i;
+
+    for (i = 0; i < USBD_MSC_UAS_QUEUE_DEPTH; i++)
+    {
+        if ((itf->UAS.SlotState[i] != UAS_SLOT_FREE) &&
+            (itf->UAS.Queue[i].wTag == tag))
+        {
+            return i;
+        }
+    }
+    return UAS_SLOT_NONE;
+}
+
+/**
+ * @brief Prepares the command pipe to receive the next IU to a free queue slot.
+ *        The reception is held back while the queue is full, or while
+ *        the previous task management response is not yet sent.
+ * @param itf: reference of the MSC interface
+ */
+static void uas_receiveIU(USBD_MSC_IfHandleType *itf)
+{
+    uint8_t i;
+
+    if ((itf->UAS.RxSlot == UAS_SLOT_NONE) &&
+        (((itf->UAS.StatusPending | itf->UAS.StatusXfer) & UAS_STATUS_RESPONSE) == 0))
+    {
+        for (i = 0; i < USBD_MSC_UAS_QUEUE_DEPTH; i++)
+        {
+            if (itf->UAS.SlotState[i] == UAS_SLOT_FREE)
+            {
+                itf->UAS.RxSlot = i;
+
+                USBD_EpReceive(itf->Base.Device, itf->Config.CmdEpNum,
+                        (uint8_t*)&itf->UAS.Queue[i], sizeof(itf->UAS.Queue[i]));
+                break;
+            }
+        }
+    }
+}
+
+/**
+ * @brief Swaps the context of the selected command into the interface,
+ *        and stores the context of the previously processed command.
+ *        The state of the LU access is shared by the commands.
+ * @param itf: reference of the MSC interface
+ * @param slot: the queue slot of the command
+ */
+static void uas_select(USBD_MSC_IfHandleType *itf, uint8_t slot)
+{
+    if (itf->UAS.Current != slot)
+    {
+        uint8_t mediaBusy = itf->SCSI.MediaBusy;
+        USBD_MSC_UAS_ContextType *ctx;
+
+        if (itf->UAS.Current != UAS_SLOT_NONE)
+        {
+            ctx = &itf->UAS.Context[itf->UAS.Current];
+            ctx->CBW   = itf->CBW;
+            ctx->CSW   = itf->CSW;
+            ctx->State = itf->State;
+            ctx->SCSI  = itf->SCSI;
+        }
+
+        ctx = &itf->UAS.Context[slot];
+        itf->CBW   = ctx->CBW;
+        itf->CSW   = ctx->CSW;
+        itf->State = ctx->State;
+        itf->SCSI  = ctx->SCSI;
+        itf->SCSI.MediaBusy = mediaBusy;
+
+        itf->Buffer = &itf->UAS.Buffers[slot * USBD_MSC_BUFFER_COUNT];
+        itf->UAS.Current = slot;
+    }
+}
+
+/**
+ * @brief Keeps track of the command which accesses the LU,
+ *        after the current command has been processed.
+ * @param itf: reference of the MSC interface
+ */
+static void uas_mediaUpdate(USBD_MSC_IfHandleType *itf)
+{
+    if (itf->SCSI.MediaBusy == 0)
+    {
+        itf->UAS.MediaSlot = UAS_SLOT_NONE;
+    }
+    else if (itf->UAS.MediaSlot == UAS_SLOT_NONE)
+    {
+        itf->UAS.MediaSlot = itf->UAS.Current;
+    }
+}
+
+/**
+ * @brief Sends the next pending IU on the status pipe, if it's idle.
+ *        The Ready IUs are sent before the Sense IUs,
+ *        so the data phases of the commands aren't held back.
+ * @param itf: reference of the MSC interface
+ */
+static void uas_sendStatus(USBD_MSC_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint8_t i, slot = UAS_SLOT_NONE, status = 0;
+
+    if (itf->UAS.StatusXfer != 0)
+    {
+        /* Wait for the ongoing transfer */
+    }
+    else if ((itf->UAS.StatusPending & UAS_STATUS_RESPONSE) != 0)
+    {
+        itf->UAS.StatusPending = 0;
+        itf->UAS.StatusXfer = UAS_STATUS_RESPONSE;
+        USBD_EpSend(dev, itf->Config.StatusEpNum,
+                (uint8_t*)&itf->UAS.Response, sizeof(itf->UAS.Response));
+    }
+    else
+    {
+        for (i = 0; i < USBD_MSC_UAS_QUEUE_DEPTH; i++)
+        {
+            if ((itf->UAS.SlotStatus[i] & UAS_STATUS_READY) != 0)
+            {
+                slot = i;
+                status = UAS_STATUS_READY;
+                break;
+            }
+            else if ((status == 0) && ((itf->UAS.SlotStatus[i] & UAS_STATUS_SENSE) != 0))
+            {
+                slot = i;
+                status = UAS_STATUS_SENSE;
+            }
+        }
+
+        if (status == UAS_STATUS_READY)
+        {
+            itf->UAS.Ready.bIUID = ((itf->UAS.SlotFlags[slot] & UAS_FLAG_DATA_IN) != 0) ?
+                    UAS_IU_READ_READY : UAS_IU_WRITE_READY;
+            itf->UAS.Ready.wTag  = itf->UAS.Queue[slot].wTag;
+
+            USBD_EpSend(dev, itf->Config.StatusEpNum,
+                    (uint8_t*)&itf->UAS.Ready, sizeof(itf->UAS.Ready));
+        }
+        else if (status == UAS_STATUS_SENSE)
+        {
+            USBD_MSC_UAS_SenseIUType *sense = &itf->UAS.Sense;
+            uint16_t len = sizeof(*sense);
+
+            /* The sense data is in the context of the command */
+            uas_select(itf, slot);
+
+            memset(sense, 0, sizeof(*sense));
+            sense->bIUID = UAS_IU_SENSE;
+            sense->wTag  = itf->UAS.Queue[slot].wTag;
+
+            /* Sense data is only sent along with CHECK CONDITION */
+            if (itf->CSW.bStatus != MSC_CSW_CMD_PASSED)
+            {
+                uint16_t senseLen = SCSI_GetSenseData(itf, sense->SenseData);
+
+                sense->bStatus = SCSI_STATUS_CHECK_CONDITION;
+                sense->wLength = (senseLen >> 8) | (senseLen << 8);
+            }
+            else
+            {
+                len -= sizeof(sense->SenseData);
+            }
+
+            USBD_EpSend(dev, itf->Config.StatusEpNum, (uint8_t*)sense, len);
+        }
+
+        if (status != 0)
+        {
+            itf->UAS.SlotStatus[slot] &= ~status;
+            itf->UAS.StatusXfer = status;
+            itf->UAS.StatusSlot = slot;
+        }
+    }
+}
+
+/**
+ * @brief Queues a Response IU for transmission.
+ * @param itf: reference of the MSC interface
+ * @param tag: the tag of the IU which is responded to
+ * @param code: the response code
+ */
+static void uas_respond(USBD_MSC_IfHandleType *itf, uint16_t tag,
+        USBD_UAS_ResponseCodeType code)
+{
+    memset(&itf->UAS.Response, 0, sizeof(itf->UAS.Response));
+    itf->UAS.Response.bIUID = UAS_IU_RESPONSE;
+    itf->UAS.Response.wTag  = tag;
+    itf->UAS.Response.bResponseCode = code;
+
+    itf->UAS.StatusPending |= UAS_STATUS_RESPONSE;
+}
+
+/**
+ * @brief Sets up the context of the received command in its queue slot.
+ * @param itf: reference of the MSC interface
+ * @param slot: the queue slot of the command
+ */
+static void uas_setupCommand(USBD_MSC_IfHandleType *itf, uint8_t slot)
+{
+    USBD_MSC_UAS_CommandIUType *cmd = &itf->UAS.Queue[slot];
+    uint8_t flags = 0;
+
+    uas_select(itf, slot);
+
+    /* Set up the SCSI command context */
+    itf->CBW.dTag       = cmd->wTag;
+    itf->CBW.bLUN       = cmd->LUN[1];
+    itf->CBW.bCBLength  = sizeof(cmd->CDB);
+    itf->CBW.dDataLength = 0;
+    memcpy(itf->CBW.CB, cmd->CDB, sizeof(cmd->CDB));
+    itf->CSW.bStatus    = MSC_CSW_CMD_PASSED;
+    itf->State          = MSC_STATE_COMMAND_OUT;
+    itf->SCSI.XferBusy  = 0;
+
+    /* The sense data is reported in the Sense IU of each command */
+    memset(&itf->SCSI.Sense, 0, sizeof(itf->SCSI.Sense));
+
+    if (itf->CBW.bLUN > itf->Config.MaxLUN)
+    {
+        SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                SCSI_ASC_LOGICAL_UNIT_NOT_SUPPORTED);
+    }
+    else if ((cmd->bAddCDBLength >> 2) != 0)
+    {
+        /* Additional CDB bytes are not supported */
+        SCSI_PutSenseCode(itf, SCSI_SKEY_ILLEGAL_REQUEST,
+                SCSI_ASC_INVALID_CDB);
+    }
+    else
+    {
+        itf->CBW.dDataLength = SCSI_GetDataLength(itf);
+
+        if (itf->CBW.dDataLength > 0)
+        {
+            flags = UAS_FLAG_DATA;
+
+            if (itf->CBW.bmFlags != 0)
+            {   flags |= UAS_FLAG_DATA_IN; }
+        }
+    }
+    itf->CSW.dDataResidue = itf->CBW.dDataLength;
+
+    /* These commands access the LU outside of the block data transport */
+    if (((cmd->bmAttributes & UAS_TASK_ATTR_MASK) == UAS_TASK_ATTR_ORDERED) ||
+        (cmd->CDB[0] == SCSI_SYNCHRONIZE_CACHE10) ||
+        (cmd->CDB[0] == SCSI_START_STOP_UNIT) ||
+        (cmd->CDB[0] == SCSI_UNMAP))
+    {
+        flags |= UAS_FLAG_EXCLUSIVE;
+    }
+    itf->UAS.SlotFlags[slot] = flags;
+}
+
+/**
+ * @brief Completes the current command by queueing its Sense IU,
+ *        and releases its data pipe for the other commands.
+ * @param itf: reference of the MSC interface
+ */
+static void uas_completeCommand(USBD_MSC_IfHandleType *itf)
+{
+    uint8_t slot = itf->UAS.Current;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(itf->UAS.PipeSlot); i++)
+    {
+        if (itf->UAS.PipeSlot[i] == slot)
+        {
+            itf->UAS.PipeSlot[i] = UAS_SLOT_NONE;
+        }
+    }
+
+    itf->UAS.SlotState[slot] = UAS_SLOT_DONE;
+    itf->UAS.SlotStatus[slot] |= UAS_STATUS_SENSE;
+}
+
+/**
+ * @brief Completes the current command when its data transport has finished,
+ *        either by transferring all data or by a failure.
+ * @param itf: reference of the MSC interface
+ */
+static void uas_dataTransport(USBD_MSC_IfHandleType *itf)
+{
+    if (itf->UAS.SlotState[itf->UAS.Current] != UAS_SLOT_ACTIVE)
+    {
+        /* No command in data transport */
+    }
+    else if (itf->CSW.bStatus != MSC_CSW_CMD_PASSED)
+    {
+        /* Complete when the ongoing transfer is finished */
+        if (itf->SCSI.XferBusy == 0)
+        {
+            uas_completeCommand(itf);
+        }
+    }
+    /* No data phase, or write completed */
+    else if ((itf->State == MSC_STATE_COMMAND_OUT) ||
+             ((itf->State == MSC_STATE_DATA_OUT) && (itf->SCSI.RemLength == 0)))
+    {
+        uas_completeCommand(itf);
+    }
+}
+
+/**
+ * @brief Returns the execution priority of the queued command:
+ *        head of queue commands are executed first,
+ *        the others in their order of arrival.
+ * @param itf: reference of the MSC interface
+ * @param slot: the queue slot of the command
+ * @return The priority of the command, the higher is executed first
+ */
+static uint16_t uas_priority(USBD_MSC_IfHandleType *itf, uint8_t slot)
+{
+    uint16_t head = (itf->UAS.Queue[slot].bmAttributes & UAS_TASK_ATTR_MASK)
+            == UAS_TASK_ATTR_HEAD_OF_QUEUE;
+    uint8_t age = itf->UAS.OrderCount - itf->UAS.SlotOrder[slot];
+
+    return (head << 8) | age;
+}
+
+/**
+ * @brief Selects the queued command which is executed next.
+ *        A command is started when its data pipe is free, while the exclusive
+ *        commands wait for the completion of the executed ones,
+ *        and hold back the commands which arrived after them.
+ * @param itf: reference of the MSC interface
+ * @return The queue slot of the command, or UAS_SLOT_NONE if none can be started
+ */
+static uint8_t uas_nextCommand(USBD_MSC_IfHandleType *itf)
+{
+    uint8_t i, slot = UAS_SLOT_NONE, active = 0, exclusive = 0;
+    uint16_t prio = 0, barrier = 0;
+
+    for (i = 0; i < USBD_MSC_UAS_QUEUE_DEPTH; i++)
+    {
+        if (itf->UAS.SlotState[i] == UAS_SLOT_ACTIVE)
+        {
+            active = 1;
+            exclusive |= itf->UAS.SlotFlags[i] & UAS_FLAG_EXCLUSIVE;
+        }
+        else if ((itf->UAS.SlotState[i] == UAS_SLOT_QUEUED) &&
+                 ((itf->UAS.SlotFlags[i] & UAS_FLAG_EXCLUSIVE) != 0) &&
+                 (uas_priority(itf, i) > barrier))
+        {
+            barrier = uas_priority(itf, i);
+        }
+    }
+
+    for (i = 0; (i < USBD_MSC_UAS_QUEUE_DEPTH) && (exclusive == 0); i++)
+    {
+        uint8_t flags = itf->UAS.SlotFlags[i];
+        uint16_t iPrio = uas_priority(itf, i);
+
+        if ((itf->UAS.SlotState[i] != UAS_SLOT_QUEUED) ||
+            (iPrio < barrier) || (iPrio <= prio))
+        {
+            /* Not queued, held back, or a higher priority command is found */
+        }
+        else if (((flags & UAS_FLAG_EXCLUSIVE) != 0) ? (active != 0) :
+                 (((flags & UAS_FLAG_DATA) != 0) &&
+                  (itf->UAS.PipeSlot[UAS_DATA_PIPE(flags)] != UAS_SLOT_NONE)))
+        {
+            /* The command cannot be started yet */
+        }
+        else
+        {
+            slot = i;
+            prio = iPrio;
+        }
+    }
+    return slot;
+}
+
+/**
+ * @brief Starts the execution of the queued command.
+ * @param itf: reference of the MSC interface
+ * @param slot: the queue slot of the command
+ */
+static void uas_startCommand(USBD_MSC_IfHandleType *itf, uint8_t slot)
+{
+    uint8_t flags = itf->UAS.SlotFlags[slot];
+
+    uas_select(itf, slot);
+    itf->UAS.SlotState[slot] = UAS_SLOT_ACTIVE;
+
+    /* The data pipe is used by this command until its completion */
+    if ((flags & UAS_FLAG_DATA) != 0)
+    {
+        itf->UAS.PipeSlot[UAS_DATA_PIPE(flags)] = slot;
+    }
+
+    if (itf->CSW.bStatus == MSC_CSW_CMD_PASSED)
+    {
+        SCSI_ProcessCommand(itf);
+
+        /* Notify the host when the data phase is started */
+        if ((itf->State == MSC_STATE_STATUS_IN) ||
+            (((itf->State == MSC_STATE_DATA_IN) || (itf->State == MSC_STATE_DATA_OUT)) &&
+             ((itf->CSW.bStatus == MSC_CSW_CMD_PASSED) || (itf->SCSI.XferBusy != 0))))
+        {
+            itf->UAS.SlotStatus[slot] |= UAS_STATUS_READY;
+        }
+    }
+
+    uas_mediaUpdate(itf);
+    uas_dataTransport(itf);
+}
+
+/**
+ * @brief Continues the executed commands which have been waiting for the LU,
+ *        starts the queued commands which can be executed,
+ *        and sends the next pending status IU.
+ * @param itf: reference of the MSC interface
+ */
+static void uas_process(USBD_MSC_IfHandleType *itf)
+{
+    uint8_t i, slot;
+
+    for (i = 0; (i < USBD_MSC_UAS_QUEUE_DEPTH) &&
+                (itf->UAS.MediaSlot == UAS_SLOT_NONE); i++)
+    {
+        if ((itf->UAS.SlotState[i] == UAS_SLOT_ACTIVE) &&
+            ((itf->UAS.SlotFlags[i] & UAS_FLAG_DATA) != 0))
+        {
+            uas_select(itf, i);
+
+            (void)SCSI_ProcessNext(itf);
+
+            uas_mediaUpdate(itf);
+            uas_dataTransport(itf);
+        }
+    }
+
+    for (slot = uas_nextCommand(itf); slot != UAS_SLOT_NONE; slot = uas_nextCommand(itf))
+    {
+        uas_startCommand(itf, slot);
+    }
+
+    uas_sendStatus(itf);
+}
+
+/**
+ * @brief Performs the requested task management function on the command queue.
+ * @param itf: reference of the MSC interface
+ * @param tmf: the received Task Management IU
+ */
+static void uas_taskManagement(USBD_MSC_IfHandleType *itf, const UAS_TaskMgmtIUType *tmf)
+{
+    USBD_UAS_ResponseCodeType code = UAS_RC_TMF_COMPLETE;
+    uint8_t i, slot;
+
+    if ((tmf->LUN[1] > itf->Config.MaxLUN) &&
+        (tmf->bFunction != UAS_TMF_I_T_NEXUS_RESET))
+    {
+        code = UAS_RC_INCORRECT_LUN;
+    }
+    else switch (tmf->bFunction)
+    {
+        case UAS_TMF_ABORT_TASK:
+        {
+            slot = uas_findTag(itf, tmf->wTaskTag);
+
+            if (slot == UAS_SLOT_NONE)
+            {
+                /* The command is already completed */
+            }
+            else if (itf->UAS.SlotState[slot] == UAS_SLOT_QUEUED)
+            {
+                itf->UAS.SlotState[slot] = UAS_SLOT_FREE;
+            }
+            else
+            {
+                /* The executed command cannot be aborted */
+                code = UAS_RC_TMF_FAILED;
+            }
+            break;
+        }
+
+        case UAS_TMF_ABORT_TASK_SET:
+        case UAS_TMF_CLEAR_TASK_SET:
+        case UAS_TMF_LOGICAL_UNIT_RESET:
+        case UAS_TMF_I_T_NEXUS_RESET:
+        {
+            /* Discard the queued commands of the LU */
+            for (i = 0; i < USBD_MSC_UAS_QUEUE_DEPTH; i++)
+            {
+                if ((itf->UAS.SlotState[i] == UAS_SLOT_QUEUED) &&
+                    ((tmf->bFunction == UAS_TMF_I_T_NEXUS_RESET) ||
+                     (itf->UAS.Queue[i].LUN[1] == tmf->LUN[1])))
+                {
+                    itf->UAS.SlotState[i] = UAS_SLOT_FREE;
+                }
+            }
+            break;
+        }
+
+        case UAS_TMF_QUERY_TASK:
+        {
+            if (uas_findTag(itf, tmf->wTaskTag) != UAS_SLOT_NONE)
+            {
+                code = UAS_RC_TMF_SUCCEEDED;
+            }
+            break;
+        }
+
+        case UAS_TMF_QUERY_TASK_SET:
+        {
+            for (i = 0; i < USBD_MSC_UAS_QUEUE_DEPTH; i++)
+            {
+                if ((itf->UAS.SlotState[i] != UAS_SLOT_FREE) &&
+                    (itf->UAS.Queue[i].LUN[1] == tmf->LUN[1]))
+                {
+                    code = UAS_RC_TMF_SUCCEEDED;
+                }
+            }
+            break;
+        }
+
+        default:
+            code = UAS_RC_TMF_NOT_SUPPORTED;
+            break;
+    }
+
+    uas_respond(itf, tmf->wTag, code);
+}
+
+/**
+ * @brief Copies the UAS endpoint and pipe usage descriptors to the destination buffer.
+ * @param itf: reference of the MSC interface
+ * @param dest: the destination buffer
+ * @return Length of the copied descriptors
+ */
+uint16_t MSC_UAS_EpDesc(USBD_MSC_IfHandleType *itf, uint8_t *dest)
+{
+    const uint8_t pipes[][2] = {
+        { itf->Config.CmdEpNum,     UAS_PIPE_COMMAND  },
+        { itf->Config.StatusEpNum,  UAS_PIPE_STATUS   },
+        { itf->Config.InEpNum,      UAS_PIPE_DATA_IN  },
+        { itf->Config.OutEpNum,     UAS_PIPE_DATA_OUT },
+    };
+    uint16_t len = 0;
+    uint8_t i;
+
+    for (i = 0; i < sizeof(pipes) / sizeof(pipes[0]); i++)
+    {
+        UAS_PipeUsageDescType *pd;
+
+#if (USBD_HS_SUPPORT == 1)
+        USB_EndpointDescType *ed = (USB_EndpointDescType*)&dest[len];
+#endif
+        len += USBD_EpDesc(itf->Base.Device, pipes[i][0], &dest[len]);
+
+#if (USBD_HS_SUPPORT == 1)
+        if (itf->Base.Device->Speed == USB_SPEED_FULL)
+        {
+            ed->wMaxPacketSize = USB_EP_BULK_FS_MPS;
+        }
+#endif
+
+        pd = (UAS_PipeUsageDescType*)&dest[len];
+        pd->bLength         = sizeof(UAS_PipeUsageDescType);
+        pd->bDescriptorType = UAS_DESC_TYPE_PIPE_USAGE;
+        pd->bPipeID         = pipes[i][1];
+        pd->__reserved      = 0;
+        len += sizeof(UAS_PipeUsageDescType);
+    }
+    return len;
+}
+
+/**
+ * @brief Initializes the UAS protocol context, and starts the command reception.
+ * @param itf: reference of the MSC interface
+ */
+void MSC_UAS_Init(USBD_MSC_IfHandleType *itf)
+{
+    memset(itf->UAS.SlotState, UAS_SLOT_FREE, sizeof(itf->UAS.SlotState));
+    memset(itf->UAS.SlotStatus, 0, sizeof(itf->UAS.SlotStatus));
+    memset(itf->UAS.PipeSlot, UAS_SLOT_NONE, sizeof(itf->UAS.PipeSlot));
+    itf->UAS.OrderCount = 0;
+    itf->UAS.RxSlot = UAS_SLOT_NONE;
+    itf->UAS.Current = UAS_SLOT_NONE;
+    itf->UAS.MediaSlot = UAS_SLOT_NONE;
+    itf->UAS.StatusPending = 0;
+    itf->UAS.StatusXfer = 0;
+
+    itf->SCSI.XferBusy = 0;
+    itf->SCSI.MediaBusy = 0;
+
+    uas_receiveIU(itf);
+}
+
+/**
+ * @brief Continues the command which has been waiting for the completion
+ *        of its asynchronous LU access, and the other commands waiting for the LU.
+ * @param itf: reference of the MSC interface
+ * @param status: the result of the LU access
+ */
+void MSC_UAS_MediaComplete(USBD_MSC_IfHandleType *itf, USBD_ReturnType status)
+{
+    uas_select(itf, itf->UAS.MediaSlot);
+
+    if ((itf->State == MSC_STATE_DATA_IN) ||
+        (itf->State == MSC_STATE_DATA_OUT))
+    {
+        SCSI_MediaComplete(itf, status);
+    }
+    else
+    {
+        /* The transport has been terminated in the meantime */
+        itf->SCSI.MediaBusy = 0;
+    }
+
+    uas_mediaUpdate(itf);
+    uas_dataTransport(itf);
+    uas_process(itf);
+}
+
+/**
+ * @brief Processes the received IUs on the command pipe,
+ *        and the block data received on the data-out pipe.
+ * @param itf: reference of the MSC interface
+ * @param ep: reference to the OUT endpoint structure
+ */
+void MSC_UAS_OutData(USBD_MSC_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint8_t slot;
+
+    if (ep == USBD_EpAddr2Ref(dev, itf->Config.CmdEpNum))
+    {
+        USBD_MSC_UAS_CommandIUType *cmd;
+
+        slot = itf->UAS.RxSlot;
+        cmd = &itf->UAS.Queue[slot];
+        itf->UAS.RxSlot = UAS_SLOT_NONE;
+
+        if ((cmd->bIUID == UAS_IU_COMMAND) &&
+            (ep->Transfer.Length == sizeof(*cmd)))
+        {
+            if (uas_findTag(itf, cmd->wTag) != UAS_SLOT_NONE)
+            {
+                uas_respond(itf, cmd->wTag, UAS_RC_OVERLAPPED_TAG);
+            }
+            else
+            {
+                uas_setupCommand(itf, slot);
+
+                itf->UAS.SlotState[slot] = UAS_SLOT_QUEUED;
+                itf->UAS.SlotOrder[slot] = itf->UAS.OrderCount++;
+            }
+        }
+        else if ((cmd->bIUID == UAS_IU_TASK_MGMT) &&
+                 (ep->Transfer.Length == UAS_TMF_IU_SIZE))
+        {
+            uas_taskManagement(itf, (const UAS_TaskMgmtIUType*)cmd);
+        }
+        else
+        {
+            uas_respond(itf, cmd->wTag, UAS_RC_INVALID_IU);
+        }
+
+        uas_receiveIU(itf);
+        uas_process(itf);
+    }
+    else if ((slot = itf->UAS.PipeSlot[USB_DIRECTION_OUT]) != UAS_SLOT_NONE)
+    {
+        uas_select(itf, slot);
+
+        if (itf->State == MSC_STATE_DATA_OUT)
+        {
+            /* Continue with WRITE command */
+            SCSI_ProcessWrite(itf);
+
+            uas_mediaUpdate(itf);
+            uas_dataTransport(itf);
+        }
+        uas_process(itf);
+    }
+}
+
+/**
+ * @brief Advances the status pipe transmissions and the block data sending
+ *        on the data-in pipe.
+ * @param itf: reference of the MSC interface
+ * @param ep: reference to the IN endpoint structure
+ */
+void MSC_UAS_InData(USBD_MSC_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint8_t slot;
+
+    if (ep == USBD_EpAddr2Ref(dev, itf->Config.StatusEpNum))
+    {
+        uint8_t xfer = itf->UAS.StatusXfer;
+
+        itf->UAS.StatusXfer = 0;
+
+        if (xfer == UAS_STATUS_SENSE)
+        {
+            /* The command is finished, release its slot */
+            itf->UAS.SlotState[itf->UAS.StatusSlot] = UAS_SLOT_FREE;
+        }
+
+        uas_receiveIU(itf);
+        uas_process(itf);
+    }
+    else if ((slot = itf->UAS.PipeSlot[USB_DIRECTION_IN]) != UAS_SLOT_NONE)
+    {
+        uas_select(itf, slot);
+
+        if (itf->State == MSC_STATE_DATA_IN)
+        {
+            /* Continue with READ command */
+            SCSI_ProcessRead(itf);
+        }
+        else if (itf->State == MSC_STATE_STATUS_IN)
+        {
+            /* Single or last transfer is complete */
+            itf->SCSI.XferBusy = 0;
+            itf->State = MSC_STATE_COMMAND_OUT;
+        }
+
+        uas_mediaUpdate(itf);
+        uas_dataTransport(itf);
+        uas_process(itf);
+    }
+}
+
+/** @} */
+
+#endif /* (USBD_MSC_UAS_SUPPORT == 1) */
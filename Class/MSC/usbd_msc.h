@@ -44,6 +44,40 @@ extern "C"
 #define USBD_MSC_BUFFER_SIZE        512
 #endif
 
+/* When set to 2 or more, the LU access of the next block range
+ * is overlapped with the USB transfer of the previous one */
+#ifndef USBD_MSC_BUFFER_COUNT
+#define USBD_MSC_BUFFER_COUNT       1
+#endif
+
+/* When set to non-zero, the LUs with a linked @ref USBD_MSC_CacheType
+ * use a write-back cache of this many lines */
+#ifndef USBD_MSC_CACHE_LINES
+#define USBD_MSC_CACHE_LINES        0
+#endif
+
+/* The size of each cache line, preferably the erase sector size of the media,
+ * at most 32 blocks */
+#ifndef USBD_MSC_CACHE_LINE_SIZE
+#define USBD_MSC_CACHE_LINE_SIZE    4096
+#endif
+
+/* When set to 1, the interface gets a USB Attached SCSI alternate setting
+ * next to Bulk-Only Transport. The host can queue several tagged commands,
+ * which are executed concurrently: while a command waits for its LU
+ * (which returned BUSY) or for its data pipe, the next tags proceed,
+ * and each command is completed as soon as its own transfer is done */
+#ifndef USBD_MSC_UAS_SUPPORT
+#define USBD_MSC_UAS_SUPPORT        0
+#endif
+
+/* The number of commands the UAS alternate setting can queue
+ * (when USBD_MSC_UAS_SUPPORT is set to 1),
+ * each queue slot has its own USBD_MSC_BUFFER_COUNT block buffers */
+#ifndef USBD_MSC_UAS_QUEUE_DEPTH
+#define USBD_MSC_UAS_QUEUE_DEPTH    4
+#endif
+
 /** @} */
 
 /** @defgroup USBD_MSC_Exported_Types MSC Exported Types
@@ -169,6 +203,57 @@ typedef struct
 }USBD_MSC_CommandStatusWrapperType;
 
 
+#if (USBD_MSC_UAS_SUPPORT == 1)
+/** @brief UAS Command Information Unit structure */
+typedef struct
+{
+    uint8_t  bIUID;         /*!< Information Unit ID */
+    uint8_t  __reserved0;
+    uint16_t wTag;          /*!< Tag to bind the IUs of a command (big-endian) */
+    uint8_t  bmAttributes;  /*!< Task priority and attribute */
+    uint8_t  __reserved1;
+    uint8_t  bAddCDBLength; /*!< Additional CDB length in dwords (bits 7..2) */
+    uint8_t  __reserved2;
+    uint8_t  LUN[8];        /*!< Logical Unit Number */
+    uint8_t  CDB[16];       /*!< Command Descriptor Block */
+}USBD_MSC_UAS_CommandIUType;
+
+
+/** @brief UAS Sense Information Unit structure */
+typedef struct
+{
+    uint8_t  bIUID;         /*!< Information Unit ID */
+    uint8_t  __reserved0;
+    uint16_t wTag;          /*!< Tag of the completed command */
+    uint16_t wStatusQualifier;/*!< SCSI status qualifier */
+    uint8_t  bStatus;       /*!< SCSI status */
+    uint8_t  __reserved1[7];
+    uint16_t wLength;       /*!< Length of the sense data (big-endian) */
+    uint8_t  SenseData[18]; /*!< Fixed format sense data */
+}__packed USBD_MSC_UAS_SenseIUType;
+
+
+/** @brief UAS Response Information Unit structure */
+typedef struct
+{
+    uint8_t  bIUID;         /*!< Information Unit ID */
+    uint8_t  __reserved0;
+    uint16_t wTag;          /*!< Tag of the task management request */
+    uint8_t  AddResponseInfo[3];/*!< Additional response information */
+    uint8_t  bResponseCode; /*!< Response code */
+}USBD_MSC_UAS_ResponseIUType;
+
+
+/** @brief UAS Read/Write Ready Information Unit structure */
+typedef struct
+{
+    uint8_t  bIUID;         /*!< Information Unit ID */
+    uint8_t  __reserved0;
+    uint16_t wTag;          /*!< Tag of the command ready for data transfer */
+}USBD_MSC_UAS_ReadyIUType;
+#endif /* (USBD_MSC_UAS_SUPPORT == 1) */
+
+
 /** @brief MSC Logical Unit status */
 typedef struct
 {
@@ -179,6 +264,29 @@ typedef struct
 }USBD_MSC_LUStatusType;
 
 
+#if (USBD_MSC_CACHE_LINES > 0)
+/** @brief MSC Logical Unit write-back cache line */
+typedef struct
+{
+    uint8_t  Data[USBD_MSC_CACHE_LINE_SIZE];/*!< Cached blocks of the line */
+    uint32_t Tag;           /*!< Line index in the LU */
+    uint32_t ValidMask;     /*!< Bitmask of the blocks holding valid data */
+    uint32_t LastUse;       /*!< Usage counter value at the last access */
+    uint8_t  Dirty;         /*!< Indicates that the line has to be written to the LU */
+}USBD_MSC_CacheLineType;
+
+
+/** @brief MSC Logical Unit write-back cache
+ * @note  The cache requires synchronously completing Read and Write calls */
+typedef struct
+{
+    USBD_MSC_CacheLineType Line[USBD_MSC_CACHE_LINES]; /*!< Cache lines */
+    uint32_t UseCount;      /*!< Access counter for LRU replacement */
+    uint32_t BlockSize;     /*!< LU block size of the cached lines */
+}USBD_MSC_CacheType;
+#endif
+
+
 /** @brief MSC Logical Unit interfacing structure */
 typedef struct
 {
@@ -186,14 +294,34 @@ typedef struct
     void    (*Stop)         (void);             /*!< Stop media (by StopUnit command) */
     uint8_t (*Read)         (uint8_t *dest,
                              uint32_t blockAddr,
-                             uint16_t blockLen);/*!< Read media block */
+                             uint16_t blockLen);/*!< Read media block
+                                                     @note Returning BUSY indicates that the read
+                                                     is completed later by @ref USBD_MSC_LUComplete */
     uint8_t (*Write)        (uint8_t *src,
                              uint32_t blockAddr,
-                             uint16_t blockLen);/*!< Write media block */
+                             uint16_t blockLen);/*!< Write media block
+                                                     @note Returning BUSY indicates that the write
+                                                     is completed later by @ref USBD_MSC_LUComplete */
 
     const USBD_SCSI_StdInquiryType* Inquiry;    /*!< Standard Inquiry of Logical Unit */
 
     USBD_MSC_LUStatusType* Status;              /*!< Up-to-date status of Logical Unit */
+#if (USBD_MSC_CACHE_LINES > 0)
+    USBD_MSC_CacheType* Cache;                  /*!< Optional write-back cache of Logical Unit
+                                                     @note The cache is only used by the commands
+                                                     while the block size is valid, and at most
+                                                     32 blocks fit in a cache line. The cached data
+                                                     is dropped when the block size changes */
+#endif
+    uint8_t*(*GetBlock)     (uint32_t blockAddr,
+                             uint16_t blockLen,
+                             uint8_t write);    /*!< Optional direct access of memory-mapped media blocks,
+                                                     returns NULL when the blocks are only accessible
+                                                     through the Read or Write calls */
+    uint8_t (*Trim)         (uint32_t blockAddr,
+                             uint32_t blockLen);/*!< Optional discarding of media blocks which are no longer
+                                                     in use (by UNMAP command), their content is undefined
+                                                     until they are written again */
 }USBD_MSC_LUType;
 
 
@@ -204,16 +332,59 @@ typedef struct
     uint8_t InEpNum;    /*!< IN endpoint address */
     uint8_t MaxLUN;     /*!< Last Logical Unit Number in
                              @ref USBD_MSC_IfHandleType::LUs (starting from 0) */
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    uint8_t CmdEpNum;   /*!< UAS command pipe OUT endpoint address
+                             (the data pipes are the above BOT endpoints) */
+    uint8_t StatusEpNum;/*!< UAS status pipe IN endpoint address */
+#endif
 }USBD_MSC_ConfigType;
 
 
+/** @brief SCSI command processing context */
+typedef struct
+{
+    USBD_SCSI_SenseType Sense;          /*!< Last sense data */
+    uint32_t Address;                   /*!< Current block address in LU */
+    uint32_t RemLength;                 /*!< Remaining block length to access in LU */
+    uint8_t  BufIndex;                  /*!< Buffer index of the current USB transfer */
+    uint8_t  BufPending;                /*!< Number of buffers waiting for
+                                             USB transfer (read) or LU access (write) */
+    uint8_t  XferBusy;                  /*!< USB transfer of the current buffer is ongoing */
+    uint8_t  Direct;                    /*!< USB transfer is ongoing directly on LU memory */
+    volatile uint8_t MediaBusy;         /*!< Asynchronous LU access is ongoing */
+#if (USBD_MSC_CACHE_LINES > 0)
+    uint8_t  Cached;                    /*!< The LU of the command uses its cache */
+#endif
+}USBD_SCSI_ContextType;
+
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+/** @brief UAS command context of a queue slot, stored while other commands are processed */
+typedef struct
+{
+    USBD_MSC_CommandBlockWrapperType  CBW;  /*!< Command Block Wrapper */
+    USBD_MSC_CommandStatusWrapperType CSW;  /*!< Command Status Wrapper */
+    USBD_MSC_StateType  State;              /*!< Command transport state */
+    USBD_SCSI_ContextType SCSI;             /*!< SCSI context data */
+}USBD_MSC_UAS_ContextType;
+#endif
+
+
 /** @brief MSC class interface structure */
 typedef struct
 {
     USBD_IfHandleType Base;                 /*!< Class-independent interface base */
     const USBD_MSC_LUType* LUs;             /*!< Logical Units reference */
 
-    uint8_t Buffer[USBD_MSC_BUFFER_SIZE];   /*!< Block transferring buffer */
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    uint8_t (*Buffer)[USBD_MSC_BUFFER_SIZE];/*!< Block transferring buffers of the current command */
+#elif (USBD_ARENA_BLOCK_COUNT > 0)
+    uint8_t (*Buffer)[USBD_MSC_BUFFER_SIZE];/*!< Block transferring buffers,
+                                                 allocated from the device arena when mounted */
+#else
+    uint8_t Buffer[USBD_MSC_BUFFER_COUNT]
+                  [USBD_MSC_BUFFER_SIZE];   /*!< Block transferring buffers */
+#endif
     USBD_MSC_CommandBlockWrapperType  CBW;  /*!< Command Block Wrapper */
     USBD_MSC_CommandStatusWrapperType CSW;  /*!< Command Status Wrapper */
 
@@ -222,11 +393,42 @@ typedef struct
     USBD_MSC_StateType  State;              /*!< MSC interface state */
     USBD_MSC_StatusType Status;             /*!< MSC interface error status */
 
+    USBD_SCSI_ContextType SCSI;             /*!< SCSI context data */
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
     struct {
-        USBD_SCSI_SenseType Sense;          /*!< Last sense data */
-        uint32_t Address;                   /*!< Current address in LU block */
-        uint32_t RemLength;                 /*!< Remaining block length to transfer */
-    }SCSI;                                  /*!< SCSI context data */
+        USBD_MSC_UAS_CommandIUType Queue[USBD_MSC_UAS_QUEUE_DEPTH]; /*!< Tagged command queue */
+        USBD_MSC_UAS_ContextType Context[USBD_MSC_UAS_QUEUE_DEPTH]; /*!< Stored command contexts */
+#if (USBD_ARENA_BLOCK_COUNT > 0)
+        uint8_t (*Buffers)[USBD_MSC_BUFFER_SIZE];       /*!< Block transferring buffers of the queue slots,
+                                                             allocated from the device arena when mounted */
+#else
+        uint8_t  Buffers[USBD_MSC_UAS_QUEUE_DEPTH * USBD_MSC_BUFFER_COUNT]
+                        [USBD_MSC_BUFFER_SIZE];         /*!< Block transferring buffers of the queue slots */
+#endif
+        uint8_t  SlotState[USBD_MSC_UAS_QUEUE_DEPTH];   /*!< States of the queue slots */
+        uint8_t  SlotOrder[USBD_MSC_UAS_QUEUE_DEPTH];   /*!< Arrival order of the queued commands */
+        uint8_t  SlotFlags[USBD_MSC_UAS_QUEUE_DEPTH];   /*!< Data phase and ordering of the commands */
+        uint8_t  SlotStatus[USBD_MSC_UAS_QUEUE_DEPTH];  /*!< Status IUs of the commands
+                                                             waiting for transmission */
+        uint8_t  OrderCount;                /*!< Arrival counter */
+        uint8_t  RxSlot;                    /*!< Queue slot receiving the next IU */
+        uint8_t  Current;                   /*!< Queue slot of the command context in the interface */
+        uint8_t  MediaSlot;                 /*!< Queue slot of the command accessing the LU */
+        uint8_t  PipeSlot[2];               /*!< Queue slots of the commands transferring data
+                                                 on the data-out and data-in pipes */
+        uint8_t  StatusPending;             /*!< Response IU is waiting for transmission */
+        uint8_t  StatusXfer;                /*!< Status IU being transmitted */
+        uint8_t  StatusSlot;                /*!< Queue slot of the transmitted Status IU */
+        USBD_MSC_UAS_ReadyIUType    Ready;  /*!< Read/Write Ready IU */
+        USBD_MSC_UAS_SenseIUType    Sense;  /*!< Sense IU */
+        USBD_MSC_UAS_ResponseIUType Response;/*!< Response IU */
+    }UAS;                                   /*!< UAS context data */
+#endif
+#if (USBD_MSC_CACHE_LINES > 0)
+    uint8_t CacheFlushPending;              /*!< The caches are written back before
+                                                 the next command, as requested by BOT reset */
+#endif
 }USBD_MSC_IfHandleType;
 
 /** @} */
@@ -235,6 +437,9 @@ typedef struct
  * @{ */
 USBD_ReturnType USBD_MSC_MountInterface (USBD_MSC_IfHandleType *itf,
                                          USBD_HandleType *dev);
+
+void            USBD_MSC_LUComplete     (USBD_MSC_IfHandleType *itf,
+                                         USBD_ReturnType status);
 /** @} */
 
 /** @} */
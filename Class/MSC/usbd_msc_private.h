@@ -69,8 +69,73 @@ typedef enum
     SCSI_VERIFY10                       = 0x2F,
     SCSI_VERIFY12                       = 0xAF,
     SCSI_VERIFY16                       = 0x8F,
+
+    SCSI_SYNCHRONIZE_CACHE10            = 0x35,
+    SCSI_SYNCHRONIZE_CACHE16            = 0x91,
+
+    SCSI_UNMAP                          = 0x42,
 }USBD_SCSI_OperationCodeType;
 
+/** @brief SCSI service actions of SERVICE ACTION IN(16) */
+typedef enum
+{
+    SCSI_SA_READ_CAPACITY16             = 0x10,
+}USBD_SCSI_ServiceActionType;
+
+/** @brief SCSI Vital Product Data page codes */
+typedef enum
+{
+    SCSI_VPD_SUPPORTED_PAGES            = 0x00,
+    SCSI_VPD_BLOCK_LIMITS               = 0xB0,
+    SCSI_VPD_LB_PROVISIONING            = 0xB2,
+}USBD_SCSI_VPDPageType;
+
+/** @brief SCSI mode page codes */
+typedef enum
+{
+    SCSI_MODE_PAGE_CACHING              = 0x08,
+    SCSI_MODE_PAGE_ALL                  = 0x3F,
+}USBD_SCSI_ModePageType;
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+/** @brief UAS Information Unit IDs */
+typedef enum
+{
+    UAS_IU_COMMAND              = 0x01,
+    UAS_IU_SENSE                = 0x03,
+    UAS_IU_RESPONSE             = 0x04,
+    UAS_IU_TASK_MGMT            = 0x05,
+    UAS_IU_READ_READY           = 0x06,
+    UAS_IU_WRITE_READY          = 0x07,
+}USBD_UAS_IUIDType;
+
+/** @brief UAS task management functions */
+typedef enum
+{
+    UAS_TMF_ABORT_TASK          = 0x01,
+    UAS_TMF_ABORT_TASK_SET      = 0x02,
+    UAS_TMF_CLEAR_TASK_SET      = 0x04,
+    UAS_TMF_LOGICAL_UNIT_RESET  = 0x08,
+    UAS_TMF_I_T_NEXUS_RESET     = 0x10,
+    UAS_TMF_CLEAR_ACA           = 0x40,
+    UAS_TMF_QUERY_TASK          = 0x80,
+    UAS_TMF_QUERY_TASK_SET      = 0x81,
+    UAS_TMF_QUERY_ASYNC_EVENT   = 0x82,
+}USBD_UAS_TaskMgmtType;
+
+/** @brief UAS response codes */
+typedef enum
+{
+    UAS_RC_TMF_COMPLETE         = 0x00,
+    UAS_RC_INVALID_IU           = 0x02,
+    UAS_RC_TMF_NOT_SUPPORTED    = 0x04,
+    UAS_RC_TMF_FAILED           = 0x05,
+    UAS_RC_TMF_SUCCEEDED        = 0x08,
+    UAS_RC_INCORRECT_LUN        = 0x09,
+    UAS_RC_OVERLAPPED_TAG       = 0x0A,
+}USBD_UAS_ResponseCodeType;
+#endif /* (USBD_MSC_UAS_SUPPORT == 1) */
+
 /** @brief SCSI Sense Keys */
 typedef enum
 {
@@ -95,6 +160,7 @@ typedef enum
 {
     SCSI_ASC_INVALID_CDB                    = 0x20,
     SCSI_ASC_INVALID_FIELD_IN_COMMAND       = 0x24,
+    SCSI_ASC_LOGICAL_UNIT_NOT_SUPPORTED     = 0x25,
     SCSI_ASC_PARAMETER_LIST_LENGTH_ERROR    = 0x1A,
     SCSI_ASC_ADDRESS_OUT_OF_RANGE           = 0x21,
     SCSI_ASC_MEDIUM_NOT_PRESENT             = 0x3A,
@@ -112,10 +178,50 @@ const USBD_MSC_LUType* MSC_GetLU    (USBD_MSC_IfHandleType *itf,
 void            SCSI_ProcessCommand (USBD_MSC_IfHandleType *itf);
 USBD_ReturnType SCSI_ProcessRead    (USBD_MSC_IfHandleType *itf);
 USBD_ReturnType SCSI_ProcessWrite   (USBD_MSC_IfHandleType *itf);
+USBD_ReturnType SCSI_MediaComplete  (USBD_MSC_IfHandleType *itf,
+                                     USBD_ReturnType status);
 
 void            SCSI_PutSenseCode   (USBD_MSC_IfHandleType *itf,
                                      USBD_SCSI_SenseKeyType skey,
                                      USBD_SCSI_AddSenseCodeType asc);
+uint32_t        SCSI_GetSenseData   (USBD_MSC_IfHandleType *itf,
+                                     uint8_t *dest);
+
+#if (USBD_MSC_CACHE_LINES > 0)
+USBD_ReturnType MSC_CacheRead       (const USBD_MSC_LUType *LU,
+                                     uint8_t *dest,
+                                     uint32_t blockAddr,
+                                     uint16_t blockLen);
+USBD_ReturnType MSC_CacheWrite      (const USBD_MSC_LUType *LU,
+                                     uint8_t *src,
+                                     uint32_t blockAddr,
+                                     uint16_t blockLen);
+USBD_ReturnType MSC_CacheFlush      (const USBD_MSC_LUType *LU);
+void            MSC_CacheDiscard    (const USBD_MSC_LUType *LU,
+                                     uint32_t blockAddr,
+                                     uint32_t blockLen);
+uint8_t         MSC_CacheUsable     (const USBD_MSC_LUType *LU);
+
+/** @brief Whether the current command's data goes through the LU's cache */
+#define MSC_CACHE_USED(ITF)         ((ITF)->SCSI.Cached)
+#else
+#define MSC_CACHE_USED(ITF)         0
+#endif
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+uint32_t        SCSI_GetDataLength  (USBD_MSC_IfHandleType *itf);
+USBD_ReturnType SCSI_ProcessNext    (USBD_MSC_IfHandleType *itf);
+
+uint16_t        MSC_UAS_EpDesc      (USBD_MSC_IfHandleType *itf,
+                                     uint8_t *dest);
+void            MSC_UAS_Init        (USBD_MSC_IfHandleType *itf);
+void            MSC_UAS_OutData     (USBD_MSC_IfHandleType *itf,
+                                     USBD_EpHandleType *ep);
+void            MSC_UAS_InData      (USBD_MSC_IfHandleType *itf,
+                                     USBD_EpHandleType *ep);
+void            MSC_UAS_MediaComplete(USBD_MSC_IfHandleType *itf,
+                                     USBD_ReturnType status);
+#endif
 
 
 #ifdef __cplusplus
@@ -0,0 +1,1063 @@
+/**
+  ******************************************************************************
+  * @file    usbd_ncm.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB CDC Network Control Model implementation
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+#include <usbd_ncm.h>
+
+#if (USBD_MAX_IF_COUNT < 2)
+#error "A single NCM interface takes up 2 device interface slots!"
+#endif
+
+#if (USBD_NCM_TX_TIMEOUT > 0) && (USBD_SOF_SUPPORT != 1)
+#error "The NCM aggregation timeout requires USBD_SOF_SUPPORT!"
+#endif
+
+#if (USBD_NCM_NTB_IN_SIZE < 2048) || (USBD_NCM_NTB_IN_SIZE > 0xFFFF)
+#error "USBD_NCM_NTB_IN_SIZE shall be between 2048 and 65535!"
+#endif
+
+#define NCM_NOT_INTR_INTERVAL                       16
+#define NCM_NOT_INTR_INTERVAL_HS                    8
+#define NCM_NOT_PACKET_SIZE                         16
+#if (USBD_HS_SUPPORT == 1)
+#define NCM_DATA_PACKET_SIZE                        USB_EP_BULK_HS_MPS
+#else
+#define NCM_DATA_PACKET_SIZE                        USB_EP_BULK_FS_MPS
+#endif
+
+/* Interface-internal index of the MAC address string */
+#define NCM_ISTR_MAC_ADDRESS                        1
+
+/* NTB16 signatures */
+#define NCM_NTH16_SIGNATURE                         0x484D434E /* "NCMH" */
+#define NCM_NDP16_SIGNATURE                         0x304D434E /* "NCM0" */
+
+/* The datagrams and NDPs are aligned to this many bytes in both directions */
+#define NCM_NDP_ALIGNMENT                           4
+#define NCM_ALIGN(X)    (((X) + NCM_NDP_ALIGNMENT - 1) & ~(NCM_NDP_ALIGNMENT - 1))
+
+/* The number of NDPs processed in an OUT NTB */
+#define NCM_MAX_RX_NDP_COUNT                        8
+
+/* Pending notification flags */
+#define NCM_NOTIFY_SPEED_CHANGE                     0x01
+#define NCM_NOTIFY_CONNECTION                       0x02
+
+#define NCM_APP(ITF)    ((USBD_NCM_AppType*)((ITF)->App))
+
+/** @brief NCM class specific requests */
+typedef enum
+{
+    NCM_SET_ETHERNET_PACKET_FILTER  = 0x43, /*!< Ethernet packet filter bitmap */
+    NCM_GET_NTB_PARAMETERS          = 0x80, /*!< NTB parameter structure */
+    NCM_GET_NTB_FORMAT              = 0x83, /*!< Current NTB format */
+    NCM_SET_NTB_FORMAT              = 0x84, /*!< Select NTB format */
+    NCM_GET_NTB_INPUT_SIZE          = 0x85, /*!< Current IN NTB size limit */
+    NCM_SET_NTB_INPUT_SIZE          = 0x86, /*!< Select IN NTB size limit */
+}USBD_NCM_RequestType;
+
+/** @brief NCM notification codes */
+typedef enum
+{
+    NCM_NOTIFY_NETWORK_CONNECTION   = 0x00, /*!< Network link state */
+    NCM_NOTIFY_SPEED_CHANGE_CODE    = 0x2A, /*!< Network link bit rates */
+}USBD_NCM_NotificationType;
+
+/* NTB parameter structure */
+typedef struct
+{
+    uint16_t wLength;
+    uint16_t bmNtbFormatsSupported;
+    uint32_t dwNtbInMaxSize;
+    uint16_t wNdpInDivisor;
+    uint16_t wNdpInPayloadRemainder;
+    uint16_t wNdpInAlignment;
+    uint16_t wReserved;
+    uint32_t dwNtbOutMaxSize;
+    uint16_t wNdpOutDivisor;
+    uint16_t wNdpOutPayloadRemainder;
+    uint16_t wNdpOutAlignment;
+    uint16_t wNtbOutMaxDatagrams;
+}__packed USBD_NCM_NtbParametersType;
+
+/* NTB16 transfer header */
+typedef struct
+{
+    uint32_t dwSignature;
+    uint16_t wHeaderLength;
+    uint16_t wSequence;
+    uint16_t wBlockLength;
+    uint16_t wNdpIndex;
+}__packed USBD_NCM_Nth16Type;
+
+/* NTB16 datagram pointer table */
+typedef struct
+{
+    uint32_t dwSignature;
+    uint16_t wLength;
+    uint16_t wNextNdpIndex;
+    struct {
+        uint16_t wDatagramIndex;
+        uint16_t wDatagramLength;
+    }__packed Datagram[];
+}__packed USBD_NCM_Ndp16Type;
+
+/* Notification header */
+typedef struct
+{
+    uint8_t  bmRequestType;
+    uint8_t  bNotificationCode;
+    uint16_t wValue;
+    uint16_t wIndex;
+    uint16_t wLength;
+    uint32_t DLBitRate;
+    uint32_t ULBitRate;
+}__packed USBD_NCM_NotificationDataType;
+
+typedef struct
+{
+    /* Interface Association Descriptor */
+    USB_IfAssocDescType IAD;
+    /* Communication Interface Descriptor */
+    USB_InterfaceDescType CID;
+    /* Header Functional Descriptor */
+    struct {
+        uint8_t bLength;
+        uint8_t bDescriptorType;
+        uint8_t bDescriptorSubtype;
+        uint16_t bcdCDC;
+    }__packed HFD;
+    /* Union Functional Descriptor */
+    struct {
+        uint8_t  bFunctionLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bMasterInterface;
+        uint8_t  bSlaveInterface0;
+    }__packed UFD;
+    /* Ethernet Networking Functional Descriptor */
+    struct {
+        uint8_t  bFunctionLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  iMACAddress;
+        uint32_t bmEthernetStatistics;
+        uint16_t wMaxSegmentSize;
+        uint16_t wNumberMCFilters;
+        uint8_t  bNumberPowerFilters;
+    }__packed ENFD;
+    /* NCM Functional Descriptor */
+    struct {
+        uint8_t  bFunctionLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint16_t bcdNcmVersion;
+        uint8_t  bmNetworkCapabilities;
+    }__packed NCMFD;
+    /* Notification Endpoint Descriptor */
+    USB_EndpointDescType NED;
+    /* Data Interface Descriptor (no endpoints) */
+    USB_InterfaceDescType DID0;
+    /* Data Interface Descriptor (operational) */
+    USB_InterfaceDescType DID1;
+    /* Endpoint descriptors are dynamically added */
+}__packed USBD_NCM_DescType;
+
+static const USBD_NCM_DescType ncm_desc = {
+    .IAD = { /* Interface Association Descriptor */
+        .bLength            = sizeof(ncm_desc.IAD),
+        .bDescriptorType    = USB_DESC_TYPE_IAD,
+        .bFirstInterface    = 0,
+        .bInterfaceCount    = 2,
+        .bFunctionClass     = 0x02, /* bFunctionClass: Communication Interface Class */
+        .bFunctionSubClass  = 0x0D, /* bFunctionSubClass: Network Control Model */
+        .bFunctionProtocol  = 0x00, /* bFunctionProtocol: No encapsulated commands */
+        .iFunction          = USBD_ISTR_INTERFACES,
+    },
+    .CID = { /* Comm Interface Descriptor */
+        .bLength            = sizeof(ncm_desc.CID),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 0,
+        .bAlternateSetting  = 0,
+        .bNumEndpoints      = 1,
+        .bInterfaceClass    = 0x02, /* bInterfaceClass: Communication Interface Class */
+        .bInterfaceSubClass = 0x0D, /* bInterfaceSubClass: Network Control Model */
+        .bInterfaceProtocol = 0x00, /* bInterfaceProtocol: No encapsulated commands */
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+    .HFD = { /* Header Functional Descriptor */
+        .bLength            = sizeof(ncm_desc.HFD),
+        .bDescriptorType    = 0x24, /* bDescriptorType: CS_INTERFACE */
+        .bDescriptorSubtype = 0x00, /* bDescriptorSubtype: Header Func Desc */
+        .bcdCDC             = 0x110,/* bcdCDC: spec release number v1.10 */
+    },
+    .UFD = { /* Union Functional Descriptor */
+        .bFunctionLength    = sizeof(ncm_desc.UFD),
+        .bDescriptorType    = 0x24, /* bDescriptorType: CS_INTERFACE */
+        .bDescriptorSubtype = 0x06, /* bDescriptorSubtype: Union func desc */
+        .bMasterInterface   = 0,
+        .bSlaveInterface0   = 1,
+    },
+    .ENFD = { /* Ethernet Networking Functional Descriptor */
+        .bFunctionLength    = sizeof(ncm_desc.ENFD),
+        .bDescriptorType    = 0x24, /* bDescriptorType: CS_INTERFACE */
+        .bDescriptorSubtype = 0x0F, /* bDescriptorSubtype: Ethernet Networking func desc */
+        .iMACAddress        = USBD_ISTR_INTERFACES + (NCM_ISTR_MAC_ADDRESS << 4),
+        .bmEthernetStatistics = 0,
+        .wMaxSegmentSize    = USBD_NCM_MAX_SEGMENT_SIZE,
+        .wNumberMCFilters   = 0,
+        .bNumberPowerFilters = 0,
+    },
+    .NCMFD = { /* NCM Functional Descriptor */
+        .bFunctionLength    = sizeof(ncm_desc.NCMFD),
+        .bDescriptorType    = 0x24, /* bDescriptorType: CS_INTERFACE */
+        .bDescriptorSubtype = 0x1A, /* bDescriptorSubtype: NCM func desc */
+        .bcdNcmVersion      = 0x100,/* bcdNcmVersion: spec release number v1.00 */
+        .bmNetworkCapabilities = 0x00,
+    },
+    .NED = { /* Notification Endpoint Descriptor */
+        .bLength            = sizeof(ncm_desc.NED),
+        .bDescriptorType    = USB_DESC_TYPE_ENDPOINT,
+        .bEndpointAddress   = 0x82,
+        .bmAttributes       = USB_EP_TYPE_INTERRUPT,
+        .wMaxPacketSize     = NCM_NOT_PACKET_SIZE,
+        .bInterval          = NCM_NOT_INTR_INTERVAL,
+    },
+    .DID0 = { /* Data class interface descriptor (no endpoints) */
+        .bLength            = sizeof(ncm_desc.DID0),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 1,
+        .bAlternateSetting  = 0,
+        .bNumEndpoints      = 0,
+        .bInterfaceClass    = 0x0A, /* bInterfaceClass: Data Interface Class */
+        .bInterfaceSubClass = 0x00,
+        .bInterfaceProtocol = 0x01, /* bInterfaceProtocol: Network Transfer Block */
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+    .DID1 = { /* Data class interface descriptor (operational) */
+        .bLength            = sizeof(ncm_desc.DID1),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 1,
+        .bAlternateSetting  = 1,
+        .bNumEndpoints      = 2,
+        .bInterfaceClass    = 0x0A, /* bInterfaceClass: Data Interface Class */
+        .bInterfaceSubClass = 0x00,
+        .bInterfaceProtocol = 0x01, /* bInterfaceProtocol: Network Transfer Block */
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+};
+
+static const USBD_NCM_NtbParametersType ncm_ntbParams = {
+    .wLength                    = sizeof(USBD_NCM_NtbParametersType),
+    .bmNtbFormatsSupported      = 0x0001, /* NTB16 only */
+    .dwNtbInMaxSize             = USBD_NCM_NTB_IN_SIZE,
+    .wNdpInDivisor              = NCM_NDP_ALIGNMENT,
+    .wNdpInPayloadRemainder     = 0,
+    .wNdpInAlignment            = NCM_NDP_ALIGNMENT,
+    .wReserved                  = 0,
+    .dwNtbOutMaxSize            = USBD_NCM_NTB_OUT_SIZE,
+    .wNdpOutDivisor             = NCM_NDP_ALIGNMENT,
+    .wNdpOutPayloadRemainder    = 0,
+    .wNdpOutAlignment           = NCM_NDP_ALIGNMENT,
+    .wNtbOutMaxDatagrams        = 0, /* No limit */
+};
+
+static uint16_t         ncm_getDesc     (USBD_NCM_IfHandleType *itf, uint8_t ifNum, uint8_t * dest);
+static const char *     ncm_getString   (USBD_NCM_IfHandleType *itf, uint8_t intNum);
+static void             ncm_init        (USBD_NCM_IfHandleType *itf);
+static void             ncm_deinit      (USBD_NCM_IfHandleType *itf);
+static USBD_ReturnType  ncm_setupStage  (USBD_NCM_IfHandleType *itf);
+static void             ncm_dataStage   (USBD_NCM_IfHandleType *itf);
+static void             ncm_outData     (USBD_NCM_IfHandleType *itf, USBD_EpHandleType *ep);
+static void             ncm_inData      (USBD_NCM_IfHandleType *itf, USBD_EpHandleType *ep);
+#if (USBD_NCM_TX_TIMEOUT > 0)
+static void             ncm_sof         (USBD_NCM_IfHandleType *itf);
+#endif
+
+/* NCM interface class callbacks structure */
+static const USBD_ClassType ncm_cbks = {
+    .GetDescriptor  = (USBD_IfDescCbkType)  ncm_getDesc,
+    .GetString      = (USBD_IfStrCbkType)   ncm_getString,
+    .Init           = (USBD_IfCbkType)      ncm_init,
+    .Deinit         = (USBD_IfCbkType)      ncm_deinit,
+    .SetupStage     = (USBD_IfSetupCbkType) ncm_setupStage,
+    .DataStage      = (USBD_IfCbkType)      ncm_dataStage,
+    .OutData        = (USBD_IfEpCbkType)    ncm_outData,
+    .InData         = (USBD_IfEpCbkType)    ncm_inData,
+#if (USBD_NCM_TX_TIMEOUT > 0)
+    .Sof            = (USBD_IfCbkType)      ncm_sof,
+#endif
+};
+
+/** @ingroup USBD_NCM
+ * @defgroup USBD_NCM_Private_Functions NCM Private Functions
+ * @{ */
+
+/**
+ * @brief Copies the interface descriptor to the destination buffer.
+ * @param itf: reference of the NCM interface
+ * @param ifNum: the index of the current interface in the device
+ * @param dest: the destination buffer
+ * @return Length of the copied descriptor
+ */
+static uint16_t ncm_getDesc(USBD_NCM_IfHandleType *itf, uint8_t ifNum, uint8_t * dest)
+{
+    USBD_NCM_DescType *desc = (USBD_NCM_DescType*)dest;
+    uint16_t len = sizeof(ncm_desc);
+
+    memcpy(dest, &ncm_desc, sizeof(ncm_desc));
+
+#if (USBD_MAX_IF_COUNT > 2)
+    /* Adjustment of interface indexes */
+    desc->IAD.bFirstInterface  = ifNum;
+    desc->IAD.iFunction  = USBD_IIF_INDEX(ifNum, 0);
+
+    desc->CID.bInterfaceNumber = ifNum;
+    desc->UFD.bMasterInterface = ifNum;
+
+    desc->DID0.bInterfaceNumber = ifNum + 1;
+    desc->DID1.bInterfaceNumber = ifNum + 1;
+    desc->UFD.bSlaveInterface0 = ifNum + 1;
+
+    desc->CID.iInterface  = USBD_IIF_INDEX(ifNum, 0);
+    desc->DID0.iInterface = USBD_IIF_INDEX(ifNum, 0);
+    desc->DID1.iInterface = USBD_IIF_INDEX(ifNum, 0);
+    desc->ENFD.iMACAddress = USBD_IIF_INDEX(ifNum, NCM_ISTR_MAC_ADDRESS);
+#endif /* (USBD_MAX_IF_COUNT > 2) */
+
+    desc->NED.bEndpointAddress = itf->Config.NotEpNum;
+
+    len += USBD_EpDesc(itf->Base.Device, itf->Config.OutEpNum, &dest[len]);
+    len += USBD_EpDesc(itf->Base.Device, itf->Config.InEpNum, &dest[len]);
+
+#if (USBD_HS_SUPPORT == 1)
+    if (itf->Base.Device->Speed == USB_SPEED_FULL)
+    {
+        USB_EndpointDescType* ed = (USB_EndpointDescType*)&dest[sizeof(ncm_desc)];
+        ed[0].wMaxPacketSize = USB_EP_BULK_FS_MPS;
+        ed[1].wMaxPacketSize = USB_EP_BULK_FS_MPS;
+    }
+    else
+    {
+        desc->NED.bInterval = NCM_NOT_INTR_INTERVAL_HS;
+    }
+#endif
+
+    return len;
+}
+
+/**
+ * @brief Returns the selected interface string.
+ * @param itf: reference of the NCM interface
+ * @param intNum: interface-internal string index
+ * @return The referenced string
+ */
+static const char* ncm_getString(USBD_NCM_IfHandleType *itf, uint8_t intNum)
+{
+    if (intNum == NCM_ISTR_MAC_ADDRESS)
+    {
+        return itf->MacString;
+    }
+    else
+    {
+        return itf->App->Name;
+    }
+}
+
+/**
+ * @brief Sends the next pending network notification,
+ *        unless one is being transmitted.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_notify(USBD_NCM_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    USBD_NCM_NotificationDataType *notif = (USBD_NCM_NotificationDataType*)itf->Notify.Data;
+    uint16_t len = 0;
+
+    if (itf->Notify.Active != 0)
+    {
+        /* Continued at completion */
+    }
+    else if ((itf->Notify.Pending & NCM_NOTIFY_SPEED_CHANGE) != 0)
+    {
+        uint32_t bitRate = 12000000;
+
+#if (USBD_HS_SUPPORT == 1)
+        if (dev->Speed == USB_SPEED_HIGH)
+        {   bitRate = 480000000; }
+#endif
+        itf->Notify.Pending &= ~NCM_NOTIFY_SPEED_CHANGE;
+
+        notif->bNotificationCode = NCM_NOTIFY_SPEED_CHANGE_CODE;
+        notif->wValue    = 0;
+        notif->wLength   = 8;
+        notif->DLBitRate = bitRate;
+        notif->ULBitRate = bitRate;
+        len = sizeof(USBD_NCM_NotificationDataType);
+    }
+    else if ((itf->Notify.Pending & NCM_NOTIFY_CONNECTION) != 0)
+    {
+        itf->Notify.Pending &= ~NCM_NOTIFY_CONNECTION;
+
+        notif->bNotificationCode = NCM_NOTIFY_NETWORK_CONNECTION;
+        notif->wValue    = itf->Active;
+        notif->wLength   = 0;
+        len = 8;
+    }
+
+    if (len > 0)
+    {
+        notif->bmRequestType = 0xA1;
+        notif->wIndex        = dev->EP.IN[itf->Config.NotEpNum & 0xF].IfNum;
+
+        itf->Notify.Active = 1;
+        USBD_EpSend(dev, itf->Config.NotEpNum, itf->Notify.Data, len);
+    }
+}
+
+/**
+ * @brief Starts the reception to a free OUT NTB buffer,
+ *        unless it's already ongoing or all buffers are held by the application.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_receiveNext(USBD_NCM_IfHandleType *itf)
+{
+    uint8_t i = 0;
+
+    while ((i < USBD_NCM_RX_BUFFER_COUNT) && (itf->RxHeld[i] != 0))
+    {   i++; }
+
+    if ((itf->Active != 0) && (itf->RxActive == 0) && (i < USBD_NCM_RX_BUFFER_COUNT))
+    {
+        itf->RxIndex = i;
+        itf->RxHeld[i] = 1;
+        itf->RxActive = 1;
+        USBD_EpReceive(itf->Base.Device, itf->Config.OutEpNum,
+                itf->RxBuffer[i], USBD_NCM_NTB_OUT_SIZE);
+    }
+}
+
+/**
+ * @brief Releases one hold of an OUT NTB buffer,
+ *        and continues the reception when it becomes free.
+ * @param itf: reference of the NCM interface
+ * @param index: index of the buffer
+ */
+static void ncm_receiveRelease(USBD_NCM_IfHandleType *itf, uint8_t index)
+{
+    if (itf->RxHeld[index] > 0)
+    {
+        itf->RxHeld[index]--;
+
+        if (itf->RxHeld[index] == 0)
+        {
+            ncm_receiveNext(itf);
+        }
+    }
+}
+
+/**
+ * @brief Passes the datagrams of a received NTB16 to the application.
+ *        Malformed headers and tables end the processing of the block.
+ * @param itf: reference of the NCM interface
+ * @param index: index of the buffer
+ * @param length: the received length
+ */
+static void ncm_receiveNtb(USBD_NCM_IfHandleType *itf, uint8_t index, uint16_t length)
+{
+    uint8_t *ntb = itf->RxBuffer[index];
+    USBD_NCM_Nth16Type *nth = (USBD_NCM_Nth16Type*)ntb;
+    uint16_t ndpIndex = 0;
+    uint8_t ndpCount = 0;
+
+    if ((length >= sizeof(USBD_NCM_Nth16Type)) &&
+        (nth->dwSignature == NCM_NTH16_SIGNATURE) &&
+        (nth->wHeaderLength == sizeof(USBD_NCM_Nth16Type)) &&
+        (nth->wBlockLength <= length))
+    {
+        /* A zero block length means the block is terminated by the short packet */
+        if (nth->wBlockLength != 0)
+        {   length = nth->wBlockLength; }
+
+        ndpIndex = nth->wNdpIndex;
+    }
+
+    while ((ndpIndex >= sizeof(USBD_NCM_Nth16Type)) && (ndpCount < NCM_MAX_RX_NDP_COUNT) &&
+           ((ndpIndex % NCM_NDP_ALIGNMENT) == 0) &&
+           ((ndpIndex + sizeof(USBD_NCM_Ndp16Type)) <= length))
+    {
+        USBD_NCM_Ndp16Type *ndp = (USBD_NCM_Ndp16Type*)&ntb[ndpIndex];
+        uint16_t i, count = 0;
+
+        if ((ndp->dwSignature == NCM_NDP16_SIGNATURE) &&
+            ((ndpIndex + ndp->wLength) <= length) &&
+            (ndp->wLength >= sizeof(USBD_NCM_Ndp16Type)))
+        {
+            count = (ndp->wLength - sizeof(USBD_NCM_Ndp16Type)) / sizeof(ndp->Datagram[0]);
+            ndpIndex = ndp->wNextNdpIndex;
+        }
+        else
+        {
+            ndpIndex = 0;
+        }
+
+        /* The table is terminated by a null entry */
+        for (i = 0; (i < count) && (ndp->Datagram[i].wDatagramIndex != 0) &&
+                    (ndp->Datagram[i].wDatagramLength != 0); i++)
+        {
+            uint16_t dgIndex  = ndp->Datagram[i].wDatagramIndex;
+            uint16_t dgLength = ndp->Datagram[i].wDatagramLength;
+
+            if (((uint32_t)dgIndex + dgLength) <= length)
+            {
+                /* The datagram is held until the application releases it */
+                itf->RxHeld[index]++;
+
+                NCM_APP(itf)->Received(&ntb[dgIndex], dgLength);
+            }
+        }
+        ndpCount++;
+    }
+}
+
+/**
+ * @brief Determines whether a datagram fits in the IN NTB under aggregation,
+ *        together with the datagram table that follows it.
+ * @param itf: reference of the NCM interface
+ * @param index: the offset of the datagram
+ * @param length: the length of the datagram
+ * @return Non-zero if the datagram fits
+ */
+static int ncm_transmitFits(USBD_NCM_IfHandleType *itf, uint16_t index, uint16_t length)
+{
+    USBD_NCM_TxNtbType *ntb = &itf->Tx[itf->TxIndex];
+
+    /* The table holds the new entry and the null entry as well */
+    return (ntb->Count < USBD_NCM_TX_MAX_DATAGRAMS) &&
+           ((NCM_ALIGN((uint32_t)index + length) + sizeof(USBD_NCM_Ndp16Type) +
+             (ntb->Count + 2) * sizeof(((USBD_NCM_Ndp16Type*)0)->Datagram[0]))
+                    <= itf->TxMaxSize);
+}
+
+/**
+ * @brief Prepares the IN NTB for the aggregation of new datagrams.
+ * @param ntb: reference of the IN NTB
+ */
+static void ncm_transmitReset(USBD_NCM_TxNtbType *ntb)
+{
+    ntb->Length = sizeof(USBD_NCM_Nth16Type);
+    ntb->Count  = 0;
+}
+
+/**
+ * @brief Completes the aggregated IN NTB with its header and datagram table,
+ *        and starts its transmission, while the other NTB takes over the aggregation.
+ * @note  The IN endpoint has to be idle.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_transmitNtb(USBD_NCM_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    USBD_NCM_TxNtbType *ntb = &itf->Tx[itf->TxIndex];
+    USBD_NCM_Nth16Type *nth = (USBD_NCM_Nth16Type*)ntb->Buffer;
+    uint16_t ndpIndex = NCM_ALIGN(ntb->Length);
+    USBD_NCM_Ndp16Type *ndp = (USBD_NCM_Ndp16Type*)&ntb->Buffer[ndpIndex];
+    uint16_t mps = dev->EP.IN[itf->Config.InEpNum & 0xF].MaxPacketSize;
+    uint16_t len;
+    uint8_t i;
+
+    ndp->dwSignature   = NCM_NDP16_SIGNATURE;
+    ndp->wLength       = sizeof(USBD_NCM_Ndp16Type) +
+                         (ntb->Count + 1) * sizeof(ndp->Datagram[0]);
+    ndp->wNextNdpIndex = 0;
+    for (i = 0; i < ntb->Count; i++)
+    {
+        ndp->Datagram[i].wDatagramIndex  = ntb->Datagram[i].Index;
+        ndp->Datagram[i].wDatagramLength = ntb->Datagram[i].Length;
+    }
+    ndp->Datagram[i].wDatagramIndex  = 0;
+    ndp->Datagram[i].wDatagramLength = 0;
+
+    len = ndpIndex + ndp->wLength;
+
+    /* Shorter blocks end with a short packet instead of a ZLP */
+    if (((len % mps) == 0) && (len < itf->TxMaxSize))
+    {
+        ntb->Buffer[len] = 0;
+        len++;
+    }
+
+    nth->dwSignature   = NCM_NTH16_SIGNATURE;
+    nth->wHeaderLength = sizeof(USBD_NCM_Nth16Type);
+    nth->wSequence     = itf->TxSequence++;
+    nth->wBlockLength  = len;
+    nth->wNdpIndex     = ndpIndex;
+
+    itf->TxActive = 1;
+    itf->TxIndex ^= 1;
+    ncm_transmitReset(&itf->Tx[itf->TxIndex]);
+#if (USBD_NCM_TX_TIMEOUT > 0)
+    itf->TxTimer = 0;
+#endif
+
+    USBD_EpSend(dev, itf->Config.InEpNum, ntb->Buffer, len);
+}
+
+/**
+ * @brief Opens the data endpoints and starts the network function.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_start(USBD_NCM_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint16_t mps;
+    uint8_t i;
+
+#if (USBD_HS_SUPPORT == 1)
+    if (itf->Base.Device->Speed == USB_SPEED_HIGH)
+    {
+        mps = USB_EP_BULK_HS_MPS;
+    }
+    else
+#endif
+    {
+        mps = USB_EP_BULK_FS_MPS;
+    }
+
+    /* Open EPs */
+    USBD_EpOpen(dev, itf->Config.InEpNum , USB_EP_TYPE_BULK, mps,
+            USBD_EP_OPT_DOUBLE_BUFFER);
+    USBD_EpOpen(dev, itf->Config.OutEpNum, USB_EP_TYPE_BULK, mps,
+            USBD_EP_OPT_DOUBLE_BUFFER);
+
+    /* The NTB state is reset at each activation */
+    for (i = 0; i < USBD_NCM_RX_BUFFER_COUNT; i++)
+    {
+        itf->RxHeld[i] = 0;
+    }
+    itf->RxActive   = 0;
+    itf->TxIndex    = 0;
+    itf->TxActive   = 0;
+    itf->TxSequence = 0;
+    ncm_transmitReset(&itf->Tx[0]);
+#if (USBD_NCM_TX_TIMEOUT > 0)
+    itf->TxTimer    = 0;
+#endif
+    itf->Active = 1;
+
+    /* Initialize application */
+    USBD_SAFE_CALLBACK(NCM_APP(itf)->Init, );
+
+    ncm_receiveNext(itf);
+
+    /* Report the link */
+    itf->Notify.Pending = NCM_NOTIFY_SPEED_CHANGE | NCM_NOTIFY_CONNECTION;
+    ncm_notify(itf);
+}
+
+/**
+ * @brief Closes the data endpoints and stops the network function.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_stop(USBD_NCM_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+
+    itf->Active = 0;
+
+    /* Close EPs */
+    USBD_EpClose(dev, itf->Config.InEpNum);
+    USBD_EpClose(dev, itf->Config.OutEpNum);
+
+    /* Deinitialize application */
+    USBD_SAFE_CALLBACK(NCM_APP(itf)->Deinit, );
+
+#if (USBD_HS_SUPPORT == 1)
+    /* Reset the endpoint MPS to the desired size */
+    dev->EP.IN [itf->Config.InEpNum  & 0xF].MaxPacketSize =
+    dev->EP.OUT[itf->Config.OutEpNum      ].MaxPacketSize = NCM_DATA_PACKET_SIZE;
+#endif
+}
+
+/**
+ * @brief Opens the notification endpoint, and starts the network function
+ *        when the operational alternate setting is selected.
+ * @note  The function is called for both device interface slots,
+ *        therefore it only acts on state changes.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_init(USBD_NCM_IfHandleType *itf)
+{
+    if (itf->Opened == 0)
+    {
+        itf->Opened = 1;
+        itf->Notify.Active = 0;
+        itf->Notify.Pending = 0;
+
+        USBD_EpOpen(itf->Base.Device, itf->Config.NotEpNum, USB_EP_TYPE_INTERRUPT,
+                NCM_NOT_PACKET_SIZE, USBD_EP_OPT_NONE);
+    }
+
+    if ((itf->Base.AltSelector != 0) && (itf->Active == 0))
+    {
+        ncm_start(itf);
+    }
+}
+
+/**
+ * @brief Stops the network function and closes the notification endpoint.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_deinit(USBD_NCM_IfHandleType *itf)
+{
+    if (itf->Active != 0)
+    {
+        ncm_stop(itf);
+    }
+
+    if (itf->Opened != 0)
+    {
+        itf->Opened = 0;
+
+        USBD_EpClose(itf->Base.Device, itf->Config.NotEpNum);
+    }
+}
+
+/**
+ * @brief Performs the interface-specific setup request handling.
+ * @param itf: reference of the NCM interface
+ * @return OK if the setup request is accepted, INVALID otherwise
+ */
+static USBD_ReturnType ncm_setupStage(USBD_NCM_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+    USBD_HandleType *dev = itf->Base.Device;
+
+    if (dev->Request.RequestType.Type == USB_REQ_TYPE_CLASS)
+    {
+        switch (dev->Request.Request)
+        {
+            case NCM_GET_NTB_PARAMETERS:
+                retval = USBD_CtrlSendData(dev, (const uint8_t*)&ncm_ntbParams,
+                        sizeof(ncm_ntbParams));
+                break;
+
+            case NCM_GET_NTB_FORMAT:
+                /* Only NTB16 is supported */
+                dev->CtrlData[0] = 0;
+                dev->CtrlData[1] = 0;
+                retval = USBD_CtrlSendData(dev, dev->CtrlData, 2);
+                break;
+
+            case NCM_SET_NTB_FORMAT:
+                if (dev->Request.Value == 0)
+                {   retval = USBD_E_OK; }
+                break;
+
+            case NCM_GET_NTB_INPUT_SIZE:
+                dev->CtrlData[0] = (uint8_t)(itf->TxMaxSize);
+                dev->CtrlData[1] = (uint8_t)(itf->TxMaxSize >> 8);
+                dev->CtrlData[2] = 0;
+                dev->CtrlData[3] = 0;
+                retval = USBD_CtrlSendData(dev, dev->CtrlData, 4);
+                break;
+
+            case NCM_SET_NTB_INPUT_SIZE:
+                if (dev->Request.Length >= 4)
+                {
+                    retval = USBD_CtrlReceiveData(dev, dev->CtrlData);
+                }
+                break;
+
+            case NCM_SET_ETHERNET_PACKET_FILTER:
+                /* All packets are passed to the network stack */
+                retval = USBD_E_OK;
+                break;
+
+            default:
+                break;
+        }
+    }
+
+    return retval;
+}
+
+/**
+ * @brief Applies the IN NTB size limit received from the host.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_dataStage(USBD_NCM_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+
+    if (dev->Request.Request == NCM_SET_NTB_INPUT_SIZE)
+    {
+        uint32_t size = dev->CtrlData[0] | ((uint32_t)dev->CtrlData[1] << 8) |
+                ((uint32_t)dev->CtrlData[2] << 16) | ((uint32_t)dev->CtrlData[3] << 24);
+
+        /* The NTB16 blocks shall fit at least 2048 bytes */
+        if ((size >= 2048) && (size < USBD_NCM_NTB_IN_SIZE))
+        {
+            itf->TxMaxSize = size;
+        }
+        else
+        {
+            itf->TxMaxSize = USBD_NCM_NTB_IN_SIZE;
+        }
+    }
+}
+
+/**
+ * @brief Passes the received datagrams to the application,
+ *        after the reception is continued to a free buffer.
+ * @param itf: reference of the NCM interface
+ * @param ep: reference to the endpoint structure
+ */
+static void ncm_outData(USBD_NCM_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    uint8_t index = itf->RxIndex;
+
+    if (itf->Active != 0)
+    {
+        itf->RxActive = 0;
+        ncm_receiveNext(itf);
+
+        ncm_receiveNtb(itf, index, ep->Transfer.Length);
+
+        /* Drop the hold of the class */
+        ncm_receiveRelease(itf, index);
+    }
+}
+
+/**
+ * @brief Continues with the next notification, or the next IN NTB
+ *        if datagrams were aggregated during the previous transmission.
+ * @param itf: reference of the NCM interface
+ * @param ep: reference to the endpoint structure
+ */
+static void ncm_inData(USBD_NCM_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+
+    if (ep == &dev->EP.IN[itf->Config.NotEpNum & 0xF])
+    {
+        itf->Notify.Active = 0;
+        ncm_notify(itf);
+    }
+    else if (itf->Active != 0)
+    {
+        itf->TxActive = 0;
+
+        if (itf->Tx[itf->TxIndex].Count > 0)
+        {
+            ncm_transmitNtb(itf);
+        }
+
+        USBD_SAFE_CALLBACK(NCM_APP(itf)->Transmitted, );
+    }
+}
+
+#if (USBD_NCM_TX_TIMEOUT > 0)
+/**
+ * @brief Sends the aggregated IN NTB when its timeout elapses
+ *        while the IN endpoint is idle.
+ * @param itf: reference of the NCM interface
+ */
+static void ncm_sof(USBD_NCM_IfHandleType *itf)
+{
+    if ((itf->Active != 0) && (itf->TxActive == 0) &&
+        (itf->Tx[itf->TxIndex].Count > 0))
+    {
+        itf->TxTimer++;
+
+        if (itf->TxTimer >= USBD_NCM_TX_TIMEOUT)
+        {
+            ncm_transmitNtb(itf);
+        }
+    }
+}
+#endif /* (USBD_NCM_TX_TIMEOUT > 0) */
+
+/** @} */
+
+/** @defgroup USBD_NCM_Exported_Functions NCM Exported Functions
+ * @{ */
+
+/**
+ * @brief Mounts the NCM interface to the USB Device at the next two interface slots.
+ * @note  The NCM class uses two device interface slots per software interface.
+ * @note  The interface reference shall have its @ref USBD_NCM_IfHandleType::Config structure
+ *        and @ref USBD_NCM_IfHandleType::App reference properly set before this function is called.
+ * @param itf: reference of the NCM interface
+ * @param dev: reference of the USB Device
+ * @return OK if the mounting was successful,
+ *         ERROR if it failed due to insufficient device interface slots
+ */
+USBD_ReturnType USBD_NCM_MountInterface(USBD_NCM_IfHandleType *itf, USBD_HandleType *dev)
+{
+    USBD_ReturnType retval = USBD_E_ERROR;
+
+    /* Note: NCM uses 2 interfaces */
+    if (dev->IfCount < (USBD_MAX_IF_COUNT - 1))
+    {
+        static const char hex[] = "0123456789ABCDEF";
+        uint8_t i;
+
+        /* Binding interfaces */
+        itf->Base.Device = dev;
+        itf->Base.Class  = &ncm_cbks;
+        itf->Base.AltCount = 2;
+        itf->Base.AltSelector = 0;
+        itf->Opened = 0;
+        itf->Active = 0;
+        itf->TxMaxSize = USBD_NCM_NTB_IN_SIZE;
+
+        for (i = 0; i < sizeof(itf->Config.MacAddress); i++)
+        {
+            itf->MacString[2 * i]     = hex[itf->Config.MacAddress[i] >> 4];
+            itf->MacString[2 * i + 1] = hex[itf->Config.MacAddress[i] & 0xF];
+        }
+        itf->MacString[2 * i] = '\0';
+
+        {
+            USBD_EpHandleType *ep;
+
+            ep = &dev->EP.IN [itf->Config.NotEpNum & 0xF];
+            ep->Type            = USB_EP_TYPE_INTERRUPT;
+            ep->MaxPacketSize   = NCM_NOT_PACKET_SIZE;
+            ep->IfNum           = dev->IfCount;
+
+            ep = &dev->EP.IN [itf->Config.InEpNum  & 0xF];
+            ep->Type            = USB_EP_TYPE_BULK;
+            ep->MaxPacketSize   = NCM_DATA_PACKET_SIZE;
+            ep->IfNum           = dev->IfCount;
+
+            ep = &dev->EP.OUT[itf->Config.OutEpNum];
+            ep->Type            = USB_EP_TYPE_BULK;
+            ep->MaxPacketSize   = NCM_DATA_PACKET_SIZE;
+            ep->IfNum           = dev->IfCount;
+        }
+
+        dev->IF[dev->IfCount] = (USBD_IfHandleType*)itf;
+        dev->IfCount++;
+
+        dev->IF[dev->IfCount] = (USBD_IfHandleType*)itf;
+        dev->IfCount++;
+
+        retval = USBD_E_OK;
+    }
+
+    return retval;
+}
+
+/**
+ * @brief Copies an Ethernet frame into the IN NTB under aggregation.
+ *        The NTB is sent right away if the IN endpoint is idle
+ *        (or when USBD_NCM_TX_TIMEOUT elapses), otherwise after the ongoing transmission.
+ * @note  This function shall not preempt the USB device interrupt (or vice versa).
+ * @param itf: reference of the NCM interface
+ * @param data: pointer to the Ethernet frame
+ * @param length: length of the Ethernet frame
+ * @return OK if the frame is queued, BUSY if both NTBs are occupied,
+ *         INVALID if the network function isn't active or the frame is too long
+ */
+USBD_ReturnType USBD_NCM_Transmit(USBD_NCM_IfHandleType *itf, const uint8_t *data, uint16_t length)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+    USBD_NCM_TxNtbType *ntb = &itf->Tx[itf->TxIndex];
+    uint16_t index = NCM_ALIGN(ntb->Length);
+
+    if ((itf->Active == 0) || (length == 0) ||
+        (length > (itf->TxMaxSize - sizeof(USBD_NCM_Nth16Type) - sizeof(USBD_NCM_Ndp16Type)
+                   - 2 * sizeof(((USBD_NCM_Ndp16Type*)0)->Datagram[0]) - NCM_NDP_ALIGNMENT)))
+    {
+        /* Inactive, or the frame doesn't fit in any NTB */
+    }
+    else if (!ncm_transmitFits(itf, index, length) && (itf->TxActive != 0))
+    {
+        retval = USBD_E_BUSY;
+    }
+    else
+    {
+        if (!ncm_transmitFits(itf, index, length))
+        {
+            /* Send the full NTB, and aggregate into the other one */
+            ncm_transmitNtb(itf);
+
+            ntb = &itf->Tx[itf->TxIndex];
+            index = NCM_ALIGN(ntb->Length);
+        }
+
+        memcpy(&ntb->Buffer[index], data, length);
+        ntb->Datagram[ntb->Count].Index  = index;
+        ntb->Datagram[ntb->Count].Length = length;
+        ntb->Count++;
+        ntb->Length = index + length;
+
+#if (USBD_NCM_TX_TIMEOUT == 0)
+        if (itf->TxActive == 0)
+        {
+            ncm_transmitNtb(itf);
+        }
+#endif
+        retval = USBD_E_OK;
+    }
+
+    return retval;
+}
+
+/**
+ * @brief Sends the aggregated datagrams without waiting for the aggregation timeout.
+ * @param itf: reference of the NCM interface
+ */
+void USBD_NCM_Flush(USBD_NCM_IfHandleType *itf)
+{
+    if ((itf->Active != 0) && (itf->TxActive == 0) &&
+        (itf->Tx[itf->TxIndex].Count > 0))
+    {
+        ncm_transmitNtb(itf);
+    }
+}
+
+/**
+ * @brief Returns a received Ethernet frame to the NCM interface.
+ *        When all frames of an NTB buffer are released, the buffer is reused for reception.
+ * @note  Each frame passed to @ref USBD_NCM_AppType::Received shall be released once,
+ *        in any order. This function shall not preempt the USB device interrupt (or vice versa).
+ * @param itf: reference of the NCM interface
+ * @param data: the received frame's data
+ */
+void USBD_NCM_ReceiveRelease(USBD_NCM_IfHandleType *itf, const uint8_t *data)
+{
+    uint8_t i;
+
+    for (i = 0; i < USBD_NCM_RX_BUFFER_COUNT; i++)
+    {
+        if ((data >= itf->RxBuffer[i]) && (data < &itf->RxBuffer[i][USBD_NCM_NTB_OUT_SIZE]))
+        {
+            ncm_receiveRelease(itf, i);
+        }
+    }
+}
+
+/** @} */
@@ -0,0 +1,183 @@
+/**
+  ******************************************************************************
+  * @file    usbd_ncm.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB CDC Network Control Model
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_NCM_H
+#define __USBD_NCM_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <usbd_types.h>
+
+/** @ingroup USBD
+ * @addtogroup USBD_Class USBD Classes
+ * @{ */
+
+/** @defgroup USBD_NCM CDC Network Control Model (NCM)
+ * @{ */
+
+/** @defgroup USBD_NCM_Exported_Macros NCM Exported Macros
+ * @{ */
+
+/* The size of the IN (device to host) NCM Transfer Blocks,
+ * at least 2048 bytes; the host may limit it further */
+#ifndef USBD_NCM_NTB_IN_SIZE
+#define USBD_NCM_NTB_IN_SIZE            2048
+#endif
+
+/* The size of the OUT (host to device) NCM Transfer Blocks,
+ * shall be a multiple of the max packet size */
+#ifndef USBD_NCM_NTB_OUT_SIZE
+#define USBD_NCM_NTB_OUT_SIZE           2048
+#endif
+
+/* The number of OUT NTB buffers, the reception continues to a free buffer
+ * while the datagrams of the previous ones are held by the network stack */
+#ifndef USBD_NCM_RX_BUFFER_COUNT
+#define USBD_NCM_RX_BUFFER_COUNT        2
+#endif
+
+/* The maximal number of datagrams aggregated in each IN NTB */
+#ifndef USBD_NCM_TX_MAX_DATAGRAMS
+#define USBD_NCM_TX_MAX_DATAGRAMS       16
+#endif
+
+/* The number of (micro)frames an IN NTB waits for more datagrams
+ * while the IN endpoint is idle, 0 to send it immediately.
+ * Non-zero values require USBD_SOF_SUPPORT. */
+#ifndef USBD_NCM_TX_TIMEOUT
+#define USBD_NCM_TX_TIMEOUT             0
+#endif
+
+/* The maximal Ethernet frame size, without CRC */
+#ifndef USBD_NCM_MAX_SEGMENT_SIZE
+#define USBD_NCM_MAX_SEGMENT_SIZE       1514
+#endif
+
+/** @} */
+
+/** @defgroup USBD_NCM_Exported_Types NCM Exported Types
+ * @{ */
+
+/** @brief NCM application structure */
+typedef struct
+{
+    const char* Name;           /*!< String description of the application */
+
+    void (*Init)        (void); /*!< The host activated the network function */
+
+    void (*Deinit)      (void); /*!< The host deactivated the network function */
+
+    void (*Received)    (uint8_t * data,
+                         uint16_t length);  /*!< An Ethernet frame is received, which stays
+                                                 valid until it is returned to the class by
+                                                 @ref USBD_NCM_ReceiveRelease */
+
+    void (*Transmitted) (void); /*!< An IN NTB is transmitted, freeing space for new datagrams */
+}USBD_NCM_AppType;
+
+
+/** @brief NCM interface configuration */
+typedef struct
+{
+    uint8_t OutEpNum;       /*!< OUT endpoint address */
+    uint8_t InEpNum;        /*!< IN endpoint address */
+    uint8_t NotEpNum;       /*!< Notification endpoint address */
+    uint8_t MacAddress[6];  /*!< MAC address of the host side network interface */
+}USBD_NCM_ConfigType;
+
+
+/** @brief NCM IN NTB under aggregation or transmission */
+typedef struct
+{
+    uint8_t  Buffer[USBD_NCM_NTB_IN_SIZE]
+                  __align(USBD_DATA_ALIGNMENT); /*!< NTB data */
+    uint16_t Length;                /*!< End of the aggregated datagrams */
+    uint8_t  Count;                 /*!< Number of aggregated datagrams */
+    struct {
+        uint16_t Index;             /*!< Offset of the datagram in the NTB */
+        uint16_t Length;            /*!< Length of the datagram */
+    }Datagram[USBD_NCM_TX_MAX_DATAGRAMS]; /*!< Datagrams to be listed in the NDP */
+}USBD_NCM_TxNtbType;
+
+
+/** @brief NCM class interface structure */
+typedef struct
+{
+    USBD_IfHandleType Base;         /*!< Class-independent interface base */
+    const USBD_NCM_AppType* App;    /*!< NCM application reference */
+    USBD_NCM_ConfigType Config;     /*!< NCM interface configuration */
+
+    /* NCM class internal context */
+    uint8_t  RxBuffer[USBD_NCM_RX_BUFFER_COUNT][USBD_NCM_NTB_OUT_SIZE]
+                  __align(USBD_DATA_ALIGNMENT); /*!< OUT NTB buffers */
+    volatile uint16_t RxHeld[USBD_NCM_RX_BUFFER_COUNT]; /*!< Received datagrams of each buffer
+                                                             held by the application,
+                                                             plus one while in use by the class */
+    uint8_t  RxIndex;               /*!< Index of the buffer under reception */
+    uint8_t  RxActive;              /*!< Set while the reception is ongoing */
+    USBD_NCM_TxNtbType Tx[2];       /*!< IN NTBs, one is aggregated while the other is sent */
+    uint8_t  TxIndex;               /*!< Index of the IN NTB under aggregation */
+    uint8_t  TxActive;              /*!< Set while the other IN NTB is transmitted */
+    uint16_t TxSequence;            /*!< Sequence number of the next IN NTB */
+    uint16_t TxMaxSize;             /*!< IN NTB size limit selected by the host */
+#if (USBD_NCM_TX_TIMEOUT > 0)
+    uint16_t TxTimer;               /*!< (Micro)frames since the first aggregated datagram */
+#endif
+    uint8_t  Opened;                /*!< Set while the notification endpoint is open */
+    uint8_t  Active;                /*!< Set while the data alternate setting is active */
+    char     MacString[13];         /*!< MAC address as 12 hexadecimal digits */
+    struct {
+        uint8_t  Data[16] __align(USBD_DATA_ALIGNMENT); /*!< Notification in transmission */
+        uint8_t  Pending;           /*!< Notifications waiting to be sent */
+        uint8_t  Active;            /*!< Set while a notification is transmitted */
+    }Notify;                        /*!< Network status notifications */
+}USBD_NCM_IfHandleType;
+
+/** @} */
+
+/** @addtogroup USBD_NCM_Exported_Functions
+ * @{ */
+USBD_ReturnType USBD_NCM_MountInterface (USBD_NCM_IfHandleType *itf,
+                                         USBD_HandleType *dev);
+
+USBD_ReturnType USBD_NCM_Transmit       (USBD_NCM_IfHandleType *itf,
+                                         const uint8_t *data,
+                                         uint16_t length);
+
+void            USBD_NCM_Flush          (USBD_NCM_IfHandleType *itf);
+
+void            USBD_NCM_ReceiveRelease (USBD_NCM_IfHandleType *itf,
+                                         const uint8_t *data);
+/** @} */
+
+/** @} */
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_NCM_H */
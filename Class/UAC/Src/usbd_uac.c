@@ -0,0 +1,1051 @@
+/**
+  ******************************************************************************
+  * @file    usbd_uac.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB Audio Class implementation
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+#include <usbd_uac.h>
+
+#if (USBD_MAX_IF_COUNT < 2)
+#error "A single UAC interface takes up 2 device interface slots!"
+#endif
+
+#if (USBD_SOF_SUPPORT != 1)
+#error "The UAC explicit feedback requires USBD_SOF_SUPPORT!"
+#endif
+
+#if (USBD_UAC_FEEDBACK_REFRESH < 1) || (USBD_UAC_FEEDBACK_REFRESH > 9)
+#error "USBD_UAC_FEEDBACK_REFRESH shall be between 1 and 9!"
+#endif
+
+#define UAC_APP(ITF)    ((USBD_UAC_AppType*)((ITF)->App))
+
+/* Audio function topology */
+#define UAC_ID_INPUT_TERMINAL           1
+#define UAC_ID_OUTPUT_TERMINAL          2
+#define UAC_ID_CLOCK_SOURCE             3
+
+#define UAC_DESC_TYPE_CS_INTERFACE      0x24
+#define UAC_DESC_TYPE_CS_ENDPOINT       0x25
+
+/* Isochronous endpoint synchronization and usage types */
+#define UAC_EP_ATTR_ASYNC               0x04
+#define UAC_EP_ATTR_FEEDBACK            0x10
+
+/* UAC 2.0 clock source requests */
+#define UAC_REQ_CUR                     0x01
+#define UAC_REQ_RANGE                   0x02
+#define UAC_CS_SAM_FREQ_CONTROL         0x01
+
+/* Explicit feedback fixed point format */
+#define UAC_FEEDBACK_FS_SHIFT           14
+#define UAC_FEEDBACK_FS_SIZE            3
+#define UAC_FEEDBACK_HS_SHIFT           16
+#define UAC_FEEDBACK_HS_SIZE            4
+
+#define UAC_IS_IN_STREAM(ITF)   (((ITF)->Config.DataEpNum & 0x80) != 0)
+#define UAC_FRAME_SIZE(ITF)     ((ITF)->Config.Channels * (ITF)->Config.SubframeSize)
+
+#if (USBD_UAC_VERSION == 2)
+typedef struct
+{
+    /* Interface Association Descriptor */
+    USB_IfAssocDescType IAD;
+    /* Audio Control Interface Descriptor */
+    USB_InterfaceDescType ACI;
+    /* Class-specific AC Interface Header Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint16_t bcdADC;
+        uint8_t  bCategory;
+        uint16_t wTotalLength;
+        uint8_t  bmControls;
+    }__packed ACH;
+    /* Clock Source Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bClockID;
+        uint8_t  bmAttributes;
+        uint8_t  bmControls;
+        uint8_t  bAssocTerminal;
+        uint8_t  iClockSource;
+    }__packed CS;
+    /* Input Terminal Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bTerminalID;
+        uint16_t wTerminalType;
+        uint8_t  bAssocTerminal;
+        uint8_t  bCSourceID;
+        uint8_t  bNrChannels;
+        uint32_t bmChannelConfig;
+        uint8_t  iChannelNames;
+        uint16_t bmControls;
+        uint8_t  iTerminal;
+    }__packed IT;
+    /* Output Terminal Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bTerminalID;
+        uint16_t wTerminalType;
+        uint8_t  bAssocTerminal;
+        uint8_t  bSourceID;
+        uint8_t  bCSourceID;
+        uint16_t bmControls;
+        uint8_t  iTerminal;
+    }__packed OT;
+    /* Audio Streaming Interface Descriptor (zero bandwidth) */
+    USB_InterfaceDescType ASI0;
+    /* Audio Streaming Interface Descriptor (operational) */
+    USB_InterfaceDescType ASI1;
+    /* Class-specific AS General Interface Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bTerminalLink;
+        uint8_t  bmControls;
+        uint8_t  bFormatType;
+        uint32_t bmFormats;
+        uint8_t  bNrChannels;
+        uint32_t bmChannelConfig;
+        uint8_t  iChannelNames;
+    }__packed ASG;
+    /* Type I Format Type Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bFormatType;
+        uint8_t  bSubslotSize;
+        uint8_t  bBitResolution;
+    }__packed FMT;
+    /* Endpoint descriptors are dynamically added */
+}__packed USBD_UAC_DescType;
+
+/* Class-specific AS Isochronous Audio Data Endpoint Descriptor */
+typedef struct
+{
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+    uint8_t  bDescriptorSubtype;
+    uint8_t  bmAttributes;
+    uint8_t  bmControls;
+    uint8_t  bLockDelayUnits;
+    uint16_t wLockDelay;
+}__packed USBD_UAC_CsEpDescType;
+
+/* Layout of the RANGE request response */
+typedef struct
+{
+    uint16_t wNumSubRanges;
+    uint32_t dMIN;
+    uint32_t dMAX;
+    uint32_t dRES;
+}__packed USBD_UAC_RangeType;
+
+static const USBD_UAC_DescType uac_desc = {
+    .IAD = { /* Interface Association Descriptor */
+        .bLength            = sizeof(uac_desc.IAD),
+        .bDescriptorType    = USB_DESC_TYPE_IAD,
+        .bFirstInterface    = 0,
+        .bInterfaceCount    = 2,
+        .bFunctionClass     = 0x01, /* bFunctionClass: Audio */
+        .bFunctionSubClass  = 0x00, /* bFunctionSubClass: Undefined */
+        .bFunctionProtocol  = 0x20, /* bFunctionProtocol: IP version 2.00 */
+        .iFunction          = USBD_ISTR_INTERFACES,
+    },
+    .ACI = { /* Audio Control Interface Descriptor */
+        .bLength            = sizeof(uac_desc.ACI),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 0,
+        .bAlternateSetting  = 0,
+        .bNumEndpoints      = 0,
+        .bInterfaceClass    = 0x01, /* bInterfaceClass: Audio */
+        .bInterfaceSubClass = 0x01, /* bInterfaceSubClass: Audio Control */
+        .bInterfaceProtocol = 0x20, /* bInterfaceProtocol: IP version 2.00 */
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+    .ACH = { /* Class-specific AC Interface Header Descriptor */
+        .bLength            = sizeof(uac_desc.ACH),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x01, /* bDescriptorSubtype: Header */
+        .bcdADC             = 0x200,/* bcdADC: spec release number v2.00 */
+        .bCategory          = 0x08, /* bCategory: I/O Box */
+        .wTotalLength       = sizeof(uac_desc.ACH) + sizeof(uac_desc.CS) +
+                              sizeof(uac_desc.IT) + sizeof(uac_desc.OT),
+        .bmControls         = 0x00,
+    },
+    .CS = { /* Clock Source Descriptor */
+        .bLength            = sizeof(uac_desc.CS),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x0A, /* bDescriptorSubtype: Clock Source */
+        .bClockID           = UAC_ID_CLOCK_SOURCE,
+        .bmAttributes       = 0x01, /* bmAttributes: Internal fixed clock */
+        .bmControls         = 0x01, /* bmControls: Clock Frequency read-only */
+        .bAssocTerminal     = 0,
+        .iClockSource       = 0,
+    },
+    .IT = { /* Input Terminal Descriptor */
+        .bLength            = sizeof(uac_desc.IT),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x02, /* bDescriptorSubtype: Input Terminal */
+        .bTerminalID        = UAC_ID_INPUT_TERMINAL,
+        .wTerminalType      = UAC_TERMINAL_USB_STREAMING,
+        .bAssocTerminal     = 0,
+        .bCSourceID         = UAC_ID_CLOCK_SOURCE,
+        .bNrChannels        = 2,
+        .bmChannelConfig    = 0,    /* bmChannelConfig: Non-predefined spatial positions */
+        .iChannelNames      = 0,
+        .bmControls         = 0,
+        .iTerminal          = 0,
+    },
+    .OT = { /* Output Terminal Descriptor */
+        .bLength            = sizeof(uac_desc.OT),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x03, /* bDescriptorSubtype: Output Terminal */
+        .bTerminalID        = UAC_ID_OUTPUT_TERMINAL,
+        .wTerminalType      = UAC_TERMINAL_SPEAKER,
+        .bAssocTerminal     = 0,
+        .bSourceID          = UAC_ID_INPUT_TERMINAL,
+        .bCSourceID         = UAC_ID_CLOCK_SOURCE,
+        .bmControls         = 0,
+        .iTerminal          = 0,
+    },
+    .ASI0 = { /* Audio Streaming Interface Descriptor (zero bandwidth) */
+        .bLength            = sizeof(uac_desc.ASI0),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 1,
+        .bAlternateSetting  = 0,
+        .bNumEndpoints      = 0,
+        .bInterfaceClass    = 0x01, /* bInterfaceClass: Audio */
+        .bInterfaceSubClass = 0x02, /* bInterfaceSubClass: Audio Streaming */
+        .bInterfaceProtocol = 0x20, /* bInterfaceProtocol: IP version 2.00 */
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+    .ASI1 = { /* Audio Streaming Interface Descriptor (operational) */
+        .bLength            = sizeof(uac_desc.ASI1),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 1,
+        .bAlternateSetting  = 1,
+        .bNumEndpoints      = 1,
+        .bInterfaceClass    = 0x01, /* bInterfaceClass: Audio */
+        .bInterfaceSubClass = 0x02, /* bInterfaceSubClass: Audio Streaming */
+        .bInterfaceProtocol = 0x20, /* bInterfaceProtocol: IP version 2.00 */
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+    .ASG = { /* Class-specific AS General Interface Descriptor */
+        .bLength            = sizeof(uac_desc.ASG),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x01, /* bDescriptorSubtype: AS General */
+        .bTerminalLink      = UAC_ID_INPUT_TERMINAL,
+        .bmControls         = 0,
+        .bFormatType        = 0x01, /* bFormatType: Format Type I */
+        .bmFormats          = 0x01, /* bmFormats: PCM */
+        .bNrChannels        = 2,
+        .bmChannelConfig    = 0,
+        .iChannelNames      = 0,
+    },
+    .FMT = { /* Type I Format Type Descriptor */
+        .bLength            = sizeof(uac_desc.FMT),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x02, /* bDescriptorSubtype: Format Type */
+        .bFormatType        = 0x01, /* bFormatType: Format Type I */
+        .bSubslotSize       = 2,
+        .bBitResolution     = 16,
+    },
+};
+
+static const USBD_UAC_CsEpDescType uac_csEpDesc = {
+    .bLength            = sizeof(uac_csEpDesc),
+    .bDescriptorType    = UAC_DESC_TYPE_CS_ENDPOINT,
+    .bDescriptorSubtype = 0x01, /* bDescriptorSubtype: EP General */
+    .bmAttributes       = 0x00,
+    .bmControls         = 0x00,
+    .bLockDelayUnits    = 0x00,
+    .wLockDelay         = 0,
+};
+
+#else
+typedef struct
+{
+    /* Interface Association Descriptor */
+    USB_IfAssocDescType IAD;
+    /* Audio Control Interface Descriptor */
+    USB_InterfaceDescType ACI;
+    /* Class-specific AC Interface Header Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint16_t bcdADC;
+        uint16_t wTotalLength;
+        uint8_t  bInCollection;
+        uint8_t  baInterfaceNr;
+    }__packed ACH;
+    /* Input Terminal Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bTerminalID;
+        uint16_t wTerminalType;
+        uint8_t  bAssocTerminal;
+        uint8_t  bNrChannels;
+        uint16_t wChannelConfig;
+        uint8_t  iChannelNames;
+        uint8_t  iTerminal;
+    }__packed IT;
+    /* Output Terminal Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bTerminalID;
+        uint16_t wTerminalType;
+        uint8_t  bAssocTerminal;
+        uint8_t  bSourceID;
+        uint8_t  iTerminal;
+    }__packed OT;
+    /* Audio Streaming Interface Descriptor (zero bandwidth) */
+    USB_InterfaceDescType ASI0;
+    /* Audio Streaming Interface Descriptor (operational) */
+    USB_InterfaceDescType ASI1;
+    /* Class-specific AS General Interface Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bTerminalLink;
+        uint8_t  bDelay;
+        uint16_t wFormatTag;
+    }__packed ASG;
+    /* Type I Format Type Descriptor */
+    struct {
+        uint8_t  bLength;
+        uint8_t  bDescriptorType;
+        uint8_t  bDescriptorSubtype;
+        uint8_t  bFormatType;
+        uint8_t  bNrChannels;
+        uint8_t  bSubframeSize;
+        uint8_t  bBitResolution;
+        uint8_t  bSamFreqType;
+        uint8_t  tSamFreq[3];
+    }__packed FMT;
+    /* Endpoint descriptors are dynamically added */
+}__packed USBD_UAC_DescType;
+
+/* Class-specific AS Isochronous Audio Data Endpoint Descriptor */
+typedef struct
+{
+    uint8_t  bLength;
+    uint8_t  bDescriptorType;
+    uint8_t  bDescriptorSubtype;
+    uint8_t  bmAttributes;
+    uint8_t  bLockDelayUnits;
+    uint16_t wLockDelay;
+}__packed USBD_UAC_CsEpDescType;
+
+static const USBD_UAC_DescType uac_desc = {
+    .IAD = { /* Interface Association Descriptor */
+        .bLength            = sizeof(uac_desc.IAD),
+        .bDescriptorType    = USB_DESC_TYPE_IAD,
+        .bFirstInterface    = 0,
+        .bInterfaceCount    = 2,
+        .bFunctionClass     = 0x01, /* bFunctionClass: Audio */
+        .bFunctionSubClass  = 0x01, /* bFunctionSubClass: Audio Control */
+        .bFunctionProtocol  = 0x00,
+        .iFunction          = USBD_ISTR_INTERFACES,
+    },
+    .ACI = { /* Audio Control Interface Descriptor */
+        .bLength            = sizeof(uac_desc.ACI),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 0,
+        .bAlternateSetting  = 0,
+        .bNumEndpoints      = 0,
+        .bInterfaceClass    = 0x01, /* bInterfaceClass: Audio */
+        .bInterfaceSubClass = 0x01, /* bInterfaceSubClass: Audio Control */
+        .bInterfaceProtocol = 0x00,
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+    .ACH = { /* Class-specific AC Interface Header Descriptor */
+        .bLength            = sizeof(uac_desc.ACH),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x01, /* bDescriptorSubtype: Header */
+        .bcdADC             = 0x100,/* bcdADC: spec release number v1.00 */
+        .wTotalLength       = sizeof(uac_desc.ACH) +
+                              sizeof(uac_desc.IT) + sizeof(uac_desc.OT),
+        .bInCollection      = 1,
+        .baInterfaceNr      = 1,
+    },
+    .IT = { /* Input Terminal Descriptor */
+        .bLength            = sizeof(uac_desc.IT),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x02, /* bDescriptorSubtype: Input Terminal */
+        .bTerminalID        = UAC_ID_INPUT_TERMINAL,
+        .wTerminalType      = UAC_TERMINAL_USB_STREAMING,
+        .bAssocTerminal     = 0,
+        .bNrChannels        = 2,
+        .wChannelConfig     = 0,    /* wChannelConfig: Non-predefined spatial positions */
+        .iChannelNames      = 0,
+        .iTerminal          = 0,
+    },
+    .OT = { /* Output Terminal Descriptor */
+        .bLength            = sizeof(uac_desc.OT),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x03, /* bDescriptorSubtype: Output Terminal */
+        .bTerminalID        = UAC_ID_OUTPUT_TERMINAL,
+        .wTerminalType      = UAC_TERMINAL_SPEAKER,
+        .bAssocTerminal     = 0,
+        .bSourceID          = UAC_ID_INPUT_TERMINAL,
+        .iTerminal          = 0,
+    },
+    .ASI0 = { /* Audio Streaming Interface Descriptor (zero bandwidth) */
+        .bLength            = sizeof(uac_desc.ASI0),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 1,
+        .bAlternateSetting  = 0,
+        .bNumEndpoints      = 0,
+        .bInterfaceClass    = 0x01, /* bInterfaceClass: Audio */
+        .bInterfaceSubClass = 0x02, /* bInterfaceSubClass: Audio Streaming */
+        .bInterfaceProtocol = 0x00,
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+    .ASI1 = { /* Audio Streaming Interface Descriptor (operational) */
+        .bLength            = sizeof(uac_desc.ASI1),
+        .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+        .bInterfaceNumber   = 1,
+        .bAlternateSetting  = 1,
+        .bNumEndpoints      = 1,
+        .bInterfaceClass    = 0x01, /* bInterfaceClass: Audio */
+        .bInterfaceSubClass = 0x02, /* bInterfaceSubClass: Audio Streaming */
+        .bInterfaceProtocol = 0x00,
+        .iInterface         = USBD_ISTR_INTERFACES,
+    },
+    .ASG = { /* Class-specific AS General Interface Descriptor */
+        .bLength            = sizeof(uac_desc.ASG),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x01, /* bDescriptorSubtype: AS General */
+        .bTerminalLink      = UAC_ID_INPUT_TERMINAL,
+        .bDelay             = 1,
+        .wFormatTag         = 0x0001, /* wFormatTag: PCM */
+    },
+    .FMT = { /* Type I Format Type Descriptor */
+        .bLength            = sizeof(uac_desc.FMT),
+        .bDescriptorType    = UAC_DESC_TYPE_CS_INTERFACE,
+        .bDescriptorSubtype = 0x02, /* bDescriptorSubtype: Format Type */
+        .bFormatType        = 0x01, /* bFormatType: Format Type I */
+        .bNrChannels        = 2,
+        .bSubframeSize      = 2,
+        .bBitResolution     = 16,
+        .bSamFreqType       = 1,    /* bSamFreqType: One discrete sampling frequency */
+    },
+};
+
+static const USBD_UAC_CsEpDescType uac_csEpDesc = {
+    .bLength            = sizeof(uac_csEpDesc),
+    .bDescriptorType    = UAC_DESC_TYPE_CS_ENDPOINT,
+    .bDescriptorSubtype = 0x01, /* bDescriptorSubtype: EP General */
+    .bmAttributes       = 0x00,
+    .bLockDelayUnits    = 0x00,
+    .wLockDelay         = 0,
+};
+#endif /* (USBD_UAC_VERSION == 2) */
+
+static uint16_t         uac_getDesc     (USBD_UAC_IfHandleType *itf, uint8_t ifNum, uint8_t * dest);
+static const char *     uac_getString   (USBD_UAC_IfHandleType *itf, uint8_t intNum);
+static void             uac_init        (USBD_UAC_IfHandleType *itf);
+static void             uac_deinit      (USBD_UAC_IfHandleType *itf);
+static USBD_ReturnType  uac_setupStage  (USBD_UAC_IfHandleType *itf);
+static void             uac_outData     (USBD_UAC_IfHandleType *itf, USBD_EpHandleType *ep);
+static void             uac_inData      (USBD_UAC_IfHandleType *itf, USBD_EpHandleType *ep);
+static void             uac_sof         (USBD_UAC_IfHandleType *itf);
+
+/* UAC interface class callbacks structure */
+static const USBD_ClassType uac_cbks = {
+    .GetDescriptor  = (USBD_IfDescCbkType)  uac_getDesc,
+    .GetString      = (USBD_IfStrCbkType)   uac_getString,
+    .Init           = (USBD_IfCbkType)      uac_init,
+    .Deinit         = (USBD_IfCbkType)      uac_deinit,
+    .SetupStage     = (USBD_IfSetupCbkType) uac_setupStage,
+    .OutData        = (USBD_IfEpCbkType)    uac_outData,
+    .InData         = (USBD_IfEpCbkType)    uac_inData,
+    .Sof            = (USBD_IfCbkType)      uac_sof,
+};
+
+/** @ingroup USBD_UAC
+ * @defgroup USBD_UAC_Private_Functions UAC Private Functions
+ * @{ */
+
+/**
+ * @brief Returns the number of isochronous service intervals per second.
+ * @param dev: USB Device handle reference
+ * @return The (micro)frame rate of the current speed
+ */
+static uint16_t uac_frameRate(USBD_HandleType *dev)
+{
+#if (USBD_HS_SUPPORT == 1)
+    if (dev->Speed == USB_SPEED_HIGH)
+    {
+        return 8000;
+    }
+    else
+#else
+    (void)dev;
+#endif
+    {
+        return 1000;
+    }
+}
+
+/**
+ * @brief Calculates the largest packet size of the stream,
+ *        which fits one more audio frame than the rounded up nominal rate.
+ * @param itf: reference of the UAC interface
+ * @param frameRate: the (micro)frame rate
+ * @return The maximal packet size
+ */
+static uint32_t uac_maxPacketSize(USBD_UAC_IfHandleType *itf, uint16_t frameRate)
+{
+    uint32_t frames = (itf->Config.SampleRate + frameRate - 1) / frameRate;
+
+    return (frames + 1) * UAC_FRAME_SIZE(itf);
+}
+
+/**
+ * @brief Sets the packet sizes of the endpoints for the current speed.
+ *        High speed streams exceeding 1024 bytes per microframe
+ *        are split into multiple transactions.
+ * @param itf: reference of the UAC interface
+ */
+static void uac_epSetup(USBD_UAC_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, itf->Config.DataEpNum);
+    uint16_t feedbackSize = UAC_FEEDBACK_FS_SIZE;
+
+    itf->PacketSize = uac_maxPacketSize(itf, uac_frameRate(dev));
+    ep->MaxPacketSize = itf->PacketSize;
+
+#if (USBD_HS_SUPPORT == 1)
+    ep->Transactions = 0;
+    if (dev->Speed == USB_SPEED_HIGH)
+    {
+        ep->Transactions  = (itf->PacketSize - 1) / USB_EP_ISOC_HS_MPS;
+        ep->MaxPacketSize = (itf->PacketSize + ep->Transactions) / (ep->Transactions + 1);
+        feedbackSize = UAC_FEEDBACK_HS_SIZE;
+    }
+#endif
+
+    if (!UAC_IS_IN_STREAM(itf))
+    {
+        dev->EP.IN[itf->Config.FeedbackEpNum & 0xF].MaxPacketSize = feedbackSize;
+    }
+}
+
+/**
+ * @brief Copies an isochronous endpoint descriptor to the destination buffer.
+ * @param itf: reference of the UAC interface
+ * @param epAddr: endpoint address
+ * @param dest: the destination buffer
+ * @return Length of the copied descriptor
+ */
+static uint16_t uac_epDesc(USBD_UAC_IfHandleType *itf, uint8_t epAddr, uint8_t * dest)
+{
+    USB_EndpointDescType *desc = (USB_EndpointDescType*)dest;
+    uint16_t len = USBD_EpDesc(itf->Base.Device, epAddr, dest);
+
+    if (epAddr == itf->Config.DataEpNum)
+    {
+        desc->bmAttributes |= UAC_EP_ATTR_ASYNC;
+    }
+    else
+    {
+        desc->bmAttributes |= UAC_EP_ATTR_FEEDBACK;
+    }
+
+#if (USBD_UAC_VERSION != 2)
+    /* Audio 1.0 endpoints are described with the synchronization fields */
+    if (epAddr == itf->Config.DataEpNum)
+    {
+        dest[len++] = 0;
+        dest[len++] = UAC_IS_IN_STREAM(itf) ? 0 : itf->Config.FeedbackEpNum;
+    }
+    else
+    {
+        dest[len++] = USBD_UAC_FEEDBACK_REFRESH;
+        dest[len++] = 0;
+    }
+    desc->bLength = len;
+#endif
+
+    return len;
+}
+
+/**
+ * @brief Copies the interface descriptor to the destination buffer.
+ * @param itf: reference of the UAC interface
+ * @param ifNum: the index of the current interface in the device
+ * @param dest: the destination buffer
+ * @return Length of the copied descriptor
+ */
+static uint16_t uac_getDesc(USBD_UAC_IfHandleType *itf, uint8_t ifNum, uint8_t * dest)
+{
+    USBD_UAC_DescType *desc = (USBD_UAC_DescType*)dest;
+    uint16_t len = sizeof(uac_desc);
+
+    memcpy(dest, &uac_desc, sizeof(uac_desc));
+
+#if (USBD_MAX_IF_COUNT > 2)
+    /* Adjustment of interface indexes */
+    desc->IAD.bFirstInterface   = ifNum;
+    desc->IAD.iFunction         = USBD_IIF_INDEX(ifNum, 0);
+
+    desc->ACI.bInterfaceNumber  = ifNum;
+    desc->ASI0.bInterfaceNumber = ifNum + 1;
+    desc->ASI1.bInterfaceNumber = ifNum + 1;
+#if (USBD_UAC_VERSION != 2)
+    desc->ACH.baInterfaceNr     = ifNum + 1;
+#endif
+
+    desc->ACI.iInterface  = USBD_IIF_INDEX(ifNum, 0);
+    desc->ASI0.iInterface = USBD_IIF_INDEX(ifNum, 0);
+    desc->ASI1.iInterface = USBD_IIF_INDEX(ifNum, 0);
+#endif /* (USBD_MAX_IF_COUNT > 2) */
+
+    /* The USB streaming terminal is on the host side of the stream */
+    if (UAC_IS_IN_STREAM(itf))
+    {
+        desc->IT.wTerminalType = itf->Config.TerminalType;
+        desc->OT.wTerminalType = UAC_TERMINAL_USB_STREAMING;
+        desc->ASG.bTerminalLink = UAC_ID_OUTPUT_TERMINAL;
+    }
+    else
+    {
+        desc->OT.wTerminalType = itf->Config.TerminalType;
+        desc->ASI1.bNumEndpoints = 2;
+    }
+
+    desc->IT.bNrChannels = itf->Config.Channels;
+#if (USBD_UAC_VERSION == 2)
+    desc->ASG.bNrChannels = itf->Config.Channels;
+    desc->FMT.bSubslotSize = itf->Config.SubframeSize;
+#else
+    desc->FMT.bNrChannels = itf->Config.Channels;
+    desc->FMT.bSubframeSize = itf->Config.SubframeSize;
+    desc->FMT.tSamFreq[0] = (uint8_t)(itf->Config.SampleRate);
+    desc->FMT.tSamFreq[1] = (uint8_t)(itf->Config.SampleRate >> 8);
+    desc->FMT.tSamFreq[2] = (uint8_t)(itf->Config.SampleRate >> 16);
+#endif
+    desc->FMT.bBitResolution = itf->Config.BitResolution;
+
+    /* The packet sizes depend on the speed */
+    uac_epSetup(itf);
+
+    len += uac_epDesc(itf, itf->Config.DataEpNum, &dest[len]);
+
+    memcpy(&dest[len], &uac_csEpDesc, sizeof(uac_csEpDesc));
+    len += sizeof(uac_csEpDesc);
+
+    if (!UAC_IS_IN_STREAM(itf))
+    {
+        len += uac_epDesc(itf, itf->Config.FeedbackEpNum, &dest[len]);
+    }
+
+    return len;
+}
+
+/**
+ * @brief Returns the selected interface string.
+ * @param itf: reference of the UAC interface
+ * @param intNum: interface-internal string index
+ * @return The referenced string
+ */
+static const char* uac_getString(USBD_UAC_IfHandleType *itf, uint8_t intNum)
+{
+    return itf->App->Name;
+}
+
+/**
+ * @brief Sends the current explicit feedback value.
+ * @param itf: reference of the UAC interface
+ */
+static void uac_sendFeedback(USBD_UAC_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint32_t value = itf->Feedback.Value;
+
+    itf->Feedback.Data[0] = (uint8_t)(value);
+    itf->Feedback.Data[1] = (uint8_t)(value >> 8);
+    itf->Feedback.Data[2] = (uint8_t)(value >> 16);
+    itf->Feedback.Data[3] = (uint8_t)(value >> 24);
+
+    USBD_EpSend(dev, itf->Config.FeedbackEpNum, itf->Feedback.Data,
+            dev->EP.IN[itf->Config.FeedbackEpNum & 0xF].MaxPacketSize);
+}
+
+/**
+ * @brief Fills a packet buffer of the IN stream with the next (micro)frame's samples.
+ *        The fractional audio frames are accumulated, so the packet sizes
+ *        follow the nominal sampling frequency.
+ * @param itf: reference of the UAC interface
+ * @param index: the index of the packet buffer
+ */
+static void uac_fill(USBD_UAC_IfHandleType *itf, uint8_t index)
+{
+    uint16_t frameRate = uac_frameRate(itf->Base.Device);
+    uint16_t frames = itf->Rate.Frames;
+    uint16_t len;
+
+    itf->Rate.Accumulator += itf->Rate.Remainder;
+    if (itf->Rate.Accumulator >= frameRate)
+    {
+        itf->Rate.Accumulator -= frameRate;
+        frames++;
+    }
+
+    len = UAC_APP(itf)->Fill(itf->Buffer[index], frames * UAC_FRAME_SIZE(itf));
+
+    if (len > itf->PacketSize)
+    {   len = itf->PacketSize; }
+
+    itf->Length[index] = len;
+}
+
+/**
+ * @brief Opens the streaming endpoints and starts the packet pipeline.
+ * @param itf: reference of the UAC interface
+ */
+static void uac_start(USBD_UAC_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint16_t frameRate = uac_frameRate(dev);
+    uint8_t shift = UAC_FEEDBACK_FS_SHIFT;
+    uint8_t i;
+
+#if (USBD_HS_SUPPORT == 1)
+    if (dev->Speed == USB_SPEED_HIGH)
+    {   shift = UAC_FEEDBACK_HS_SHIFT; }
+#endif
+
+    uac_epSetup(itf);
+
+    itf->Rate.Frames      = itf->Config.SampleRate / frameRate;
+    itf->Rate.Remainder   = itf->Config.SampleRate % frameRate;
+    itf->Rate.Accumulator = 0;
+    itf->Index = 0;
+    itf->Streaming = 1;
+
+    USBD_SAFE_CALLBACK(UAC_APP(itf)->Start, );
+
+    USBD_EpOpen(dev, itf->Config.DataEpNum, USB_EP_TYPE_ISOCHRONOUS,
+            USBD_EpAddr2Ref(dev, itf->Config.DataEpNum)->MaxPacketSize, USBD_EP_OPT_NONE);
+
+    if (UAC_IS_IN_STREAM(itf))
+    {
+        /* All buffers are prepared, so the completions only have to resubmit */
+        for (i = 0; i < USBD_UAC_BUFFER_COUNT; i++)
+        {
+            uac_fill(itf, i);
+        }
+
+        USBD_EpSend(dev, itf->Config.DataEpNum, itf->Buffer[0], itf->Length[0]);
+    }
+    else
+    {
+        USBD_EpOpen(dev, itf->Config.FeedbackEpNum, USB_EP_TYPE_ISOCHRONOUS,
+                dev->EP.IN[itf->Config.FeedbackEpNum & 0xF].MaxPacketSize, USBD_EP_OPT_NONE);
+
+        /* The nominal rate is reported until the first measurement */
+        itf->Feedback.Value = ((uint32_t)itf->Rate.Frames << shift) +
+                (((uint32_t)itf->Rate.Remainder << shift) / frameRate);
+        itf->Feedback.Frames = 0;
+        if (UAC_APP(itf)->SampleClock != NULL)
+        {
+            itf->Feedback.LastClock = UAC_APP(itf)->SampleClock();
+        }
+
+        USBD_EpReceive(dev, itf->Config.DataEpNum, itf->Buffer[0], itf->PacketSize);
+
+        uac_sendFeedback(itf);
+    }
+}
+
+/**
+ * @brief Closes the streaming endpoints.
+ * @param itf: reference of the UAC interface
+ */
+static void uac_stop(USBD_UAC_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+
+    itf->Streaming = 0;
+
+    USBD_EpClose(dev, itf->Config.DataEpNum);
+    if (!UAC_IS_IN_STREAM(itf))
+    {
+        USBD_EpClose(dev, itf->Config.FeedbackEpNum);
+    }
+
+    USBD_SAFE_CALLBACK(UAC_APP(itf)->Stop, );
+}
+
+/**
+ * @brief Starts the streaming when the operational alternate setting is selected.
+ * @note  The function is called for both device interface slots,
+ *        therefore it only acts on state changes.
+ * @param itf: reference of the UAC interface
+ */
+static void uac_init(USBD_UAC_IfHandleType *itf)
+{
+    if ((itf->Base.AltSelector != 0) && (itf->Streaming == 0))
+    {
+        uac_start(itf);
+    }
+}
+
+/**
+ * @brief Stops the ongoing streaming.
+ * @param itf: reference of the UAC interface
+ */
+static void uac_deinit(USBD_UAC_IfHandleType *itf)
+{
+    if (itf->Streaming != 0)
+    {
+        uac_stop(itf);
+    }
+}
+
+/**
+ * @brief Performs the interface-specific setup request handling.
+ *        The fixed sampling frequency is readable from the UAC 2.0 clock source.
+ * @param itf: reference of the UAC interface
+ * @return OK if the setup request is accepted, INVALID otherwise
+ */
+static USBD_ReturnType uac_setupStage(USBD_UAC_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+#if (USBD_UAC_VERSION == 2)
+    USBD_HandleType *dev = itf->Base.Device;
+
+    if ((dev->Request.RequestType.Type == USB_REQ_TYPE_CLASS) &&
+        (dev->Request.RequestType.Direction == USB_DIRECTION_IN) &&
+        ((dev->Request.Index >> 8) == UAC_ID_CLOCK_SOURCE) &&
+        ((dev->Request.Value >> 8) == UAC_CS_SAM_FREQ_CONTROL))
+    {
+        switch (dev->Request.Request)
+        {
+            case UAC_REQ_CUR:
+            {
+                memcpy(dev->CtrlData, &itf->Config.SampleRate, sizeof(uint32_t));
+
+                retval = USBD_CtrlSendData(dev, dev->CtrlData, sizeof(uint32_t));
+                break;
+            }
+
+            case UAC_REQ_RANGE:
+            {
+                USBD_UAC_RangeType *range = (USBD_UAC_RangeType*)dev->CtrlData;
+
+                range->wNumSubRanges = 1;
+                range->dMIN = itf->Config.SampleRate;
+                range->dMAX = itf->Config.SampleRate;
+                range->dRES = 0;
+
+                retval = USBD_CtrlSendData(dev, dev->CtrlData, sizeof(USBD_UAC_RangeType));
+                break;
+            }
+
+            default:
+                break;
+        }
+    }
+#else
+    (void)itf;
+#endif /* (USBD_UAC_VERSION == 2) */
+
+    return retval;
+}
+
+/**
+ * @brief Rearms the OUT stream with the next packet buffer,
+ *        then passes the received samples to the application.
+ * @param itf: reference of the UAC interface
+ * @param ep: reference to the endpoint structure
+ */
+static void uac_outData(USBD_UAC_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    if (itf->Streaming != 0)
+    {
+        uint8_t *data = ep->Transfer.Data - ep->Transfer.Length;
+        uint16_t length = ep->Transfer.Length;
+
+        itf->Index = (itf->Index + 1) % USBD_UAC_BUFFER_COUNT;
+
+        USBD_EpReceive(itf->Base.Device, itf->Config.DataEpNum,
+                itf->Buffer[itf->Index], itf->PacketSize);
+
+        USBD_SAFE_CALLBACK(UAC_APP(itf)->Received, data, length);
+    }
+}
+
+/**
+ * @brief Submits the next prepared packet of the IN stream,
+ *        then refills the transmitted packet buffer.
+ * @param itf: reference of the UAC interface
+ * @param ep: reference to the endpoint structure
+ */
+static void uac_inData(USBD_UAC_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    if ((itf->Streaming != 0) && UAC_IS_IN_STREAM(itf) &&
+        (ep == &itf->Base.Device->EP.IN[itf->Config.DataEpNum & 0xF]))
+    {
+        uint8_t sent = itf->Index;
+
+        itf->Index = (sent + 1) % USBD_UAC_BUFFER_COUNT;
+
+        USBD_EpSend(itf->Base.Device, itf->Config.DataEpNum,
+                itf->Buffer[itf->Index], itf->Length[itf->Index]);
+
+        uac_fill(itf, sent);
+    }
+}
+
+/**
+ * @brief Measures the consumption rate of the OUT stream's samples
+ *        by the start of (micro)frames, and sends the explicit feedback
+ *        at the end of each refresh period.
+ * @param itf: reference of the UAC interface
+ */
+static void uac_sof(USBD_UAC_IfHandleType *itf)
+{
+    if ((itf->Streaming != 0) && !UAC_IS_IN_STREAM(itf))
+    {
+        itf->Feedback.Frames++;
+    }
+
+    if (itf->Feedback.Frames >= (1 << USBD_UAC_FEEDBACK_REFRESH))
+    {
+        uint8_t shift = UAC_FEEDBACK_FS_SHIFT;
+
+        itf->Feedback.Frames = 0;
+
+#if (USBD_HS_SUPPORT == 1)
+        if (itf->Base.Device->Speed == USB_SPEED_HIGH)
+        {   shift = UAC_FEEDBACK_HS_SHIFT; }
+#endif
+
+        if (UAC_APP(itf)->SampleClock != NULL)
+        {
+            uint32_t clock = UAC_APP(itf)->SampleClock();
+
+            /* The consumed frames of the period, in the fixed point format */
+            itf->Feedback.Value = (clock - itf->Feedback.LastClock)
+                    << (shift - USBD_UAC_FEEDBACK_REFRESH);
+            itf->Feedback.LastClock = clock;
+        }
+
+        uac_sendFeedback(itf);
+    }
+}
+
+/** @} */
+
+/** @defgroup USBD_UAC_Exported_Functions UAC Exported Functions
+ * @{ */
+
+/**
+ * @brief Mounts the UAC interface to the USB Device at the next two interface slots.
+ * @note  The UAC class uses two device interface slots per software interface:
+ *        the audio control and the audio streaming interface.
+ * @note  The interface reference shall have its @ref USBD_UAC_IfHandleType::Config structure
+ *        and @ref USBD_UAC_IfHandleType::App reference properly set before this function is called.
+ * @param itf: reference of the UAC interface
+ * @param dev: reference of the USB Device
+ * @return OK if the mounting was successful,
+ *         ERROR if it failed due to insufficient device interface slots
+ *         or packet buffer size
+ */
+USBD_ReturnType USBD_UAC_MountInterface(USBD_UAC_IfHandleType *itf, USBD_HandleType *dev)
+{
+    USBD_ReturnType retval = USBD_E_ERROR;
+
+    /* Note: UAC uses 2 interfaces, and the full speed packets are the largest */
+    if ((dev->IfCount < (USBD_MAX_IF_COUNT - 1)) &&
+        (uac_maxPacketSize(itf, 1000) <= USBD_UAC_PACKET_SIZE))
+    {
+        /* Binding interfaces */
+        itf->Base.Device = dev;
+        itf->Base.Class  = &uac_cbks;
+        itf->Base.AltCount = 2;
+        itf->Base.AltSelector = 0;
+        itf->Streaming = 0;
+
+        {
+            USBD_EpHandleType *ep;
+
+            ep = USBD_EpAddr2Ref(dev, itf->Config.DataEpNum);
+            ep->Type            = USB_EP_TYPE_ISOCHRONOUS;
+            ep->IfNum           = dev->IfCount;
+            ep->Interval        = 1;
+#if (USBD_HS_SUPPORT == 1)
+            ep->IntervalHS      = 1;
+#endif
+
+            if (!UAC_IS_IN_STREAM(itf))
+            {
+                ep = &dev->EP.IN[itf->Config.FeedbackEpNum & 0xF];
+                ep->Type            = USB_EP_TYPE_ISOCHRONOUS;
+                ep->IfNum           = dev->IfCount;
+#if (USBD_UAC_VERSION == 2)
+                ep->Interval        = USBD_UAC_FEEDBACK_REFRESH + 1;
+#else
+                /* The refresh period is described by bRefresh */
+                ep->Interval        = 1;
+#endif
+#if (USBD_HS_SUPPORT == 1)
+                ep->IntervalHS      = USBD_UAC_FEEDBACK_REFRESH + 1;
+#endif
+            }
+
+            uac_epSetup(itf);
+        }
+
+        dev->IF[dev->IfCount] = (USBD_IfHandleType*)itf;
+        dev->IfCount++;
+
+        dev->IF[dev->IfCount] = (USBD_IfHandleType*)itf;
+        dev->IfCount++;
+
+        retval = USBD_E_OK;
+    }
+
+    return retval;
+}
+
+/** @} */
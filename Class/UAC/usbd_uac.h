@@ -0,0 +1,168 @@
+/**
+  ******************************************************************************
+  * @file    usbd_uac.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB Audio Class
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_UAC_H
+#define __USBD_UAC_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <usbd_types.h>
+
+/** @ingroup USBD
+ * @addtogroup USBD_Class USBD Classes
+ * @{ */
+
+/** @defgroup USBD_UAC Audio Class (UAC)
+ * @{ */
+
+/** @defgroup USBD_UAC_Exported_Macros UAC Exported Macros
+ * @{ */
+
+/* The implemented Audio Device Class specification version: 1 (1.0) or 2 (2.0) */
+#ifndef USBD_UAC_VERSION
+#define USBD_UAC_VERSION                1
+#endif
+
+/* The number of isochronous packet buffers of the streaming pipeline:
+ * 2 for double buffering, 3 for triple buffering */
+#ifndef USBD_UAC_BUFFER_COUNT
+#define USBD_UAC_BUFFER_COUNT           2
+#endif
+
+/* The size of each packet buffer, shall fit the nominal number of audio frames
+ * per (micro)frame rounded up, plus one audio frame.
+ * The default fits 48 kHz stereo 16 bit streams at full speed. */
+#ifndef USBD_UAC_PACKET_SIZE
+#define USBD_UAC_PACKET_SIZE            (49 * 2 * 2)
+#endif
+
+/* The explicit feedback of OUT streams is measured and sent
+ * every 2^USBD_UAC_FEEDBACK_REFRESH (micro)frames (1..9) */
+#ifndef USBD_UAC_FEEDBACK_REFRESH
+#define USBD_UAC_FEEDBACK_REFRESH       3
+#endif
+
+/** @} */
+
+/** @defgroup USBD_UAC_Exported_Types UAC Exported Types
+ * @{ */
+
+/** @brief Common audio terminal types */
+typedef enum
+{
+    UAC_TERMINAL_USB_STREAMING  = 0x0101, /*!< USB streaming terminal */
+    UAC_TERMINAL_MICROPHONE     = 0x0201, /*!< Generic microphone input */
+    UAC_TERMINAL_SPEAKER        = 0x0301, /*!< Generic speaker output */
+    UAC_TERMINAL_LINE_CONNECTOR = 0x0603, /*!< Line level analog connector */
+    UAC_TERMINAL_DIGITAL        = 0x0602, /*!< Digital audio interface */
+}USBD_UAC_TerminalType;
+
+
+/** @brief UAC application structure */
+typedef struct
+{
+    const char* Name;           /*!< String description of the application */
+
+    void (*Start)       (void); /*!< The host started streaming */
+
+    void (*Stop)        (void); /*!< The host stopped streaming */
+
+    uint16_t (*Fill)    (uint8_t * data,
+                         uint16_t length);  /*!< IN stream (mandatory): provide the next packet's samples,
+                                                 length is the nominal size of the packet,
+                                                 return the provided size, which may be one audio
+                                                 frame more or less to follow the device clock */
+
+    void (*Received)    (uint8_t * data,
+                         uint16_t length);  /*!< OUT stream: samples of a packet are received,
+                                                 the data is valid for
+                                                 (USBD_UAC_BUFFER_COUNT - 1) (micro)frames */
+
+    uint32_t (*SampleClock)(void);          /*!< OUT stream: optional free-running count of the
+                                                 audio frames consumed by the device, the explicit
+                                                 feedback is measured from it */
+}USBD_UAC_AppType;
+
+
+/** @brief UAC interface configuration */
+typedef struct
+{
+    uint8_t  DataEpNum;     /*!< Isochronous data endpoint address, its direction
+                                 selects the streaming direction */
+    uint8_t  FeedbackEpNum; /*!< Explicit feedback IN endpoint address of OUT streams */
+    uint8_t  Channels;      /*!< Number of audio channels */
+    uint8_t  SubframeSize;  /*!< Bytes per sample (1, 2, 3 or 4) */
+    uint8_t  BitResolution; /*!< Used bits of each sample */
+    uint16_t TerminalType;  /*!< @ref USBD_UAC_TerminalType of the device side terminal */
+    uint32_t SampleRate;    /*!< Sampling frequency [Hz] */
+}USBD_UAC_ConfigType;
+
+
+/** @brief UAC class interface structure */
+typedef struct
+{
+    USBD_IfHandleType Base;         /*!< Class-independent interface base */
+    const USBD_UAC_AppType* App;    /*!< UAC application reference */
+    USBD_UAC_ConfigType Config;     /*!< UAC interface configuration */
+
+    /* UAC class internal context */
+    uint8_t  Buffer[USBD_UAC_BUFFER_COUNT][USBD_UAC_PACKET_SIZE]
+                  __align(USBD_DATA_ALIGNMENT); /*!< Packet buffers of the stream */
+    uint16_t Length[USBD_UAC_BUFFER_COUNT];     /*!< Filled length of the IN packet buffers */
+    uint8_t  Index;                 /*!< Index of the packet buffer in transfer */
+    uint8_t  Streaming;             /*!< Set while the operational alternate setting is active */
+    uint16_t PacketSize;            /*!< Maximal packet size at the current speed */
+    struct {
+        uint16_t Frames;            /*!< Nominal audio frames per (micro)frame */
+        uint16_t Remainder;         /*!< Fractional audio frames per (micro)frame
+                                         [1 / (micro)frames per second] */
+        uint16_t Accumulator;       /*!< Accumulated fractional audio frames */
+    }Rate;                          /*!< IN stream packet sizing */
+    struct {
+        uint8_t  Data[4] __align(USBD_DATA_ALIGNMENT); /*!< Feedback value in transmission */
+        uint32_t Value;             /*!< Current feedback [audio frames per (micro)frame],
+                                         in 10.14 format at full speed, 16.16 at high speed */
+        uint32_t LastClock;         /*!< Sample clock at the last measurement */
+        uint16_t Frames;            /*!< (Micro)frames since the last measurement */
+    }Feedback;                      /*!< OUT stream explicit feedback */
+}USBD_UAC_IfHandleType;
+
+/** @} */
+
+/** @addtogroup USBD_UAC_Exported_Functions
+ * @{ */
+USBD_ReturnType USBD_UAC_MountInterface (USBD_UAC_IfHandleType *itf,
+                                         USBD_HandleType *dev);
+/** @} */
+
+/** @} */
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_UAC_H */
@@ -0,0 +1,480 @@
+/**
+  ******************************************************************************
+  * @file    usbd_vnd.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB Vendor-specific bulk class implementation
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+#include <usbd_utils.h>
+#include <usbd_vnd.h>
+
+#if (USBD_EP_QUEUE_SUPPORT != 1)
+#error "The VND pipes require USBD_EP_QUEUE_SUPPORT!"
+#endif
+
+#if (USBD_HS_SUPPORT == 1)
+#define VND_DATA_PACKET_SIZE                        USB_EP_BULK_HS_MPS
+#else
+#define VND_DATA_PACKET_SIZE                        USB_EP_BULK_FS_MPS
+#endif
+
+#define VND_APP(ITF)    ((USBD_VND_AppType*)((ITF)->App))
+
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+/* Length of the braced GUID string */
+#define VND_GUID_LENGTH                             38
+
+/* Registry value type of the device interface GUIDs */
+#define VND_REG_MULTI_SZ                            7
+
+/* MS OS 2.0 registry property of the device interface GUID */
+typedef struct
+{
+    uint16_t wLength;
+    uint16_t wDescriptorType;
+    uint16_t wPropertyDataType;
+    uint16_t wPropertyNameLength;
+    uint8_t  PropertyName[sizeof("DeviceInterfaceGUIDs") * 2];
+    uint16_t wPropertyDataLength;
+    uint8_t  PropertyData[(VND_GUID_LENGTH + 2) * 2]; /* REG_MULTI_SZ double termination */
+}__packed VND_GuidPropertyDescType;
+#endif /* (USBD_MS_OS_DESC_SUPPORT == 1) */
+
+static const USB_InterfaceDescType vnd_desc = {
+    .bLength            = sizeof(vnd_desc),
+    .bDescriptorType    = USB_DESC_TYPE_INTERFACE,
+    .bInterfaceNumber   = 0,
+    .bAlternateSetting  = 0,
+    .bNumEndpoints      = 0,
+    .bInterfaceClass    = 0xFF, /* bInterfaceClass: Vendor Specific */
+    .bInterfaceSubClass = 0x00,
+    .bInterfaceProtocol = 0x00,
+    .iInterface         = USBD_ISTR_INTERFACES,
+};
+
+static uint16_t         vnd_getDesc     (USBD_VND_IfHandleType *itf, uint8_t ifNum, uint8_t * dest);
+static const char *     vnd_getString   (USBD_VND_IfHandleType *itf, uint8_t intNum);
+static void             vnd_init        (USBD_VND_IfHandleType *itf);
+static void             vnd_deinit      (USBD_VND_IfHandleType *itf);
+static USBD_ReturnType  vnd_setupStage  (USBD_VND_IfHandleType *itf);
+static void             vnd_dataStage   (USBD_VND_IfHandleType *itf);
+static void             vnd_outData     (USBD_VND_IfHandleType *itf, USBD_EpHandleType *ep);
+static void             vnd_inData      (USBD_VND_IfHandleType *itf, USBD_EpHandleType *ep);
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+static uint16_t         vnd_getMsOsDesc (USBD_VND_IfHandleType *itf, uint8_t ifNum, uint8_t * dest);
+#endif
+
+/* VND interface class callbacks structure */
+static const USBD_ClassType vnd_cbks = {
+    .GetDescriptor  = (USBD_IfDescCbkType)  vnd_getDesc,
+    .GetString      = (USBD_IfStrCbkType)   vnd_getString,
+    .Init           = (USBD_IfCbkType)      vnd_init,
+    .Deinit         = (USBD_IfCbkType)      vnd_deinit,
+    .SetupStage     = (USBD_IfSetupCbkType) vnd_setupStage,
+    .DataStage      = (USBD_IfCbkType)      vnd_dataStage,
+    .OutData        = (USBD_IfEpCbkType)    vnd_outData,
+    .InData         = (USBD_IfEpCbkType)    vnd_inData,
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+    .GetMsOsDesc    = (USBD_IfDescCbkType)  vnd_getMsOsDesc,
+#endif
+};
+
+/** @ingroup USBD_VND
+ * @defgroup USBD_VND_Private_Functions VND Private Functions
+ * @{ */
+
+/**
+ * @brief Copies the interface descriptor to the destination buffer.
+ * @param itf: reference of the VND interface
+ * @param ifNum: the index of the current interface in the device
+ * @param dest: the destination buffer
+ * @return Length of the copied descriptor
+ */
+static uint16_t vnd_getDesc(USBD_VND_IfHandleType *itf, uint8_t ifNum, uint8_t * dest)
+{
+    USB_InterfaceDescType *desc = (USB_InterfaceDescType*)dest;
+    uint16_t len = sizeof(vnd_desc);
+    uint8_t pipe;
+
+    memcpy(dest, &vnd_desc, sizeof(vnd_desc));
+
+#if (USBD_MAX_IF_COUNT > 1)
+    /* Adjustment of interface indexes */
+    desc->bInterfaceNumber = ifNum;
+    desc->iInterface       = USBD_IIF_INDEX(ifNum, 0);
+#endif /* (USBD_MAX_IF_COUNT > 1) */
+
+    desc->bNumEndpoints      = itf->Config.OutCount + itf->Config.InCount;
+    desc->bInterfaceSubClass = itf->Config.SubClass;
+    desc->bInterfaceProtocol = itf->Config.Protocol;
+
+    for (pipe = 0; pipe < itf->Config.OutCount; pipe++)
+    {
+        len += USBD_EpDesc(itf->Base.Device, itf->Config.OutEpNum[pipe], &dest[len]);
+    }
+    for (pipe = 0; pipe < itf->Config.InCount; pipe++)
+    {
+        len += USBD_EpDesc(itf->Base.Device, itf->Config.InEpNum[pipe], &dest[len]);
+    }
+
+#if (USBD_HS_SUPPORT == 1)
+    if (itf->Base.Device->Speed == USB_SPEED_FULL)
+    {
+        USB_EndpointDescType* ed = (USB_EndpointDescType*)&dest[sizeof(vnd_desc)];
+
+        for (pipe = 0; pipe < desc->bNumEndpoints; pipe++)
+        {
+            ed[pipe].wMaxPacketSize = USB_EP_BULK_FS_MPS;
+        }
+    }
+#endif
+
+    return len;
+}
+
+/**
+ * @brief Returns the selected interface string.
+ * @param itf: reference of the VND interface
+ * @param intNum: interface-internal string index
+ * @return The referenced string
+ */
+static const char* vnd_getString(USBD_VND_IfHandleType *itf, uint8_t intNum)
+{
+    return itf->App->Name;
+}
+
+/**
+ * @brief Initializes the interface by opening its endpoints, linking the pipe queues
+ *        and initializing the attached application.
+ * @param itf: reference of the VND interface
+ */
+static void vnd_init(USBD_VND_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint16_t mps;
+    uint8_t pipe;
+
+#if (USBD_HS_SUPPORT == 1)
+    if (itf->Base.Device->Speed == USB_SPEED_HIGH)
+    {
+        mps = USB_EP_BULK_HS_MPS;
+    }
+    else
+#endif
+    {
+        mps = USB_EP_BULK_FS_MPS;
+    }
+
+    /* Open EPs */
+    for (pipe = 0; pipe < itf->Config.OutCount; pipe++)
+    {
+        USBD_EpOpen(dev, itf->Config.OutEpNum[pipe], USB_EP_TYPE_BULK, mps,
+                USBD_EP_OPT_DOUBLE_BUFFER);
+        USBD_EpQueueInit(dev, itf->Config.OutEpNum[pipe], &itf->Out[pipe].Queue,
+                itf->Out[pipe].Ring, USBD_VND_QUEUE_SIZE);
+    }
+    for (pipe = 0; pipe < itf->Config.InCount; pipe++)
+    {
+        USBD_EpOpen(dev, itf->Config.InEpNum[pipe], USB_EP_TYPE_BULK, mps,
+                USBD_EP_OPT_DOUBLE_BUFFER);
+        USBD_EpQueueInit(dev, itf->Config.InEpNum[pipe], &itf->In[pipe].Queue,
+                itf->In[pipe].Ring, USBD_VND_QUEUE_SIZE);
+    }
+
+    /* Initialize application */
+    USBD_SAFE_CALLBACK(VND_APP(itf)->Init, );
+}
+
+/**
+ * @brief Deinitializes the interface by closing its endpoints
+ *        and deinitializing the attached application.
+ * @param itf: reference of the VND interface
+ */
+static void vnd_deinit(USBD_VND_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+    uint8_t pipe;
+
+    /* Close EPs, discarding the queued transfers */
+    for (pipe = 0; pipe < itf->Config.OutCount; pipe++)
+    {
+        USBD_EpClose(dev, itf->Config.OutEpNum[pipe]);
+    }
+    for (pipe = 0; pipe < itf->Config.InCount; pipe++)
+    {
+        USBD_EpClose(dev, itf->Config.InEpNum[pipe]);
+    }
+
+    /* Deinitialize application */
+    USBD_SAFE_CALLBACK(VND_APP(itf)->Deinit, );
+
+#if (USBD_HS_SUPPORT == 1)
+    /* Reset the endpoint MPS to the desired size */
+    for (pipe = 0; pipe < itf->Config.OutCount; pipe++)
+    {
+        dev->EP.OUT[itf->Config.OutEpNum[pipe]].MaxPacketSize = VND_DATA_PACKET_SIZE;
+    }
+    for (pipe = 0; pipe < itf->Config.InCount; pipe++)
+    {
+        dev->EP.IN[itf->Config.InEpNum[pipe] & 0xF].MaxPacketSize = VND_DATA_PACKET_SIZE;
+    }
+#endif
+}
+
+/**
+ * @brief Passes the vendor requests of the interface to the application.
+ * @param itf: reference of the VND interface
+ * @return OK if the setup request is accepted, INVALID otherwise
+ */
+static USBD_ReturnType vnd_setupStage(USBD_VND_IfHandleType *itf)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+    USBD_HandleType *dev = itf->Base.Device;
+
+    if ((dev->Request.RequestType.Type == USB_REQ_TYPE_VENDOR) &&
+        (VND_APP(itf)->Control != NULL))
+    {
+        /* Data stage is upcoming */
+        if (dev->Request.Length > 0)
+        {
+            if (dev->Request.RequestType.Direction == USB_DIRECTION_IN)
+            {
+                /* Get the data to send */
+                VND_APP(itf)->Control(&dev->Request, dev->CtrlData);
+
+                retval = USBD_CtrlSendData(dev, dev->CtrlData, dev->Request.Length);
+            }
+            else
+            {
+                /* Receive Control data first */
+                retval = USBD_CtrlReceiveData(dev, dev->CtrlData);
+            }
+        }
+        else
+        {
+            /* Simply pass the request with wValue */
+            VND_APP(itf)->Control(&dev->Request, (uint8_t*) &dev->Request.Value);
+
+            retval = USBD_E_OK;
+        }
+    }
+
+    return retval;
+}
+
+/**
+ * @brief Passes the received control endpoint data to the application.
+ * @param itf: reference of the VND interface
+ */
+static void vnd_dataStage(USBD_VND_IfHandleType *itf)
+{
+    USBD_HandleType *dev = itf->Base.Device;
+
+    if (dev->Request.RequestType.Direction == USB_DIRECTION_OUT)
+    {
+        /* Hand over received data to App */
+        VND_APP(itf)->Control(&dev->Request, dev->CtrlData);
+    }
+}
+
+/**
+ * @brief Notifies the application of a completed OUT pipe transfer.
+ * @param itf: reference of the VND interface
+ * @param ep: reference to the endpoint structure
+ */
+static void vnd_outData(USBD_VND_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    uint8_t epAddr = USBD_EpRef2Addr(itf->Base.Device, ep);
+    uint8_t pipe = 0;
+
+    while ((pipe < itf->Config.OutCount) && (itf->Config.OutEpNum[pipe] != epAddr))
+    {   pipe++; }
+
+    if (pipe < itf->Config.OutCount)
+    {
+        USBD_SAFE_CALLBACK(VND_APP(itf)->Received, pipe,
+                ep->Transfer.Data - ep->Transfer.Length, ep->Transfer.Length);
+    }
+}
+
+/**
+ * @brief Notifies the application of a completed IN pipe transfer.
+ * @param itf: reference of the VND interface
+ * @param ep: reference to the endpoint structure
+ */
+static void vnd_inData(USBD_VND_IfHandleType *itf, USBD_EpHandleType *ep)
+{
+    uint8_t epAddr = USBD_EpRef2Addr(itf->Base.Device, ep);
+    uint8_t pipe = 0;
+
+    while ((pipe < itf->Config.InCount) && (itf->Config.InEpNum[pipe] != epAddr))
+    {   pipe++; }
+
+    if (pipe < itf->Config.InCount)
+    {
+        USBD_SAFE_CALLBACK(VND_APP(itf)->Transmitted, pipe,
+                ep->Transfer.Data - ep->Transfer.Length, ep->Transfer.Length);
+    }
+}
+
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+/**
+ * @brief Provides the MS OS 2.0 features of the interface:
+ *        the WinUSB compatible ID, and the device interface GUID if configured.
+ * @param itf: reference of the VND interface
+ * @param ifNum: the index of the current interface in the device
+ * @param dest: the destination buffer
+ * @return Length of the feature descriptors
+ */
+static uint16_t vnd_getMsOsDesc(USBD_VND_IfHandleType *itf, uint8_t ifNum, uint8_t * dest)
+{
+    USB_MsOs20CompatibleIdDescType *cid = (USB_MsOs20CompatibleIdDescType*)dest;
+    uint16_t len = sizeof(USB_MsOs20CompatibleIdDescType);
+
+    (void)ifNum;
+    memset(cid, 0, sizeof(USB_MsOs20CompatibleIdDescType));
+    cid->wLength         = sizeof(USB_MsOs20CompatibleIdDescType);
+    cid->wDescriptorType = USB_MS_OS_20_FEATURE_COMPATIBLE_ID;
+    memcpy(cid->CompatibleID, "WINUSB", sizeof("WINUSB") - 1);
+
+    if ((itf->Config.InterfaceGUID != NULL) &&
+        (strlen(itf->Config.InterfaceGUID) == VND_GUID_LENGTH))
+    {
+        VND_GuidPropertyDescType *prop = (VND_GuidPropertyDescType*)&dest[len];
+
+        memset(prop, 0, sizeof(VND_GuidPropertyDescType));
+        prop->wLength             = sizeof(VND_GuidPropertyDescType);
+        prop->wDescriptorType     = USB_MS_OS_20_FEATURE_REG_PROPERTY;
+        prop->wPropertyDataType   = VND_REG_MULTI_SZ;
+        prop->wPropertyNameLength = sizeof(prop->PropertyName);
+        Ascii2Unicode("DeviceInterfaceGUIDs", prop->PropertyName);
+        prop->wPropertyDataLength = sizeof(prop->PropertyData);
+        Ascii2Unicode(itf->Config.InterfaceGUID, prop->PropertyData);
+
+        len += sizeof(VND_GuidPropertyDescType);
+    }
+
+    return len;
+}
+#endif /* (USBD_MS_OS_DESC_SUPPORT == 1) */
+
+/** @} */
+
+/** @defgroup USBD_VND_Exported_Functions VND Exported Functions
+ * @{ */
+
+/**
+ * @brief Mounts the VND interface to the USB Device at the next interface slot.
+ * @note  The interface reference shall have its @ref USBD_VND_IfHandleType::Config structure
+ *        and @ref USBD_VND_IfHandleType::App reference properly set before this function is called.
+ * @param itf: reference of the VND interface
+ * @param dev: reference of the USB Device
+ * @return OK if the mounting was successful,
+ *         ERROR if it failed due to insufficient device interface slots
+ *         or the pipe counts exceed USBD_VND_MAX_PIPES
+ */
+USBD_ReturnType USBD_VND_MountInterface(USBD_VND_IfHandleType *itf, USBD_HandleType *dev)
+{
+    USBD_ReturnType retval = USBD_E_ERROR;
+
+    if ((dev->IfCount < USBD_MAX_IF_COUNT) &&
+        (itf->Config.OutCount <= USBD_VND_MAX_PIPES) &&
+        (itf->Config.InCount  <= USBD_VND_MAX_PIPES))
+    {
+        uint8_t pipe;
+
+        /* Binding interfaces */
+        itf->Base.Device = dev;
+        itf->Base.Class  = &vnd_cbks;
+        itf->Base.AltCount = 1;
+        itf->Base.AltSelector = 0;
+
+        for (pipe = 0; pipe < itf->Config.OutCount; pipe++)
+        {
+            USBD_EpHandleType *ep = &dev->EP.OUT[itf->Config.OutEpNum[pipe]];
+
+            ep->Type            = USB_EP_TYPE_BULK;
+            ep->MaxPacketSize   = VND_DATA_PACKET_SIZE;
+            ep->IfNum           = dev->IfCount;
+        }
+        for (pipe = 0; pipe < itf->Config.InCount; pipe++)
+        {
+            USBD_EpHandleType *ep = &dev->EP.IN[itf->Config.InEpNum[pipe] & 0xF];
+
+            ep->Type            = USB_EP_TYPE_BULK;
+            ep->MaxPacketSize   = VND_DATA_PACKET_SIZE;
+            ep->IfNum           = dev->IfCount;
+        }
+
+        dev->IF[dev->IfCount] = (USBD_IfHandleType*)itf;
+        dev->IfCount++;
+
+        retval = USBD_E_OK;
+    }
+
+    return retval;
+}
+
+/**
+ * @brief Queues a transfer on the selected IN pipe,
+ *        which is started as soon as the pipe's previous transfers are completed.
+ * @note  The data shall remain valid until @ref USBD_VND_AppType::Transmitted
+ *        is called with it. Similarly to @ref USBD_EpSend, no ZLP is appended.
+ * @param itf: reference of the VND interface
+ * @param pipe: index of the IN pipe
+ * @param data: pointer to the data to send
+ * @param length: length of the data
+ * @return BUSY if the queue of the pipe is full, OK if successful
+ */
+USBD_ReturnType USBD_VND_Transmit(USBD_VND_IfHandleType *itf, uint8_t pipe,
+        uint8_t *data, uint16_t length)
+{
+    USBD_EpRequestType req = {
+        .Data       = data,
+        .Length     = length,
+        .Complete   = NULL,
+        .Context    = NULL,
+    };
+    return USBD_EpSubmit(itf->Base.Device, itf->Config.InEpNum[pipe], &req);
+}
+
+/**
+ * @brief Queues a transfer on the selected OUT pipe,
+ *        which is started as soon as the pipe's previous transfers are completed.
+ * @note  The transfer completes when the length is received or a short packet ends it,
+ *        the length should be a multiple of the max packet size.
+ * @param itf: reference of the VND interface
+ * @param pipe: index of the OUT pipe
+ * @param data: pointer to the data to receive
+ * @param length: length of the data
+ * @return BUSY if the queue of the pipe is full, OK if successful
+ */
+USBD_ReturnType USBD_VND_Receive(USBD_VND_IfHandleType *itf, uint8_t pipe,
+        uint8_t *data, uint16_t length)
+{
+    USBD_EpRequestType req = {
+        .Data       = data,
+        .Length     = length,
+        .Complete   = NULL,
+        .Context    = NULL,
+    };
+    return USBD_EpSubmit(itf->Base.Device, itf->Config.OutEpNum[pipe], &req);
+}
+
+/** @} */
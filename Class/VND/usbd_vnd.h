@@ -0,0 +1,143 @@
+/**
+  ******************************************************************************
+  * @file    usbd_vnd.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB Vendor-specific bulk class
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_VND_H
+#define __USBD_VND_H
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <usbd_types.h>
+
+/** @ingroup USBD
+ * @addtogroup USBD_Class USBD Classes
+ * @{ */
+
+/** @defgroup USBD_VND Vendor-specific Class (VND)
+ * @{ */
+
+/** @defgroup USBD_VND_Exported_Macros VND Exported Macros
+ * @{ */
+
+/* The maximal number of bulk pipes of each direction per interface */
+#ifndef USBD_VND_MAX_PIPES
+#define USBD_VND_MAX_PIPES              2
+#endif
+
+/* The number of transfers each pipe can hold in its request queue */
+#ifndef USBD_VND_QUEUE_SIZE
+#define USBD_VND_QUEUE_SIZE             4
+#endif
+
+/** @} */
+
+/** @defgroup USBD_VND_Exported_Types VND Exported Types
+ * @{ */
+
+/** @brief VND application structure */
+typedef struct
+{
+    const char* Name;           /*!< String description of the application */
+
+    void (*Init)        (void); /*!< Initialization request */
+
+    void (*Deinit)      (void); /*!< Shutdown request */
+
+    void (*Control)     (USB_SetupRequestType * req,
+                         uint8_t * data);   /*!< Optional vendor requests of the interface */
+
+    void (*Received)    (uint8_t pipe,
+                         uint8_t * data,
+                         uint16_t length);  /*!< Received transfer of the OUT pipe completed */
+
+    void (*Transmitted) (uint8_t pipe,
+                         uint8_t * data,
+                         uint16_t length);  /*!< Transmission of the IN pipe completed */
+}USBD_VND_AppType;
+
+
+/** @brief VND interface configuration */
+typedef struct
+{
+    uint8_t SubClass;       /*!< Vendor-defined interface subclass */
+    uint8_t Protocol;       /*!< Vendor-defined interface protocol */
+    uint8_t OutCount;       /*!< Number of OUT pipes */
+    uint8_t InCount;        /*!< Number of IN pipes */
+    uint8_t OutEpNum[USBD_VND_MAX_PIPES]; /*!< OUT endpoint addresses of the pipes */
+    uint8_t InEpNum[USBD_VND_MAX_PIPES];  /*!< IN endpoint addresses of the pipes */
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+    const char* InterfaceGUID;  /*!< Device interface GUID registered by WinUSB, in the
+                                     "{xxxxxxxx-xxxx-xxxx-xxxx-xxxxxxxxxxxx}" format,
+                                     or NULL to only provide the WinUSB compatible ID */
+#endif
+}USBD_VND_ConfigType;
+
+
+/** @brief VND pipe request queue */
+typedef struct
+{
+    USBD_EpQueueType Queue;                         /*!< Endpoint queue of the pipe */
+    USBD_EpRequestType Ring[USBD_VND_QUEUE_SIZE];   /*!< Request ring of the queue */
+}USBD_VND_PipeType;
+
+
+/** @brief VND class interface structure */
+typedef struct
+{
+    USBD_IfHandleType Base;         /*!< Class-independent interface base */
+    const USBD_VND_AppType* App;    /*!< VND application reference */
+    USBD_VND_ConfigType Config;     /*!< VND interface configuration */
+
+    /* VND class internal context */
+    USBD_VND_PipeType Out[USBD_VND_MAX_PIPES];  /*!< OUT pipe queues */
+    USBD_VND_PipeType In[USBD_VND_MAX_PIPES];   /*!< IN pipe queues */
+}USBD_VND_IfHandleType;
+
+/** @} */
+
+/** @addtogroup USBD_VND_Exported_Functions
+ * @{ */
+USBD_ReturnType USBD_VND_MountInterface (USBD_VND_IfHandleType *itf,
+                                         USBD_HandleType *dev);
+
+USBD_ReturnType USBD_VND_Transmit       (USBD_VND_IfHandleType *itf,
+                                         uint8_t pipe,
+                                         uint8_t *data,
+                                         uint16_t length);
+
+USBD_ReturnType USBD_VND_Receive        (USBD_VND_IfHandleType *itf,
+                                         uint8_t pipe,
+                                         uint8_t *data,
+                                         uint16_t length);
+/** @} */
+
+/** @} */
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif  /* __USBD_VND_H */
@@ -23,6 +23,134 @@
   */
 #include <usbd_private.h>
 
+#if (USBD_DEFERRED_PROCESSING == 1)
+/** @ingroup USBD
+ * @defgroup USBD_Private_Functions_Event USB Device Event Queue Functions
+ * @brief The PD callbacks only store the events in the queue,
+ *        to be processed outside of the interrupt context.
+ * @{ */
+
+static void USBD_ResetHandler(USBD_HandleType *dev, USB_SpeedType speed);
+#if (USBD_TRACE_SUPPORT == 1)
+static void USBD_TraceLinkHandler(USBD_HandleType *dev, USB_LinkStateType state);
+#endif
+
+/**
+ * @brief Stores an event in the device's event queue.
+ *        Called from the PD context only.
+ * @param dev: USB Device handle reference
+ * @param id: the event identifier
+ * @param param: the event parameter
+ * @return Reference of the stored event, or NULL if the queue is full
+ */
+static volatile USBD_EventType* USBD_EventPush(USBD_HandleType *dev,
+        USBD_EventIdType id, uint8_t param)
+{
+    volatile USBD_EventType *ev = NULL;
+    uint8_t head = dev->Events.Head;
+    uint8_t next = (head + 1) % USBD_EVENT_QUEUE_SIZE;
+
+    if (next == dev->Events.Tail)
+    {
+        dev->Events.Overflow = 1;
+    }
+    else
+    {
+        ev = &dev->Events.Ring[head];
+        ev->Id    = id;
+        ev->Param = param;
+    }
+    return ev;
+}
+
+/**
+ * @brief Publishes the last stored event to @ref USBD_Process.
+ * @param dev: USB Device handle reference
+ */
+static inline void USBD_EventCommit(USBD_HandleType *dev)
+{
+    dev->Events.Head = (dev->Events.Head + 1) % USBD_EVENT_QUEUE_SIZE;
+}
+
+/**
+ * @brief Queues the reception of a setup request.
+ * @param dev: USB Device handle reference
+ */
+void USBD_SetupCallback(USBD_HandleType *dev)
+{
+    volatile USBD_EventType *ev = USBD_EventPush(dev, USBD_EVENT_SETUP, 0);
+
+    if (ev != NULL)
+    {
+        /* The setup request is saved, as a new one may arrive before processing */
+        ev->Setup = dev->Setup;
+        USBD_EventCommit(dev);
+    }
+}
+
+/**
+ * @brief Queues the completion of an IN endpoint transfer.
+ * @param dev: USB Device handle reference
+ * @param ep: USB IN endpoint handle reference
+ */
+void USBD_EpInCallback(USBD_HandleType *dev, USBD_EpHandleType *ep)
+{
+    if (USBD_EventPush(dev, USBD_EVENT_EP_IN, ep - dev->EP.IN) != NULL)
+    {   USBD_EventCommit(dev); }
+}
+
+/**
+ * @brief Queues the completion of an OUT endpoint transfer.
+ * @param dev: USB Device handle reference
+ * @param ep: USB OUT endpoint handle reference
+ */
+void USBD_EpOutCallback(USBD_HandleType *dev, USBD_EpHandleType *ep)
+{
+    if (USBD_EventPush(dev, USBD_EVENT_EP_OUT, ep - dev->EP.OUT) != NULL)
+    {   USBD_EventCommit(dev); }
+}
+
+/**
+ * @brief Queues the bus reset.
+ * @param dev: USB Device handle reference
+ * @param speed: The new device speed
+ */
+void USBD_ResetCallback(USBD_HandleType *dev, USB_SpeedType speed)
+{
+    if (USBD_EventPush(dev, USBD_EVENT_RESET, speed) != NULL)
+    {   USBD_EventCommit(dev); }
+}
+
+#if (USBD_SOF_SUPPORT == 1)
+/**
+ * @brief Counts the start of (micro)frame, without occupying the event queue.
+ * @param dev: USB Device handle reference
+ */
+void USBD_SofCallback(USBD_HandleType *dev)
+{
+    dev->Events.SofHead++;
+#if (USBD_TRACE_SUPPORT == 1)
+    dev->Trace.Frame++;
+#endif
+}
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+/**
+ * @brief Queues the link state change to be traced.
+ * @param dev: USB Device handle reference
+ * @param state: The new link state
+ */
+void USBD_TraceLinkState(USBD_HandleType *dev, USB_LinkStateType state)
+{
+    if (USBD_EventPush(dev, USBD_EVENT_LINK, state) != NULL)
+    {   USBD_EventCommit(dev); }
+}
+#endif
+
+/** @} */
+#endif /* (USBD_DEFERRED_PROCESSING == 1) */
+
 /** @ingroup USBD
  * @defgroup USBD_Exported_Functions USB Device Exported Functions
  * @brief These functions are called by the user code
@@ -44,12 +172,37 @@ void USBD_Init(USBD_HandleType *dev, const USBD_DescriptionType *desc)
     dev->Features.RemoteWakeup = 0;
     dev->Features.SelfPowered  = dev->Desc->Config.SelfPowered;
 
+#if (USBD_SERIAL_BCD_SIZE > 0)
+    /* Convert the serial number once */
+    USBD_SerialDescInit(dev);
+#endif
+
     /* For FS device some buffer space can be saved by changing
      * EP0 MPS to 32/16/8
      * HS capable devices must keep this value at 64 */
     dev->EP.IN [0].MaxPacketSize = USB_EP0_FS_MAX_PACKET_SIZE;
     dev->EP.OUT[0].MaxPacketSize = USB_EP0_FS_MAX_PACKET_SIZE;
 
+#if (USBD_DEFERRED_PROCESSING == 1)
+    dev->Events.Head = 0;
+    dev->Events.Tail = 0;
+    dev->Events.Overflow = 0;
+#endif
+
+#if (USBD_STATS_SUPPORT == 1)
+    USBD_StatsReset(dev);
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+    /* No stale entry shall appear committed */
+    memset(dev->Trace.Ring, 0, sizeof(dev->Trace.Ring));
+    dev->Trace.Head = 0;
+    dev->Trace.Tail = 0;
+    dev->Trace.Frame = 0;
+    dev->Trace.Dropped = 0;
+    dev->Trace.Ignore = 0;
+#endif
+
     /* Initialize low level driver with device configuration */
     USBD_PD_Init(dev, &dev->Desc->Config);
 }
@@ -77,6 +230,9 @@ void USBD_UnmountInterfaces(USBD_HandleType *dev)
     USBD_IfConfig(dev, 0);
 
     dev->IfCount = 0;
+#if (USBD_CONFIG_DESC_CACHE == 1)
+    USBD_ConfigDescInvalidate(dev);
+#endif
 
     for (i = 1; i < USBD_MAX_EP_COUNT; i++)
     {
@@ -149,6 +305,67 @@ USBD_ReturnType USBD_ClearRemoteWakeup(USBD_HandleType *dev)
     return retval;
 }
 
+#if (USBD_DEFERRED_PROCESSING == 1)
+/**
+ * @brief This function processes the events signalled by the Peripheral Driver
+ *        since the last call, in their order of arrival. The class and application
+ *        callbacks are called from this context instead of the PD's interrupt.
+ * @note  Shall be called periodically from a single thread context.
+ * @param dev: USB Device handle reference
+ */
+void USBD_Process(USBD_HandleType *dev)
+{
+    uint8_t tail = dev->Events.Tail;
+
+    while (tail != dev->Events.Head)
+    {
+        volatile USBD_EventType *ev = &dev->Events.Ring[tail];
+
+        switch (ev->Id)
+        {
+            case USBD_EVENT_RESET:
+                USBD_ResetHandler(dev, (USB_SpeedType)ev->Param);
+                break;
+
+            case USBD_EVENT_SETUP:
+                dev->Request = ev->Setup;
+                USBD_SetupHandler(dev);
+                break;
+
+            case USBD_EVENT_EP_IN:
+                USBD_EpInHandler(dev, &dev->EP.IN[ev->Param]);
+                break;
+
+            case USBD_EVENT_EP_OUT:
+                USBD_EpOutHandler(dev, &dev->EP.OUT[ev->Param]);
+                break;
+
+#if (USBD_TRACE_SUPPORT == 1)
+            case USBD_EVENT_LINK:
+                USBD_TraceLinkHandler(dev, (USB_LinkStateType)ev->Param);
+                break;
+#endif
+
+            default:
+                break;
+        }
+
+        /* The slot is only released after processing */
+        tail = (tail + 1) % USBD_EVENT_QUEUE_SIZE;
+        dev->Events.Tail = tail;
+    }
+
+#if (USBD_SOF_SUPPORT == 1)
+    /* Each counted start of frame is passed on */
+    while (dev->Events.SofTail != dev->Events.SofHead)
+    {
+        USBD_IfSof(dev);
+        dev->Events.SofTail++;
+    }
+#endif
+}
+#endif /* (USBD_DEFERRED_PROCESSING == 1) */
+
 /**
  * @brief This function performs the necessary actions upon receiving Reset signal:
  *         - Opens the control endpoint 0
@@ -156,9 +373,21 @@ USBD_ReturnType USBD_ClearRemoteWakeup(USBD_HandleType *dev)
  * @param dev: USB Device handle reference
  * @param speed: The new device speed
  */
+#if (USBD_DEFERRED_PROCESSING == 1)
+static void USBD_ResetHandler(USBD_HandleType *dev, USB_SpeedType speed)
+#else
 void USBD_ResetCallback(USBD_HandleType *dev, USB_SpeedType speed)
+#endif
 {
+#if (USBD_CONFIG_DESC_CACHE == 1)
+    /* The endpoint descriptors depend on the speed */
+    if (dev->Speed != speed)
+    {
+        USBD_ConfigDescInvalidate(dev);
+    }
+#endif
     dev->Speed = speed;
+    USBD_TraceRecord(dev, USBD_TRACE_RESET, speed, 0);
 
     /* Reset EP0 state */
     dev->EP.OUT[0].State = USB_EP_STATE_IDLE;
@@ -167,6 +396,39 @@ void USBD_ResetCallback(USBD_HandleType *dev, USB_SpeedType speed)
     USBD_IfConfig(dev, 0);
 }
 
+#if (USBD_SOF_SUPPORT == 1) && (USBD_DEFERRED_PROCESSING == 0)
+/**
+ * @brief This function passes the start of (micro)frame to the interfaces.
+ * @param dev: USB Device handle reference
+ */
+void USBD_SofCallback(USBD_HandleType *dev)
+{
+#if (USBD_TRACE_SUPPORT == 1)
+    dev->Trace.Frame++;
+#endif
+    USBD_IfSof(dev);
+}
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+/**
+ * @brief This function records the link state change (suspend or resume) in the trace.
+ * @note  Shall be called by the PD after the change: the loopback PD records its
+ *        simulated suspend and resume, the STM32_XPD PD by USBD_PD_SuspendCallback()
+ *        and USBD_PD_ResumeCallback() set as the Suspend and Resume callbacks of the handle.
+ * @param dev: USB Device handle reference
+ * @param state: The new link state
+ */
+#if (USBD_DEFERRED_PROCESSING == 1)
+static void USBD_TraceLinkHandler(USBD_HandleType *dev, USB_LinkStateType state)
+#else
+void USBD_TraceLinkState(USBD_HandleType *dev, USB_LinkStateType state)
+#endif
+{
+    USBD_TraceRecord(dev, USBD_TRACE_LINK, state, 0);
+}
+#endif /* (USBD_TRACE_SUPPORT == 1) */
+
 /** @} */
 
 /** @ingroup USBD
@@ -183,12 +445,12 @@ static USBD_ReturnType USBD_SetAddress(USBD_HandleType *dev)
     USBD_ReturnType retval = USBD_E_INVALID;
 
     /* The request is only valid when not configured yet */
-    if ((dev->Setup.Index    == 0) &&
-        (dev->Setup.Length   == 0) &&
+    if ((dev->Request.Index    == 0) &&
+        (dev->Request.Length   == 0) &&
         (dev->ConfigSelector == 0))
     {
 #if (USBD_SET_ADDRESS_IMMEDIATE == 1)
-        USBD_PD_SetAddress(dev, dev->Setup.Value & 0x7F);
+        USBD_PD_SetAddress(dev, dev->Request.Value & 0x7F);
 #endif
         /* Address is accepted, it will be applied
          * after this Ctrl transfer is complete */
@@ -205,7 +467,7 @@ static USBD_ReturnType USBD_SetAddress(USBD_HandleType *dev)
 static USBD_ReturnType USBD_SetConfig(USBD_HandleType *dev)
 {
     USBD_ReturnType retval = USBD_E_INVALID;
-    uint8_t cfgNum = (uint8_t)dev->Setup.Value;
+    uint8_t cfgNum = (uint8_t)dev->Request.Value;
 
     if (cfgNum <= USBD_MAX_CONFIGURATION_COUNT)
     {
@@ -250,7 +512,7 @@ static USBD_ReturnType USBD_SetFeature(USBD_HandleType *dev)
     USBD_ReturnType retval = USBD_E_INVALID;
 
     /* The only settable std device feature */
-    if (dev->Setup.Value == USB_FEATURE_REMOTE_WAKEUP)
+    if (dev->Request.Value == USB_FEATURE_REMOTE_WAKEUP)
     {
         dev->Features.RemoteWakeup = 1;
         retval = USBD_E_OK;
@@ -268,7 +530,7 @@ static USBD_ReturnType USBD_ClearFeature(USBD_HandleType *dev)
     USBD_ReturnType retval = USBD_E_INVALID;
 
     /* The only settable std device feature */
-    if (dev->Setup.Value == USB_FEATURE_REMOTE_WAKEUP)
+    if (dev->Request.Value == USB_FEATURE_REMOTE_WAKEUP)
     {
         dev->Features.RemoteWakeup = 0;
         retval = USBD_E_OK;
@@ -285,10 +547,11 @@ USBD_ReturnType USBD_DevRequest(USBD_HandleType *dev)
 {
     USBD_ReturnType retval = USBD_E_INVALID;
 
-    /* On device level only (the below) standard requests are supported */
-    if (dev->Setup.RequestType.Type == USB_REQ_TYPE_STANDARD)
+    /* On device level only (the below) standard requests are supported,
+     * and the vendor requests of the MS OS 2.0 descriptor set and the statistics */
+    if (dev->Request.RequestType.Type == USB_REQ_TYPE_STANDARD)
     {
-        switch (dev->Setup.Request)
+        switch (dev->Request.Request)
         {
             case USB_REQ_GET_DESCRIPTOR:
                 retval = USBD_GetDescriptor(dev);
@@ -322,6 +585,19 @@ USBD_ReturnType USBD_DevRequest(USBD_HandleType *dev)
                 break;
         }
     }
+#if (USBD_STATS_SUPPORT == 1) && (USBD_STATS_VENDOR_CODE != 0)
+    else if ((dev->Request.RequestType.Type == USB_REQ_TYPE_VENDOR) &&
+             (dev->Request.Request == USBD_STATS_VENDOR_CODE))
+    {
+        retval = USBD_StatsRequest(dev);
+    }
+#endif
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+    else if (dev->Request.RequestType.Type == USB_REQ_TYPE_VENDOR)
+    {
+        retval = USBD_GetMsOsDescriptor(dev);
+    }
+#endif
     return retval;
 }
 
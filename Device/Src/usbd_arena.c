@@ -0,0 +1,114 @@
+/**
+  ******************************************************************************
+  * @file    usbd_arena.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Transfer buffer arena
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+
+#if (USBD_ARENA_BLOCK_COUNT > 0)
+
+#if ((USBD_ARENA_BLOCK_SIZE % USBD_ARENA_ALIGNMENT) != 0)
+#error "USBD_ARENA_BLOCK_SIZE has to be a multiple of USBD_ARENA_ALIGNMENT!"
+#endif
+
+__alignment(USBD_ARENA_ALIGNMENT)
+/** @brief The arena blocks */
+static uint8_t usbd_arena[USBD_ARENA_BLOCK_COUNT][USBD_ARENA_BLOCK_SIZE]
+                          __align(USBD_ARENA_ALIGNMENT) USBD_ARENA_SECTION;
+
+/** @brief The number of allocated blocks starting at each block, 0 if the block is free */
+static uint16_t usbd_arenaRun[USBD_ARENA_BLOCK_COUNT];
+
+/** @ingroup USBD
+ * @addtogroup USBD_Exported_Functions
+ * @{ */
+
+/**
+ * @brief Allocates a transfer buffer from the arena.
+ *        The buffer is aligned for the peripheral and the data cache,
+ *        and its size is rounded up to whole blocks.
+ * @note  The arena is not interrupt-safe, the buffers should be allocated
+ *        when the interfaces are mounted.
+ * @param size: the requested buffer size
+ * @return Reference of the buffer, or NULL if no contiguous space is available
+ */
+void* USBD_ArenaAlloc(uint16_t size)
+{
+    uint16_t blocks = (size + USBD_ARENA_BLOCK_SIZE - 1) / USBD_ARENA_BLOCK_SIZE;
+    uint16_t i = 0, j;
+    void *buffer = NULL;
+
+    if (blocks == 0)
+    {   blocks = 1; }
+
+    /* First fit search, skipping the allocated runs */
+    while ((buffer == NULL) && ((i + blocks) <= USBD_ARENA_BLOCK_COUNT))
+    {
+        if (usbd_arenaRun[i] != 0)
+        {
+            i += usbd_arenaRun[i];
+        }
+        else
+        {
+            j = i + 1;
+            while ((j < (i + blocks)) && (usbd_arenaRun[j] == 0))
+            {   j++; }
+
+            if (j == (i + blocks))
+            {
+                usbd_arenaRun[i] = blocks;
+                buffer = usbd_arena[i];
+            }
+            else
+            {
+                i = j;
+            }
+        }
+    }
+    return buffer;
+}
+
+/**
+ * @brief Returns a transfer buffer to the arena.
+ * @param buffer: reference of the buffer returned by @ref USBD_ArenaAlloc
+ */
+void USBD_ArenaFree(void *buffer)
+{
+    if (USBD_ArenaContains(buffer) != 0)
+    {
+        usbd_arenaRun[((uint8_t*)buffer - usbd_arena[0]) / USBD_ARENA_BLOCK_SIZE] = 0;
+    }
+}
+
+/**
+ * @brief Determines whether the memory is located in the arena.
+ * @param buffer: reference of the memory
+ * @return Non-zero if the memory is part of the arena
+ */
+int USBD_ArenaContains(const void *buffer)
+{
+    return ((const uint8_t*)buffer >= usbd_arena[0]) &&
+           ((const uint8_t*)buffer <  usbd_arena[USBD_ARENA_BLOCK_COUNT]);
+}
+
+/** @} */
+
+#endif /* (USBD_ARENA_BLOCK_COUNT > 0) */
@@ -37,6 +37,8 @@ static void USBD_CtrlSendError(USBD_HandleType *dev)
     dev->EP.IN [0].State = USB_EP_STATE_STALL;
     USBD_PD_EpSetStall(dev, 0x00);
     dev->EP.OUT[0].State = USB_EP_STATE_STALL;
+    USBD_EP_STATS_INC(&dev->EP.IN[0], Stalls);
+    USBD_TraceEp(dev, USBD_TRACE_STALL, 0x00, 0);
 }
 
 /**
@@ -59,6 +61,92 @@ static void USBD_CtrlReceiveStatus(USBD_HandleType *dev)
     USBD_PD_EpReceive(dev, 0x00, NULL, 0);
 }
 
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+/**
+ * @brief Returns the size of the control data chunks: the most EP0 packets
+ *        which fit in the control endpoint buffer.
+ * @param dev: USB Device handle reference
+ * @return The chunk size
+ */
+static inline uint16_t USBD_CtrlChunkSize(USBD_HandleType *dev)
+{
+    uint16_t mps = dev->EP.IN[0].MaxPacketSize;
+
+    return (sizeof(dev->CtrlData) / mps) * mps;
+}
+
+/**
+ * @brief This function sends the next chunk of the data stage,
+ *        filled by the chunk provider.
+ * @param dev: USB Device handle reference
+ */
+static void USBD_CtrlSendChunk(USBD_HandleType *dev)
+{
+    uint16_t len = dev->CtrlChunk.Length - dev->CtrlChunk.Offset;
+    uint16_t filled;
+
+    if (len > USBD_CtrlChunkSize(dev))
+    {   len = USBD_CtrlChunkSize(dev); }
+
+    filled = dev->CtrlChunk.Callback(dev->CtrlChunk.Context,
+            dev->CtrlData, dev->CtrlChunk.Offset, len);
+
+    /* A short chunk ends the data stage */
+    if (filled < len)
+    {   dev->CtrlChunk.Length = dev->CtrlChunk.Offset + filled; }
+
+    dev->CtrlChunk.Offset += filled;
+    USBD_PD_EpSend(dev, 0x80, dev->CtrlData, filled);
+}
+
+/**
+ * @brief This function receives the next chunk of the data stage.
+ * @param dev: USB Device handle reference
+ */
+static void USBD_CtrlReceiveChunk(USBD_HandleType *dev)
+{
+    uint16_t len = dev->CtrlChunk.Length - dev->CtrlChunk.Offset;
+
+    if (len > USBD_CtrlChunkSize(dev))
+    {   len = USBD_CtrlChunkSize(dev); }
+
+    dev->EP.OUT[0].State = USB_EP_STATE_DATA;
+    USBD_PD_EpReceive(dev, 0x00, dev->CtrlData, len);
+}
+
+/**
+ * @brief This function passes the received chunk to the chunk consumer,
+ *        and continues the reception until the data stage is complete.
+ * @param dev: USB Device handle reference
+ * @return OK if the data stage is complete, BUSY if the next chunk is being received,
+ *         ERROR if the consumer didn't accept the data
+ */
+static USBD_ReturnType USBD_CtrlReceivedChunk(USBD_HandleType *dev)
+{
+    USBD_ReturnType retval = USBD_E_OK;
+    uint16_t len = dev->EP.OUT[0].Transfer.Length;
+
+    if (dev->CtrlChunk.Callback(dev->CtrlChunk.Context,
+            dev->CtrlData, dev->CtrlChunk.Offset, len) < len)
+    {
+        retval = USBD_E_ERROR;
+    }
+    else
+    {
+        dev->CtrlChunk.Offset += len;
+
+        /* A short packet ends the data stage early */
+        if ((dev->CtrlChunk.Offset < dev->CtrlChunk.Length) &&
+            ((len % dev->EP.OUT[0].MaxPacketSize) == 0) && (len > 0))
+        {
+            USBD_CtrlReceiveChunk(dev);
+            retval = USBD_E_BUSY;
+        }
+    }
+    return retval;
+}
+#endif /* (USBD_CTRL_CHUNK_SUPPORT == 1) */
+
 /**
  * @brief This function manages the end of a control IN endpoint transfer:
  *         - Send Zero Length Packet if the end of the transfer is ambiguous
@@ -68,10 +156,25 @@ static void USBD_CtrlReceiveStatus(USBD_HandleType *dev)
  */
 void USBD_CtrlInCallback(USBD_HandleType *dev)
 {
+    uint16_t len = dev->EP.IN[0].Transfer.Length;
+
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    /* The ZLP decision is based on the entire chunked data stage */
+    if ((dev->CtrlChunk.Callback != NULL) && (len > 0))
+    {   len = dev->CtrlChunk.Length; }
+
+    if ((dev->CtrlChunk.Callback != NULL) &&
+        (dev->CtrlChunk.Offset < dev->CtrlChunk.Length))
+    {
+        /* Continue with the next chunk */
+        USBD_CtrlSendChunk(dev);
+    }
+    else
+#endif
     /* Last packet is MPS multiple, so send ZLP packet */
-    if (( dev->EP.IN[0].Transfer.Length <  dev->Setup.Length) &&
-        ( dev->EP.IN[0].Transfer.Length >= dev->EP.IN[0].MaxPacketSize) &&
-        ((dev->EP.IN[0].Transfer.Length & (dev->EP.IN[0].MaxPacketSize - 1)) == 0))
+    if (( len <  dev->Request.Length) &&
+        ( len >= dev->EP.IN[0].MaxPacketSize) &&
+        ((len & (dev->EP.IN[0].MaxPacketSize - 1)) == 0))
     {
         USBD_PD_EpSend(dev, 0x80, NULL, 0);
     }
@@ -80,14 +183,14 @@ void USBD_CtrlInCallback(USBD_HandleType *dev)
         dev->EP.IN[0].State = USB_EP_STATE_IDLE;
 
         /* If the callback is from a Data stage */
-        if (dev->Setup.RequestType.Direction == USB_DIRECTION_IN)
+        if (dev->Request.RequestType.Direction == USB_DIRECTION_IN)
         {
             /* Only call back if the IF was serving the request */
             if ((dev->ConfigSelector != 0) &&
-                (dev->Setup.RequestType.Recipient == USB_REQ_RECIPIENT_INTERFACE))
+                (dev->Request.RequestType.Recipient == USB_REQ_RECIPIENT_INTERFACE))
             {
                 /* If callback for transmitted EP0 data */
-                USBD_IfClass_DataStage(dev->IF[(uint8_t)dev->Setup.Index]);
+                USBD_IfClass_DataStage(dev->IF[(uint8_t)dev->Request.Index]);
             }
 
             /* Proceed to Status stage */
@@ -95,10 +198,10 @@ void USBD_CtrlInCallback(USBD_HandleType *dev)
         }
 #if (USBD_SET_ADDRESS_IMMEDIATE != 1)
         /* If the address was set by the last request, apply it now */
-        else if ((dev->Setup.RequestType.b == 0x00) &&
-                 (dev->Setup.Request == USB_REQ_SET_ADDRESS))
+        else if ((dev->Request.RequestType.b == 0x00) &&
+                 (dev->Request.Request == USB_REQ_SET_ADDRESS))
         {
-            USBD_PD_SetAddress(dev, dev->Setup.Value & 0x7F);
+            USBD_PD_SetAddress(dev, dev->Request.Value & 0x7F);
         }
 #endif
     }
@@ -111,22 +214,44 @@ void USBD_CtrlInCallback(USBD_HandleType *dev)
  */
 void USBD_CtrlOutCallback(USBD_HandleType *dev)
 {
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    USBD_ReturnType chunk = USBD_E_OK;
+#endif
+
+    dev->EP.OUT[0].State = USB_EP_STATE_IDLE;
+
     /* If the callback is from a Data stage */
-    if ((dev->Setup.Length > 0) &&
-        (dev->Setup.RequestType.Direction == USB_DIRECTION_OUT))
+    if ((dev->Request.Length > 0) &&
+        (dev->Request.RequestType.Direction == USB_DIRECTION_OUT))
     {
-        /* Standard requests have no OUT direction data stage -> must be IF related */
-        if (dev->ConfigSelector != 0)
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+        if (dev->CtrlChunk.Callback != NULL)
         {
-            /* If callback for received EP0 data */
-            USBD_IfClass_DataStage(dev->IF[(uint8_t)dev->Setup.Index]);
+            chunk = USBD_CtrlReceivedChunk(dev);
         }
 
-        /* Proceed to Status stage */
-        USBD_CtrlSendStatus(dev);
-    }
+        if (chunk == USBD_E_BUSY)
+        {
+            /* The next chunk is being received */
+        }
+        else if (chunk != USBD_E_OK)
+        {
+            USBD_CtrlSendError(dev);
+        }
+        else
+#endif
+        {
+            /* Standard requests have no OUT direction data stage -> must be IF related */
+            if (dev->ConfigSelector != 0)
+            {
+                /* If callback for received EP0 data */
+                USBD_IfClass_DataStage(dev->IF[(uint8_t)dev->Request.Index]);
+            }
 
-    dev->EP.OUT[0].State = USB_EP_STATE_IDLE;
+            /* Proceed to Status stage */
+            USBD_CtrlSendStatus(dev);
+        }
+    }
 }
 
 /** @} */
@@ -149,9 +274,9 @@ USBD_ReturnType USBD_CtrlSendData(USBD_HandleType *dev, const uint8_t *data, uin
     if (dev->EP.OUT[0].State == USB_EP_STATE_SETUP)
     {
         /* Don't send more bytes than requested */
-        if (dev->Setup.Length < len)
+        if (dev->Request.Length < len)
         {
-            len = dev->Setup.Length;
+            len = dev->Request.Length;
         }
 
         dev->EP.IN[0].State = USB_EP_STATE_DATA;
@@ -180,7 +305,7 @@ USBD_ReturnType USBD_CtrlReceiveData(USBD_HandleType *dev, uint8_t *data)
     /* Sanity check */
     if (dev->EP.OUT[0].State == USB_EP_STATE_SETUP)
     {
-        uint16_t len = dev->Setup.Length;
+        uint16_t len = dev->Request.Length;
 
         dev->EP.OUT[0].State = USB_EP_STATE_DATA;
         USBD_PD_EpReceive(dev, 0x00, data, len);
@@ -190,6 +315,74 @@ USBD_ReturnType USBD_CtrlReceiveData(USBD_HandleType *dev, uint8_t *data)
     return retval;
 }
 
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+/**
+ * @brief This function sends the data stage in chunks in response to a setup request.
+ *        Each chunk is filled by the provider into the device's CtrlData buffer,
+ *        so the data stage can be longer than the buffer.
+ * @param dev: USB Device handle reference
+ * @param len: total length of the data
+ * @param provider: the chunk provider callback
+ * @param context: the context passed to the provider
+ * @return OK if called from the right context, ERROR otherwise
+ */
+USBD_ReturnType USBD_CtrlSendChunked(USBD_HandleType *dev, uint16_t len,
+        USBD_CtrlChunkCbkType provider, void *context)
+{
+    USBD_ReturnType retval = USBD_E_ERROR;
+
+    /* Sanity check */
+    if (dev->EP.OUT[0].State == USB_EP_STATE_SETUP)
+    {
+        /* Don't send more bytes than requested */
+        if (dev->Request.Length < len)
+        {
+            len = dev->Request.Length;
+        }
+
+        dev->CtrlChunk.Callback = provider;
+        dev->CtrlChunk.Context  = context;
+        dev->CtrlChunk.Offset   = 0;
+        dev->CtrlChunk.Length   = len;
+
+        dev->EP.IN[0].State = USB_EP_STATE_DATA;
+        USBD_CtrlSendChunk(dev);
+
+        retval = USBD_E_OK;
+    }
+    return retval;
+}
+
+/**
+ * @brief This function receives the data stage of the setup request in chunks.
+ *        Each chunk is received to the device's CtrlData buffer and passed to the consumer,
+ *        so the data stage can be longer than the buffer.
+ * @param dev: USB Device handle reference
+ * @param consumer: the chunk consumer callback
+ * @param context: the context passed to the consumer
+ * @return OK if called from the right context, ERROR otherwise
+ */
+USBD_ReturnType USBD_CtrlReceiveChunked(USBD_HandleType *dev,
+        USBD_CtrlChunkCbkType consumer, void *context)
+{
+    USBD_ReturnType retval = USBD_E_ERROR;
+
+    /* Sanity check */
+    if (dev->EP.OUT[0].State == USB_EP_STATE_SETUP)
+    {
+        dev->CtrlChunk.Callback = consumer;
+        dev->CtrlChunk.Context  = context;
+        dev->CtrlChunk.Offset   = 0;
+        dev->CtrlChunk.Length   = dev->Request.Length;
+
+        USBD_CtrlReceiveChunk(dev);
+
+        retval = USBD_E_OK;
+    }
+    return retval;
+}
+#endif /* (USBD_CTRL_CHUNK_SUPPORT == 1) */
+
 /** @} */
 
 /** @addtogroup USBD_Exported_Functions
@@ -201,14 +394,31 @@ USBD_ReturnType USBD_CtrlReceiveData(USBD_HandleType *dev, uint8_t *data)
  *        or the request wasn't accepted.
  * @param dev: USB Device handle reference
  */
+#if (USBD_DEFERRED_PROCESSING == 1)
+void USBD_SetupHandler(USBD_HandleType *dev)
+#else
 void USBD_SetupCallback(USBD_HandleType *dev)
+#endif
 {
     USBD_ReturnType retval = USBD_E_INVALID;
+    USBD_PROFILE_START();
+#if (USBD_TRACE_SUPPORT == 1)
+    USBD_TraceEntryType *entry = USBD_TracePush(dev, USBD_TRACE_SETUP, 0);
+
+    if (entry != NULL)
+    {
+        entry->Setup = dev->Request;
+        USBD_TraceCommit(entry);
+    }
+#endif
 
     dev->EP.OUT[0].State = USB_EP_STATE_SETUP;
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    dev->CtrlChunk.Callback = NULL;
+#endif
 
     /* Route the request to the recipient */
-    switch (dev->Setup.RequestType.Recipient)
+    switch (dev->Request.RequestType.Recipient)
     {
         case USB_REQ_RECIPIENT_DEVICE:
             retval = USBD_DevRequest(dev);
@@ -233,7 +443,7 @@ void USBD_SetupCallback(USBD_HandleType *dev)
     }
     /* If the wLength is 0, there is no Data stage,
      * send positive status (EP0 ZLP) */
-    else if (dev->Setup.Length == 0)
+    else if (dev->Request.Length == 0)
     {
         USBD_CtrlSendStatus(dev);
     }
@@ -241,6 +451,8 @@ void USBD_SetupCallback(USBD_HandleType *dev)
     {
         /* Data stage starts in the requested direction */
     }
+
+    USBD_PROFILE_END(dev, USBD_PROFILE_SETUP);
 }
 
 /** @} */
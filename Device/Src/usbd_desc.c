@@ -24,6 +24,7 @@
 #define USBD_DEVICE_API
 #include <usbd_private.h>
 #include <usbd_utils.h>
+#include <usbd_desc.h>
 
 /** @ingroup USBD
  * @defgroup USBD_Private_Constants USBD Descriptor Prototypes
@@ -73,25 +74,53 @@ static const USB_DeviceQualifierDescType usbd_devQualDesc __align(USBD_DATA_ALIG
 };
 #endif
 
-/** @brief USB Binary device Object Store (BOS) Descriptor */
-#if (USBD_LPM_SUPPORT == 1)
-static const struct {
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+/* The MS OS 2.0 descriptors apply from Windows 8.1 */
+#define USBD_MS_OS_20_WINDOWS_VERSION       0x06030000
+
+/* The wIndex of the MS OS 2.0 descriptor set request */
+#define USBD_MS_OS_20_DESCRIPTOR_INDEX      7
+#endif
+
+#if (USBD_LPM_SUPPORT == 1) || (USBD_MS_OS_DESC_SUPPORT == 1)
+/** @brief USB Binary device Object Store (BOS) Descriptor type */
+typedef struct {
     USB_BOSDescType bos;                /*!< BOS base */
     USB_DevCapabilityDescType devCap;   /*!< Device capabilities */
-}__packed usbd_bosDesc __align(USBD_DATA_ALIGNMENT) =
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+    USB_MsOs20PlatformDescType msOs;    /*!< MS OS 2.0 platform capability */
+#endif
+}__packed USBD_BOSDescType;
+
+/** @brief USB Binary device Object Store (BOS) Descriptor */
+static const USBD_BOSDescType usbd_bosDesc __align(USBD_DATA_ALIGNMENT) =
 {
     .bos = {
         .bLength            = sizeof(USB_BOSDescType),
         .bDescriptorType    = USB_DESC_TYPE_BOS,
         .wTotalLength       = sizeof(usbd_bosDesc),
-        .bNumDeviceCaps     = 1,
+        .bNumDeviceCaps     = 1 + USBD_MS_OS_DESC_SUPPORT,
     },
     .devCap = {
         .bLength            = sizeof(USB_DevCapabilityDescType),
         .bDescriptorType    = USB_DESC_TYPE_DEVICE_CAPABILITY,
         .bDevCapabilityType = USB_DEVCAP_USB_2p0_EXT,
         .bmAttributes       = 0,
-    }
+    },
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+    .msOs = {
+        .bLength            = sizeof(USB_MsOs20PlatformDescType),
+        .bDescriptorType    = USB_DESC_TYPE_DEVICE_CAPABILITY,
+        .bDevCapabilityType = USB_DEVCAP_PLATFORM,
+        .bReserved          = 0,
+        .PlatformCapabilityUUID = { 0xDF, 0x60, 0xDD, 0xD8, 0x89, 0x45, 0xC7, 0x4C,
+                                    0x9C, 0xD2, 0x65, 0x9D, 0x9E, 0x64, 0x8A, 0x9F },
+        .dwWindowsVersion   = USBD_MS_OS_20_WINDOWS_VERSION,
+        .wMSOSDescriptorSetTotalLength = 0, /* Set when the BOS is requested */
+        .bMS_VendorCode     = USBD_MS_VENDOR_CODE,
+        .bAltEnumCode       = 0,
+    },
+#endif
 };
 #endif
 
@@ -158,19 +187,223 @@ static uint16_t USBD_ConfigDesc(USBD_HandleType *dev, uint8_t *data)
     return wTotalLength;
 }
 
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
 /**
- * @brief This function converts an ASCII string into a string descriptor.
- * @param str: the input ASCII string
- * @param data: the target container for the string descriptor
+ * @brief This function assembles the MS OS 2.0 descriptor set
+ *        using the feature descriptors of the interfaces.
+ *        The features of composite devices are grouped in function subsets.
+ * @param dev: USB Device handle reference
+ * @param data: the target container for the descriptor set
+ * @return The length of the descriptor set
+ */
+static uint16_t USBD_MsOsDescSet(USBD_HandleType *dev, uint8_t *data)
+{
+    USB_MsOs20SetHeaderDescType *desc = (USB_MsOs20SetHeaderDescType*)data;
+    uint16_t wTotalLength = sizeof(USB_MsOs20SetHeaderDescType);
+    uint8_t ifNum;
+    USBD_IfHandleType *itf = NULL;
+
+    if (dev->IfCount > 1)
+    {
+        USB_MsOs20ConfigSubsetDescType *cfg =
+                (USB_MsOs20ConfigSubsetDescType*)&data[wTotalLength];
+        uint16_t cfgStart = wTotalLength;
+
+        wTotalLength += sizeof(USB_MsOs20ConfigSubsetDescType);
+
+        for (ifNum = 0; ifNum < dev->IfCount; ifNum++)
+        {
+            USB_MsOs20FunctionSubsetDescType *func =
+                    (USB_MsOs20FunctionSubsetDescType*)&data[wTotalLength];
+            uint16_t len;
+
+            /* Associated interfaces return the entire function's features */
+            if (dev->IF[ifNum] == itf) { continue; }
+
+            itf = dev->IF[ifNum];
+            len = USBD_IfClass_GetMsOsDesc(itf, ifNum,
+                    &data[wTotalLength + sizeof(USB_MsOs20FunctionSubsetDescType)]);
+
+            /* Only the functions with features get a subset */
+            if (len > 0)
+            {
+                func->wLength           = sizeof(USB_MsOs20FunctionSubsetDescType);
+                func->wDescriptorType   = USB_MS_OS_20_SUBSET_HEADER_FUNCTION;
+                func->bFirstInterface   = ifNum;
+                func->bReserved         = 0;
+                func->wSubsetLength     = sizeof(USB_MsOs20FunctionSubsetDescType) + len;
+
+                wTotalLength += func->wSubsetLength;
+            }
+        }
+
+        if (wTotalLength > (cfgStart + sizeof(USB_MsOs20ConfigSubsetDescType)))
+        {
+            cfg->wLength                = sizeof(USB_MsOs20ConfigSubsetDescType);
+            cfg->wDescriptorType        = USB_MS_OS_20_SUBSET_HEADER_CONFIGURATION;
+            cfg->bConfigurationValue    = 0;
+            cfg->bReserved              = 0;
+            cfg->wTotalLength           = wTotalLength - cfgStart;
+        }
+        else
+        {
+            /* No features at all */
+            wTotalLength = cfgStart;
+        }
+    }
+    else if (dev->IfCount > 0)
+    {
+        /* The features of a single function apply to the device */
+        wTotalLength += USBD_IfClass_GetMsOsDesc(dev->IF[0], 0, &data[wTotalLength]);
+    }
+
+    desc->wLength           = sizeof(USB_MsOs20SetHeaderDescType);
+    desc->wDescriptorType   = USB_MS_OS_20_SET_HEADER_DESCRIPTOR;
+    desc->dwWindowsVersion  = USBD_MS_OS_20_WINDOWS_VERSION;
+    desc->wTotalLength      = wTotalLength;
+
+    return wTotalLength;
+}
+#endif /* (USBD_MS_OS_DESC_SUPPORT == 1) */
+
+#if (USBD_LPM_SUPPORT == 1) || (USBD_MS_OS_DESC_SUPPORT == 1)
+/**
+ * @brief This function provides the USB BOS descriptor.
+ * @param dev: USB Device handle reference
+ * @param data: the target container for the BOS descriptor
  * @return The length of the descriptor
  */
-static uint16_t USBD_GetStringDesc(const char *str, uint8_t *data)
+static uint16_t USBD_BOSDesc(USBD_HandleType *dev, uint8_t *data)
 {
-    data[0] = 2 + strlen(str) * 2;
-    data[1] = USB_DESC_TYPE_STRING;
-    Ascii2Unicode(str, &data[2]);
-    return data[0];
+    USBD_BOSDescType *desc = (USBD_BOSDescType*)data;
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+    /* The set is assembled in the same container to get its length */
+    uint16_t msOsLength = USBD_MsOsDescSet(dev, data);
+#endif
+
+    memcpy(data, &usbd_bosDesc, sizeof(usbd_bosDesc));
+
+#if (USBD_LPM_SUPPORT == 1)
+    /* Check if Link Power Management is used */
+    if (dev->Desc->Config.LPM != 0)
+    {
+        /* Modify bmAttributes:
+         * bit1: LPM protocol support
+         * bit2: BESL and alternate HIRD definitions supported */
+        desc->devCap.bmAttributes |= 6;
+    }
+#endif
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+    desc->msOs.wMSOSDescriptorSetTotalLength = msOsLength;
+#endif
+
+    return sizeof(usbd_bosDesc);
 }
+#endif
+
+#if (USBD_CONFIG_DESC_CACHE == 1)
+/**
+ * @brief This function provides the USB configuration descriptor of the current speed,
+ *        which is only assembled when the mounted interfaces changed since the last request.
+ * @param dev: USB Device handle reference
+ * @param len: the length of the configuration descriptor
+ * @return Reference of the cached configuration descriptor
+ */
+static uint8_t* USBD_CachedConfigDesc(USBD_HandleType *dev, uint16_t *len)
+{
+    uint8_t speed = (dev->Speed == USB_SPEED_HIGH) ? USBD_HS_SUPPORT : 0;
+
+    /* Interfaces are only mounted by increasing the count */
+    if (dev->ConfigDesc.IfCount != dev->IfCount)
+    {
+        USBD_ConfigDescInvalidate(dev);
+        dev->ConfigDesc.IfCount = dev->IfCount;
+    }
+
+    if (dev->ConfigDesc.Length[speed] == 0)
+    {
+        dev->ConfigDesc.Length[speed] = USBD_ConfigDesc(dev, dev->ConfigDesc.Data[speed]);
+    }
+
+    *len = dev->ConfigDesc.Length[speed];
+    return dev->ConfigDesc.Data[speed];
+}
+#endif /* (USBD_CONFIG_DESC_CACHE == 1) */
+
+/**
+ * @brief This function provides the USB configuration descriptor of the current speed:
+ *        the static descriptor if available, otherwise the assembled one.
+ * @param dev: USB Device handle reference
+ * @param len: the length of the configuration descriptor
+ * @return Reference of the configuration descriptor
+ */
+const uint8_t* USBD_ConfigDescRef(USBD_HandleType *dev, uint16_t *len)
+{
+    const uint8_t *data = NULL;
+
+#if (USBD_STATIC_DESCRIPTORS == 1)
+#if (USBD_HS_SUPPORT == 1)
+    if (dev->Speed == USB_SPEED_HIGH)
+    {   data = dev->Desc->Static.ConfigHS; }
+    else
+#endif
+    {   data = dev->Desc->Static.Config; }
+
+    if (data != NULL)
+    {
+        *len = ((const USB_ConfigDescType*)data)->wTotalLength;
+    }
+    else
+#endif /* (USBD_STATIC_DESCRIPTORS == 1) */
+    {
+#if (USBD_CONFIG_DESC_CACHE == 1)
+        data = USBD_CachedConfigDesc(dev, len);
+#else
+        *len = USBD_ConfigDesc(dev, dev->CtrlData);
+        data = dev->CtrlData;
+#endif
+    }
+    return data;
+}
+
+/**
+ * @brief This function provides the string descriptor of a string.
+ *        Pre-encoded string descriptors (see @ref USBD_STRING_DESC) are referenced directly,
+ *        ASCII strings are converted into the target container.
+ * @param str: the input ASCII string or string descriptor
+ * @param data: the target container for the string descriptor,
+ *              set to the string descriptor if it is pre-encoded
+ * @return The length of the descriptor
+ */
+static uint16_t USBD_GetStringDesc(const char *str, uint8_t **data)
+{
+    if (USBD_IS_STRING_DESC(str))
+    {
+        *data = (uint8_t*)str;
+    }
+    else
+    {
+        (*data)[0] = 2 + strlen(str) * 2;
+        (*data)[1] = USB_DESC_TYPE_STRING;
+        Ascii2Unicode(str, &(*data)[2]);
+    }
+    return (*data)[0];
+}
+
+#if (USBD_SERIAL_BCD_SIZE > 0)
+/**
+ * @brief This function converts the serial number into its string descriptor,
+ *        so it doesn't need to be converted at each request.
+ * @param dev: USB Device handle reference
+ */
+void USBD_SerialDescInit(USBD_HandleType *dev)
+{
+    dev->SerialDesc[0] = sizeof(dev->SerialDesc);
+    dev->SerialDesc[1] = USB_DESC_TYPE_STRING;
+    Uint2Unicode((const uint8_t*)dev->Desc->SerialNumber,
+            &dev->SerialDesc[2], sizeof(*dev->Desc->SerialNumber) * 2);
+}
+#endif /* (USBD_SERIAL_BCD_SIZE > 0) */
 
 /**
  * @brief This function collects and transfers the requested descriptor through EP0.
@@ -185,24 +418,45 @@ USBD_ReturnType USBD_GetDescriptor(USBD_HandleType *dev)
     uint8_t *data = dev->CtrlData;
 
     /* High byte identifies descriptor type */
-    switch (dev->Setup.Value >> 8)
+    switch (dev->Request.Value >> 8)
     {
         case USB_DESC_TYPE_DEVICE:
         {
-            len = USBD_DeviceDesc(dev, data);
+#if (USBD_STATIC_DESCRIPTORS == 1)
+            if (dev->Desc->Static.Device != NULL)
+            {
+                data = (uint8_t*)dev->Desc->Static.Device;
+                len  = sizeof(USB_DeviceDescType);
+            }
+            else
+#endif
+            {
+                len = USBD_DeviceDesc(dev, data);
+            }
             break;
         }
 
         case USB_DESC_TYPE_CONFIGURATION:
         {
-            len = USBD_ConfigDesc(dev, data);
+            data = (uint8_t*)USBD_ConfigDescRef(dev, &len);
             break;
         }
 
         case USB_DESC_TYPE_STRING:
         {
+#if (USBD_STATIC_DESCRIPTORS == 1)
+            uint8_t strIndex = dev->Request.Value & 0xFF;
+
+            if ((strIndex < dev->Desc->Static.StringCount) &&
+                (dev->Desc->Static.Strings[strIndex] != NULL))
+            {
+                data = (uint8_t*)dev->Desc->Static.Strings[strIndex];
+                len  = data[0];
+            }
+            else
+#endif
             /* Low byte is the descriptor iIndex */
-            switch (dev->Setup.Value & 0xFF)
+            switch (dev->Request.Value & 0xFF)
             {
                 /* Zero index returns the list of supported Unicode
                  * language identifiers */
@@ -214,23 +468,21 @@ USBD_ReturnType USBD_GetDescriptor(USBD_HandleType *dev)
                 /* Otherwise Setup.Index == LangID of requested string */
 
                 case USBD_ISTR_VENDOR:
-                    len = USBD_GetStringDesc(dev->Desc->Vendor.Name, data);
+                    len = USBD_GetStringDesc(dev->Desc->Vendor.Name, &data);
                     break;
 
                 case USBD_ISTR_PRODUCT:
-                    len = USBD_GetStringDesc(dev->Desc->Product.Name, data);
+                    len = USBD_GetStringDesc(dev->Desc->Product.Name, &data);
                     break;
 
                 case USBD_ISTR_CONFIG:
-                    len = USBD_GetStringDesc(dev->Desc->Config.Name, data);
+                    len = USBD_GetStringDesc(dev->Desc->Config.Name, &data);
                     break;
 
 #if (USBD_SERIAL_BCD_SIZE > 0)
                 case USBD_ISTR_SERIAL:
-                    data[0] = len = sizeof(*dev->Desc->SerialNumber) * 4 + 2;
-                    data[1] = USB_DESC_TYPE_STRING;
-                    Uint2Unicode((const uint8_t*)dev->Desc->SerialNumber,
-                            &data[2], sizeof(*dev->Desc->SerialNumber) * 2);
+                    data = dev->SerialDesc;
+                    len  = sizeof(dev->SerialDesc);
                     break;
 #endif
 
@@ -240,7 +492,7 @@ USBD_ReturnType USBD_GetDescriptor(USBD_HandleType *dev)
 
                     if (str != NULL)
                     {
-                        len = USBD_GetStringDesc(str, data);
+                        len = USBD_GetStringDesc(str, &data);
                     }
                     break;
                 }
@@ -259,40 +511,24 @@ USBD_ReturnType USBD_GetDescriptor(USBD_HandleType *dev)
             break;
         }
 
-        case USB_DESC_TYPE_OTHER_SPEED_CONFIGURATION:
+        case USB_DESC_TYPE_OTHER_SPEED_CONFIG:
         {
             if (dev->Speed == USB_SPEED_HIGH)
             {
                 /* Workaround: temporarily set speed to full,
                  * so the configuration is assembled for full speed case */
                 dev->Speed = USB_SPEED_FULL;
-                len = USBD_ConfigDesc(dev, data);
+                data = (uint8_t*)USBD_ConfigDescRef(dev, &len);
                 dev->Speed = USB_SPEED_HIGH;
             }
             break;
         }
 #endif
 
-#if (USBD_LPM_SUPPORT == 1)
+#if (USBD_LPM_SUPPORT == 1) || (USBD_MS_OS_DESC_SUPPORT == 1)
         case USB_DESC_TYPE_BOS:
         {
-            len = sizeof(usbd_bosDesc);
-
-            /* Check if Link Power Management is used */
-            if (dev->Desc->Config.LPM != 0)
-            {
-                memcpy(data, &usbd_bosDesc, sizeof(usbd_bosDesc));
-
-                /* Modify bmAttributes:
-                 * bit1: LPM protocol support
-                 * bit2: BESL and alternate HIRD definitions supported */
-                data[8] |= 6;
-            }
-            else
-            {
-                /* Return the default BOS */
-                data = (uint8_t*)&usbd_bosDesc;
-            }
+            len = USBD_BOSDesc(dev, data);
             break;
         }
 #endif
@@ -310,6 +546,30 @@ USBD_ReturnType USBD_GetDescriptor(USBD_HandleType *dev)
     return retval;
 }
 
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+/**
+ * @brief This function handles the vendor request of the MS OS 2.0 descriptor set,
+ *        which is announced in the platform capability of the BOS descriptor.
+ * @param dev: USB Device handle reference
+ * @return OK if the request is processed, INVALID if not supported
+ */
+USBD_ReturnType USBD_GetMsOsDescriptor(USBD_HandleType *dev)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+
+    if ((dev->Request.Request == USBD_MS_VENDOR_CODE) &&
+        (dev->Request.Index == USBD_MS_OS_20_DESCRIPTOR_INDEX) &&
+        (dev->Request.RequestType.Direction == USB_DIRECTION_IN))
+    {
+        uint16_t len = USBD_MsOsDescSet(dev, dev->CtrlData);
+
+        retval = USBD_CtrlSendData(dev, dev->CtrlData, len);
+    }
+
+    return retval;
+}
+#endif /* (USBD_MS_OS_DESC_SUPPORT == 1) */
+
 /** @} */
 
 /** @addtogroup USBD_Internal_Functions
@@ -332,7 +592,24 @@ uint16_t USBD_EpDesc(USBD_HandleType *dev, uint8_t epAddr, uint8_t *data)
     desc->bEndpointAddress  = epAddr;
     desc->bmAttributes      = ep->Type;
     desc->wMaxPacketSize    = ep->MaxPacketSize;
-    desc->bInterval         = 1;
+    desc->bInterval         = ep->Interval;
+
+#if (USBD_HS_SUPPORT == 1)
+    if (dev->Speed == USB_SPEED_HIGH)
+    {
+        desc->bInterval     = ep->IntervalHS;
+
+        /* High bandwidth periodic endpoints transfer up to 3 packets per microframe */
+        if ((ep->Type == USB_EP_TYPE_INTERRUPT) ||
+            (ep->Type == USB_EP_TYPE_ISOCHRONOUS))
+        {
+            desc->wMaxPacketSize |= (uint16_t)ep->Transactions << 11;
+        }
+    }
+#endif
+
+    if (desc->bInterval == 0)
+    {   desc->bInterval = 1; }
 
     return sizeof(USB_EndpointDescType);
 }
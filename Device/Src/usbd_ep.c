@@ -23,18 +23,409 @@
   */
 #include <usbd_private.h>
 
+#if (USBD_ARENA_BLOCK_COUNT > 0) && (USBD_DCACHE_LINE_SIZE > 0)
+/**
+ * @brief Writes the cached data of an arena buffer to the memory
+ *        before it is transmitted.
+ * @param data: the transfer data
+ * @param len: the transfer length
+ */
+static void USBD_EpCacheClean(const uint8_t *data, uint16_t len)
+{
+    if ((len > 0) && (USBD_ArenaContains(data) != 0))
+    {
+        uint32_t start = (uint32_t)data & ~(USBD_DCACHE_LINE_SIZE - 1);
+
+        USBD_DCACHE_CLEAN((void*)start, (uint32_t)data + len - start);
+    }
+}
+
+/**
+ * @brief Discards the cached data of an arena buffer
+ *        before and after it is received to.
+ * @param data: the transfer data
+ * @param len: the transfer length
+ */
+static void USBD_EpCacheInvalidate(const uint8_t *data, uint16_t len)
+{
+    if ((len > 0) && (USBD_ArenaContains(data) != 0))
+    {
+        uint32_t start = (uint32_t)data & ~(USBD_DCACHE_LINE_SIZE - 1);
+
+        USBD_DCACHE_INVALIDATE((void*)start, (uint32_t)data + len - start);
+    }
+}
+#else
+#define USBD_EpCacheClean(DATA, LEN)        ((void)0)
+#define USBD_EpCacheInvalidate(DATA, LEN)   ((void)0)
+#endif /* (USBD_ARENA_BLOCK_COUNT > 0) && (USBD_DCACHE_LINE_SIZE > 0) */
+
+#if (USBD_STATS_SUPPORT == 1)
+/**
+ * @brief Counts the completed transfer of the non-control endpoint.
+ * @param ep: USB endpoint handle reference
+ */
+static void USBD_EpStatsComplete(USBD_EpHandleType *ep)
+{
+    ep->Stats.Transfers++;
+    ep->Stats.Bytes += ep->Transfer.Length;
+
+    /* Only a short packet (or ZLP) ends a transfer before its whole length */
+    if ((ep->Transfer.Length == 0) ||
+        ((ep->Transfer.Length % ep->MaxPacketSize) != 0))
+    {   ep->Stats.ShortPackets++; }
+}
+#else
+#define USBD_EpStatsComplete(EP)            ((void)0)
+#endif /* (USBD_STATS_SUPPORT == 1) */
+
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+/**
+ * @brief Starts the transfer of the oldest queued request,
+ *        if the endpoint is idle.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ */
+static void USBD_EpQueueStart(USBD_HandleType *dev, uint8_t epAddr)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr);
+    USBD_EpQueueType *queue = ep->Queue;
+
+    if ((queue->Active == 0) && (queue->Count > 0) &&
+        (ep->State == USB_EP_STATE_IDLE))
+    {
+        USBD_EpRequestType *req = &queue->Ring[queue->Head];
+
+        queue->Active = 1;
+        ep->State = USB_EP_STATE_DATA;
+
+        if (epAddr > 0x7F)
+        {
+            USBD_EpCacheClean(req->Data, req->Length);
+            USBD_PD_EpSend(dev, epAddr, req->Data, req->Length);
+        }
+        else
+        {
+            USBD_EpCacheInvalidate(req->Data, req->Length);
+            USBD_PD_EpReceive(dev, epAddr, req->Data, req->Length);
+        }
+    }
+}
+
+/**
+ * @brief Releases the completed request of the endpoint queue, starts the next one,
+ *        and notifies the requester of the completion.
+ *        The next request is started before the notification when the completed one
+ *        has its own callback, otherwise after the interface's endpoint callback,
+ *        as that one accesses the endpoint's transfer context.
+ * @param dev: USB Device handle reference
+ * @param ep: USB endpoint handle reference
+ */
+static void USBD_EpQueueComplete(USBD_HandleType *dev, USBD_EpHandleType *ep)
+{
+    USBD_EpQueueType *queue = ep->Queue;
+    USBD_IfHandleType *itf = dev->IF[ep->IfNum];
+    uint8_t epAddr = USBD_EpRef2Addr(dev, ep);
+    USBD_EpRequestType req = { .Complete = NULL };
+
+    if (queue->Active != 0)
+    {
+        req = queue->Ring[queue->Head];
+        req.Length = ep->Transfer.Length;
+
+        queue->Head = (queue->Head + 1) % queue->Size;
+        queue->Count--;
+        queue->Active = 0;
+    }
+
+    if (req.Complete != NULL)
+    {
+        USBD_EpQueueStart(dev, epAddr);
+
+        req.Complete(itf, &req);
+    }
+    else
+    {
+        if (epAddr > 0x7F)
+        {
+            USBD_IfClass_InData(itf, ep);
+        }
+        else
+        {
+            USBD_IfClass_OutData(itf, ep);
+        }
+
+        USBD_EpQueueStart(dev, epAddr);
+    }
+}
+
+/**
+ * @brief Continues the endpoint queue when the endpoint's halt is cleared.
+ *        The request interrupted by the halt is ended with 0 length,
+ *        otherwise the interface is notified of the ready endpoint the same way,
+ *        then the requests submitted in the meantime are started.
+ * @param dev: USB Device handle reference
+ * @param ep: USB endpoint handle reference
+ */
+void USBD_EpQueueResume(USBD_HandleType *dev, USBD_EpHandleType *ep)
+{
+    if (ep->Queue->Active != 0)
+    {
+        /* Drop the transfer which was armed before the halt */
+        USBD_PD_EpFlush(dev, USBD_EpRef2Addr(dev, ep));
+    }
+    ep->Transfer.Length = 0;
+
+    USBD_EpQueueComplete(dev, ep);
+}
+#endif /* (USBD_EP_QUEUE_SUPPORT == 1) */
+
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+/**
+ * @brief Skips the transferred segments of the vectored transfer,
+ *        and marks the transfer finished when the last one is transferred.
+ * @param vec: the vectored transfer context
+ */
+static void USBD_EpVectorAdvance(USBD_EpVectorType *vec)
+{
+    while ((vec->Count > 1) && (vec->Offset == vec->Segment->Length))
+    {
+        vec->Segment++;
+        vec->Count--;
+        vec->Offset = 0;
+    }
+    if ((vec->Count == 1) && (vec->Offset == vec->Segment->Length))
+    {
+        vec->Count = 0;
+    }
+}
+
+/**
+ * @brief Sends the next part of the vectored transfer. Whole packets within a segment
+ *        are sent directly from the segment data, the packets spanning segment
+ *        boundaries are assembled in the packet buffer of the transfer.
+ *        Therefore only the last packet of the transfer can be a short packet.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ */
+static void USBD_EpVectorNext(USBD_HandleType *dev, uint8_t epAddr)
+{
+    USBD_EpVectorType *vec = &dev->EP.Vector[epAddr & 0xF];
+    uint16_t mps = dev->EP.IN[epAddr & 0xF].MaxPacketSize;
+    uint16_t len = vec->Segment->Length - vec->Offset;
+
+    if ((len >= mps) || (vec->Count == 1))
+    {
+        const uint8_t *data = &vec->Segment->Data[vec->Offset];
+
+        /* Only the last segment may end with a short packet */
+        if (vec->Count > 1)
+        {   len -= len % mps; }
+
+        vec->Offset += len;
+        USBD_EpVectorAdvance(vec);
+
+        USBD_EpCacheClean(data, len);
+        USBD_PD_EpSend(dev, epAddr, data, len);
+    }
+    else
+    {
+        /* Assemble a packet from the following segments */
+        for (len = 0; (len < mps) && (vec->Count > 0); )
+        {
+            uint16_t chunk = vec->Segment->Length - vec->Offset;
+
+            if (chunk > (mps - len))
+            {   chunk = mps - len; }
+
+            memcpy(&vec->Packet[len], &vec->Segment->Data[vec->Offset], chunk);
+            len += chunk;
+            vec->Offset += chunk;
+            USBD_EpVectorAdvance(vec);
+        }
+
+        USBD_PD_EpSend(dev, epAddr, vec->Packet, len);
+    }
+}
+
+/**
+ * @brief Continues the ongoing vectored transfer of the IN endpoint,
+ *        or sets up the endpoint's transfer context of the completed one.
+ * @param dev: USB Device handle reference
+ * @param ep: USB IN endpoint handle reference
+ * @return Non-zero if the transfer is continued
+ */
+static int USBD_EpVectorContinue(USBD_HandleType *dev, USBD_EpHandleType *ep)
+{
+    uint8_t epAddr = USBD_EpRef2Addr(dev, ep);
+    USBD_EpVectorType *vec = &dev->EP.Vector[epAddr & 0xF];
+    int retval = 0;
+
+    if (vec->Active == 0)
+    {
+        /* Not a vectored transfer */
+    }
+    else if (vec->Count > 0)
+    {
+        USBD_EpVectorNext(dev, epAddr);
+        retval = 1;
+    }
+    else
+    {
+        /* The transfer appears as one from the first segment's data */
+        vec->Active = 0;
+        ep->Transfer.Data   = (uint8_t*)vec->Start + vec->Length;
+        ep->Transfer.Length = vec->Length;
+    }
+    return retval;
+}
+#endif /* (USBD_EP_VECTOR_SUPPORT == 1) */
+
 /** @ingroup USBD
  * @defgroup USBD_Internal_Functions USB Device Internal Functions
  * @brief This group is used by the Device and the Classes.
  * @{ */
 
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+/**
+ * @brief Links a request queue to the endpoint, which holds the transfers
+ *        submitted while the endpoint is busy instead of rejecting them.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ * @param queue: reference of the request queue, or NULL to unlink the current one
+ * @param ring: the request descriptor ring of the queue
+ * @param size: the number of descriptors in the ring
+ */
+void USBD_EpQueueInit(USBD_HandleType *dev, uint8_t epAddr,
+        USBD_EpQueueType *queue, USBD_EpRequestType *ring, uint8_t size)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr);
+
+    if (queue != NULL)
+    {
+        queue->Ring = ring;
+        queue->Size = size;
+        queue->Head = 0;
+    }
+    ep->Queue = queue;
+
+    USBD_EpQueueReset(ep);
+}
+
+/**
+ * @brief Appends a transfer request to the queue of the endpoint,
+ *        and starts it if the endpoint is idle.
+ * @note  This function shall not preempt the USB device interrupt (or vice versa).
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ * @param req: the transfer request, which is copied to the queue
+ * @return OK if the request is queued, BUSY if the queue is full,
+ *         INVALID if the endpoint has no queue
+ */
+USBD_ReturnType USBD_EpSubmit(USBD_HandleType *dev, uint8_t epAddr,
+        const USBD_EpRequestType *req)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr);
+    USBD_EpQueueType *queue = ep->Queue;
+
+    if (queue == NULL)
+    {
+        /* Endpoint without queue */
+    }
+    else if (queue->Count >= queue->Size)
+    {
+        USBD_EP_STATS_INC(ep, Busy);
+        retval = USBD_E_BUSY;
+    }
+    else
+    {
+        queue->Ring[(queue->Head + queue->Count) % queue->Size] = *req;
+        queue->Count++;
+        USBD_TraceEp(dev, USBD_TRACE_SUBMIT, epAddr, req->Length);
+
+        USBD_EpQueueStart(dev, epAddr);
+
+        retval = USBD_E_OK;
+    }
+    return retval;
+}
+#endif /* (USBD_EP_QUEUE_SUPPORT == 1) */
+
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+/**
+ * @brief This function sends the data of multiple segments
+ *        as a single transfer through the selected IN endpoint.
+ * @note  The segments shall remain valid until the transfer is completed.
+ *        When completed, the endpoint's transfer context presents the first segment's data
+ *        with the total length. Similarly to @ref USBD_EpSend, no ZLP is appended.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ * @param segments: the data segments of the transfer
+ * @param count: the number of segments
+ * @return BUSY if the endpoint isn't idle, INVALID if the transfer can't be vectored,
+ *         OK if successful
+ */
+USBD_ReturnType USBD_EpSendVector(USBD_HandleType *dev, uint8_t epAddr,
+        const USBD_EpSegmentType *segments, uint8_t count)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+    USBD_EpHandleType *ep = &dev->EP.IN[epAddr & 0xF];
+    USBD_EpVectorType *vec = &dev->EP.Vector[epAddr & 0xF];
+    uint32_t len = 0;
+    uint8_t i;
+
+    for (i = 0; i < count; i++)
+    {
+        len += segments[i].Length;
+    }
+
+    if ((count == 0) || (len > 0xFFFF) ||
+        (ep->MaxPacketSize > sizeof(vec->Packet)))
+    {
+        /* Invalid transfer */
+    }
+    else if (ep->State != USB_EP_STATE_IDLE)
+    {
+        USBD_EP_STATS_INC(ep, Busy);
+        retval = USBD_E_BUSY;
+    }
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+    else if ((ep->Queue != NULL) && (ep->Queue->Count > 0))
+    {
+        USBD_EP_STATS_INC(ep, Busy);
+        retval = USBD_E_BUSY;
+    }
+#endif
+    else
+    {
+        vec->Segment = segments;
+        vec->Start   = segments[0].Data;
+        vec->Offset  = 0;
+        vec->Length  = len;
+        vec->Count   = count;
+        vec->Active  = 1;
+
+        ep->State = USB_EP_STATE_DATA;
+        USBD_TraceEp(dev, USBD_TRACE_SUBMIT, epAddr, len);
+        USBD_EpVectorNext(dev, epAddr);
+
+        retval = USBD_E_OK;
+    }
+
+    return retval;
+}
+#endif /* (USBD_EP_VECTOR_SUPPORT == 1) */
+
 /**
  * @brief This function sends data through the selected IN endpoint.
+ * @note  When the endpoint has a request queue, the transfer is queued
+ *        if the endpoint isn't idle.
  * @param dev: USB Device handle reference
  * @param epAddr: endpoint address
  * @param data: pointer to the data to send
  * @param len: length of the data
- * @return BUSY if the endpoint isn't idle, OK if successful
+ * @return BUSY if the endpoint isn't idle (or its queue is full), OK if successful
  */
 USBD_ReturnType USBD_EpSend(USBD_HandleType *dev, uint8_t epAddr,
         const uint8_t *data, uint16_t len)
@@ -42,26 +433,46 @@ USBD_ReturnType USBD_EpSend(USBD_HandleType *dev, uint8_t epAddr,
     USBD_ReturnType retval = USBD_E_BUSY;
     USBD_EpHandleType *ep = &dev->EP.IN[epAddr & 0xF];
 
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+    if (ep->Queue != NULL)
+    {
+        USBD_EpRequestType req = {
+            .Data = (uint8_t*)data,
+            .Length = len,
+        };
+
+        retval = USBD_EpSubmit(dev, epAddr, &req);
+    }
+    else
+#endif
     if ((ep->State == USB_EP_STATE_IDLE) ||
         (ep->Type  == USB_EP_TYPE_ISOCHRONOUS))
     {
         /* Set EP transfer data */
         ep->State = USB_EP_STATE_DATA;
+        USBD_TraceEp(dev, USBD_TRACE_SUBMIT, epAddr, len);
+        USBD_EpCacheClean(data, len);
         USBD_PD_EpSend(dev, epAddr, data, len);
 
         retval = USBD_E_OK;
     }
+    else
+    {
+        USBD_EP_STATS_INC(ep, Busy);
+    }
 
     return retval;
 }
 
 /**
  * @brief This function prepares data reception through the selected OUT endpoint.
+ * @note  When the endpoint has a request queue, the reception is queued
+ *        if the endpoint isn't idle.
  * @param dev: USB Device handle reference
  * @param epAddr: endpoint address
  * @param data: pointer to the target buffer to receive to
  * @param len: maximum length of the data
- * @return BUSY if the endpoint isn't idle, OK if successful
+ * @return BUSY if the endpoint isn't idle (or its queue is full), OK if successful
  */
 USBD_ReturnType USBD_EpReceive(USBD_HandleType *dev, uint8_t epAddr,
         uint8_t *data, uint16_t len)
@@ -69,15 +480,33 @@ USBD_ReturnType USBD_EpReceive(USBD_HandleType *dev, uint8_t epAddr,
     USBD_ReturnType retval = USBD_E_BUSY;
     USBD_EpHandleType *ep = &dev->EP.OUT[epAddr];
 
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+    if (ep->Queue != NULL)
+    {
+        USBD_EpRequestType req = {
+            .Data = data,
+            .Length = len,
+        };
+
+        retval = USBD_EpSubmit(dev, epAddr, &req);
+    }
+    else
+#endif
     if ((ep->State == USB_EP_STATE_IDLE) ||
         (ep->Type  == USB_EP_TYPE_ISOCHRONOUS))
     {
         /* Set EP transfer data */
         ep->State = USB_EP_STATE_DATA;
+        USBD_TraceEp(dev, USBD_TRACE_SUBMIT, epAddr, len);
+        USBD_EpCacheInvalidate(data, len);
         USBD_PD_EpReceive(dev, epAddr, data, len);
 
         retval = USBD_E_OK;
     }
+    else
+    {
+        USBD_EP_STATS_INC(ep, Busy);
+    }
 
     return retval;
 }
@@ -93,17 +522,43 @@ USBD_ReturnType USBD_EpReceive(USBD_HandleType *dev, uint8_t epAddr,
  * @param dev: USB Device handle reference
  * @param ep: USB IN endpoint handle reference
  */
+#if (USBD_DEFERRED_PROCESSING == 1)
+void USBD_EpInHandler(USBD_HandleType *dev, USBD_EpHandleType *ep)
+#else
 void USBD_EpInCallback(USBD_HandleType *dev, USBD_EpHandleType *ep)
+#endif
 {
+    USBD_PROFILE_START();
+
     if (ep == &dev->EP.IN[0])
     {
+        USBD_TraceEp(dev, USBD_TRACE_COMPLETE, 0x80, ep->Transfer.Length);
         USBD_CtrlInCallback(dev);
     }
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+    else if (USBD_EpVectorContinue(dev, ep) != 0)
+    {
+        /* Vectored transfer is ongoing */
+    }
+#endif
     else
     {
         ep->State = USB_EP_STATE_IDLE;
-        USBD_IfClass_InData(dev->IF[ep->IfNum], ep);
+        USBD_EpStatsComplete(ep);
+        USBD_TraceEp(dev, USBD_TRACE_COMPLETE, USBD_EpRef2Addr(dev, ep), ep->Transfer.Length);
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+        if (ep->Queue != NULL)
+        {
+            USBD_EpQueueComplete(dev, ep);
+        }
+        else
+#endif
+        {
+            USBD_IfClass_InData(dev->IF[ep->IfNum], ep);
+        }
     }
+
+    USBD_PROFILE_END(dev, USBD_PROFILE_EP_IN);
 }
 
 /**
@@ -112,17 +567,41 @@ void USBD_EpInCallback(USBD_HandleType *dev, USBD_EpHandleType *ep)
  * @param dev: USB Device handle reference
  * @param ep: USB OUT endpoint handle reference
  */
+#if (USBD_DEFERRED_PROCESSING == 1)
+void USBD_EpOutHandler(USBD_HandleType *dev, USBD_EpHandleType *ep)
+#else
 void USBD_EpOutCallback(USBD_HandleType *dev, USBD_EpHandleType *ep)
+#endif
 {
+    USBD_PROFILE_START();
+
     if (ep == &dev->EP.OUT[0])
     {
+        USBD_TraceEp(dev, USBD_TRACE_COMPLETE, 0x00, ep->Transfer.Length);
         USBD_CtrlOutCallback(dev);
     }
     else
     {
         ep->State = USB_EP_STATE_IDLE;
-        USBD_IfClass_OutData(dev->IF[ep->IfNum], ep);
+
+        /* Drop any cache lines fetched during the reception */
+        USBD_EpCacheInvalidate(ep->Transfer.Data - ep->Transfer.Length,
+                ep->Transfer.Length);
+        USBD_EpStatsComplete(ep);
+        USBD_TraceEp(dev, USBD_TRACE_COMPLETE, USBD_EpRef2Addr(dev, ep), ep->Transfer.Length);
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+        if (ep->Queue != NULL)
+        {
+            USBD_EpQueueComplete(dev, ep);
+        }
+        else
+#endif
+        {
+            USBD_IfClass_OutData(dev->IF[ep->IfNum], ep);
+        }
     }
+
+    USBD_PROFILE_END(dev, USBD_PROFILE_EP_OUT);
 }
 
 /** @} */
@@ -138,22 +617,22 @@ void USBD_EpOutCallback(USBD_HandleType *dev, USBD_EpHandleType *ep)
 USBD_ReturnType USBD_EpRequest(USBD_HandleType *dev)
 {
     USBD_ReturnType retval = USBD_E_INVALID;
-    uint8_t epAddr = (uint8_t)dev->Setup.Index;
+    uint8_t epAddr = (uint8_t)dev->Request.Index;
 
     if ((dev->ConfigSelector == 0) && ((epAddr & 0xF) != 0))
     {
         /* Only EP0 can be affected while the device is not configured */
     }
-    else if (dev->Setup.RequestType.Type == USB_REQ_TYPE_STANDARD)
+    else if (dev->Request.RequestType.Type == USB_REQ_TYPE_STANDARD)
     {
         USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr);
 
         /* EP halt is the only standard feature */
-        switch (dev->Setup.Request)
+        switch (dev->Request.Request)
         {
             case USB_REQ_SET_FEATURE:
             {
-                if (dev->Setup.Value == USB_FEATURE_EP_HALT)
+                if (dev->Request.Value == USB_FEATURE_EP_HALT)
                 {
                     retval = USBD_E_OK;
 
@@ -161,6 +640,8 @@ USBD_ReturnType USBD_EpRequest(USBD_HandleType *dev)
                     {
                         USBD_PD_EpSetStall(dev, epAddr);
                         ep->State = USB_EP_STATE_STALL;
+                        USBD_EP_STATS_INC(ep, Stalls);
+                        USBD_TraceEp(dev, USBD_TRACE_STALL, epAddr, 0);
                     }
                 }
                 break;
@@ -168,7 +649,7 @@ USBD_ReturnType USBD_EpRequest(USBD_HandleType *dev)
 
             case USB_REQ_CLEAR_FEATURE:
             {
-                if (dev->Setup.Value == USB_FEATURE_EP_HALT)
+                if (dev->Request.Value == USB_FEATURE_EP_HALT)
                 {
                     retval = USBD_E_OK;
 
@@ -178,6 +659,13 @@ USBD_ReturnType USBD_EpRequest(USBD_HandleType *dev)
                         ep->State = USB_EP_STATE_IDLE;
 
                         ep->Transfer.Length = 0;
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+                        if (((epAddr & 0xF) > 0) && (ep->Queue != NULL))
+                        {
+                            USBD_EpQueueResume(dev, ep);
+                        }
+                        else
+#endif
                         /* Workaround: notify interface of ready endpoint
                          * by completion callback with 0 length */
                         if ((epAddr & 0x8F) > 0x80)
@@ -51,6 +51,22 @@ void USBD_IfConfig(USBD_HandleType *dev, uint8_t cfgNum)
         /* Update configuration index */
         dev->ConfigSelector = cfgNum;
 
+#ifdef USBD_PD_EpPlan
+        /* Lay out the peripheral's endpoint buffers for the new configuration,
+         * before the interfaces open their endpoints */
+        if (dev->ConfigSelector != 0)
+        {
+            uint16_t len;
+            const uint8_t *desc = USBD_ConfigDescRef(dev, &len);
+
+            USBD_PD_EpPlan(dev, desc, len);
+        }
+        else
+        {
+            USBD_PD_EpPlan(dev, NULL, 0);
+        }
+#endif
+
         /* Set the new selected valid config */
         if (dev->ConfigSelector != 0)
         {
@@ -62,6 +78,31 @@ void USBD_IfConfig(USBD_HandleType *dev, uint8_t cfgNum)
     }
 }
 
+#if (USBD_SOF_SUPPORT == 1)
+/**
+ * @brief This function notifies the interfaces of the active configuration
+ *        of the start of (micro)frame.
+ * @note  Classes which occupy multiple consecutive device interface slots
+ *        are notified only once per (micro)frame.
+ * @param dev: USB Device handle reference
+ */
+void USBD_IfSof(USBD_HandleType *dev)
+{
+    uint8_t ifNum;
+
+    if (dev->ConfigSelector != 0)
+    {
+        for (ifNum = 0; ifNum < dev->IfCount; ifNum++)
+        {
+            if ((ifNum == 0) || (dev->IF[ifNum] != dev->IF[ifNum - 1]))
+            {
+                USBD_IfClass_Sof(dev->IF[ifNum]);
+            }
+        }
+    }
+}
+#endif /* (USBD_SOF_SUPPORT == 1) */
+
 /** @} */
 
 /** @addtogroup USBD_Private_Functions_Desc
@@ -75,8 +116,8 @@ void USBD_IfConfig(USBD_HandleType *dev, uint8_t cfgNum)
  */
 const char* USBD_IfString(USBD_HandleType *dev)
 {
-    uint8_t ifNum  = ((uint8_t)dev->Setup.Value & 0xF) - USBD_ISTR_INTERFACES;
-    uint8_t intNum = ((uint8_t)dev->Setup.Value >> 4);
+    uint8_t ifNum  = ((uint8_t)dev->Request.Value & 0xF) - USBD_ISTR_INTERFACES;
+    uint8_t intNum = ((uint8_t)dev->Request.Value >> 4);
     USBD_IfHandleType *itf = dev->IF[ifNum];
     const char* str = NULL;
 
@@ -101,16 +142,16 @@ const char* USBD_IfString(USBD_HandleType *dev)
 USBD_ReturnType USBD_IfRequest(USBD_HandleType *dev)
 {
     USBD_ReturnType retval = USBD_E_INVALID;
-    uint8_t ifNum = (uint8_t)dev->Setup.Index;
+    uint8_t ifNum = (uint8_t)dev->Request.Index;
     USBD_IfHandleType *itf = dev->IF[ifNum];
 
     if ((dev->ConfigSelector == 0) || (ifNum >= dev->IfCount))
     {
         /* Configured and valid indexed interfaces only */
     }
-    else if (dev->Setup.RequestType.Type == USB_REQ_TYPE_STANDARD)
+    else if (dev->Request.RequestType.Type == USB_REQ_TYPE_STANDARD)
     {
-        switch (dev->Setup.Request)
+        switch (dev->Request.Request)
         {
             /* Current alternate setting of the IF */
             case USB_REQ_GET_INTERFACE:
@@ -123,7 +164,7 @@ USBD_ReturnType USBD_IfRequest(USBD_HandleType *dev)
             /* Set alternate setting of the IF */
             case USB_REQ_SET_INTERFACE:
             {
-                uint8_t altSel = (uint8_t)dev->Setup.Value;
+                uint8_t altSel = (uint8_t)dev->Request.Value;
 
                 /* Check validity */
                 if (itf->AltCount > altSel)
@@ -149,7 +190,7 @@ USBD_ReturnType USBD_IfRequest(USBD_HandleType *dev)
                 /* Try to find desc in default descriptor */
                 for (i = 0; i < len; i += data[i])
                 {
-                    if (data[i + 1] == (dev->Setup.Value >> 8))
+                    if (data[i + 1] == (dev->Request.Value >> 8))
                     {
                         retval = USBD_CtrlSendData(dev, &data[i], data[i]);
                         break;
@@ -0,0 +1,153 @@
+/**
+  ******************************************************************************
+  * @file    usbd_stats.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Transfer statistics and callback profiling
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_private.h>
+
+#if (USBD_STATS_SUPPORT == 1)
+
+/** @ingroup USBD
+ * @defgroup USBD_Private_Functions_Stats USB Device Statistics
+ * @brief These functions record the statistics of the device handling.
+ * @{ */
+
+/**
+ * @brief Records the duration of a profiled callback.
+ * @param dev: USB Device handle reference
+ * @param id: the profiled callback
+ * @param start: the cycle counter value at the start of the callback
+ */
+void USBD_StatsProfile(USBD_HandleType *dev, USBD_ProfileIdType id, uint32_t start)
+{
+    uint32_t cycles = (uint32_t)USBD_STATS_CYCLES() - start;
+    USBD_ProfileType *profile = &dev->Profile[id];
+    uint32_t limit = USBD_STATS_HISTOGRAM_BASE;
+    uint8_t bin = 0;
+
+    while ((bin < (USBD_STATS_HISTOGRAM_SIZE - 1)) && (cycles >= limit))
+    {
+        bin++;
+        limit <<= 1;
+    }
+    profile->Histogram[bin]++;
+
+    if ((profile->Count == 0) || (cycles < profile->Min))
+    {   profile->Min = cycles; }
+    if (cycles > profile->Max)
+    {   profile->Max = cycles; }
+    profile->Count++;
+}
+
+#if (USBD_STATS_VENDOR_CODE != 0)
+/**
+ * @brief This function handles the statistics vendor request of the device,
+ *        the selected statistics are sent in the device's byte order.
+ * @param dev: USB Device handle reference
+ * @return OK if the request is processed, INVALID if not supported
+ */
+USBD_ReturnType USBD_StatsRequest(USBD_HandleType *dev)
+{
+    USBD_ReturnType retval = USBD_E_INVALID;
+    uint8_t index = (uint8_t)dev->Request.Index;
+
+    switch (dev->Request.Value)
+    {
+        case USBD_STATS_REQ_ENDPOINT:
+            if ((dev->Request.RequestType.Direction == USB_DIRECTION_IN) &&
+                ((index & 0x70) == 0) && ((index & 0xF) < USBD_MAX_EP_COUNT))
+            {
+                memcpy(dev->CtrlData, &USBD_EpAddr2Ref(dev, index)->Stats,
+                        sizeof(USBD_EpStatsType));
+                retval = USBD_CtrlSendData(dev, dev->CtrlData, sizeof(USBD_EpStatsType));
+            }
+            break;
+
+        case USBD_STATS_REQ_PROFILE:
+            if ((dev->Request.RequestType.Direction == USB_DIRECTION_IN) &&
+                (index < USBD_PROFILE_COUNT))
+            {
+                memcpy(dev->CtrlData, &dev->Profile[index], sizeof(USBD_ProfileType));
+                retval = USBD_CtrlSendData(dev, dev->CtrlData, sizeof(USBD_ProfileType));
+            }
+            break;
+
+        case USBD_STATS_REQ_RESET:
+            if ((dev->Request.RequestType.Direction == USB_DIRECTION_OUT) &&
+                (dev->Request.Length == 0))
+            {
+                USBD_StatsReset(dev);
+                retval = USBD_E_OK;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return retval;
+}
+#endif /* (USBD_STATS_VENDOR_CODE != 0) */
+
+/** @} */
+
+/** @addtogroup USBD_Exported_Functions
+ * @{ */
+
+/**
+ * @brief Copies the current statistics of the device.
+ * @note  The statistics are updated by the USB device interrupt
+ *        (or by @ref USBD_Process when USBD_DEFERRED_PROCESSING is set),
+ *        which shouldn't preempt this call for a consistent snapshot.
+ * @param dev: USB Device handle reference
+ * @param stats: the destination of the snapshot
+ */
+void USBD_StatsGet(USBD_HandleType *dev, USBD_StatsType *stats)
+{
+    uint8_t i;
+
+    for (i = 0; i < USBD_MAX_EP_COUNT; i++)
+    {
+        stats->IN [i] = dev->EP.IN [i].Stats;
+        stats->OUT[i] = dev->EP.OUT[i].Stats;
+    }
+    memcpy(stats->Profile, dev->Profile, sizeof(stats->Profile));
+}
+
+/**
+ * @brief Clears all statistics of the device.
+ * @param dev: USB Device handle reference
+ */
+void USBD_StatsReset(USBD_HandleType *dev)
+{
+    uint8_t i;
+
+    for (i = 0; i < USBD_MAX_EP_COUNT; i++)
+    {
+        memset(&dev->EP.IN [i].Stats, 0, sizeof(USBD_EpStatsType));
+        memset(&dev->EP.OUT[i].Stats, 0, sizeof(USBD_EpStatsType));
+    }
+    memset(dev->Profile, 0, sizeof(dev->Profile));
+}
+
+/** @} */
+
+#endif /* (USBD_STATS_SUPPORT == 1) */
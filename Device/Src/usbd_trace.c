@@ -0,0 +1,74 @@
+/**
+  ******************************************************************************
+  * @file    usbd_trace.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Event trace
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+
+#if (USBD_TRACE_SUPPORT == 1)
+
+/** @ingroup USBD
+ * @addtogroup USBD_Exported_Functions
+ * @{ */
+
+/**
+ * @brief Moves the oldest recorded entries out of the device's trace.
+ * @note  The trace is a lock-free ring, which shall be read from a single context.
+ *        The reading stops at the first entry which is still being recorded.
+ *        The number of entries lost since @ref USBD_Init is USBD_TraceType::Dropped.
+ * @param dev: USB Device handle reference
+ * @param entries: the destination of the entries
+ * @param count: the maximal number of entries to read
+ * @return The number of read entries
+ */
+uint16_t USBD_TraceRead(USBD_HandleType *dev, USBD_TraceEntryType *entries, uint16_t count)
+{
+    uint16_t tail = dev->Trace.Tail;
+    uint16_t i;
+
+    for (i = 0; (i < count) &&
+         (dev->Trace.Ring[(tail + i) & (USBD_TRACE_SIZE - 1)].Sequence == (uint16_t)(tail + i + 1));
+         i++)
+    {
+        USBD_RING_BARRIER();
+        entries[i] = dev->Trace.Ring[(tail + i) & (USBD_TRACE_SIZE - 1)];
+    }
+
+    /* The slots are only released after copying */
+    USBD_RING_BARRIER();
+    dev->Trace.Tail = tail + i;
+    return i;
+}
+
+/**
+ * @brief Excludes the events of an endpoint from the device's trace,
+ *        e.g. of the interface which drains the trace.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ */
+void USBD_TraceIgnore(USBD_HandleType *dev, uint8_t epAddr)
+{
+    dev->Trace.Ignore |= USBD_TRACE_EP_BIT(epAddr);
+}
+
+/** @} */
+
+#endif /* (USBD_TRACE_SUPPORT == 1) */
@@ -204,8 +204,19 @@ typedef enum
 typedef enum
 {
     USB_DEVCAP_USB_2p0_EXT  = 0x02, /*!< USB 2.0 extension (for LPM) */
+    USB_DEVCAP_PLATFORM     = 0x05, /*!< Platform specific capability (e.g. MS OS 2.0) */
 }USB_DeviceCapabilityType;
 
+/** @brief Microsoft OS 2.0 descriptor types */
+typedef enum
+{
+    USB_MS_OS_20_SET_HEADER_DESCRIPTOR       = 0x00, /*!< Descriptor set header */
+    USB_MS_OS_20_SUBSET_HEADER_CONFIGURATION = 0x01, /*!< Configuration subset header */
+    USB_MS_OS_20_SUBSET_HEADER_FUNCTION      = 0x02, /*!< Function subset header */
+    USB_MS_OS_20_FEATURE_COMPATIBLE_ID       = 0x03, /*!< Compatible ID feature */
+    USB_MS_OS_20_FEATURE_REG_PROPERTY        = 0x04, /*!< Registry property feature */
+}USB_MsOs20DescriptorType;
+
 /** @brief USB setup request */
 typedef struct
 {
@@ -346,6 +357,59 @@ typedef struct
                                          Bit 1 Link Power Management support */
 }__packed USB_DevCapabilityDescType;
 
+/** @brief Microsoft OS 2.0 platform capability descriptor structure */
+typedef struct
+{
+    uint8_t  bLength;               /*!< Size of Descriptor in Bytes (28) */
+    uint8_t  bDescriptorType;       /*!< Device Capability Descriptor (0x10) */
+    uint8_t  bDevCapabilityType;    /*!< Capability type: PLATFORM (0x05) */
+    uint8_t  bReserved;             /*!< Reserved (set to 0) */
+    uint8_t  PlatformCapabilityUUID[16]; /*!< MS OS 2.0 platform UUID
+                                              {D8DD60DF-4589-4CC7-9CD2-659D9E648A9F} */
+    uint32_t dwWindowsVersion;      /*!< Minimum Windows version of the descriptor set */
+    uint16_t wMSOSDescriptorSetTotalLength; /*!< Total length of the descriptor set */
+    uint8_t  bMS_VendorCode;        /*!< Vendor request code to retrieve the descriptor set */
+    uint8_t  bAltEnumCode;          /*!< Alternate enumeration code (0 if not supported) */
+}__packed USB_MsOs20PlatformDescType;
+
+/** @brief Microsoft OS 2.0 descriptor set header structure */
+typedef struct
+{
+    uint16_t wLength;               /*!< Size of the header in Bytes (10) */
+    uint16_t wDescriptorType;       /*!< MS OS 2.0 descriptor set header (0x00) */
+    uint32_t dwWindowsVersion;      /*!< Minimum Windows version of the descriptor set */
+    uint16_t wTotalLength;          /*!< Total length of the descriptor set */
+}__packed USB_MsOs20SetHeaderDescType;
+
+/** @brief Microsoft OS 2.0 configuration subset header structure */
+typedef struct
+{
+    uint16_t wLength;               /*!< Size of the header in Bytes (8) */
+    uint16_t wDescriptorType;       /*!< MS OS 2.0 configuration subset header (0x01) */
+    uint8_t  bConfigurationValue;   /*!< Index of the configuration (not its value) */
+    uint8_t  bReserved;             /*!< Reserved (set to 0) */
+    uint16_t wTotalLength;          /*!< Length of the configuration subset, including this header */
+}__packed USB_MsOs20ConfigSubsetDescType;
+
+/** @brief Microsoft OS 2.0 function subset header structure */
+typedef struct
+{
+    uint16_t wLength;               /*!< Size of the header in Bytes (8) */
+    uint16_t wDescriptorType;       /*!< MS OS 2.0 function subset header (0x02) */
+    uint8_t  bFirstInterface;       /*!< First interface of the function */
+    uint8_t  bReserved;             /*!< Reserved (set to 0) */
+    uint16_t wSubsetLength;         /*!< Length of the function subset, including this header */
+}__packed USB_MsOs20FunctionSubsetDescType;
+
+/** @brief Microsoft OS 2.0 compatible ID feature descriptor structure */
+typedef struct
+{
+    uint16_t wLength;               /*!< Size of the descriptor in Bytes (20) */
+    uint16_t wDescriptorType;       /*!< MS OS 2.0 compatible ID feature (0x03) */
+    uint8_t  CompatibleID[8];       /*!< Compatible ID string, e.g. "WINUSB" */
+    uint8_t  SubCompatibleID[8];    /*!< Sub-compatible ID string */
+}__packed USB_MsOs20CompatibleIdDescType;
+
 /** @brief USB Interface Association Descriptor structure */
 typedef struct
 {
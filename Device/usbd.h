@@ -44,6 +44,32 @@ void            USBD_Disconnect         (USBD_HandleType *dev);
 
 USBD_ReturnType USBD_SetRemoteWakeup    (USBD_HandleType *dev);
 USBD_ReturnType USBD_ClearRemoteWakeup  (USBD_HandleType *dev);
+
+#if (USBD_DEFERRED_PROCESSING == 1)
+void            USBD_Process            (USBD_HandleType *dev);
+#endif
+
+#if (USBD_ARENA_BLOCK_COUNT > 0)
+void*           USBD_ArenaAlloc         (uint16_t size);
+void            USBD_ArenaFree          (void *buffer);
+int             USBD_ArenaContains      (const void *buffer);
+#endif
+
+#if (USBD_STATS_SUPPORT == 1)
+void            USBD_StatsGet           (USBD_HandleType *dev,
+                                         USBD_StatsType *stats);
+void            USBD_StatsReset         (USBD_HandleType *dev);
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+uint16_t        USBD_TraceRead          (USBD_HandleType *dev,
+                                         USBD_TraceEntryType *entries,
+                                         uint16_t count);
+void            USBD_TraceIgnore        (USBD_HandleType *dev,
+                                         uint8_t epAddr);
+void            USBD_TraceLinkState     (USBD_HandleType *dev,
+                                         USB_LinkStateType state);
+#endif
 /** @} */
 
 #ifdef __cplusplus
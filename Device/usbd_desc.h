@@ -0,0 +1,118 @@
+/**
+  ******************************************************************************
+  * @file    usbd_desc.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Compile-time descriptor construction macros
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_DESC_H_
+#define __USBD_DESC_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <usbd_types.h>
+
+/** @ingroup USBD
+ * @defgroup USBD_Static_Desc USBD Static Descriptors
+ * @brief Macros to build the descriptors of a fixed device layout as const tables,
+ *        which are linked to @ref USBD_DescriptionType::Static.
+ *
+ * The standard descriptors expand to comma separated byte lists,
+ * the class-specific descriptors can be inserted between them the same way:
+ * @code
+ * #define CONFIG_DESC_LEN (USBD_CONFIG_DESC_LEN + USBD_IF_DESC_LEN + 2 * USBD_EP_DESC_LEN)
+ *
+ * static const uint8_t configDesc[] = {
+ *     USBD_CONFIG_DESC(CONFIG_DESC_LEN, 1, 0x00, 100),
+ *     USBD_IF_DESC(0, 0, 2, 0xFF, 0x00, 0x00, 0),
+ *     USBD_EP_DESC(0x81, USB_EP_TYPE_BULK, 64, 0),
+ *     USBD_EP_DESC(0x01, USB_EP_TYPE_BULK, 64, 0),
+ * };
+ *
+ * USBD_STRING_DESC(vendorStr, "Vendor");
+ * @endcode
+ * @{ */
+
+/** @brief Lengths of the standard descriptors */
+#define USBD_CONFIG_DESC_LEN            sizeof(USB_ConfigDescType)
+#define USBD_IAD_DESC_LEN               sizeof(USB_IfAssocDescType)
+#define USBD_IF_DESC_LEN                sizeof(USB_InterfaceDescType)
+#define USBD_EP_DESC_LEN                sizeof(USB_EndpointDescType)
+
+/** @brief Little endian byte list of a 16 bit descriptor field */
+#define USBD_DESC_U16(X)                ((X) & 0xFF), (((X) >> 8) & 0xFF)
+
+/** @brief Configuration descriptor header, with the total length of the configuration */
+#define USBD_CONFIG_DESC(TOTAL_LEN, IF_COUNT, ATTRIBUTES, MAX_CURRENT_mA)   \
+    USBD_CONFIG_DESC_LEN, USB_DESC_TYPE_CONFIGURATION,                      \
+    USBD_DESC_U16(TOTAL_LEN), (IF_COUNT), 1, USBD_ISTR_CONFIG,              \
+    (0x80 | (ATTRIBUTES)), ((MAX_CURRENT_mA) / 2)
+
+/** @brief Interface association descriptor */
+#define USBD_IAD_DESC(FIRST_IF, IF_COUNT, CLASS, SUBCLASS, PROTOCOL, ISTR)  \
+    USBD_IAD_DESC_LEN, USB_DESC_TYPE_IAD,                                   \
+    (FIRST_IF), (IF_COUNT), (CLASS), (SUBCLASS), (PROTOCOL), (ISTR)
+
+/** @brief Interface descriptor */
+#define USBD_IF_DESC(IF_NUM, ALT, EP_COUNT, CLASS, SUBCLASS, PROTOCOL, ISTR) \
+    USBD_IF_DESC_LEN, USB_DESC_TYPE_INTERFACE,                              \
+    (IF_NUM), (ALT), (EP_COUNT), (CLASS), (SUBCLASS), (PROTOCOL), (ISTR)
+
+/** @brief Endpoint descriptor */
+#define USBD_EP_DESC(EP_ADDR, TYPE, MPS, INTERVAL)                          \
+    USBD_EP_DESC_LEN, USB_DESC_TYPE_ENDPOINT,                               \
+    (EP_ADDR), (TYPE), USBD_DESC_U16(MPS), (INTERVAL)
+
+/** @brief wMaxPacketSize of a high speed high bandwidth periodic endpoint,
+ *         with the number of additional transactions per microframe (0..2) */
+#define USBD_EP_HB_MPS(MPS, TRANSACTIONS)                                   \
+    ((MPS) | ((TRANSACTIONS) << 11))
+
+/** @brief Determines whether a string reference points to a string descriptor:
+ *         printable ASCII strings never contain the descriptor type byte */
+#define USBD_IS_STRING_DESC(STR)                                            \
+    ((((const uint8_t*)(STR))[0] != 0) &&                                   \
+     (((const uint8_t*)(STR))[1] == USB_DESC_TYPE_STRING))
+
+/** @brief Converts a string descriptor reference to a string reference,
+ *         so it can be set as any name of the device, interfaces or applications */
+#define USBD_STRING_DESC_REF(NAME)      ((const char*)&(NAME))
+
+/** @brief Defines a string descriptor with the UTF-16 encoding of the string literal */
+#define USBD_STRING_DESC(NAME, STR)                                         \
+    static const struct {                                                   \
+        uint8_t  bLength;                                                   \
+        uint8_t  bDescriptorType;                                           \
+        uint16_t bString[(sizeof(u"" STR) / 2) - 1];                        \
+    }__packed NAME __align(USBD_DATA_ALIGNMENT) = {                         \
+        .bLength         = sizeof(NAME),                                    \
+        .bDescriptorType = USB_DESC_TYPE_STRING,                            \
+        .bString         = u"" STR,                                         \
+    }
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_DESC_H_ */
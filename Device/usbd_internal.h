@@ -31,10 +31,125 @@ extern "C"
 
 #include <usbd.h>
 #include <usbd_pd_if.h>
+#include <usbd_ring.h>
 
 /* strlen(), memcpy() */
 #include <string.h>
 
+#if (USBD_STATS_SUPPORT == 1)
+/**
+ * @brief  Increments a transfer statistics counter of the endpoint.
+ * @param  EP: USB endpoint handle reference
+ * @param  COUNTER: the @ref USBD_EpStatsType field name
+ */
+#define USBD_EP_STATS_INC(EP, COUNTER)  ((EP)->Stats.COUNTER++)
+#else
+#define USBD_EP_STATS_INC(EP, COUNTER)  ((void)0)
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+#if ((USBD_TRACE_SIZE & (USBD_TRACE_SIZE - 1)) != 0)
+#error "USBD_TRACE_SIZE has to be a power of 2!"
+#endif
+
+/**
+ * @brief  Returns the @ref USBD_TraceType::Ignore bit of the endpoint.
+ * @param  EPADDR: endpoint address
+ */
+#define USBD_TRACE_EP_BIT(EPADDR)       \
+    (1UL << (((EPADDR) & 0xF) + (((EPADDR) & 0x80) >> 3)))
+
+/**
+ * @brief Claims a new entry in the device's trace, to be committed once its
+ *        event specific fields are filled. The slot is claimed atomically,
+ *        as the device processing context may preempt the transfer submission
+ *        of the application (or vice versa).
+ * @param dev: USB Device handle reference
+ * @param id: the @ref USBD_TraceIdType of the event
+ * @param param: the event parameter
+ * @return Reference of the stored entry, or NULL if the trace is full
+ */
+static inline USBD_TraceEntryType* USBD_TracePush(USBD_HandleType *dev,
+        USBD_TraceIdType id, uint8_t param)
+{
+    USBD_TraceEntryType *entry = NULL;
+    uint16_t head;
+    uint8_t full;
+
+    do
+    {
+        head = dev->Trace.Head;
+        full = (uint16_t)(head - dev->Trace.Tail) >= USBD_TRACE_SIZE;
+    }
+    while ((full == 0) && !USBD_TRACE_CLAIM(&dev->Trace.Head, head, (uint16_t)(head + 1)));
+
+    if (full != 0)
+    {
+        dev->Trace.Dropped++;
+    }
+    else
+    {
+        /* The entry stays invisible to the reader until committed */
+        entry = &dev->Trace.Ring[head & (USBD_TRACE_SIZE - 1)];
+        entry->Sequence  = head;
+        entry->Timestamp = USBD_TRACE_TIMESTAMP();
+        entry->Frame     = dev->Trace.Frame;
+        entry->Id        = id;
+        entry->Param     = param;
+    }
+    return entry;
+}
+
+/**
+ * @brief Publishes a claimed trace entry to @ref USBD_TraceRead.
+ * @param entry: the entry returned by @ref USBD_TracePush
+ */
+static inline void USBD_TraceCommit(USBD_TraceEntryType *entry)
+{
+    USBD_RING_BARRIER();
+    entry->Sequence++;
+}
+
+/**
+ * @brief Records an event in the device's trace.
+ * @param dev: USB Device handle reference
+ * @param id: the @ref USBD_TraceIdType of the event
+ * @param param: the event parameter
+ * @param len: the transfer length
+ */
+static inline void USBD_TraceRecord(USBD_HandleType *dev,
+        USBD_TraceIdType id, uint8_t param, uint16_t len)
+{
+    USBD_TraceEntryType *entry = USBD_TracePush(dev, id, param);
+
+    if (entry != NULL)
+    {
+        entry->Length = len;
+        USBD_TraceCommit(entry);
+    }
+}
+
+/**
+ * @brief Records an endpoint event in the device's trace,
+ *        unless the endpoint is ignored.
+ * @param dev: USB Device handle reference
+ * @param id: the @ref USBD_TraceIdType of the event
+ * @param epAddr: endpoint address
+ * @param len: the transfer length
+ */
+static inline void USBD_TraceEp(USBD_HandleType *dev,
+        USBD_TraceIdType id, uint8_t epAddr, uint16_t len)
+{
+    if ((dev->Trace.Ignore & USBD_TRACE_EP_BIT(epAddr)) == 0)
+    {
+        USBD_TraceRecord(dev, id, epAddr, len);
+    }
+}
+#else
+#define USBD_TraceRecord(DEV, ID, PARAM, LEN)   ((void)0)
+#define USBD_TraceEp(DEV, ID, EPADDR, LEN)      ((void)0)
+#endif /* (USBD_TRACE_SUPPORT == 1) */
+
 /** @ingroup USBD
  * @addtogroup USBD_Internal_Functions
  * @{ */
@@ -46,6 +161,17 @@ USBD_ReturnType USBD_CtrlSendData       (USBD_HandleType *dev,
 USBD_ReturnType USBD_CtrlReceiveData    (USBD_HandleType *dev,
                                          uint8_t *data);
 
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+USBD_ReturnType USBD_CtrlSendChunked    (USBD_HandleType *dev,
+                                         uint16_t len,
+                                         USBD_CtrlChunkCbkType provider,
+                                         void *context);
+
+USBD_ReturnType USBD_CtrlReceiveChunked (USBD_HandleType *dev,
+                                         USBD_CtrlChunkCbkType consumer,
+                                         void *context);
+#endif
+
 uint16_t        USBD_EpDesc             (USBD_HandleType *dev,
                                          uint8_t epAddr,
                                          uint8_t *data);
@@ -60,6 +186,41 @@ USBD_ReturnType USBD_EpReceive          (USBD_HandleType *dev,
                                          uint8_t *data,
                                          uint16_t len);
 
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+USBD_ReturnType USBD_EpSendVector       (USBD_HandleType *dev,
+                                         uint8_t epAddr,
+                                         const USBD_EpSegmentType *segments,
+                                         uint8_t count);
+#endif
+
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+void            USBD_EpQueueInit        (USBD_HandleType *dev,
+                                         uint8_t epAddr,
+                                         USBD_EpQueueType *queue,
+                                         USBD_EpRequestType *ring,
+                                         uint8_t size);
+
+USBD_ReturnType USBD_EpSubmit           (USBD_HandleType *dev,
+                                         uint8_t epAddr,
+                                         const USBD_EpRequestType *req);
+
+void            USBD_EpQueueResume      (USBD_HandleType *dev,
+                                         USBD_EpHandleType *ep);
+
+/**
+ * @brief Discards the queued requests of the endpoint.
+ * @param ep: USB endpoint handle reference
+ */
+static inline void USBD_EpQueueReset    (USBD_EpHandleType *ep)
+{
+    if (ep->Queue != NULL)
+    {
+        ep->Queue->Count  = 0;
+        ep->Queue->Active = 0;
+    }
+}
+#endif
+
 /**
  * @brief Converts the USBD endpoint address to its reference.
  * @param dev: USB Device handle reference
@@ -95,12 +256,15 @@ static inline uint8_t USBD_EpRef2Addr   (USBD_HandleType *dev,
  * @param epAddr: endpoint address
  * @param type: endpoint type
  * @param mps: endpoint maximal packet size
+ * @param options: @ref USBD_EpOptionType flags of the endpoint operation
  */
 static inline void USBD_EpOpen          (USBD_HandleType *dev,
                                          uint8_t epAddr,
                                          USB_EndPointType type,
-                                         uint16_t mps)
+                                         uint16_t mps,
+                                         uint8_t options)
 {
+    USBD_EpAddr2Ref(dev, epAddr)->Options = options;
     USBD_PD_EpOpen(dev, epAddr, type, mps);
     USBD_EpAddr2Ref(dev, epAddr)->State = USB_EP_STATE_IDLE;
 }
@@ -115,6 +279,13 @@ static inline void USBD_EpClose         (USBD_HandleType *dev,
 {
     USBD_PD_EpClose(dev, epAddr);
     USBD_EpAddr2Ref(dev, epAddr)->State = USB_EP_STATE_CLOSED;
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+    USBD_EpQueueReset(USBD_EpAddr2Ref(dev, epAddr));
+#endif
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+    if (epAddr > 0x7F)
+    {   dev->EP.Vector[epAddr & 0xF].Active = 0; }
+#endif
 }
 
 /**
@@ -127,6 +298,13 @@ static inline void USBD_EpFlush         (USBD_HandleType *dev,
 {
     USBD_PD_EpFlush(dev, epAddr);
     USBD_EpAddr2Ref(dev, epAddr)->State = USB_EP_STATE_IDLE;
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+    USBD_EpQueueReset(USBD_EpAddr2Ref(dev, epAddr));
+#endif
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+    if (epAddr > 0x7F)
+    {   dev->EP.Vector[epAddr & 0xF].Active = 0; }
+#endif
 }
 
 /**
@@ -139,10 +317,13 @@ static inline void USBD_EpSetStall      (USBD_HandleType *dev,
 {
     USBD_PD_EpSetStall(dev, epAddr);
     USBD_EpAddr2Ref(dev, epAddr)->State = USB_EP_STATE_STALL;
+    USBD_EP_STATS_INC(USBD_EpAddr2Ref(dev, epAddr), Stalls);
+    USBD_TraceEp(dev, USBD_TRACE_STALL, epAddr, 0);
 }
 
 /**
  * @brief Clears the stall (NAK) status on the endpoint.
+ * @note  The queue of the endpoint is continued by @ref USBD_EpQueueResume.
  * @param dev: USB Device handle reference
  * @param epAddr: endpoint address
  */
@@ -151,6 +332,12 @@ static inline void USBD_EpClearStall    (USBD_HandleType *dev,
 {
     USBD_PD_EpClearStall(dev, epAddr);
     USBD_EpAddr2Ref(dev, epAddr)->State = USB_EP_STATE_IDLE;
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+    if (USBD_EpAddr2Ref(dev, epAddr)->Queue != NULL)
+    {
+        USBD_EpQueueResume(dev, USBD_EpAddr2Ref(dev, epAddr));
+    }
+#endif
 }
 
 /** @} */
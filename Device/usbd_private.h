@@ -31,6 +31,29 @@ extern "C"
 
 #include <usbd_internal.h>
 
+#if (USBD_STATS_SUPPORT == 1)
+/* usbd_stats <- usbd_ctrl, usbd_ep, usbd_private */
+void            USBD_StatsProfile       (USBD_HandleType *dev,
+                                         USBD_ProfileIdType id,
+                                         uint32_t start);
+
+/**
+ * @brief  Starts the duration measurement of a profiled callback.
+ *         Shall be placed after the local declarations of the block.
+ */
+#define USBD_PROFILE_START()            uint32_t usbd_profileStart = USBD_STATS_CYCLES()
+
+/**
+ * @brief  Records the duration since @ref USBD_PROFILE_START in the selected profile.
+ * @param  DEV: USB Device handle reference
+ * @param  ID: the @ref USBD_ProfileIdType of the callback
+ */
+#define USBD_PROFILE_END(DEV, ID)       USBD_StatsProfile((DEV), (ID), usbd_profileStart)
+#else
+#define USBD_PROFILE_START()            ((void)0)
+#define USBD_PROFILE_END(DEV, ID)       ((void)0)
+#endif
+
 /** @ingroup USBD
  * @defgroup USBD_Private_Functions_IfClass USBD Class-specific Interface Callouts
  * @brief These functions simply call the class-specific function pointer
@@ -100,10 +123,14 @@ static inline void USBD_IfClass_Deinit(
 static inline USBD_ReturnType USBD_IfClass_SetupStage(
         USBD_IfHandleType *itf)
 {
-    if (itf->Class->SetupStage == NULL)
-    {   return USBD_E_INVALID; }
-    else
-    {   return itf->Class->SetupStage(itf); }
+    USBD_ReturnType retval = USBD_E_INVALID;
+    USBD_PROFILE_START();
+
+    if (itf->Class->SetupStage != NULL)
+    {   retval = itf->Class->SetupStage(itf); }
+
+    USBD_PROFILE_END(itf->Device, USBD_PROFILE_CLASS_SETUP);
+    return retval;
 }
 
 /**
@@ -114,7 +141,9 @@ static inline USBD_ReturnType USBD_IfClass_SetupStage(
 static inline void USBD_IfClass_DataStage(
         USBD_IfHandleType *itf)
 {
+    USBD_PROFILE_START();
     USBD_SAFE_CALLBACK(itf->Class->DataStage, itf);
+    USBD_PROFILE_END(itf->Device, USBD_PROFILE_CLASS_DATA);
 }
 
 /**
@@ -126,7 +155,9 @@ static inline void USBD_IfClass_DataStage(
 static inline void USBD_IfClass_InData(
         USBD_IfHandleType *itf, USBD_EpHandleType *ep)
 {
+    USBD_PROFILE_START();
     USBD_SAFE_CALLBACK(itf->Class->InData, itf, ep);
+    USBD_PROFILE_END(itf->Device, USBD_PROFILE_CLASS_IN);
 }
 
 /**
@@ -138,9 +169,53 @@ static inline void USBD_IfClass_InData(
 static inline void USBD_IfClass_OutData(
         USBD_IfHandleType *itf, USBD_EpHandleType *ep)
 {
+    USBD_PROFILE_START();
     USBD_SAFE_CALLBACK(itf->Class->OutData, itf, ep);
+    USBD_PROFILE_END(itf->Device, USBD_PROFILE_CLASS_OUT);
+}
+
+/**
+ * @brief Calls the interface's class specific
+ *        @ref USBD_ClassType::Sof function.
+ * @param itf: reference of the interface
+ */
+static inline void USBD_IfClass_Sof(
+        USBD_IfHandleType *itf)
+{
+    USBD_PROFILE_START();
+    USBD_SAFE_CALLBACK(itf->Class->Sof, itf);
+    USBD_PROFILE_END(itf->Device, USBD_PROFILE_CLASS_SOF);
+}
+
+/**
+ * @brief Calls the interface's class specific
+ *        @ref USBD_ClassType::GetMsOsDesc function.
+ * @param itf:   reference of the interface
+ * @param ifNum: the interface index in the device
+ * @param dest:  destination buffer pointer
+ * @return Length of the feature descriptors
+ */
+static inline uint16_t USBD_IfClass_GetMsOsDesc(
+        USBD_IfHandleType *itf, uint8_t ifNum, uint8_t *dest)
+{
+    if (itf->Class->GetMsOsDesc != NULL)
+        { return itf->Class->GetMsOsDesc(itf, ifNum, dest); }
+    else
+        { return 0; }
 }
 
+#if (USBD_CONFIG_DESC_CACHE == 1)
+/**
+ * @brief Discards the cached configuration descriptors,
+ *        so they are assembled again at the next request.
+ * @param dev: USB Device handle reference
+ */
+static inline void USBD_ConfigDescInvalidate(USBD_HandleType *dev)
+{
+    memset(dev->ConfigDesc.Length, 0, sizeof(dev->ConfigDesc.Length));
+}
+#endif
+
 /** @} */
 
 /* {function definition} <- {call site} */
@@ -159,15 +234,50 @@ USBD_ReturnType USBD_IfRequest          (USBD_HandleType *dev);
 void            USBD_IfConfig           (USBD_HandleType *dev,
                                          uint8_t cfgNum);
 
+#if (USBD_SOF_SUPPORT == 1)
+/* usbd_if <- usbd */
+void            USBD_IfSof              (USBD_HandleType *dev);
+#endif
+
 /* usbd_if <- usbd_desc */
 const char*     USBD_IfString           (USBD_HandleType *dev);
 
 /* usbd_ep <- usbd_ctrl */
 USBD_ReturnType USBD_EpRequest          (USBD_HandleType *dev);
 
+#if (USBD_DEFERRED_PROCESSING == 1)
+/* usbd_ctrl <- usbd */
+void            USBD_SetupHandler       (USBD_HandleType *dev);
+
+/* usbd_ep <- usbd */
+void            USBD_EpInHandler        (USBD_HandleType *dev,
+                                         USBD_EpHandleType *ep);
+void            USBD_EpOutHandler       (USBD_HandleType *dev,
+                                         USBD_EpHandleType *ep);
+#endif
+
 /* usbd_desc <- usbd */
 USBD_ReturnType USBD_GetDescriptor      (USBD_HandleType *dev);
 
+#if (USBD_MS_OS_DESC_SUPPORT == 1)
+/* usbd_desc <- usbd */
+USBD_ReturnType USBD_GetMsOsDescriptor  (USBD_HandleType *dev);
+#endif
+
+#if (USBD_SERIAL_BCD_SIZE > 0)
+/* usbd_desc <- usbd */
+void            USBD_SerialDescInit     (USBD_HandleType *dev);
+#endif
+
+#if (USBD_STATS_SUPPORT == 1) && (USBD_STATS_VENDOR_CODE != 0)
+/* usbd_stats <- usbd */
+USBD_ReturnType USBD_StatsRequest       (USBD_HandleType *dev);
+#endif
+
+/* usbd_desc <- usbd_if */
+const uint8_t*  USBD_ConfigDescRef      (USBD_HandleType *dev,
+                                         uint16_t *len);
+
 #ifdef __cplusplus
 }
 #endif
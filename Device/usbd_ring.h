@@ -0,0 +1,220 @@
+/**
+  ******************************************************************************
+  * @file    usbd_ring.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Single-producer single-consumer byte ring buffer
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_RING_H_
+#define __USBD_RING_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <stdint.h>
+#include <string.h>
+
+/** @ingroup USBD
+ * @defgroup USBD_Ring Ring buffer
+ * @brief Lock-free ring for one producer and one consumer context
+ *        (e.g. an interrupt and a thread). The free-running indexes
+ *        make the whole storage usable.
+ * @{ */
+
+/* Memory barrier between the data access and the index update,
+ * a compiler barrier is sufficient on single core systems */
+#ifndef USBD_RING_BARRIER
+#if defined ( __GNUC__ )
+#define USBD_RING_BARRIER()     __sync_synchronize()
+#else
+#define USBD_RING_BARRIER()
+#endif
+#endif
+
+/**
+ * @brief Defines a new ring with static storage.
+ * @param R: Name of the ring as a variable
+ * @param SIZE: Ring storage size, shall be a power of 2
+ */
+#define USBD_RING_DEF(R, SIZE)                                      \
+static uint8_t R##_BUFFER__[(SIZE)];                                \
+static USBD_RingType R = {                                          \
+    .Buffer = R##_BUFFER__,                                         \
+    .Size   = (SIZE) }
+
+/** @brief Ring buffer structure */
+typedef struct
+{
+    uint8_t *Buffer;            /*!< Ring storage */
+    uint16_t Size;              /*!< Ring storage size, a power of 2 */
+    volatile uint16_t Head;     /*!< Free-running write index, modified by the producer */
+    volatile uint16_t Tail;     /*!< Free-running read index, modified by the consumer */
+}USBD_RingType;
+
+/**
+ * @brief Initializes the ring with the storage.
+ * @param ring: reference of the ring
+ * @param buffer: the ring storage
+ * @param size: the storage size, shall be a power of 2
+ */
+static inline void USBD_RingInit(USBD_RingType *ring, uint8_t *buffer, uint16_t size)
+{
+    ring->Buffer = buffer;
+    ring->Size   = size;
+    ring->Head   = 0;
+    ring->Tail   = 0;
+}
+
+/**
+ * @brief Returns the number of bytes stored in the ring.
+ * @param ring: reference of the ring
+ * @return The stored data length
+ */
+static inline uint16_t USBD_RingCount(const USBD_RingType *ring)
+{
+    return (uint16_t)(ring->Head - ring->Tail);
+}
+
+/**
+ * @brief Returns the free space of the ring.
+ * @param ring: reference of the ring
+ * @return The free space in bytes
+ */
+static inline uint16_t USBD_RingSpace(const USBD_RingType *ring)
+{
+    return ring->Size - USBD_RingCount(ring);
+}
+
+/**
+ * @brief Provides the contiguous free region at the ring's head for the producer.
+ * @param ring: reference of the ring
+ * @param data: set to the start of the region
+ * @return The length of the region
+ */
+static inline uint16_t USBD_RingReserve(USBD_RingType *ring, uint8_t **data)
+{
+    uint16_t head = ring->Head & (ring->Size - 1);
+    uint16_t space = USBD_RingSpace(ring);
+    uint16_t len = ring->Size - head;
+
+    *data = &ring->Buffer[head];
+    return (len < space) ? len : space;
+}
+
+/**
+ * @brief Publishes the data written to the reserved region to the consumer.
+ * @param ring: reference of the ring
+ * @param length: the written data length
+ */
+static inline void USBD_RingCommit(USBD_RingType *ring, uint16_t length)
+{
+    USBD_RING_BARRIER();
+    ring->Head += length;
+}
+
+/**
+ * @brief Provides the contiguous stored region at the ring's tail for the consumer.
+ * @param ring: reference of the ring
+ * @param data: set to the start of the region
+ * @return The length of the region
+ */
+static inline uint16_t USBD_RingPeek(USBD_RingType *ring, uint8_t **data)
+{
+    uint16_t tail = ring->Tail & (ring->Size - 1);
+    uint16_t count = USBD_RingCount(ring);
+    uint16_t len = ring->Size - tail;
+
+    USBD_RING_BARRIER();
+    *data = &ring->Buffer[tail];
+    return (len < count) ? len : count;
+}
+
+/**
+ * @brief Releases the consumed data of the peeked region to the producer.
+ * @param ring: reference of the ring
+ * @param length: the consumed data length
+ */
+static inline void USBD_RingRelease(USBD_RingType *ring, uint16_t length)
+{
+    USBD_RING_BARRIER();
+    ring->Tail += length;
+}
+
+/**
+ * @brief Copies data to the ring, as much as it fits.
+ * @param ring: reference of the ring
+ * @param data: the source data
+ * @param length: the data length
+ * @return The number of stored bytes
+ */
+static inline uint16_t USBD_RingPut(USBD_RingType *ring, const uint8_t *data, uint16_t length)
+{
+    uint16_t head = ring->Head & (ring->Size - 1);
+    uint16_t space = USBD_RingSpace(ring);
+    uint16_t len = ring->Size - head;
+
+    if (length > space)
+    {   length = space; }
+    if (len > length)
+    {   len = length; }
+
+    /* Split at the wrap point */
+    memcpy(&ring->Buffer[head], data, len);
+    memcpy(ring->Buffer, &data[len], length - len);
+
+    USBD_RingCommit(ring, length);
+    return length;
+}
+
+/**
+ * @brief Copies data from the ring, as much as it's available.
+ * @param ring: reference of the ring
+ * @param data: the destination buffer
+ * @param length: the requested data length
+ * @return The number of read bytes
+ */
+static inline uint16_t USBD_RingGet(USBD_RingType *ring, uint8_t *data, uint16_t length)
+{
+    uint16_t tail = ring->Tail & (ring->Size - 1);
+    uint16_t count = USBD_RingCount(ring);
+    uint16_t len = ring->Size - tail;
+
+    if (length > count)
+    {   length = count; }
+    if (len > length)
+    {   len = length; }
+
+    /* Split at the wrap point */
+    USBD_RING_BARRIER();
+    memcpy(data, &ring->Buffer[tail], len);
+    memcpy(&data[len], ring->Buffer, length - len);
+
+    USBD_RingRelease(ring, length);
+    return length;
+}
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_RING_H_ */
@@ -66,9 +66,149 @@
 #define USBD_HS_SUPPORT                 0
 #endif
 
-#if !defined(USBD_SPEC_BCD) && (USBD_LPM_SUPPORT != 0)
+#ifndef USBD_EP_QUEUE_SUPPORT
+#define USBD_EP_QUEUE_SUPPORT           0
+#endif
+
+#ifndef USBD_EP_VECTOR_SUPPORT
+#define USBD_EP_VECTOR_SUPPORT          0
+#endif
+
+#ifndef USBD_DEFERRED_PROCESSING
+#define USBD_DEFERRED_PROCESSING        0
+#endif
+
+#ifndef USBD_CONFIG_DESC_CACHE
+#define USBD_CONFIG_DESC_CACHE          0
+#endif
+
+#ifndef USBD_STATIC_DESCRIPTORS
+#define USBD_STATIC_DESCRIPTORS         0
+#endif
+
+#ifndef USBD_CTRL_CHUNK_SUPPORT
+#define USBD_CTRL_CHUNK_SUPPORT         0
+#endif
+
+#ifndef USBD_SOF_SUPPORT
+#define USBD_SOF_SUPPORT                0
+#endif
+
+#ifndef USBD_MS_OS_DESC_SUPPORT
+#define USBD_MS_OS_DESC_SUPPORT         0
+#endif
+
+/* The vendor request code of the MS OS 2.0 descriptor set */
+#ifndef USBD_MS_VENDOR_CODE
+#define USBD_MS_VENDOR_CODE             0x20
+#endif
+
+#ifndef USBD_STATS_SUPPORT
+#define USBD_STATS_SUPPORT              0
+#endif
+
+/* The free-running cycle counter of the callback profiling, e.g. DWT->CYCCNT on Cortex-M */
+#ifndef USBD_STATS_CYCLES
+#define USBD_STATS_CYCLES()             0
+#endif
+
+/* The number of duration histogram bins of each profiled callback */
+#ifndef USBD_STATS_HISTOGRAM_SIZE
+#define USBD_STATS_HISTOGRAM_SIZE       8
+#endif
+
+/* The upper limit of the first histogram bin in cycles,
+ * each following bin doubles it, the last one is unlimited */
+#ifndef USBD_STATS_HISTOGRAM_BASE
+#define USBD_STATS_HISTOGRAM_BASE       64
+#endif
+
+/* When non-zero, the host can read the statistics by this device vendor request code */
+#ifndef USBD_STATS_VENDOR_CODE
+#define USBD_STATS_VENDOR_CODE          0
+#endif
+
+#ifndef USBD_TRACE_SUPPORT
+#define USBD_TRACE_SUPPORT              0
+#endif
+
+/* The number of trace entries in the ring, shall be a power of 2 */
+#ifndef USBD_TRACE_SIZE
+#define USBD_TRACE_SIZE                 64
+#endif
+
+/* The free-running timestamp of the trace entries, e.g. DWT->CYCCNT on Cortex-M */
+#ifndef USBD_TRACE_TIMESTAMP
+#define USBD_TRACE_TIMESTAMP()          0
+#endif
+
+/* Atomic compare and swap of the 16 bit trace write index, returning non-zero on success.
+ * The transfer submissions are recorded from the application's context too,
+ * so the interrupt and the application claim the trace slots concurrently.
+ * Cores without exclusive access instructions (e.g. Cortex-M0) shall define it
+ * with the interrupts disabled. */
+#ifndef USBD_TRACE_CLAIM
+#if defined ( __GNUC__ )
+#define USBD_TRACE_CLAIM(PTR, OLD, NEW) __sync_bool_compare_and_swap((PTR), (OLD), (NEW))
+#else
+#error "USBD_TRACE_CLAIM has to be defined for this compiler!"
+#endif
+#endif
+
+/* Each endpoint has at most one pending transfer completion,
+ * the remaining space is for bus resets and setup requests */
+#ifndef USBD_EVENT_QUEUE_SIZE
+#define USBD_EVENT_QUEUE_SIZE           (2 * USBD_MAX_EP_COUNT + 4)
+#endif
+
+/* When set to non-zero, a pool of this many fixed size blocks
+ * provides transfer buffers through USBD_ArenaAlloc() */
+#ifndef USBD_ARENA_BLOCK_COUNT
+#define USBD_ARENA_BLOCK_COUNT          0
+#endif
+
+/* The size of each arena block, a multiple of USBD_ARENA_ALIGNMENT */
+#ifndef USBD_ARENA_BLOCK_SIZE
+#define USBD_ARENA_BLOCK_SIZE           64
+#endif
+
+/* Placement attribute of the arena, e.g. a DMA reachable RAM section */
+#ifndef USBD_ARENA_SECTION
+#define USBD_ARENA_SECTION
+#endif
+
+/* The data cache line size of the core, 0 if the transfer buffers aren't cached.
+ * When set, USBD_DCACHE_CLEAN() and USBD_DCACHE_INVALIDATE() have to be defined
+ * to perform the cache maintenance of the arena buffers around each transfer */
+#ifndef USBD_DCACHE_LINE_SIZE
+#define USBD_DCACHE_LINE_SIZE           0
+#endif
+
+#ifndef USBD_DCACHE_CLEAN
+#define USBD_DCACHE_CLEAN(ADDR, LEN)        ((void)0)
+#endif
+
+#ifndef USBD_DCACHE_INVALIDATE
+#define USBD_DCACHE_INVALIDATE(ADDR, LEN)   ((void)0)
+#endif
+
+/* Arena buffers satisfy both the peripheral's and the data cache's alignment */
+#if (USBD_DCACHE_LINE_SIZE > USBD_DATA_ALIGNMENT)
+#define USBD_ARENA_ALIGNMENT            USBD_DCACHE_LINE_SIZE
+#else
+#define USBD_ARENA_ALIGNMENT            USBD_DATA_ALIGNMENT
+#endif
+
+/* The largest IN endpoint packet size of vectored transfers */
+#if !defined(USBD_EP_VECTOR_PACKET_SIZE) && (USBD_HS_SUPPORT == 1)
+#define USBD_EP_VECTOR_PACKET_SIZE      USB_EP_BULK_HS_MPS
+#elif !defined(USBD_EP_VECTOR_PACKET_SIZE)
+#define USBD_EP_VECTOR_PACKET_SIZE      USB_EP_BULK_FS_MPS
+#endif
+
+#if !defined(USBD_SPEC_BCD) && ((USBD_LPM_SUPPORT != 0) || (USBD_MS_OS_DESC_SUPPORT != 0))
 /* In order to support reading the BOS descriptor
- * (which specifies the LPM support of the device),
+ * (which specifies the LPM support and the MS OS 2.0 platform of the device),
  * the bcdUSB has to be increased to 2.01 at least */
 #define USBD_SPEC_BCD                   0x0201
 #elif !defined(USBD_SPEC_BCD)
@@ -156,9 +296,170 @@ typedef struct
 #if (USBD_SERIAL_BCD_SIZE > 0)
     USBD_SerialNumberType *SerialNumber;/*!< Product serial number reference */
 #endif
+
+#if (USBD_STATIC_DESCRIPTORS == 1)
+    struct {
+        const USB_DeviceDescType *Device;   /*!< Device descriptor */
+        const uint8_t *Config;              /*!< Full speed configuration descriptor */
+#if (USBD_HS_SUPPORT == 1)
+        const uint8_t *ConfigHS;            /*!< High speed configuration descriptor */
+#endif
+        const uint8_t * const *Strings;     /*!< String descriptors by their index,
+                                                 NULL entries are converted from the names */
+        uint8_t StringCount;                /*!< Number of elements in Strings */
+    }Static;                                /*!< Constant descriptors of a fixed device layout,
+                                                 which are sent instead of the assembled ones
+                                                 when not NULL */
+#endif
 }USBD_DescriptionType;
 
 
+struct _USBD_HandleType;
+
+struct _USBD_IfHandleType;
+
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+/**
+ * @brief Control transfer data chunk callback function pointer type
+ * @param context: the context given when the chunked data stage was started
+ * @param data: the control endpoint buffer to fill (IN) or to consume (OUT)
+ * @param offset: the offset of the chunk in the data stage
+ * @param len: the length of the chunk
+ * @return The length of the provided (IN) or accepted (OUT) data.
+ *         A shorter IN chunk ends the data stage, a shorter OUT acceptance stalls it.
+ */
+typedef uint16_t        ( *USBD_CtrlChunkCbkType )( void *context,
+                                                    uint8_t *data,
+                                                    uint16_t offset,
+                                                    uint16_t len);
+#endif /* (USBD_CTRL_CHUNK_SUPPORT == 1) */
+
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+struct _USBD_EpRequestType;
+
+/**
+ * @brief Endpoint request completion callback function pointer type
+ * @param itf: reference to the interface of the endpoint
+ * @param req: reference to the completed request (a copy of the released queue entry)
+ */
+typedef void            ( *USBD_EpRequestCbkType )( struct _USBD_IfHandleType *itf,
+                                                    struct _USBD_EpRequestType *req);
+
+
+/** @brief USB endpoint transfer request structure */
+typedef struct _USBD_EpRequestType
+{
+    uint8_t *Data;                      /*!< Transfer data buffer */
+    uint16_t Length;                    /*!< Transfer length, on completion the transferred length */
+    USBD_EpRequestCbkType Complete;     /*!< Completion callback, when NULL the interface's
+                                             endpoint callback is called instead */
+    void *Context;                      /*!< Requester context for the completion */
+}USBD_EpRequestType;
+
+
+/** @brief USB endpoint request queue structure */
+typedef struct
+{
+    USBD_EpRequestType *Ring;           /*!< Request descriptor ring */
+    uint8_t Size;                       /*!< Number of descriptors in the ring */
+    uint8_t Head;                       /*!< Ring index of the oldest request */
+    uint8_t Count;                      /*!< Number of requests in the queue */
+    uint8_t Active;                     /*!< The oldest request is being transferred */
+}USBD_EpQueueType;
+#endif /* (USBD_EP_QUEUE_SUPPORT == 1) */
+
+
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+/** @brief USB endpoint transfer data segment structure */
+typedef struct
+{
+    const uint8_t *Data;                /*!< Segment data */
+    uint16_t Length;                    /*!< Segment length */
+}USBD_EpSegmentType;
+
+
+/** @brief USB IN endpoint vectored transfer context */
+typedef struct
+{
+    const USBD_EpSegmentType *Segment;  /*!< Current segment of the transfer */
+    const uint8_t *Start;               /*!< Data of the first segment */
+    uint16_t Offset;                    /*!< Transferred length of the current segment */
+    uint16_t Length;                    /*!< Total length of the transfer */
+    uint8_t  Count;                     /*!< Number of remaining segments */
+    uint8_t  Active;                    /*!< Vectored transfer is ongoing */
+    uint8_t  Packet[USBD_EP_VECTOR_PACKET_SIZE]; /*!< Packet buffer for the data
+                                                      spanning segment boundaries */
+}USBD_EpVectorType;
+#endif /* (USBD_EP_VECTOR_SUPPORT == 1) */
+
+
+#if (USBD_STATS_SUPPORT == 1)
+/** @brief USB endpoint transfer statistics */
+typedef struct
+{
+    uint32_t Transfers;                 /*!< Number of completed transfers */
+    uint32_t Bytes;                     /*!< Number of transferred bytes */
+    uint32_t ShortPackets;              /*!< Number of transfers ended by a short packet (or ZLP) */
+    uint16_t Busy;                      /*!< Number of transfers rejected as BUSY */
+    uint16_t Stalls;                    /*!< Number of times the endpoint was stalled */
+}USBD_EpStatsType;
+
+
+/** @brief USB device profiled callbacks */
+typedef enum
+{
+    USBD_PROFILE_SETUP          = 0,    /*!< Setup request handling */
+    USBD_PROFILE_EP_IN          = 1,    /*!< IN endpoint transfer completion handling */
+    USBD_PROFILE_EP_OUT         = 2,    /*!< OUT endpoint transfer completion handling */
+    USBD_PROFILE_CLASS_SETUP    = 3,    /*!< @ref USBD_ClassType::SetupStage calls */
+    USBD_PROFILE_CLASS_DATA     = 4,    /*!< @ref USBD_ClassType::DataStage calls */
+    USBD_PROFILE_CLASS_IN       = 5,    /*!< @ref USBD_ClassType::InData calls */
+    USBD_PROFILE_CLASS_OUT      = 6,    /*!< @ref USBD_ClassType::OutData calls */
+    USBD_PROFILE_CLASS_SOF      = 7,    /*!< @ref USBD_ClassType::Sof calls */
+    USBD_PROFILE_COUNT
+}USBD_ProfileIdType;
+
+
+/** @brief USB device callback duration profile */
+typedef struct
+{
+    uint32_t Count;                     /*!< Number of measured calls */
+    uint32_t Min;                       /*!< Shortest duration [cycles] */
+    uint32_t Max;                       /*!< Longest duration [cycles] */
+    uint32_t Histogram[USBD_STATS_HISTOGRAM_SIZE]; /*!< Number of calls per duration bin,
+                                             bin i counts the durations below
+                                             USBD_STATS_HISTOGRAM_BASE << i cycles */
+}USBD_ProfileType;
+
+
+/** @brief USB device statistics snapshot */
+typedef struct
+{
+    USBD_EpStatsType IN [USBD_MAX_EP_COUNT];    /*!< IN endpoint statistics */
+    USBD_EpStatsType OUT[USBD_MAX_EP_COUNT];    /*!< OUT endpoint statistics */
+    USBD_ProfileType Profile[USBD_PROFILE_COUNT]; /*!< Callback profiles by @ref USBD_ProfileIdType */
+}USBD_StatsType;
+
+
+/** @brief USB device statistics vendor request selectors (wValue) */
+typedef enum
+{
+    USBD_STATS_REQ_ENDPOINT     = 0,    /*!< IN: @ref USBD_EpStatsType of the wIndex endpoint address */
+    USBD_STATS_REQ_PROFILE      = 1,    /*!< IN: @ref USBD_ProfileType of the wIndex profile */
+    USBD_STATS_REQ_RESET        = 2,    /*!< OUT without data: clear all statistics */
+}USBD_StatsRequestType;
+#endif /* (USBD_STATS_SUPPORT == 1) */
+
+
+/** @brief USB endpoint open options */
+typedef enum
+{
+    USBD_EP_OPT_NONE            = 0x00, /*!< Default endpoint operation */
+    USBD_EP_OPT_DOUBLE_BUFFER   = 0x01, /*!< Use two hardware packet buffers for the endpoint,
+                                             if the peripheral supports and has memory for it */
+}USBD_EpOptionType;
+
+
 /** @brief USB endpoint handle structure */
 typedef struct
 {
@@ -170,18 +471,28 @@ typedef struct
     uint16_t              MaxPacketSize;/*!< Endpoint Max packet size */
     USB_EndPointType      Type;         /*!< Endpoint type */
     USB_EndPointStateType State;        /*!< Endpoint state */
+    uint8_t               Options;      /*!< Endpoint @ref USBD_EpOptionType flags */
     uint8_t               IfNum;        /*!< Interface index of non-control endpoint */
+    uint8_t               Interval;     /*!< Polling interval (bInterval) of periodic endpoint
+                                             at full speed, 0 is reported as 1 */
+#if (USBD_HS_SUPPORT == 1)
+    uint8_t               IntervalHS;   /*!< Polling interval (bInterval) of periodic endpoint
+                                             at high speed, 0 is reported as 1 */
+    uint8_t               Transactions; /*!< Additional transactions per microframe (0..2)
+                                             of high speed periodic endpoint */
+#endif
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+    USBD_EpQueueType     *Queue;        /*!< Optional request queue of non-control endpoint */
+#endif
+#if (USBD_STATS_SUPPORT == 1)
+    USBD_EpStatsType      Stats;        /*!< Transfer statistics */
+#endif
 #ifdef USBD_PD_EP_FIELDS
     USBD_PD_EP_FIELDS;                  /*!< Peripheral Driver specific endpoint context */
 #endif
 }USBD_EpHandleType;
 
 
-struct _USBD_HandleType;
-
-struct _USBD_IfHandleType;
-
-
 /**
  * @brief Generic callback function pointer type
  * @param itf: reference to the callback sender USBD interface
@@ -238,6 +549,11 @@ typedef struct
 
     USBD_IfEpCbkType    OutData;        /*!< OUT EP transfer is completed */
     USBD_IfEpCbkType    InData;         /*!< IN EP transfer is completed */
+
+    USBD_IfCbkType      Sof;            /*!< Start of (micro)frame, when USBD_SOF_SUPPORT is set */
+
+    USBD_IfDescCbkType  GetMsOsDesc;    /*!< Read the interface's MS OS 2.0 feature descriptors,
+                                             when USBD_MS_OS_DESC_SUPPORT is set */
 }USBD_ClassType;
 
 
@@ -251,11 +567,105 @@ typedef struct _USBD_IfHandleType
 }USBD_IfHandleType;
 
 
+#if (USBD_DEFERRED_PROCESSING == 1)
+/** @brief USB device events signalled by the Peripheral Driver */
+typedef enum
+{
+    USBD_EVENT_RESET    = 0,    /*!< Bus reset, Param is the new speed */
+    USBD_EVENT_SETUP    = 1,    /*!< Setup request received on EP0 */
+    USBD_EVENT_EP_IN    = 2,    /*!< IN transfer completed, Param is the endpoint address */
+    USBD_EVENT_EP_OUT   = 3,    /*!< OUT transfer completed, Param is the endpoint address */
+#if (USBD_TRACE_SUPPORT == 1)
+    USBD_EVENT_LINK     = 4,    /*!< Link state change to trace, Param is the new state */
+#endif
+}USBD_EventIdType;
+
+
+/** @brief USB device event structure */
+typedef struct
+{
+    uint8_t Id;                 /*!< The @ref USBD_EventIdType */
+    uint8_t Param;              /*!< Event specific parameter */
+    USB_SetupRequestType Setup; /*!< The received setup request */
+}USBD_EventType;
+
+
+/** @brief USB device event queue, filled by the PD callbacks and drained by @ref USBD_Process */
+typedef struct
+{
+    volatile USBD_EventType Ring[USBD_EVENT_QUEUE_SIZE]; /*!< Event storage */
+    volatile uint8_t Head;      /*!< Next slot to write, modified by the PD callbacks only */
+    volatile uint8_t Tail;      /*!< Next slot to read, modified by @ref USBD_Process only */
+    volatile uint8_t Overflow;  /*!< Set when an event is lost due to insufficient space */
+#if (USBD_SOF_SUPPORT == 1)
+    volatile uint8_t SofHead;   /*!< Number of start of frames, counted by the PD callback */
+    volatile uint8_t SofTail;   /*!< Number of start of frames processed by @ref USBD_Process */
+#endif
+}USBD_EventQueueType;
+#endif /* (USBD_DEFERRED_PROCESSING == 1) */
+
+
+#if (USBD_TRACE_SUPPORT == 1)
+/** @brief USB device trace events */
+typedef enum
+{
+    USBD_TRACE_RESET    = 0,    /*!< Bus reset, Param is the new speed */
+    USBD_TRACE_SETUP    = 1,    /*!< Setup request received, Setup is the request */
+    USBD_TRACE_SUBMIT   = 2,    /*!< Transfer started or queued, Param is the endpoint address,
+                                     Length is the requested length */
+    USBD_TRACE_COMPLETE = 3,    /*!< Transfer completed, Param is the endpoint address,
+                                     Length is the transferred length */
+    USBD_TRACE_STALL    = 4,    /*!< Endpoint stalled, Param is the endpoint address */
+    USBD_TRACE_LINK     = 5,    /*!< Link state changed (suspend or resume),
+                                     Param is the new @ref USB_LinkStateType */
+}USBD_TraceIdType;
+
+
+/** @brief USB device trace entry */
+typedef struct
+{
+    uint32_t Timestamp;         /*!< USBD_TRACE_TIMESTAMP() at the recording */
+    uint16_t Frame;             /*!< Number of started (micro)frames at the recording,
+                                     when USBD_SOF_SUPPORT is set */
+    uint8_t  Id;                /*!< The @ref USBD_TraceIdType */
+    uint8_t  Param;             /*!< Event specific parameter */
+    union {
+        uint16_t Length;        /*!< Transfer length */
+        USB_SetupRequestType Setup; /*!< Setup request */
+    };
+    volatile uint16_t Sequence; /*!< Write index of the entry plus one once it is complete */
+}USBD_TraceEntryType;
+
+
+/** @brief USB device trace ring, filled by the device processing context
+ *         and the transfer submissions, and drained by @ref USBD_TraceRead */
+typedef struct
+{
+    USBD_TraceEntryType Ring[USBD_TRACE_SIZE]; /*!< Entry storage */
+    volatile uint16_t Head;     /*!< Free-running write index, claimed by USBD_TRACE_CLAIM() */
+    volatile uint16_t Tail;     /*!< Free-running read index, modified by @ref USBD_TraceRead only */
+    volatile uint16_t Frame;    /*!< Number of started (micro)frames */
+    uint16_t Dropped;           /*!< Number of entries lost due to insufficient space */
+    uint32_t Ignore;            /*!< Endpoints excluded from the trace, bit 0..15 for OUT,
+                                     bit 16..31 for IN endpoints */
+}USBD_TraceType;
+#endif /* (USBD_TRACE_SUPPORT == 1) */
+
+
 /** @brief USB Device handle structure */
 typedef struct _USBD_HandleType
 {
     const USBD_DescriptionType *Desc;       /*!< Reference of the device description */
-    USB_SetupRequestType Setup;             /*!< Setup request is stored */
+#if (USBD_DEFERRED_PROCESSING == 1)
+    USB_SetupRequestType Setup;             /*!< Setup request is stored by the PD */
+    USB_SetupRequestType Request;           /*!< Setup request under handling, copied from
+                                                 the event queue, as the PD can overwrite Setup */
+#else
+    union {
+    USB_SetupRequestType Setup;             /*!< Setup request is stored by the PD */
+    USB_SetupRequestType Request;           /*!< Setup request under handling */
+    };
+#endif
 
 #ifdef USBD_PD_DEV_FIELDS
     USBD_PD_DEV_FIELDS;                     /*!< Peripheral Driver specific device context */
@@ -279,9 +689,46 @@ typedef struct _USBD_HandleType
     struct {
         USBD_EpHandleType IN [USBD_MAX_EP_COUNT];   /*!< IN endpoint status */
         USBD_EpHandleType OUT[USBD_MAX_EP_COUNT];   /*!< OUT endpoint status */
+#if (USBD_EP_VECTOR_SUPPORT == 1)
+        USBD_EpVectorType Vector[USBD_MAX_EP_COUNT];/*!< IN endpoint vectored transfers */
+#endif
     }EP;                                            /*!< Endpoint management */
 
     uint8_t CtrlData[USBD_EP0_BUFFER_SIZE]; /*!< Control EP buffer for common use */
+
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    struct {
+        USBD_CtrlChunkCbkType Callback;     /*!< Chunk provider or consumer, NULL if not chunked */
+        void *Context;                      /*!< Context of the callback */
+        uint16_t Offset;                    /*!< Length of the already transferred chunks */
+        uint16_t Length;                    /*!< Total length of the data stage */
+    }CtrlChunk;                             /*!< Chunked control data stage context */
+#endif
+
+#if (USBD_SERIAL_BCD_SIZE > 0)
+    uint8_t SerialDesc[USBD_SERIAL_BCD_SIZE * 4 + 2]; /*!< Serial number string descriptor */
+#endif
+
+#if (USBD_CONFIG_DESC_CACHE == 1)
+    struct {
+        uint8_t  Data[USBD_HS_SUPPORT + 1][USBD_EP0_BUFFER_SIZE]; /*!< Assembled descriptors
+                                                                       of full and high speed */
+        uint16_t Length[USBD_HS_SUPPORT + 1];  /*!< Descriptor lengths, 0 if not assembled yet */
+        uint8_t  IfCount;                       /*!< Number of interfaces at the assembly */
+    }ConfigDesc;                                /*!< Configuration descriptor cache */
+#endif
+
+#if (USBD_DEFERRED_PROCESSING == 1)
+    USBD_EventQueueType Events;             /*!< Events pending for processing */
+#endif
+
+#if (USBD_STATS_SUPPORT == 1)
+    USBD_ProfileType Profile[USBD_PROFILE_COUNT]; /*!< Callback duration profiles */
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+    USBD_TraceType Trace;                   /*!< Event trace */
+#endif
 }USBD_HandleType;
 
 /** @} */
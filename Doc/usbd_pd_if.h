@@ -80,6 +80,12 @@ extern void USBD_PD_SetAddress(USBD_HandleType * dev, uint8_t addr);
 
 /**
  * @brief Opens a device endpoint.
+ * @note  The requested @ref USBD_EpOptionType flags are available in the
+ *        endpoint handle's Options field.
+ * @note  High speed periodic endpoints can have additional transactions
+ *        per microframe set in the endpoint handle's Transactions field.
+ *        The peripheral has to schedule (Transactions + 1) packets of mps size
+ *        in each interval, e.g. by the multi count setting of the OTG HS core.
  * @param dev: USB Device handle reference
  * @param addr: endpoint address
  * @param type: endpoint type
@@ -88,6 +94,17 @@ extern void USBD_PD_SetAddress(USBD_HandleType * dev, uint8_t addr);
 extern void USBD_PD_EpOpen      (USBD_HandleType * dev, uint8_t addr,
                                  USB_EndPointType type,uint16_t mps);
 
+/**
+ * @brief Optional: lays out the peripheral's endpoint buffers for a configuration.
+ *        It is called when the device configuration changes,
+ *        before the interfaces open their endpoints.
+ * @param dev: USB Device handle reference
+ * @param desc: the configuration descriptor, or NULL when unconfigured
+ * @param len: the length of the configuration descriptor
+ */
+extern void USBD_PD_EpPlan      (USBD_HandleType * dev, const uint8_t* desc,
+                                 uint16_t len);
+
 /**
  * @brief Closes a device endpoint.
  * @param dev: USB Device handle reference
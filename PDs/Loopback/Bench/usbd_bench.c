@@ -0,0 +1,1763 @@
+/**
+  ******************************************************************************
+  * @file    usbd_bench.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB Device class benchmark on the host loopback peripheral driver
+  *
+  * @details
+  * The benchmark mounts an MSC (RAM disk), a CDC and a HID interface on one
+  * device, a UAC speaker, an NCM network function, a VND bulk function and
+  * a DFU (bootloader mode) interface on others,
+  * enumerates them through the loopback PD and drives their transfers end to end:
+  *  - MSC sequential and random READ(10) / WRITE(10) commands, the
+  *    write-back of the LU cache requested by BOT reset (USBD_MSC_CACHE_LINES),
+  *    and overlapping UAS commands on an asynchronous LU (USBD_MSC_UAS_SUPPORT)
+  *  - CDC bulk OUT and IN streaming, and OUT messages ending with a short packet
+  *    received to class-owned buffers (USBD_CDC_RX_BUFFER_COUNT)
+  *  - HID input report round trips, and feature reports longer than
+  *    the control endpoint buffer (USBD_CTRL_CHUNK_SUPPORT)
+  *  - UAC isochronous OUT streaming, with the explicit feedback checked
+  *    against the known sample clock of the speaker
+  *  - NCM IN datagrams, with the aggregation timeout checked in (micro)frames
+  *  - VND bulk OUT and IN streaming through the endpoint request queues
+  *    (USBD_EP_QUEUE_SUPPORT), and the continuation of the queues
+  *    when the host clears the endpoint halt
+  *  - link suspend and resume, with the recorded events read back from
+  *    the device trace (USBD_TRACE_SUPPORT)
+  *  - DFU firmware download with digest verification
+  * Each test reports the throughput [MB/s], the rate of its transfers
+  * (commands, bulk transfers, reports or firmware blocks) [1/s] and the
+  * percentiles of the transfers' latency [us]. When USBD_STATS_SUPPORT is set,
+  * the callback durations profiled by the device stack are listed after each test.
+  * The results measure the processing cost of the stack on the host CPU,
+  * the bus timing isn't simulated.
+  *
+  * It's built from the repository root by:
+  *     @code
+  *     gcc -O2 -no-pie -IPDs/Loopback/Bench -IPDs/Loopback -IDevice \
+  *         -IClass/MSC -IClass/CDC -IClass/HID -IClass/UAC -IClass/NCM \
+  *         -IClass/VND -IClass/DFU Device/Src/usbd*.c Class/MSC/Src/usbd*.c \
+  *         Class/CDC/Src/usbd*.c Class/HID/Src/usbd*.c Class/UAC/Src/usbd*.c \
+  *         Class/NCM/Src/usbd*.c Class/VND/Src/usbd*.c Class/DFU/Src/usbd*.c \
+  *         PDs/Loopback/Src/usbd_pd_loopback.c PDs/Loopback/Bench/usbd_bench.c \
+  *         -o usbd_bench
+  *     ./usbd_bench [MiB per test]
+  *     @endcode
+  * Other build configurations are benchmarked by overriding the options of the
+  * usbd_config.h next to this file, e.g. -DUSBD_DEFERRED_PROCESSING=1,
+  * -DUSBD_HS_SUPPORT=0, -DUSBD_MSC_BUFFER_COUNT=2, -DUSBD_DFU_ASYNC_PROGRAM=1,
+  * or -DBENCH_MSC_DIRECT=1 to access the RAM disk without copying.
+  * The VND sources are left out when building with -DUSBD_EP_QUEUE_SUPPORT=0.
+  * The DFU firmware address is 32 bits wide, hence the -no-pie linking.
+  * The program returns non-zero if any transfer fails.
+  *
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd.h>
+#include <usbd_pd_if.h>
+#include <usbd_msc.h>
+#include <usbd_cdc.h>
+#include <usbd_hid.h>
+#include <usbd_uac.h>
+#include <usbd_ncm.h>
+#include <usbd_dfu.h>
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+#include <usbd_vnd.h>
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+/** @defgroup usbd_bench USB Device class benchmark
+ * @{ */
+
+/* Serve the MSC transfers directly from the RAM disk */
+#ifndef BENCH_MSC_DIRECT
+#define BENCH_MSC_DIRECT            0
+#endif
+
+#define BENCH_BLOCK_SIZE            512
+#define BENCH_DISK_BLOCKS           8192
+#define BENCH_SEQ_BLOCKS            128     /* 64 kB per sequential command */
+#define BENCH_RANDOM_BLOCKS         8       /* 4 kB per random command */
+#define BENCH_CDC_SIZE              4096
+#define BENCH_CDC_RX_SHORT          17      /* The short packet of the buffered messages */
+#define BENCH_HID_SIZE              64
+#define BENCH_HID_FEATURE_SIZE      1024    /* Longer than the control endpoint buffer */
+#define BENCH_UAC_RATE              48000   /* The nominal sampling frequency */
+#define BENCH_UAC_CLOCK             47990   /* The sample consumption rate of the speaker */
+#define BENCH_NCM_SIZE              1514
+#define BENCH_VND_SIZE              4096
+#define BENCH_LINK_CYCLES           4096    /* Suspend and resume cycles per MiB */
+#define BENCH_DFU_BLOCK_SIZE        2048
+#define BENCH_DFU_ERASE_SIZE        4096
+#define BENCH_FLASH_SIZE            (256 * 1024)
+#define BENCH_MAX_SAMPLES           (1 << 20)
+
+#define BENCH_SCSI_READ10           0x28
+#define BENCH_SCSI_WRITE10          0x2A
+#define BENCH_CBW_SIGNATURE         0x43425355
+#define BENCH_CSW_SIGNATURE         0x53425355
+#define BENCH_CBW_SIZE              31
+#define BENCH_CSW_SIZE              13
+#define BENCH_UAS_IU_COMMAND        0x01
+#define BENCH_UAS_IU_SENSE          0x03
+#define BENCH_UAS_IU_READ_READY     0x06
+#define BENCH_UAS_IU_WRITE_READY    0x07
+#define BENCH_UAS_POLLS             4096    /* Host polling rounds per command pair */
+
+#define BENCH_REQ_TYPE(DIR, TYPE, RECIPIENT) \
+    (((DIR) << 7) | ((TYPE) << 5) | (RECIPIENT))
+
+static uint8_t  bench_disk[BENCH_DISK_BLOCKS * BENCH_BLOCK_SIZE] __align(USBD_DATA_ALIGNMENT);
+static uint8_t  bench_data[BENCH_SEQ_BLOCKS * BENCH_BLOCK_SIZE] __align(USBD_DATA_ALIGNMENT);
+static uint8_t  bench_flash[BENCH_FLASH_SIZE] __align(USBD_DATA_ALIGNMENT);
+static uint8_t  bench_image[BENCH_FLASH_SIZE - BENCH_DFU_ERASE_SIZE];
+static uint8_t  bench_dfuBuffer[2 * BENCH_DFU_BLOCK_SIZE] __align(USBD_DATA_ALIGNMENT);
+static uint8_t  bench_cdcRx[BENCH_CDC_SIZE] __align(USBD_DATA_ALIGNMENT);
+static uint8_t  bench_report[BENCH_HID_SIZE] __align(USBD_DATA_ALIGNMENT);
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+static uint8_t  bench_feature[BENCH_HID_FEATURE_SIZE];
+#endif
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+static uint8_t  bench_vndRx[USBD_VND_QUEUE_SIZE][BENCH_VND_SIZE] __align(USBD_DATA_ALIGNMENT);
+#endif
+
+static uint32_t bench_samples[BENCH_MAX_SAMPLES];
+static uint32_t bench_sampleCount;
+static uint32_t bench_failures;
+static uint32_t bench_random = 0x2545F491;
+static uint32_t bench_tag;
+#if (USBD_MSC_UAS_SUPPORT == 1)
+static uint8_t  bench_diskAsync;
+static struct {
+    uint8_t *Data;
+    uint32_t BlockAddr;
+    uint16_t BlockLen;
+    uint8_t  Write;
+    uint8_t  Pending;
+}bench_diskAccess;
+#endif
+static uint64_t bench_cdcReceived;
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+static uint8_t *bench_cdcRxData[USBD_CDC_RX_BUFFER_COUNT];
+static uint16_t bench_cdcRxLength[USBD_CDC_RX_BUFFER_COUNT];
+static uint8_t  bench_cdcRxCount;
+#endif
+static uint64_t bench_uacReceived;
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+static uint64_t bench_vndReceived;
+static uint64_t bench_vndTransmitted;
+#endif
+static uint32_t bench_frames;
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+static uint8_t  bench_dfuPending;
+#endif
+
+/**
+ * @brief Reads the monotonic clock.
+ * @return The current time [ns]
+ */
+static uint64_t bench_ns(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((uint64_t)ts.tv_sec * 1000000000) + ts.tv_nsec;
+}
+
+/**
+ * @brief Provides the timestamps of the device stack's profiles and trace.
+ * @return The current time [ns]
+ */
+uint32_t bench_clock(void)
+{
+    return (uint32_t)bench_ns();
+}
+
+/**
+ * @brief Generates the random block addresses.
+ * @return The next pseudo-random number (xorshift32)
+ */
+static uint32_t bench_rand(void)
+{
+    bench_random ^= bench_random << 13;
+    bench_random ^= bench_random >> 17;
+    bench_random ^= bench_random << 5;
+    return bench_random;
+}
+
+/* MSC RAM disk ***************************************************************/
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+/**
+ * @brief Accepts the block access for later completion by @ref bench_diskComplete.
+ * @return BUSY
+ */
+static uint8_t bench_diskDefer(uint8_t *data, uint32_t blockAddr, uint16_t blockLen, uint8_t write)
+{
+    bench_diskAccess.Data      = data;
+    bench_diskAccess.BlockAddr = blockAddr;
+    bench_diskAccess.BlockLen  = blockLen;
+    bench_diskAccess.Write     = write;
+    bench_diskAccess.Pending   = 1;
+    return USBD_E_BUSY;
+}
+#endif
+
+static uint8_t bench_diskRead(uint8_t *dest, uint32_t blockAddr, uint16_t blockLen)
+{
+    uint8_t retval = USBD_E_OK;
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    if (bench_diskAsync != 0)
+    {
+        retval = bench_diskDefer(dest, blockAddr, blockLen, 0);
+    }
+    else
+#endif
+    {
+        memcpy(dest, &bench_disk[blockAddr * BENCH_BLOCK_SIZE], blockLen * BENCH_BLOCK_SIZE);
+    }
+    return retval;
+}
+
+static uint8_t bench_diskWrite(uint8_t *src, uint32_t blockAddr, uint16_t blockLen)
+{
+    uint8_t retval = USBD_E_OK;
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    if (bench_diskAsync != 0)
+    {
+        retval = bench_diskDefer(src, blockAddr, blockLen, 1);
+    }
+    else
+#endif
+    {
+        memcpy(&bench_disk[blockAddr * BENCH_BLOCK_SIZE], src, blockLen * BENCH_BLOCK_SIZE);
+    }
+    return retval;
+}
+
+#if (BENCH_MSC_DIRECT == 1)
+static uint8_t* bench_diskGetBlock(uint32_t blockAddr, uint16_t blockLen, uint8_t write)
+{
+    (void)blockLen;
+    (void)write;
+    return &bench_disk[blockAddr * BENCH_BLOCK_SIZE];
+}
+#endif
+
+static const USBD_SCSI_StdInquiryType bench_inquiry = {
+    .PeriphType     = SCSI_PERIPH_SBC_2,
+    .Version        = 2,
+    .RespDataFormat = 2,
+    .AddLength      = sizeof(USBD_SCSI_StdInquiryType) - 4,
+    .VendorId       = "USBD    ",
+    .ProductId      = "Loopback RAMdisk",
+    .VersionId      = "0.1 ",
+};
+
+static USBD_MSC_LUStatusType bench_diskStatus = {
+    .BlockCount = BENCH_DISK_BLOCKS,
+    .BlockSize  = BENCH_BLOCK_SIZE,
+    .Ready      = 1,
+    .Writable   = 1,
+};
+
+#if (USBD_MSC_CACHE_LINES > 0)
+static USBD_MSC_CacheType bench_diskCache;
+#endif
+
+static const USBD_MSC_LUType bench_lu = {
+    .Read       = bench_diskRead,
+    .Write      = bench_diskWrite,
+#if (BENCH_MSC_DIRECT == 1)
+    .GetBlock   = bench_diskGetBlock,
+#endif
+    .Inquiry    = &bench_inquiry,
+    .Status     = &bench_diskStatus,
+#if (USBD_MSC_CACHE_LINES > 0)
+    .Cache      = &bench_diskCache,
+#endif
+};
+
+static USBD_MSC_IfHandleType bench_msc = {
+    .LUs = &bench_lu,
+    .Config.InEpNum  = 0x81,
+    .Config.OutEpNum = 0x01,
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    .Config.CmdEpNum    = 0x05,
+    .Config.StatusEpNum = 0x85,
+#endif
+    .Config.MaxLUN   = 0,
+};
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+/**
+ * @brief Performs the accepted block access, and notifies the MSC interface.
+ * @return Non-zero if an access has been completed
+ */
+static int bench_diskComplete(void)
+{
+    int pending = bench_diskAccess.Pending;
+
+    if (pending != 0)
+    {
+        uint8_t *block = &bench_disk[bench_diskAccess.BlockAddr * BENCH_BLOCK_SIZE];
+        uint32_t len = bench_diskAccess.BlockLen * BENCH_BLOCK_SIZE;
+
+        /* The notification may start the next access */
+        bench_diskAccess.Pending = 0;
+
+        if (bench_diskAccess.Write != 0)
+        {   memcpy(block, bench_diskAccess.Data, len); }
+        else
+        {   memcpy(bench_diskAccess.Data, block, len); }
+
+        USBD_MSC_LUComplete(&bench_msc, USBD_E_OK);
+    }
+    return pending;
+}
+#endif
+
+/* CDC bulk stream ************************************************************/
+
+static USBD_CDC_IfHandleType bench_cdc;
+
+static void bench_cdcInit(void)
+{
+    bench_cdcReceived = 0;
+    USBD_CDC_Receive(&bench_cdc, bench_cdcRx, sizeof(bench_cdcRx));
+}
+
+static void bench_cdcControl(USB_SetupRequestType *req, uint8_t *data)
+{
+    (void)req;
+    (void)data;
+}
+
+static void bench_cdcReceivedCbk(uint8_t *data, uint16_t length)
+{
+    (void)data;
+    bench_cdcReceived += length;
+    USBD_CDC_Receive(&bench_cdc, bench_cdcRx, sizeof(bench_cdcRx));
+}
+
+static const USBD_CDC_AppType bench_cdcApp = {
+    .Name       = "Loopback bulk stream",
+    .Init       = bench_cdcInit,
+    .Control    = bench_cdcControl,
+    .Received   = bench_cdcReceivedCbk,
+};
+
+static USBD_CDC_IfHandleType bench_cdc = {
+    .App = &bench_cdcApp,
+    .Base.AltCount = 1,
+    .Config.Protocol = 0xFF,
+    .Config.InEpNum  = 0x82,
+    .Config.OutEpNum = 0x02,
+    .Config.NotEpNum = 0x83,
+};
+
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+/* CDC reception buffers ******************************************************/
+
+static USBD_CDC_IfHandleType bench_cdcBuf;
+static USBD_CDC_RxBuffersType bench_cdcRxBuffers;
+
+/* The receptions are held until the test checks them */
+static void bench_cdcBufReceivedCbk(uint8_t *data, uint16_t length)
+{
+    if (bench_cdcRxCount < USBD_CDC_RX_BUFFER_COUNT)
+    {
+        bench_cdcRxData[bench_cdcRxCount] = data;
+        bench_cdcRxLength[bench_cdcRxCount] = length;
+    }
+    bench_cdcRxCount++;
+}
+
+static const USBD_CDC_AppType bench_cdcBufApp = {
+    .Name       = "Loopback buffered reception",
+    .Control    = bench_cdcControl,
+    .Received   = bench_cdcBufReceivedCbk,
+};
+
+static USBD_CDC_IfHandleType bench_cdcBuf = {
+    .App = &bench_cdcBufApp,
+    .Base.AltCount = 1,
+    .Config.Protocol = 0xFF,
+    .Config.InEpNum  = 0x81,
+    .Config.OutEpNum = 0x01,
+    .Config.NotEpNum = 0x82,
+    .RxBuffers = &bench_cdcRxBuffers,
+};
+#endif /* (USBD_CDC_RX_BUFFER_COUNT > 1) */
+
+/* HID input reports **********************************************************/
+
+static const uint8_t bench_reportDesc[] = {
+    0x06, 0x00, 0xFF,   /* Usage Page (Vendor Defined 0xFF00) */
+    0x09, 0x01,         /* Usage (0x01) */
+    0xA1, 0x01,         /* Collection (Application) */
+    0x15, 0x00,         /*   Logical Minimum (0) */
+    0x26, 0xFF, 0x00,   /*   Logical Maximum (255) */
+    0x75, 0x08,         /*   Report Size (8) */
+    0x95, BENCH_HID_SIZE, /* Report Count */
+    0x09, 0x01,         /*   Usage (0x01) */
+    0x81, 0x02,         /*   Input (Data, Variable, Absolute) */
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    0x96, (uint8_t)BENCH_HID_FEATURE_SIZE, BENCH_HID_FEATURE_SIZE >> 8, /* Report Count */
+    0x09, 0x02,         /*   Usage (0x02) */
+    0xB1, 0x02,         /*   Feature (Data, Variable, Absolute) */
+#endif
+    0xC0,               /* End Collection */
+};
+
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+/**
+ * @brief Stores a chunk of the received feature report.
+ * @param reportId: the report ID
+ * @param data: the chunk
+ * @param offset: the offset of the chunk in the report
+ * @param length: the length of the chunk
+ * @return The accepted length
+ */
+static uint16_t bench_hidSetFeature(uint8_t reportId, uint8_t *data,
+        uint16_t offset, uint16_t length)
+{
+    if ((reportId != 0) || ((offset + length) > BENCH_HID_FEATURE_SIZE))
+    {   length = 0; }
+
+    memcpy(&bench_feature[offset], data, length);
+    return length;
+}
+
+/**
+ * @brief Provides a chunk of the requested feature report.
+ * @param reportId: the report ID
+ * @param data: the chunk to fill
+ * @param offset: the offset of the chunk in the report
+ * @param length: the length of the chunk
+ * @return The provided length
+ */
+static uint16_t bench_hidGetFeature(uint8_t reportId, uint8_t *data,
+        uint16_t offset, uint16_t length)
+{
+    if (reportId != 0)
+    {   length = 0; }
+    else if ((offset + length) > BENCH_HID_FEATURE_SIZE)
+    {   length = BENCH_HID_FEATURE_SIZE - offset; }
+
+    memcpy(data, &bench_feature[offset], length);
+    return length;
+}
+#endif /* (USBD_CTRL_CHUNK_SUPPORT == 1) */
+
+static const USBD_HID_AppType bench_hidApp = {
+    .Name = "Loopback input reports",
+    .Report.Desc   = bench_reportDesc,
+    .Report.Length = sizeof(bench_reportDesc),
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    .SetReportChunk = bench_hidSetFeature,
+    .GetReportChunk = bench_hidGetFeature,
+#endif
+};
+
+static USBD_HID_IfHandleType bench_hid = {
+    .App = &bench_hidApp,
+    .Base.AltCount = 1,
+    .Config.InEp.Num      = 0x84,
+    .Config.InEp.Interval = 1,
+    .Config.InEp.Size     = BENCH_HID_SIZE,
+};
+
+/* UAC speaker ****************************************************************/
+
+static USBD_UAC_IfHandleType bench_uac;
+
+/**
+ * @brief Provides the audio frames consumed by the speaker, which follows its own
+ *        clock of BENCH_UAC_CLOCK instead of the nominal sampling frequency.
+ * @return The free-running sample clock
+ */
+static uint32_t bench_uacClock(void)
+{
+    USBD_HandleType *dev = bench_uac.Base.Device;
+    uint32_t frameRate = (dev->Speed == USB_SPEED_HIGH) ? 8000 : 1000;
+
+    return ((uint64_t)bench_frames * BENCH_UAC_CLOCK) / frameRate;
+}
+
+static void bench_uacReceivedCbk(uint8_t *data, uint16_t length)
+{
+    (void)data;
+    bench_uacReceived += length;
+}
+
+static const USBD_UAC_AppType bench_uacApp = {
+    .Name        = "Loopback speaker",
+    .Received    = bench_uacReceivedCbk,
+    .SampleClock = bench_uacClock,
+};
+
+static USBD_UAC_IfHandleType bench_uac = {
+    .App = &bench_uacApp,
+    .Config.DataEpNum     = 0x01,
+    .Config.FeedbackEpNum = 0x81,
+    .Config.Channels      = 2,
+    .Config.SubframeSize  = 2,
+    .Config.BitResolution = 16,
+    .Config.TerminalType  = UAC_TERMINAL_SPEAKER,
+    .Config.SampleRate    = BENCH_UAC_RATE,
+};
+
+/* NCM network function *****************************************************/
+
+static USBD_NCM_IfHandleType bench_ncm;
+
+static void bench_ncmReceivedCbk(uint8_t *data, uint16_t length)
+{
+    (void)length;
+    USBD_NCM_ReceiveRelease(&bench_ncm, data);
+}
+
+static const USBD_NCM_AppType bench_ncmApp = {
+    .Name     = "Loopback network",
+    .Received = bench_ncmReceivedCbk,
+};
+
+static USBD_NCM_IfHandleType bench_ncm = {
+    .App = &bench_ncmApp,
+    .Config.InEpNum  = 0x81,
+    .Config.OutEpNum = 0x01,
+    .Config.NotEpNum = 0x82,
+    .Config.MacAddress = { 0x02, 0x00, 0x00, 0x00, 0x00, 0x01 },
+};
+
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+/* VND bulk function **********************************************************/
+
+static USBD_VND_IfHandleType bench_vnd;
+
+/* Each OUT transfer of the pipe has its own buffer in the queue */
+static void bench_vndInit(void)
+{
+    uint8_t i;
+
+    for (i = 0; i < USBD_VND_QUEUE_SIZE; i++)
+    {
+        USBD_VND_Receive(&bench_vnd, 0, bench_vndRx[i], BENCH_VND_SIZE);
+    }
+}
+
+static void bench_vndReceivedCbk(uint8_t pipe, uint8_t *data, uint16_t length)
+{
+    bench_vndReceived += length;
+    USBD_VND_Receive(&bench_vnd, pipe, data, BENCH_VND_SIZE);
+}
+
+static void bench_vndTransmittedCbk(uint8_t pipe, uint8_t *data, uint16_t length)
+{
+    (void)pipe;
+    (void)data;
+    bench_vndTransmitted += length;
+}
+
+static const USBD_VND_AppType bench_vndApp = {
+    .Name        = "Loopback vendor bulk",
+    .Init        = bench_vndInit,
+    .Received    = bench_vndReceivedCbk,
+    .Transmitted = bench_vndTransmittedCbk,
+};
+
+static USBD_VND_IfHandleType bench_vnd = {
+    .App = &bench_vndApp,
+    .Config.OutCount    = 1,
+    .Config.InCount     = 1,
+    .Config.OutEpNum[0] = 0x01,
+    .Config.InEpNum[0]  = 0x81,
+};
+#endif /* (USBD_EP_QUEUE_SUPPORT == 1) */
+
+/* DFU RAM flash **************************************************************/
+
+static USBD_DFU_IfHandleType bench_dfu;
+
+static USBD_DFU_StatusType bench_flashErase(uint8_t *addr)
+{
+    memset(addr, 0xFF, BENCH_DFU_ERASE_SIZE);
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+    bench_dfuPending = 1;
+#endif
+    return DFU_ERROR_NONE;
+}
+
+static USBD_DFU_StatusType bench_flashWrite(uint8_t *addr, uint8_t *data, uint32_t len)
+{
+    memcpy(addr, data, len);
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+    bench_dfuPending = 1;
+#endif
+    return DFU_ERROR_NONE;
+}
+
+static uint32_t bench_flashDigest(uint32_t digest, const uint8_t *data, uint32_t len)
+{
+    uint32_t i;
+
+    /* FNV-1a */
+    for (i = 0; i < len; i++)
+    {
+        digest = (digest ^ data[i]) * 16777619;
+    }
+    return digest;
+}
+
+static void bench_reboot(void)
+{
+}
+
+static const USBD_DFU_AppType bench_dfuApp = {
+    .Name   = "Loopback RAM flash",
+    .Erase  = bench_flashErase,
+    .Write  = bench_flashWrite,
+    .Digest = bench_flashDigest,
+    .Firmware.TotalSize = sizeof(bench_flash),
+    .Firmware.EraseSize = BENCH_DFU_ERASE_SIZE,
+    .Firmware.MemoryMapped = 1,
+};
+
+static USBD_DFU_AppType bench_dfuAppRam;
+
+/* Devices ********************************************************************/
+
+static const USBD_DescriptionType bench_desc = {
+    .Vendor = {
+        .Name           = "USBDevice",
+        .ID             = 0x1209,
+    },
+    .Product = {
+        .Name           = "Loopback benchmark",
+        .ID             = 0x0001,
+        .Version.bcd    = 0x0100,
+    },
+    .Config = {
+        .Name           = "Loopback benchmark configuration",
+        .MaxCurrent_mA  = 100,
+        .RemoteWakeup   = 0,
+        .SelfPowered    = 1,
+    },
+};
+
+static USBD_HandleType bench_dev, bench_uacDev, bench_ncmDev, bench_dfuDev;
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+static USBD_HandleType bench_vndDev;
+#endif
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+static USBD_HandleType bench_cdcBufDev;
+#endif
+
+/* Measurement ****************************************************************/
+
+static int bench_compare(const void *a, const void *b)
+{
+    uint32_t x = *(const uint32_t*)a, y = *(const uint32_t*)b;
+
+    return (x > y) - (x < y);
+}
+
+/**
+ * @brief Starts a test by clearing the latency samples and the stack's statistics.
+ * @param dev: the device under test
+ * @return The start time [ns]
+ */
+static uint64_t bench_begin(USBD_HandleType *dev)
+{
+    bench_sampleCount = 0;
+#if (USBD_STATS_SUPPORT == 1)
+    USBD_StatsReset(dev);
+#else
+    (void)dev;
+#endif
+    return bench_ns();
+}
+
+/**
+ * @brief Records the latency of a transfer.
+ * @param start: the start time of the transfer [ns]
+ * @param result: zero if the transfer was successful
+ */
+static void bench_sample(uint64_t start, int result)
+{
+    bench_samples[bench_sampleCount % BENCH_MAX_SAMPLES] = bench_ns() - start;
+    bench_sampleCount++;
+
+    if (result != 0)
+    {   bench_failures++; }
+}
+
+static double bench_percentile(uint32_t count, uint32_t permille)
+{
+    return bench_samples[((count - 1) * (uint64_t)permille) / 1000] / 1000.0;
+}
+
+#if (USBD_STATS_SUPPORT == 1)
+/**
+ * @brief Estimates a percentile of a profile by the upper bound of its histogram bin.
+ * @param profile: the callback profile
+ * @param permille: the percentile [1/1000]
+ * @return The duration [ns]
+ */
+static uint32_t bench_profilePercentile(const USBD_ProfileType *profile, uint32_t permille)
+{
+    uint64_t rank = ((uint64_t)profile->Count * permille + 999) / 1000;
+    uint64_t sum = 0;
+    uint32_t bound = profile->Max;
+    uint8_t bin;
+
+    for (bin = 0; bin < (USBD_STATS_HISTOGRAM_SIZE - 1); bin++)
+    {
+        sum += profile->Histogram[bin];
+        if (sum >= rank)
+        {
+            bound = (uint32_t)USBD_STATS_HISTOGRAM_BASE << bin;
+            break;
+        }
+    }
+    if (bound > profile->Max)
+    {   bound = profile->Max; }
+    return bound;
+}
+
+/**
+ * @brief Lists the callback durations profiled by the device stack.
+ * @param dev: the device under test
+ */
+static void bench_profiles(USBD_HandleType *dev)
+{
+    static const char *const names[USBD_PROFILE_COUNT] = {
+        "setup", "ep in", "ep out", "class setup",
+        "class data", "class in", "class out", "class sof",
+    };
+    static USBD_StatsType stats;
+    uint8_t i;
+
+    USBD_StatsGet(dev, &stats);
+
+    for (i = 0; i < USBD_PROFILE_COUNT; i++)
+    {
+        const USBD_ProfileType *profile = &stats.Profile[i];
+
+        if (profile->Count > 0)
+        {
+            printf("    %-14s %9u calls %7u min %7u p50 %7u p99 %7u max [ns]\n",
+                    names[i], profile->Count, profile->Min,
+                    bench_profilePercentile(profile, 500),
+                    bench_profilePercentile(profile, 990),
+                    profile->Max);
+        }
+    }
+}
+#endif /* (USBD_STATS_SUPPORT == 1) */
+
+/**
+ * @brief Reports the results of a test.
+ * @param dev: the device under test
+ * @param name: the test name
+ * @param start: the start time of the test [ns]
+ * @param bytes: the transferred payload
+ */
+static void bench_end(USBD_HandleType *dev, const char *name, uint64_t start, uint64_t bytes)
+{
+    double elapsed = (bench_ns() - start) / 1e9;
+    uint32_t count = bench_sampleCount;
+
+    if (count > BENCH_MAX_SAMPLES)
+    {   count = BENCH_MAX_SAMPLES; }
+
+    if (count > 0)
+    {
+        qsort(bench_samples, count, sizeof(bench_samples[0]), bench_compare);
+
+        printf("%-18s %9.2f %11.0f %9.2f %9.2f %9.2f %9.2f\n", name,
+                bytes / elapsed / 1e6, bench_sampleCount / elapsed,
+                bench_percentile(count, 500), bench_percentile(count, 900),
+                bench_percentile(count, 990), bench_samples[count - 1] / 1000.0);
+    }
+#if (USBD_STATS_SUPPORT == 1)
+    bench_profiles(dev);
+#else
+    (void)dev;
+#endif
+}
+
+/* Host ***********************************************************************/
+
+/**
+ * @brief Performs a control transfer.
+ * @return The length of the data stage, negative if failed
+ */
+static int bench_control(USBD_HandleType *dev, uint8_t type, uint8_t request,
+        uint16_t value, uint16_t index, uint8_t *data, uint16_t len)
+{
+    USB_SetupRequestType setup;
+
+    setup.RequestType.b = type;
+    setup.Request = request;
+    setup.Value   = value;
+    setup.Index   = index;
+    setup.Length  = len;
+
+    return USBD_PD_LoopbackControl(dev, &setup, data);
+}
+
+/**
+ * @brief Enumerates the device: reads its descriptors, sets its address and configuration.
+ * @param dev: the device
+ * @param address: the assigned address
+ * @return Zero if successful
+ */
+static int bench_enumerate(USBD_HandleType *dev, uint8_t address)
+{
+    static uint8_t desc[USBD_EP0_BUFFER_SIZE];
+    uint8_t in  = BENCH_REQ_TYPE(USB_DIRECTION_IN,  USB_REQ_TYPE_STANDARD, USB_REQ_RECIPIENT_DEVICE);
+    uint8_t out = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_STANDARD, USB_REQ_RECIPIENT_DEVICE);
+    uint16_t total;
+    int result = 0;
+
+    USBD_PD_LoopbackReset(dev, (USBD_HS_SUPPORT == 1) ? USB_SPEED_HIGH : USB_SPEED_FULL);
+
+    result |= (bench_control(dev, in, USB_REQ_GET_DESCRIPTOR,
+            USB_DESC_TYPE_DEVICE << 8, 0, desc, 18) != 18);
+    result |= (bench_control(dev, out, USB_REQ_SET_ADDRESS, address, 0, NULL, 0) != 0);
+    result |= (dev->Address != address);
+
+    result |= (bench_control(dev, in, USB_REQ_GET_DESCRIPTOR,
+            USB_DESC_TYPE_CONFIGURATION << 8, 0, desc, 9) != 9);
+    total = desc[2] | (desc[3] << 8);
+    if (total > sizeof(desc))
+    {   total = sizeof(desc); }
+    result |= (bench_control(dev, in, USB_REQ_GET_DESCRIPTOR,
+            USB_DESC_TYPE_CONFIGURATION << 8, 0, desc, total) != total);
+
+    result |= (bench_control(dev, out, USB_REQ_SET_CONFIGURATION, 1, 0, NULL, 0) != 0);
+
+    return result;
+}
+
+/**
+ * @brief Sets up the command descriptor block of a READ(10) or WRITE(10) command.
+ * @param cb: the command descriptor block
+ * @param opcode: the SCSI operation code
+ * @param blockAddr: the first block address
+ * @param blocks: the number of blocks
+ */
+static void bench_scsiBlockCommand(uint8_t *cb, uint8_t opcode, uint32_t blockAddr, uint16_t blocks)
+{
+    cb[0] = opcode;
+    cb[2] = blockAddr >> 24;
+    cb[3] = blockAddr >> 16;
+    cb[4] = blockAddr >> 8;
+    cb[5] = blockAddr;
+    cb[7] = blocks >> 8;
+    cb[8] = blocks;
+}
+
+/**
+ * @brief Performs an MSC Bulk-Only Transport READ(10) or WRITE(10) command.
+ * @param opcode: the SCSI operation code
+ * @param blockAddr: the first block address
+ * @param blocks: the number of blocks
+ * @return Zero if successful
+ */
+static int bench_mscCommand(uint8_t opcode, uint32_t blockAddr, uint16_t blocks)
+{
+    USBD_MSC_CommandBlockWrapperType cbw;
+    USBD_MSC_CommandStatusWrapperType csw;
+    uint32_t len = blocks * BENCH_BLOCK_SIZE;
+    int result = 0;
+
+    memset(&cbw, 0, sizeof(cbw));
+    cbw.dSignature  = BENCH_CBW_SIGNATURE;
+    cbw.dTag        = ++bench_tag;
+    cbw.dDataLength = len;
+    cbw.bmFlags     = (opcode == BENCH_SCSI_READ10) ? 0x80 : 0x00;
+    cbw.bCBLength   = 10;
+    bench_scsiBlockCommand(cbw.CB, opcode, blockAddr, blocks);
+
+    result |= (USBD_PD_LoopbackOut(&bench_dev, bench_msc.Config.OutEpNum,
+            (const uint8_t*)&cbw, BENCH_CBW_SIZE) != BENCH_CBW_SIZE);
+
+    if (opcode == BENCH_SCSI_READ10)
+    {
+        result |= (USBD_PD_LoopbackIn(&bench_dev, bench_msc.Config.InEpNum,
+                bench_data, len) != (int)len);
+    }
+    else
+    {
+        result |= (USBD_PD_LoopbackOut(&bench_dev, bench_msc.Config.OutEpNum,
+                bench_data, len) != (int)len);
+    }
+
+    result |= (USBD_PD_LoopbackIn(&bench_dev, bench_msc.Config.InEpNum,
+            (uint8_t*)&csw, BENCH_CSW_SIZE) != BENCH_CSW_SIZE);
+    result |= (csw.dSignature != BENCH_CSW_SIGNATURE) || (csw.dTag != cbw.dTag) ||
+              (csw.bStatus != MSC_CSW_CMD_PASSED);
+
+    return result;
+}
+
+static void bench_mscSequential(uint8_t opcode, const char *name, uint32_t mib)
+{
+    uint32_t commands = (mib << 20) / sizeof(bench_data);
+    uint32_t blockAddr = 0, i;
+    uint64_t start = bench_begin(&bench_dev);
+
+    for (i = 0; i < commands; i++)
+    {
+        uint64_t t = bench_ns();
+
+        bench_sample(t, bench_mscCommand(opcode, blockAddr, BENCH_SEQ_BLOCKS));
+
+        blockAddr = (blockAddr + BENCH_SEQ_BLOCKS) % BENCH_DISK_BLOCKS;
+    }
+    bench_end(&bench_dev, name, start, (uint64_t)commands * sizeof(bench_data));
+}
+
+static void bench_mscRandom(uint8_t opcode, const char *name, uint32_t mib)
+{
+    uint32_t commands = (mib << 20) / (BENCH_RANDOM_BLOCKS * BENCH_BLOCK_SIZE);
+    uint32_t i;
+    uint64_t start = bench_begin(&bench_dev);
+
+    for (i = 0; i < commands; i++)
+    {
+        uint32_t blockAddr = bench_rand() % (BENCH_DISK_BLOCKS / BENCH_RANDOM_BLOCKS);
+        uint64_t t = bench_ns();
+
+        bench_sample(t, bench_mscCommand(opcode,
+                blockAddr * BENCH_RANDOM_BLOCKS, BENCH_RANDOM_BLOCKS));
+    }
+    bench_end(&bench_dev, name, start,
+            (uint64_t)commands * BENCH_RANDOM_BLOCKS * BENCH_BLOCK_SIZE);
+}
+
+#if (USBD_MSC_CACHE_LINES > 0)
+/* The cache is only used if its lines can hold the bench LU's blocks */
+#define BENCH_MSC_CACHED            ((USBD_MSC_CACHE_LINE_SIZE >= BENCH_BLOCK_SIZE) && \
+                                     ((USBD_MSC_CACHE_LINE_SIZE / BENCH_BLOCK_SIZE) <= 32))
+
+/**
+ * @brief Writes a block to the LU cache, then checks that the BOT reset
+ *        doesn't write it back in the control request, only before the next command.
+ * @param mib: the amount of data to write [MiB]
+ */
+static void bench_mscReset(uint32_t mib)
+{
+    uint8_t out = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_CLASS, USB_REQ_RECIPIENT_INTERFACE);
+    uint8_t epOut = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_STANDARD, USB_REQ_RECIPIENT_ENDPOINT);
+    uint32_t commands = (mib << 20) / BENCH_BLOCK_SIZE / 16;
+    uint32_t i;
+    uint64_t start = bench_begin(&bench_dev);
+
+    for (i = 0; i < commands; i++)
+    {
+        uint64_t t = bench_ns();
+        uint32_t blockAddr = bench_rand() % BENCH_DISK_BLOCKS;
+        uint8_t *block = &bench_disk[blockAddr * BENCH_BLOCK_SIZE];
+        uint8_t value = block[0] ^ 0xFF;
+        int result;
+
+        memset(bench_data, value, BENCH_BLOCK_SIZE);
+        result  = bench_mscCommand(BENCH_SCSI_WRITE10, blockAddr, 1);
+#if BENCH_MSC_CACHED
+        result |= (block[0] == value);
+#endif
+
+        /* An invalid CBW halts both endpoints, which the host recovers from
+         * by BOT reset and clearing the halts (the MSC interface is mounted first) */
+        USBD_PD_LoopbackOut(&bench_dev, bench_msc.Config.OutEpNum, &value, 1);
+        result |= (bench_control(&bench_dev, out, MSC_BOT_RESET, 0, 0, NULL, 0) != 0);
+        result |= (bench_control(&bench_dev, epOut, USB_REQ_CLEAR_FEATURE,
+                USB_FEATURE_EP_HALT, bench_msc.Config.InEpNum, NULL, 0) != 0);
+        result |= (bench_control(&bench_dev, epOut, USB_REQ_CLEAR_FEATURE,
+                USB_FEATURE_EP_HALT, bench_msc.Config.OutEpNum, NULL, 0) != 0);
+#if BENCH_MSC_CACHED
+        /* The write-back is deferred to the next command */
+        result |= (block[0] == value);
+#endif
+
+        memset(bench_data, 0, BENCH_BLOCK_SIZE);
+        result |= bench_mscCommand(BENCH_SCSI_READ10, blockAddr, 1);
+        result |= (block[0] != value) || (bench_data[0] != value);
+        bench_sample(t, result);
+    }
+    bench_end(&bench_dev, "msc bot reset", start, (uint64_t)commands * 2 * BENCH_BLOCK_SIZE);
+}
+#endif /* (USBD_MSC_CACHE_LINES > 0) */
+
+#if (USBD_MSC_UAS_SUPPORT == 1)
+/**
+ * @brief Sends a READ(10) or WRITE(10) command IU on the UAS command pipe.
+ * @param tag: the command tag
+ * @param opcode: the SCSI operation code
+ * @param blockAddr: the first block address
+ * @param blocks: the number of blocks
+ * @return Zero if successful
+ */
+static int bench_uasCommand(uint16_t tag, uint8_t opcode, uint32_t blockAddr, uint16_t blocks)
+{
+    USBD_MSC_UAS_CommandIUType iu;
+
+    memset(&iu, 0, sizeof(iu));
+    iu.bIUID = BENCH_UAS_IU_COMMAND;
+    iu.wTag  = tag;
+    bench_scsiBlockCommand(iu.CDB, opcode, blockAddr, blocks);
+
+    return USBD_PD_LoopbackOut(&bench_dev, bench_msc.Config.CmdEpNum,
+            (const uint8_t*)&iu, sizeof(iu)) != (int)sizeof(iu);
+}
+
+/**
+ * @brief Queues a READ(10) and a WRITE(10) command on the UAS alternate setting,
+ *        while the LU completes its accesses asynchronously (unless it uses the cache).
+ *        The WRITE READY IU has to arrive before the READ command is completed,
+ *        then the data of the two commands is transferred in parallel.
+ * @param mib: the amount of data to transfer [MiB]
+ */
+static void bench_mscUas(uint32_t mib)
+{
+    uint8_t out = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_STANDARD, USB_REQ_RECIPIENT_INTERFACE);
+    uint32_t len = BENCH_RANDOM_BLOCKS * BENCH_BLOCK_SIZE;
+    uint32_t commands = (mib << 20) / len / 2;
+    uint8_t *rd = bench_data, *wr = &bench_data[len];
+    uint32_t i;
+    uint64_t start = bench_begin(&bench_dev);
+
+    /* The MSC interface is mounted first */
+    if (bench_control(&bench_dev, out, USB_REQ_SET_INTERFACE, 1, 0, NULL, 0) != 0)
+    {   bench_failures++; }
+
+    /* The cache requires synchronously completing LU accesses */
+    bench_diskAsync = (USBD_MSC_CACHE_LINES == 0);
+
+    for (i = 0; i < commands; i++)
+    {
+        uint64_t t = bench_ns();
+        uint32_t rdAddr = (bench_rand() % (BENCH_DISK_BLOCKS / 2 / BENCH_RANDOM_BLOCKS)) *
+                BENCH_RANDOM_BLOCKS;
+        uint32_t wrAddr = rdAddr + (BENCH_DISK_BLOCKS / 2);
+        uint16_t rdTag = 2 * i + 1, wrTag = rdTag + 1;
+        uint32_t rdCount = 0, wrCount = 0, polls;
+        uint8_t ready = 0, done = 0;
+        int result = 0;
+
+        memset(wr, i, len);
+        result |= bench_uasCommand(rdTag, BENCH_SCSI_READ10,  rdAddr, BENCH_RANDOM_BLOCKS);
+        result |= bench_uasCommand(wrTag, BENCH_SCSI_WRITE10, wrAddr, BENCH_RANDOM_BLOCKS);
+
+        /* Bit 0 is set for the READ, bit 1 for the WRITE command */
+        for (polls = 0; (done != 3) && (polls < BENCH_UAS_POLLS); polls++)
+        {
+            USBD_MSC_UAS_SenseIUType iu;
+            int n = USBD_PD_LoopbackIn(&bench_dev, bench_msc.Config.StatusEpNum,
+                    (uint8_t*)&iu, sizeof(iu));
+
+            if (n >= (int)sizeof(USBD_MSC_UAS_ReadyIUType))
+            {
+                uint8_t cmd = (iu.wTag == rdTag) ? 1 : ((iu.wTag == wrTag) ? 2 : 0);
+
+                if (iu.bIUID == BENCH_UAS_IU_SENSE)
+                {
+                    result |= (cmd == 0) || (iu.bStatus != 0);
+                    done |= cmd;
+                }
+                else if (iu.bIUID == ((cmd == 1) ? BENCH_UAS_IU_READ_READY : BENCH_UAS_IU_WRITE_READY))
+                {
+                    /* The WRITE isn't held back by the READ */
+                    result |= ((done & 1) != 0);
+                    ready |= cmd;
+                }
+                else
+                {
+                    result = 1;
+                }
+            }
+
+            if (((ready & 1) != 0) && (rdCount < len))
+            {
+                n = USBD_PD_LoopbackIn(&bench_dev, bench_msc.Config.InEpNum,
+                        &rd[rdCount], len - rdCount);
+                if (n > 0)
+                {   rdCount += n; }
+            }
+            if (((ready & 2) != 0) && (wrCount < len))
+            {
+                n = USBD_PD_LoopbackOut(&bench_dev, bench_msc.Config.OutEpNum,
+                        &wr[wrCount], len - wrCount);
+                if (n > 0)
+                {   wrCount += n; }
+            }
+            bench_diskComplete();
+        }
+
+        result |= (done != 3) || (rdCount != len) || (wrCount != len);
+#if (USBD_MSC_CACHE_LINES == 0)
+        /* The cache may hold newer blocks than the disk */
+        result |= (memcmp(rd, &bench_disk[rdAddr * BENCH_BLOCK_SIZE], len) != 0);
+        result |= (memcmp(wr, &bench_disk[wrAddr * BENCH_BLOCK_SIZE], len) != 0);
+#endif
+        bench_sample(t, result);
+    }
+    bench_diskAsync = 0;
+
+    if (bench_control(&bench_dev, out, USB_REQ_SET_INTERFACE, 0, 0, NULL, 0) != 0)
+    {   bench_failures++; }
+
+    bench_end(&bench_dev, "msc uas overlap", start, (uint64_t)commands * 2 * len);
+}
+#endif /* (USBD_MSC_UAS_SUPPORT == 1) */
+
+static void bench_cdcOut(uint32_t mib)
+{
+    uint32_t transfers = (mib << 20) / BENCH_CDC_SIZE;
+    uint32_t i;
+    uint64_t received = bench_cdcReceived;
+    uint64_t start = bench_begin(&bench_dev);
+
+    for (i = 0; i < transfers; i++)
+    {
+        uint64_t t = bench_ns();
+
+        bench_sample(t, USBD_PD_LoopbackOut(&bench_dev, bench_cdc.Config.OutEpNum,
+                bench_data, BENCH_CDC_SIZE) != BENCH_CDC_SIZE);
+    }
+    if ((bench_cdcReceived - received) != ((uint64_t)transfers * BENCH_CDC_SIZE))
+    {   bench_failures++; }
+
+    bench_end(&bench_dev, "cdc bulk out", start, (uint64_t)transfers * BENCH_CDC_SIZE);
+}
+
+static void bench_cdcIn(uint32_t mib)
+{
+    uint32_t transfers = (mib << 20) / BENCH_CDC_SIZE;
+    uint32_t i;
+    uint64_t start = bench_begin(&bench_dev);
+
+    for (i = 0; i < transfers; i++)
+    {
+        uint64_t t = bench_ns();
+        int result = (USBD_CDC_Transmit(&bench_cdc, bench_data, BENCH_CDC_SIZE) != USBD_E_OK);
+
+        result |= (USBD_PD_LoopbackIn(&bench_dev, bench_cdc.Config.InEpNum,
+                bench_cdcRx, BENCH_CDC_SIZE) != BENCH_CDC_SIZE);
+        bench_sample(t, result);
+    }
+    bench_end(&bench_dev, "cdc bulk in", start, (uint64_t)transfers * BENCH_CDC_SIZE);
+}
+
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+/**
+ * @brief Sends OUT messages of full packets and a short packet to the class-owned
+ *        reception buffers, and checks the data and length of each reception.
+ *        The messages are one packet shorter than the buffer ring,
+ *        so the buffer under reception wraps around.
+ * @param mib: the amount of data to write [MiB]
+ */
+static void bench_cdcBuffers(uint32_t mib)
+{
+    uint32_t size = (USBD_CDC_RX_BUFFER_COUNT - 2) * USBD_CDC_RX_BUFFER_SIZE + BENCH_CDC_RX_SHORT;
+    uint32_t messages = (mib << 20) / size / 4;
+    uint32_t i, j;
+    uint64_t start = bench_begin(&bench_cdcBufDev);
+
+    for (i = 0; i < messages; i++)
+    {
+        uint64_t t = bench_ns();
+        uint32_t offset = 0;
+        int result;
+
+        for (j = 0; j < size; j++)
+        {   bench_data[j] = i + j; }
+
+        bench_cdcRxCount = 0;
+        result = (USBD_PD_LoopbackOut(&bench_cdcBufDev, bench_cdcBuf.Config.OutEpNum,
+                bench_data, size) != (int)size);
+        result |= (bench_cdcRxCount != (USBD_CDC_RX_BUFFER_COUNT - 1));
+
+        for (j = 0; (j < bench_cdcRxCount) && (j < USBD_CDC_RX_BUFFER_COUNT); j++)
+        {
+            uint16_t length = ((j + 2) < USBD_CDC_RX_BUFFER_COUNT) ?
+                    USBD_CDC_RX_BUFFER_SIZE : BENCH_CDC_RX_SHORT;
+
+            result |= (bench_cdcRxLength[j] != length) ||
+                      (bench_cdcRxData[j] < bench_cdcRxBuffers.Buffer[0]) ||
+                      (bench_cdcRxData[j] > bench_cdcRxBuffers.Buffer[USBD_CDC_RX_BUFFER_COUNT - 1]);
+            if (result == 0)
+            {
+                result |= (memcmp(bench_cdcRxData[j], &bench_data[offset], length) != 0);
+                offset += length;
+            }
+            USBD_CDC_ReceiveRelease(&bench_cdcBuf);
+        }
+        bench_sample(t, result);
+    }
+    bench_end(&bench_cdcBufDev, "cdc rx buffers", start, (uint64_t)messages * size);
+}
+#endif /* (USBD_CDC_RX_BUFFER_COUNT > 1) */
+
+static void bench_hidReports(uint32_t mib)
+{
+    uint32_t reports = (mib << 20) / BENCH_HID_SIZE / 16;
+    uint32_t i;
+    uint8_t data[BENCH_HID_SIZE];
+    uint64_t start = bench_begin(&bench_dev);
+
+    for (i = 0; i < reports; i++)
+    {
+        uint64_t t = bench_ns();
+        int result;
+
+        bench_report[0] = i;
+        result = (USBD_HID_ReportIn(&bench_hid, bench_report, BENCH_HID_SIZE) != USBD_E_OK);
+        result |= (USBD_PD_LoopbackIn(&bench_dev, bench_hid.Config.InEp.Num,
+                data, BENCH_HID_SIZE) != BENCH_HID_SIZE);
+        result |= (data[0] != (uint8_t)i);
+        bench_sample(t, result);
+    }
+    bench_end(&bench_dev, "hid report in", start, (uint64_t)reports * BENCH_HID_SIZE);
+}
+
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+/**
+ * @brief Writes and reads back feature reports which are longer than
+ *        the control endpoint buffer, so they are transferred in chunks.
+ * @param mib: the amount of data to write [MiB]
+ */
+static void bench_hidFeature(uint32_t mib)
+{
+    uint32_t reports = (mib << 20) / BENCH_HID_FEATURE_SIZE / 16;
+    uint8_t out = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_CLASS, USB_REQ_RECIPIENT_INTERFACE);
+    uint8_t in  = BENCH_REQ_TYPE(USB_DIRECTION_IN,  USB_REQ_TYPE_CLASS, USB_REQ_RECIPIENT_INTERFACE);
+    uint16_t value = HID_REPORT_FEATURE << 8;
+    /* The HID interface is mounted last */
+    uint16_t index = bench_dev.IfCount - 1;
+    uint32_t i, j;
+    uint8_t data[BENCH_HID_FEATURE_SIZE];
+    uint64_t start = bench_begin(&bench_dev);
+
+    for (i = 0; i < reports; i++)
+    {
+        uint64_t t = bench_ns();
+        int result;
+
+        for (j = 0; j < BENCH_HID_FEATURE_SIZE; j++)
+        {   bench_data[j] = i + j; }
+
+        result  = (bench_control(&bench_dev, out, HID_REQ_SET_REPORT, value, index,
+                bench_data, BENCH_HID_FEATURE_SIZE) != BENCH_HID_FEATURE_SIZE);
+        result |= (bench_control(&bench_dev, in, HID_REQ_GET_REPORT, value, index,
+                data, BENCH_HID_FEATURE_SIZE) != BENCH_HID_FEATURE_SIZE);
+        result |= (memcmp(data, bench_data, BENCH_HID_FEATURE_SIZE) != 0);
+        bench_sample(t, result);
+    }
+    bench_end(&bench_dev, "hid feature", start, (uint64_t)reports * 2 * BENCH_HID_FEATURE_SIZE);
+}
+#endif /* (USBD_CTRL_CHUNK_SUPPORT == 1) */
+
+#if (USBD_TRACE_SUPPORT == 1)
+/**
+ * @brief Suspends and resumes the link, and reads back the recorded
+ *        link state changes from the device trace.
+ * @param mib: the number of cycles [BENCH_LINK_CYCLES]
+ */
+static void bench_traceLink(uint32_t mib)
+{
+    uint32_t cycles = mib * BENCH_LINK_CYCLES;
+    uint32_t i;
+    USBD_TraceEntryType entries[4];
+    uint64_t start;
+
+    /* Drain the trace of the previous tests */
+    while (USBD_TraceRead(&bench_dev, entries, 4) > 0)
+    { }
+
+    start = bench_begin(&bench_dev);
+
+    for (i = 0; i < cycles; i++)
+    {
+        uint64_t t = bench_ns();
+        int result;
+
+        USBD_PD_LoopbackSuspend(&bench_dev);
+        USBD_PD_LoopbackResume(&bench_dev);
+
+        result  = (USBD_TraceRead(&bench_dev, entries, 4) != 2);
+        result |= (entries[0].Id != USBD_TRACE_LINK) ||
+                  (entries[0].Param != USB_LINK_STATE_SUSPEND);
+        result |= (entries[1].Id != USBD_TRACE_LINK) ||
+                  (entries[1].Param != USB_LINK_STATE_ACTIVE);
+        result |= (bench_dev.LinkState != USB_LINK_STATE_ACTIVE);
+        bench_sample(t, result);
+    }
+    bench_end(&bench_dev, "trace link state", start, 0);
+}
+#endif /* (USBD_TRACE_SUPPORT == 1) */
+
+/**
+ * @brief Reads the explicit feedback of the UAC OUT stream.
+ * @param value: the received feedback value
+ * @return Zero if successful
+ */
+static int bench_uacFeedback(uint32_t *value)
+{
+    uint8_t epNum = bench_uac.Config.FeedbackEpNum;
+    uint8_t data[4] = { 0 };
+    int len = USBD_PD_LoopbackIn(&bench_uacDev, epNum, data, sizeof(data));
+
+    *value = data[0] | (data[1] << 8) | (data[2] << 16) | ((uint32_t)data[3] << 24);
+
+    return (len != bench_uacDev.EP.IN[epNum & 0xF].MaxPacketSize);
+}
+
+static void bench_uacStream(uint32_t mib)
+{
+    uint8_t out = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_STANDARD, USB_REQ_RECIPIENT_INTERFACE);
+    uint32_t frameRate = (bench_uacDev.Speed == USB_SPEED_HIGH) ? 8000 : 1000;
+    uint8_t shift = (bench_uacDev.Speed == USB_SPEED_HIGH) ? 16 : 14;
+    uint16_t packet = (BENCH_UAC_RATE / frameRate) * 4;
+    uint32_t period = 1 << USBD_UAC_FEEDBACK_REFRESH;
+    uint32_t frames = ((mib << 20) / packet / period) * period;
+    /* The measurement resolution is one audio frame per refresh period */
+    uint32_t quantum = 1 << (shift - USBD_UAC_FEEDBACK_REFRESH);
+    uint32_t expected = ((uint64_t)BENCH_UAC_CLOCK << shift) / frameRate;
+    uint32_t value, i;
+    uint64_t start;
+
+    bench_uacReceived = 0;
+    bench_frames = 0;
+
+    /* The stream starts with the nominal feedback */
+    if ((bench_control(&bench_uacDev, out, USB_REQ_SET_INTERFACE, 1, 1, NULL, 0) != 0) ||
+        (bench_uacFeedback(&value) != 0) ||
+        (value != (((uint64_t)BENCH_UAC_RATE << shift) / frameRate)))
+    {   bench_failures++; }
+
+    start = bench_begin(&bench_uacDev);
+
+    for (i = 1; i <= frames; i++)
+    {
+        uint64_t t = bench_ns();
+        int result;
+
+        bench_frames++;
+        USBD_PD_LoopbackSof(&bench_uacDev);
+
+        result = (USBD_PD_LoopbackOut(&bench_uacDev, bench_uac.Config.DataEpNum,
+                bench_data, packet) != packet);
+
+        /* A new feedback is measured at the end of each refresh period */
+        if ((i % period) == 0)
+        {
+            result |= bench_uacFeedback(&value);
+            result |= ((value + quantum) < expected) || (value > (expected + quantum));
+        }
+        bench_sample(t, result);
+    }
+    if (bench_uacReceived != ((uint64_t)frames * packet))
+    {   bench_failures++; }
+
+    bench_end(&bench_uacDev, "uac stream out", start, (uint64_t)frames * packet);
+}
+
+static uint16_t bench_le16(const uint8_t *data)
+{
+    return data[0] | (data[1] << 8);
+}
+
+static void bench_ncmIn(uint32_t mib)
+{
+    uint8_t out = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_STANDARD, USB_REQ_RECIPIENT_INTERFACE);
+    uint32_t datagrams = (mib << 20) / BENCH_NCM_SIZE;
+    uint32_t i;
+    uint64_t start;
+
+    if (bench_control(&bench_ncmDev, out, USB_REQ_SET_INTERFACE, 1, 1, NULL, 0) != 0)
+    {   bench_failures++; }
+
+    start = bench_begin(&bench_ncmDev);
+
+    for (i = 0; i < datagrams; i++)
+    {
+        uint64_t t = bench_ns();
+        uint32_t frames = 0;
+        uint16_t ndp;
+        int len, result;
+
+        bench_data[0] = i;
+        result = (USBD_NCM_Transmit(&bench_ncm, bench_data, BENCH_NCM_SIZE) != USBD_E_OK);
+
+        /* The NTB is held back until the aggregation timeout elapses */
+        while (((len = USBD_PD_LoopbackIn(&bench_ncmDev, bench_ncm.Config.InEpNum,
+                bench_cdcRx, USBD_NCM_NTB_IN_SIZE)) == USBD_PD_LOOPBACK_NAK) &&
+               (frames <= USBD_NCM_TX_TIMEOUT))
+        {
+            USBD_PD_LoopbackSof(&bench_ncmDev);
+            frames++;
+        }
+        result |= (frames != USBD_NCM_TX_TIMEOUT);
+
+        /* A single datagram is listed in the NTB */
+        ndp = bench_le16(&bench_cdcRx[10]);
+        result |= (len <= 0) || (bench_le16(&bench_cdcRx[8]) != len) ||
+                  ((ndp + 16) > len) || (bench_le16(&bench_cdcRx[ndp + 10]) != BENCH_NCM_SIZE) ||
+                  (bench_le16(&bench_cdcRx[ndp + 12]) != 0) ||
+                  (bench_cdcRx[bench_le16(&bench_cdcRx[ndp + 8])] != (uint8_t)i);
+        bench_sample(t, result);
+    }
+    bench_end(&bench_ncmDev, "ncm datagram in", start, (uint64_t)datagrams * BENCH_NCM_SIZE);
+}
+
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+static void bench_vndOut(uint32_t mib)
+{
+    uint32_t transfers = (mib << 20) / BENCH_VND_SIZE;
+    uint32_t i;
+    uint64_t received = bench_vndReceived;
+    uint64_t start = bench_begin(&bench_vndDev);
+
+    for (i = 0; i < transfers; i++)
+    {
+        uint64_t t = bench_ns();
+
+        bench_sample(t, USBD_PD_LoopbackOut(&bench_vndDev, bench_vnd.Config.OutEpNum[0],
+                bench_data, BENCH_VND_SIZE) != BENCH_VND_SIZE);
+    }
+    if ((bench_vndReceived - received) != ((uint64_t)transfers * BENCH_VND_SIZE))
+    {   bench_failures++; }
+
+    bench_end(&bench_vndDev, "vnd bulk out", start, (uint64_t)transfers * BENCH_VND_SIZE);
+}
+
+/**
+ * @brief Fills the IN pipe's queue, then reads its transfers back in order.
+ * @param mib: the amount of data to read [MiB]
+ */
+static void bench_vndIn(uint32_t mib)
+{
+    uint32_t rounds = (mib << 20) / BENCH_VND_SIZE / USBD_VND_QUEUE_SIZE;
+    uint32_t i, j;
+    uint64_t transmitted = bench_vndTransmitted;
+    uint64_t start = bench_begin(&bench_vndDev);
+
+    for (i = 0; i < rounds; i++)
+    {
+        uint64_t t = bench_ns();
+        int result = 0;
+
+        for (j = 0; j < USBD_VND_QUEUE_SIZE; j++)
+        {
+            bench_data[j * BENCH_VND_SIZE] = i + j;
+            result |= (USBD_VND_Transmit(&bench_vnd, 0, &bench_data[j * BENCH_VND_SIZE],
+                    BENCH_VND_SIZE) != USBD_E_OK);
+        }
+        for (j = 0; j < USBD_VND_QUEUE_SIZE; j++)
+        {
+            result |= (USBD_PD_LoopbackIn(&bench_vndDev, bench_vnd.Config.InEpNum[0],
+                    bench_cdcRx, BENCH_VND_SIZE) != BENCH_VND_SIZE);
+            result |= (bench_cdcRx[0] != (uint8_t)(i + j));
+        }
+        bench_sample(t, result);
+    }
+    if ((bench_vndTransmitted - transmitted) !=
+        ((uint64_t)rounds * USBD_VND_QUEUE_SIZE * BENCH_VND_SIZE))
+    {   bench_failures++; }
+
+    bench_end(&bench_vndDev, "vnd bulk in", start,
+            (uint64_t)rounds * USBD_VND_QUEUE_SIZE * BENCH_VND_SIZE);
+}
+
+/**
+ * @brief Halts the VND pipes with a transfer in progress or waiting,
+ *        then checks that the queued transfers continue when the halt is cleared.
+ * @param mib: the amount of data to transfer in each direction [MiB]
+ */
+static void bench_vndHalt(uint32_t mib)
+{
+    uint8_t out = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_STANDARD, USB_REQ_RECIPIENT_ENDPOINT);
+    uint8_t outEp = bench_vnd.Config.OutEpNum[0], inEp = bench_vnd.Config.InEpNum[0];
+    uint32_t rounds = (mib << 20) / BENCH_VND_SIZE / 16;
+    uint32_t i;
+    uint64_t start = bench_begin(&bench_vndDev);
+
+    for (i = 0; i < rounds; i++)
+    {
+        uint64_t t = bench_ns();
+        uint64_t received = bench_vndReceived;
+        int result;
+
+        /* The OUT pipe has an armed reception */
+        result  = (bench_control(&bench_vndDev, out, USB_REQ_SET_FEATURE,
+                USB_FEATURE_EP_HALT, outEp, NULL, 0) != 0);
+        result |= (USBD_PD_LoopbackOut(&bench_vndDev, outEp,
+                bench_data, BENCH_VND_SIZE) != USBD_PD_LOOPBACK_STALL);
+        result |= (bench_control(&bench_vndDev, out, USB_REQ_CLEAR_FEATURE,
+                USB_FEATURE_EP_HALT, outEp, NULL, 0) != 0);
+        result |= (USBD_PD_LoopbackOut(&bench_vndDev, outEp,
+                bench_data, BENCH_VND_SIZE) != BENCH_VND_SIZE);
+        result |= ((bench_vndReceived - received) != BENCH_VND_SIZE);
+
+        /* The IN transfer is submitted during the halt */
+        bench_data[0] = i;
+        result |= (bench_control(&bench_vndDev, out, USB_REQ_SET_FEATURE,
+                USB_FEATURE_EP_HALT, inEp, NULL, 0) != 0);
+        result |= (USBD_VND_Transmit(&bench_vnd, 0, bench_data, BENCH_VND_SIZE) != USBD_E_OK);
+        result |= (USBD_PD_LoopbackIn(&bench_vndDev, inEp,
+                bench_cdcRx, BENCH_VND_SIZE) != USBD_PD_LOOPBACK_STALL);
+        result |= (bench_control(&bench_vndDev, out, USB_REQ_CLEAR_FEATURE,
+                USB_FEATURE_EP_HALT, inEp, NULL, 0) != 0);
+        result |= (USBD_PD_LoopbackIn(&bench_vndDev, inEp,
+                bench_cdcRx, BENCH_VND_SIZE) != BENCH_VND_SIZE);
+        result |= (bench_cdcRx[0] != (uint8_t)i);
+        bench_sample(t, result);
+    }
+    bench_end(&bench_vndDev, "vnd clear halt", start, (uint64_t)rounds * 2 * BENCH_VND_SIZE);
+}
+#endif /* (USBD_EP_QUEUE_SUPPORT == 1) */
+
+/**
+ * @brief Polls the DFU status until the state leaves the transitional states.
+ * @param state: the expected final state
+ * @return Zero if the expected state is reached
+ */
+static int bench_dfuWait(uint8_t state)
+{
+    uint8_t in = BENCH_REQ_TYPE(USB_DIRECTION_IN, USB_REQ_TYPE_CLASS, USB_REQ_RECIPIENT_INTERFACE);
+    USBD_DFU_StatusDataType status;
+    int result;
+
+    do
+    {
+#if (USBD_DFU_ASYNC_PROGRAM == 1)
+        /* The programming operations finish by the next poll */
+        while (bench_dfuPending != 0)
+        {
+            bench_dfuPending = 0;
+            USBD_DFU_AppComplete(&bench_dfu, DFU_ERROR_NONE);
+        }
+#endif
+        result = (bench_control(&bench_dfuDev, in, DFU_REQ_GETSTATUS, 0, 0,
+                (uint8_t*)&status, sizeof(status)) != sizeof(status));
+    }
+    while ((result == 0) && (status.State != state) && (status.State != DFU_STATE_ERROR));
+
+    return result | (status.State != state);
+}
+
+static void bench_dfuDownload(uint32_t mib)
+{
+    uint8_t out = BENCH_REQ_TYPE(USB_DIRECTION_OUT, USB_REQ_TYPE_CLASS, USB_REQ_RECIPIENT_INTERFACE);
+    uint32_t images = ((mib << 20) + sizeof(bench_image) - 1) / sizeof(bench_image);
+    uint32_t digest, i, offset;
+    uint64_t start;
+
+    /* The image is trailed by the digest of its content */
+    for (i = 0; i < sizeof(bench_image) - DFU_DIGEST_SIZE; i++)
+    {
+        bench_image[i] = bench_rand();
+    }
+    digest = bench_flashDigest(0, bench_image, sizeof(bench_image) - DFU_DIGEST_SIZE);
+    for (i = 0; i < DFU_DIGEST_SIZE; i++)
+    {
+        bench_image[sizeof(bench_image) - DFU_DIGEST_SIZE + i] = digest >> (8 * i);
+    }
+
+    /* Leave the error state of the missing firmware */
+    if (bench_control(&bench_dfuDev, out, DFU_REQ_CLRSTATUS, 0, 0, NULL, 0) != 0)
+    {   bench_failures++; }
+
+    start = bench_begin(&bench_dfuDev);
+
+    for (i = 0; i < images; i++)
+    {
+        uint16_t block = 0;
+
+        for (offset = 0; offset < sizeof(bench_image); offset += BENCH_DFU_BLOCK_SIZE)
+        {
+            uint16_t len = BENCH_DFU_BLOCK_SIZE;
+            uint64_t t = bench_ns();
+            int result;
+
+            if (len > (sizeof(bench_image) - offset))
+            {   len = sizeof(bench_image) - offset; }
+
+            result = (bench_control(&bench_dfuDev, out, DFU_REQ_DNLOAD, block++, 0,
+                    &bench_image[offset], len) != len);
+            result |= bench_dfuWait(DFU_STATE_DNLOAD_IDLE);
+            bench_sample(t, result);
+        }
+
+        /* The manifestation verifies the digest */
+        if ((bench_control(&bench_dfuDev, out, DFU_REQ_DNLOAD, block, 0, NULL, 0) != 0) ||
+            (bench_dfuWait(DFU_STATE_IDLE) != 0) ||
+            (memcmp(bench_flash, bench_image, sizeof(bench_image)) != 0))
+        {   bench_failures++; }
+    }
+    bench_end(&bench_dfuDev, "dfu download", start, (uint64_t)images * sizeof(bench_image));
+}
+
+/** @} */
+
+int main(int argc, char *argv[])
+{
+    uint32_t mib = (argc > 1) ? strtoul(argv[1], NULL, 0) : 16;
+    uint64_t start;
+
+    if (mib == 0)
+    {   mib = 1; }
+
+    printf("USB Device loopback benchmark: %s speed, deferred %d, queue %d, vector %d, "
+           "stats %d, trace %d, msc buffers %dx%d%s, dfu async %d\n",
+           (USBD_HS_SUPPORT == 1) ? "high" : "full",
+           USBD_DEFERRED_PROCESSING, USBD_EP_QUEUE_SUPPORT, USBD_EP_VECTOR_SUPPORT,
+           USBD_STATS_SUPPORT, USBD_TRACE_SUPPORT,
+           USBD_MSC_BUFFER_COUNT, USBD_MSC_BUFFER_SIZE,
+           (BENCH_MSC_DIRECT == 1) ? " direct" : "", USBD_DFU_ASYNC_PROGRAM);
+    printf("%-18s %9s %11s %9s %9s %9s %9s\n", "test", "MB/s", "xfer/s",
+           "p50 us", "p90 us", "p99 us", "max us");
+
+    /* Composite device */
+    USBD_Init(&bench_dev, &bench_desc);
+    USBD_MSC_MountInterface(&bench_msc, &bench_dev);
+    USBD_CDC_MountInterface(&bench_cdc, &bench_dev);
+    USBD_HID_MountInterface(&bench_hid, &bench_dev);
+    USBD_Connect(&bench_dev);
+
+    start = bench_begin(&bench_dev);
+    bench_sample(start, bench_enumerate(&bench_dev, 1));
+    bench_end(&bench_dev, "enumeration", start, 0);
+
+    bench_mscSequential(BENCH_SCSI_WRITE10, "msc seq write", mib);
+    bench_mscSequential(BENCH_SCSI_READ10,  "msc seq read", mib);
+    bench_mscRandom(BENCH_SCSI_WRITE10, "msc random write", mib);
+    bench_mscRandom(BENCH_SCSI_READ10,  "msc random read", mib);
+#if (USBD_MSC_CACHE_LINES > 0)
+    bench_mscReset(mib);
+#endif
+#if (USBD_MSC_UAS_SUPPORT == 1)
+    bench_mscUas(mib);
+#endif
+    bench_cdcOut(mib);
+    bench_cdcIn(mib);
+    bench_hidReports(mib);
+#if (USBD_CTRL_CHUNK_SUPPORT == 1)
+    bench_hidFeature(mib);
+#endif
+#if (USBD_TRACE_SUPPORT == 1)
+    bench_traceLink(mib);
+#endif
+
+    USBD_Deinit(&bench_dev);
+
+    /* UAC speaker device */
+    USBD_Init(&bench_uacDev, &bench_desc);
+    if (USBD_UAC_MountInterface(&bench_uac, &bench_uacDev) != USBD_E_OK)
+    {   bench_failures++; }
+    USBD_Connect(&bench_uacDev);
+
+    if (bench_enumerate(&bench_uacDev, 3) != 0)
+    {   bench_failures++; }
+    bench_uacStream(mib);
+
+    USBD_Deinit(&bench_uacDev);
+
+    /* NCM network device */
+    USBD_Init(&bench_ncmDev, &bench_desc);
+    if (USBD_NCM_MountInterface(&bench_ncm, &bench_ncmDev) != USBD_E_OK)
+    {   bench_failures++; }
+    USBD_Connect(&bench_ncmDev);
+
+    if (bench_enumerate(&bench_ncmDev, 4) != 0)
+    {   bench_failures++; }
+    bench_ncmIn(mib);
+
+    USBD_Deinit(&bench_ncmDev);
+
+#if (USBD_CDC_RX_BUFFER_COUNT > 1)
+    /* CDC device with class-owned reception buffers */
+    USBD_Init(&bench_cdcBufDev, &bench_desc);
+    if (USBD_CDC_MountInterface(&bench_cdcBuf, &bench_cdcBufDev) != USBD_E_OK)
+    {   bench_failures++; }
+    USBD_Connect(&bench_cdcBufDev);
+
+    if (bench_enumerate(&bench_cdcBufDev, 6) != 0)
+    {   bench_failures++; }
+    bench_cdcBuffers(mib);
+
+    USBD_Deinit(&bench_cdcBufDev);
+#endif
+
+#if (USBD_EP_QUEUE_SUPPORT == 1)
+    /* VND bulk device */
+    USBD_Init(&bench_vndDev, &bench_desc);
+    if (USBD_VND_MountInterface(&bench_vnd, &bench_vndDev) != USBD_E_OK)
+    {   bench_failures++; }
+    USBD_Connect(&bench_vndDev);
+
+    if (bench_enumerate(&bench_vndDev, 5) != 0)
+    {   bench_failures++; }
+    bench_vndOut(mib);
+    bench_vndIn(mib);
+    bench_vndHalt(mib);
+
+    USBD_Deinit(&bench_vndDev);
+#endif
+
+    /* DFU bootloader device, its firmware address has to fit in 32 bits */
+    if ((uintptr_t)bench_flash == (uint32_t)(uintptr_t)bench_flash)
+    {
+        bench_dfuAppRam = bench_dfuApp;
+        bench_dfuAppRam.Firmware.Address = (uint32_t)(uintptr_t)bench_flash;
+        bench_dfu.Config.Buffer = bench_dfuBuffer;
+        bench_dfu.Config.BufferSize = BENCH_DFU_BLOCK_SIZE;
+
+        USBD_Init(&bench_dfuDev, &bench_desc);
+        USBD_DFU_BootInit(&bench_dfu, bench_reboot, &bench_dfuAppRam, 1);
+        USBD_DFU_MountInterface(&bench_dfu, &bench_dfuDev);
+        USBD_Connect(&bench_dfuDev);
+
+        if (bench_enumerate(&bench_dfuDev, 2) != 0)
+        {   bench_failures++; }
+        bench_dfuDownload(mib);
+
+        USBD_Deinit(&bench_dfuDev);
+    }
+    else
+    {
+        printf("%-18s skipped, link with -no-pie\n", "dfu download");
+    }
+
+    if (bench_failures > 0)
+    {
+        printf("%u transfers failed\n", bench_failures);
+    }
+    return (bench_failures > 0) ? 1 : 0;
+}
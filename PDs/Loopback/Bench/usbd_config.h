@@ -0,0 +1,131 @@
+/**
+  ******************************************************************************
+  * @file    usbd_config.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Configuration of the loopback benchmark
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_CONFIG_H_
+#define __USBD_CONFIG_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** @addtogroup USBD_Exported_Macros
+ * @{ */
+
+/* The options are documented in Templates/usbd_config.h,
+ * each of them can be overridden on the compiler command line
+ * to benchmark another build configuration. */
+
+/* MSC, CDC (2) and HID interfaces */
+#ifndef USBD_MAX_IF_COUNT
+#define USBD_MAX_IF_COUNT           4
+#endif
+
+#ifndef USBD_EP0_BUFFER_SIZE
+#define USBD_EP0_BUFFER_SIZE        256
+#endif
+
+#ifndef USBD_HS_SUPPORT
+#define USBD_HS_SUPPORT             1
+#endif
+
+#ifndef USBD_SERIAL_BCD_SIZE
+#define USBD_SERIAL_BCD_SIZE        0
+#endif
+
+/* The VND pipes are built on the endpoint queues */
+#ifndef USBD_EP_QUEUE_SUPPORT
+#define USBD_EP_QUEUE_SUPPORT       1
+#endif
+
+#ifndef USBD_EP_VECTOR_SUPPORT
+#define USBD_EP_VECTOR_SUPPORT      0
+#endif
+
+#ifndef USBD_DEFERRED_PROCESSING
+#define USBD_DEFERRED_PROCESSING    0
+#endif
+
+#ifndef USBD_CONFIG_DESC_CACHE
+#define USBD_CONFIG_DESC_CACHE      0
+#endif
+
+#ifndef USBD_STATIC_DESCRIPTORS
+#define USBD_STATIC_DESCRIPTORS     0
+#endif
+
+/* The HID feature reports are longer than the control endpoint buffer */
+#ifndef USBD_CTRL_CHUNK_SUPPORT
+#define USBD_CTRL_CHUNK_SUPPORT     1
+#endif
+
+/* The UAC feedback is measured by the start of frames */
+#ifndef USBD_SOF_SUPPORT
+#define USBD_SOF_SUPPORT            1
+#endif
+
+#ifndef USBD_MS_OS_DESC_SUPPORT
+#define USBD_MS_OS_DESC_SUPPORT     0
+#endif
+
+#ifndef USBD_ARENA_BLOCK_COUNT
+#define USBD_ARENA_BLOCK_COUNT      0
+#endif
+
+#ifndef USBD_STATS_SUPPORT
+#define USBD_STATS_SUPPORT          1
+#endif
+
+#ifndef USBD_TRACE_SUPPORT
+#define USBD_TRACE_SUPPORT          1
+#endif
+
+/* The callback profiles and the trace are stamped in nanoseconds,
+ * the histogram bins range from 64 ns to 2 ms */
+uint32_t bench_clock(void);
+
+#define USBD_STATS_CYCLES()         bench_clock()
+#define USBD_STATS_HISTOGRAM_SIZE   16
+#define USBD_STATS_HISTOGRAM_BASE   64
+#define USBD_TRACE_TIMESTAMP()      bench_clock()
+
+/* The CDC interface of the reception buffer test keeps 4 buffers armed */
+#ifndef USBD_CDC_RX_BUFFER_COUNT
+#define USBD_CDC_RX_BUFFER_COUNT    4
+#endif
+
+/* The IN NTBs wait for more datagrams for 4 (micro)frames */
+#ifndef USBD_NCM_TX_TIMEOUT
+#define USBD_NCM_TX_TIMEOUT         4
+#endif
+
+/* The DFU interface is reused for consecutive downloads */
+#define USBD_DFU_MANIFEST_TOLERANT  1
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_CONFIG_H_ */
@@ -0,0 +1,531 @@
+/**
+  ******************************************************************************
+  * @file    usbd_pd_loopback.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Host loopback peripheral driver
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+
+#include <string.h>
+
+/** @ingroup USBD
+ * @defgroup USBD_PD_Loopback USBD Host Loopback Peripheral Driver
+ * @brief This peripheral driver connects the device stack to a simulated host
+ *        in the same program, so the classes can be exercised without hardware.
+ *        The host calls move the data of the armed transfers packet by packet,
+ *        and call the device stack's callbacks when a transfer is completed.
+ *        When USBD_DEFERRED_PROCESSING is set, the host calls @ref USBD_Process
+ *        before giving up on an endpoint which isn't armed (NAK).
+ * @{ */
+
+/**
+ * @brief Lets the device stack process the signalled events.
+ * @param dev: USB Device handle reference
+ */
+static void USBD_PD_LoopbackProcess(USBD_HandleType *dev)
+{
+#if (USBD_DEFERRED_PROCESSING == 1)
+    USBD_Process(dev);
+#else
+    (void)dev;
+#endif
+}
+
+/**
+ * @brief Arms a transfer on the endpoint.
+ * @param ep: the endpoint handle reference
+ * @param data: the transfer data
+ * @param len: the transfer length
+ */
+static void USBD_PD_LoopbackArm(USBD_EpHandleType *ep, uint8_t *data, uint16_t len)
+{
+    ep->Transfer.Data     = data;
+    ep->Transfer.Length   = len;
+    ep->Transfer.Progress = 0;
+    ep->Armed = 1;
+}
+
+/**
+ * @brief Completes the transfer of the endpoint, so Transfer.Data points
+ *        to the end of the transferred data, and Transfer.Length is its length.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ */
+static void USBD_PD_LoopbackComplete(USBD_HandleType *dev, uint8_t epAddr)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr);
+
+    ep->Armed = 0;
+    ep->Transfer.Length = ep->Transfer.Progress;
+
+    if (epAddr > 0x7F)
+    {
+        USBD_EpInCallback(dev, ep);
+    }
+    else
+    {
+        USBD_EpOutCallback(dev, ep);
+    }
+}
+
+/**
+ * @brief Performs an IN transaction: a packet is sent by the device.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ * @param data: the host buffer
+ * @param len: the free space in the host buffer
+ * @return The length of the packet, NAK or STALL
+ */
+static int USBD_PD_LoopbackInPacket(USBD_HandleType *dev, uint8_t epAddr,
+        uint8_t *data, uint32_t len)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr);
+    int retval = USBD_PD_LOOPBACK_NAK;
+
+    if ((ep->Armed == 0) && (ep->Halted == 0))
+    {   USBD_PD_LoopbackProcess(dev); }
+
+    if (ep->Halted != 0)
+    {
+        retval = USBD_PD_LOOPBACK_STALL;
+    }
+    else if ((dev->Attached != 0) && (ep->Armed != 0))
+    {
+        uint16_t pkt = ep->Transfer.Length - ep->Transfer.Progress;
+
+        if (pkt > ep->MaxPacketSize)
+        {   pkt = ep->MaxPacketSize; }
+        if (pkt > len)
+        {   pkt = len; }
+
+        if (pkt > 0)
+        {
+            memcpy(data, ep->Transfer.Data, pkt);
+        }
+        ep->Transfer.Data     += pkt;
+        ep->Transfer.Progress += pkt;
+
+        /* The transfer of a packet multiple length ends without ZLP */
+        if (ep->Transfer.Progress == ep->Transfer.Length)
+        {
+            USBD_PD_LoopbackComplete(dev, epAddr);
+        }
+        retval = pkt;
+    }
+    return retval;
+}
+
+/**
+ * @brief Performs an OUT transaction: a packet is received by the device.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ * @param data: the packet data
+ * @param len: the packet length, at most the maximal packet size
+ * @return The length of the packet, NAK or STALL
+ */
+static int USBD_PD_LoopbackOutPacket(USBD_HandleType *dev, uint8_t epAddr,
+        const uint8_t *data, uint16_t len)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr);
+    int retval = USBD_PD_LOOPBACK_NAK;
+
+    if ((ep->Armed == 0) && (ep->Halted == 0))
+    {   USBD_PD_LoopbackProcess(dev); }
+
+    if (ep->Halted != 0)
+    {
+        retval = USBD_PD_LOOPBACK_STALL;
+    }
+    else if ((dev->Attached != 0) && (ep->Armed != 0))
+    {
+        uint16_t space = ep->Transfer.Length - ep->Transfer.Progress;
+
+        /* The excess of an overrunning packet is dropped */
+        if (space > len)
+        {   space = len; }
+
+        if (space > 0)
+        {
+            memcpy(ep->Transfer.Data, data, space);
+        }
+        ep->Transfer.Data     += space;
+        ep->Transfer.Progress += space;
+
+        /* The transfer ends when the buffer is full or with a short packet */
+        if ((ep->Transfer.Progress == ep->Transfer.Length) ||
+            (len < ep->MaxPacketSize))
+        {
+            USBD_PD_LoopbackComplete(dev, epAddr);
+        }
+        retval = len;
+    }
+    return retval;
+}
+
+/** @} */
+
+/** @addtogroup USBD_PD_Loopback
+ * @{ */
+
+/**
+ * @brief Initializes the loopback peripheral.
+ * @param dev: USB Device handle reference
+ * @param conf: the configuration field of the Device Description
+ */
+void USBD_PD_Init(USBD_HandleType *dev, const USBD_ConfigurationType *conf)
+{
+    uint8_t i;
+
+    (void)conf;
+    dev->Address  = 0;
+    dev->Attached = 0;
+    dev->LinkState = USB_LINK_STATE_OFF;
+
+    for (i = 0; i < USBD_MAX_EP_COUNT; i++)
+    {
+        dev->EP.IN [i].Armed  = 0;
+        dev->EP.IN [i].Halted = 0;
+        dev->EP.OUT[i].Armed  = 0;
+        dev->EP.OUT[i].Halted = 0;
+    }
+}
+
+/**
+ * @brief Shuts down the loopback peripheral.
+ * @param dev: USB Device handle reference
+ */
+void USBD_PD_Deinit(USBD_HandleType *dev)
+{
+    USBD_PD_Stop(dev);
+}
+
+/**
+ * @brief Connects the device to the host.
+ * @param dev: USB Device handle reference
+ */
+void USBD_PD_Start(USBD_HandleType *dev)
+{
+    dev->Attached = 1;
+    dev->LinkState = USB_LINK_STATE_ACTIVE;
+}
+
+/**
+ * @brief Disconnects the device from the host.
+ * @param dev: USB Device handle reference
+ */
+void USBD_PD_Stop(USBD_HandleType *dev)
+{
+    dev->Attached = 0;
+    dev->LinkState = USB_LINK_STATE_OFF;
+}
+
+/**
+ * @brief The simulated host resumes the link by @ref USBD_PD_LoopbackResume,
+ *        so remote wakeup has no effect.
+ * @param dev: USB Device handle reference
+ */
+void USBD_PD_SetRemoteWakeup(USBD_HandleType *dev)
+{
+    (void)dev;
+}
+
+/**
+ * @brief The simulated host resumes the link by @ref USBD_PD_LoopbackResume,
+ *        so remote wakeup has no effect.
+ * @param dev: USB Device handle reference
+ */
+void USBD_PD_ClearRemoteWakeup(USBD_HandleType *dev)
+{
+    (void)dev;
+}
+
+/**
+ * @brief Sets the USB device's address.
+ * @param dev: USB Device handle reference
+ * @param addr: the new device address to set
+ */
+void USBD_PD_SetAddress(USBD_HandleType *dev, uint8_t addr)
+{
+    dev->Address = addr;
+}
+
+/**
+ * @brief Opens a device endpoint.
+ * @param dev: USB Device handle reference
+ * @param addr: endpoint address
+ * @param type: endpoint type
+ * @param mps: maximum packet size
+ */
+void USBD_PD_EpOpen(USBD_HandleType *dev, uint8_t addr,
+        USB_EndPointType type, uint16_t mps)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, addr);
+
+    ep->Type = type;
+    ep->MaxPacketSize = mps;
+    ep->Armed  = 0;
+    ep->Halted = 0;
+}
+
+/**
+ * @brief Closes a device endpoint.
+ * @param dev: USB Device handle reference
+ * @param addr: endpoint address
+ */
+void USBD_PD_EpClose(USBD_HandleType *dev, uint8_t addr)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, addr);
+
+    ep->Armed  = 0;
+    ep->Halted = 0;
+}
+
+/**
+ * @brief Arms the data stream for the host to read from the endpoint.
+ * @param dev: USB Device handle reference
+ * @param addr: endpoint address
+ * @param data: pointer to the data to send
+ * @param len: total length of the data
+ */
+void USBD_PD_EpSend(USBD_HandleType *dev, uint8_t addr,
+        const uint8_t *data, uint16_t len)
+{
+    USBD_PD_LoopbackArm(USBD_EpAddr2Ref(dev, addr | 0x80), (uint8_t*)data, len);
+}
+
+/**
+ * @brief Arms the buffer for the host to write to the endpoint.
+ * @param dev: USB Device handle reference
+ * @param addr: endpoint address
+ * @param data: pointer to the data buffer
+ * @param len: maximum length of the data
+ */
+void USBD_PD_EpReceive(USBD_HandleType *dev, uint8_t addr,
+        uint8_t *data, uint16_t len)
+{
+    USBD_PD_LoopbackArm(USBD_EpAddr2Ref(dev, addr), data, len);
+}
+
+/**
+ * @brief Sets a device endpoint to STALL transfers.
+ * @param dev: USB Device handle reference
+ * @param addr: endpoint address
+ */
+void USBD_PD_EpSetStall(USBD_HandleType *dev, uint8_t addr)
+{
+    USBD_EpAddr2Ref(dev, addr)->Halted = 1;
+}
+
+/**
+ * @brief Clears the STALL condition of a device endpoint.
+ * @param dev: USB Device handle reference
+ * @param addr: endpoint address
+ */
+void USBD_PD_EpClearStall(USBD_HandleType *dev, uint8_t addr)
+{
+    USBD_EpAddr2Ref(dev, addr)->Halted = 0;
+}
+
+/**
+ * @brief Drops the armed transfer of a device endpoint.
+ * @param dev: USB Device handle reference
+ * @param addr: endpoint address
+ */
+void USBD_PD_EpFlush(USBD_HandleType *dev, uint8_t addr)
+{
+    USBD_EpAddr2Ref(dev, addr)->Armed = 0;
+}
+
+/**
+ * @brief Signals a bus reset by the host with the selected speed,
+ *        the control endpoint is opened.
+ * @param dev: USB Device handle reference
+ * @param speed: the speed of the device after the reset
+ */
+void USBD_PD_LoopbackReset(USBD_HandleType *dev, USB_SpeedType speed)
+{
+    uint8_t i;
+
+    dev->Address = 0;
+    for (i = 1; i < USBD_MAX_EP_COUNT; i++)
+    {
+        USBD_PD_EpClose(dev, i);
+        USBD_PD_EpClose(dev, 0x80 | i);
+    }
+    USBD_PD_EpOpen(dev, 0x00, USB_EP_TYPE_CONTROL, dev->EP.OUT[0].MaxPacketSize);
+    USBD_PD_EpOpen(dev, 0x80, USB_EP_TYPE_CONTROL, dev->EP.IN [0].MaxPacketSize);
+
+    USBD_ResetCallback(dev, speed);
+    USBD_PD_LoopbackProcess(dev);
+}
+
+/**
+ * @brief Signals the start of a (micro)frame.
+ * @param dev: USB Device handle reference
+ */
+void USBD_PD_LoopbackSof(USBD_HandleType *dev)
+{
+#if (USBD_SOF_SUPPORT == 1)
+    USBD_SofCallback(dev);
+#endif
+    USBD_PD_LoopbackProcess(dev);
+}
+
+/**
+ * @brief Suspends the link, as the host stopped the start of frames.
+ * @param dev: USB Device handle reference
+ */
+void USBD_PD_LoopbackSuspend(USBD_HandleType *dev)
+{
+    dev->LinkState = USB_LINK_STATE_SUSPEND;
+#if (USBD_TRACE_SUPPORT == 1)
+    USBD_TraceLinkState(dev, USB_LINK_STATE_SUSPEND);
+#endif
+    USBD_PD_LoopbackProcess(dev);
+}
+
+/**
+ * @brief Resumes the suspended link.
+ * @param dev: USB Device handle reference
+ */
+void USBD_PD_LoopbackResume(USBD_HandleType *dev)
+{
+    dev->LinkState = USB_LINK_STATE_ACTIVE;
+#if (USBD_TRACE_SUPPORT == 1)
+    USBD_TraceLinkState(dev, USB_LINK_STATE_ACTIVE);
+#endif
+    USBD_PD_LoopbackProcess(dev);
+}
+
+/**
+ * @brief Performs a control transfer on the default pipe:
+ *        the setup stage, the data stage if wLength isn't 0, and the status stage.
+ * @param dev: USB Device handle reference
+ * @param setup: the setup request
+ * @param data: the buffer of the data stage, at least wLength long
+ * @return The length of the data stage, or NAK or STALL if the transfer failed
+ */
+int USBD_PD_LoopbackControl(USBD_HandleType *dev,
+        const USB_SetupRequestType *setup, uint8_t *data)
+{
+    int retval, status;
+
+    /* The setup packet is always accepted, it clears the EP0 stall
+     * and cancels the transfers of the previous request */
+    dev->EP.IN [0].Halted = 0;
+    dev->EP.IN [0].Armed  = 0;
+    dev->EP.OUT[0].Halted = 0;
+    dev->EP.OUT[0].Armed  = 0;
+
+    dev->Setup = *setup;
+    USBD_SetupCallback(dev);
+    USBD_PD_LoopbackProcess(dev);
+
+    if (setup->Length == 0)
+    {
+        retval = USBD_PD_LoopbackIn(dev, 0x80, NULL, 0);
+    }
+    else if (setup->RequestType.Direction == USB_DIRECTION_IN)
+    {
+        retval = USBD_PD_LoopbackIn(dev, 0x80, data, setup->Length);
+        if (retval >= 0)
+        {
+            status = USBD_PD_LoopbackOut(dev, 0x00, NULL, 0);
+            if (status < 0)
+            {   retval = status; }
+        }
+    }
+    else
+    {
+        retval = USBD_PD_LoopbackOut(dev, 0x00, data, setup->Length);
+        if (retval >= 0)
+        {
+            status = USBD_PD_LoopbackIn(dev, 0x80, NULL, 0);
+            if (status < 0)
+            {   retval = status; }
+        }
+    }
+    return retval;
+}
+
+/**
+ * @brief Reads data from an IN endpoint until a short packet
+ *        or the requested length is received.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ * @param data: the buffer to read to
+ * @param len: the requested length
+ * @return The received length, or NAK or STALL if no packet is received
+ */
+int USBD_PD_LoopbackIn(USBD_HandleType *dev, uint8_t epAddr,
+        uint8_t *data, uint32_t len)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr | 0x80);
+    uint32_t count = 0;
+    int pkt;
+
+    do
+    {
+        pkt = USBD_PD_LoopbackInPacket(dev, epAddr | 0x80, &data[count], len - count);
+        if (pkt > 0)
+        {   count += pkt; }
+    }
+    while ((pkt == ep->MaxPacketSize) && (count < len));
+
+    USBD_PD_LoopbackProcess(dev);
+
+    return ((pkt < 0) && (count == 0)) ? pkt : (int)count;
+}
+
+/**
+ * @brief Writes data to an OUT endpoint, ending with a short packet
+ *        unless the length is a multiple of the maximal packet size.
+ * @param dev: USB Device handle reference
+ * @param epAddr: endpoint address
+ * @param data: the data to write
+ * @param len: the length of the data
+ * @return The accepted length, or NAK or STALL if no packet is accepted
+ */
+int USBD_PD_LoopbackOut(USBD_HandleType *dev, uint8_t epAddr,
+        const uint8_t *data, uint32_t len)
+{
+    USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, epAddr & 0x7F);
+    uint32_t count = 0;
+    int pkt;
+
+    do
+    {
+        uint16_t size = ep->MaxPacketSize;
+
+        if (size > (len - count))
+        {   size = len - count; }
+
+        pkt = USBD_PD_LoopbackOutPacket(dev, epAddr & 0x7F, &data[count], size);
+        if (pkt > 0)
+        {   count += pkt; }
+    }
+    while ((pkt == ep->MaxPacketSize) && (count < len));
+
+    USBD_PD_LoopbackProcess(dev);
+
+    return ((pkt < 0) && (count == 0)) ? pkt : (int)count;
+}
+
+/** @} */
@@ -0,0 +1,67 @@
+/**
+  ******************************************************************************
+  * @file    usbd_pd_def.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Host loopback peripheral driver definitions
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_PD_DEF_H_
+#define __USBD_PD_DEF_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <usbd_config.h>
+
+/** @addtogroup USBD_Exported_Macros
+ * @{ */
+
+/* No Link Power Management on the loopback bus */
+#define USBD_LPM_SUPPORT                0
+
+/* The address is set after the SetAddress request is completed,
+ * as the USB cores do */
+#define USBD_SET_ADDRESS_IMMEDIATE      0
+
+/* The number of endpoints in each direction */
+#ifndef USBD_MAX_EP_COUNT
+#define USBD_MAX_EP_COUNT               8
+#endif
+
+/* Word alignment, as the DMA capable cores require */
+#define USBD_DATA_ALIGNMENT             4
+
+/* Peripheral Driver extension fields */
+#define USBD_PD_EP_FIELDS                                           \
+    uint8_t             Armed;          /*!< A transfer waits for the host */\
+    uint8_t             Halted;         /*!< The endpoint answers with STALL */
+
+#define USBD_PD_DEV_FIELDS                                          \
+    uint8_t             Address;        /*!< The device address set by the host */\
+    uint8_t             Attached;       /*!< The device is connected to the host */
+
+/** @} */
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_PD_DEF_H_ */
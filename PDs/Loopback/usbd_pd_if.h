@@ -0,0 +1,120 @@
+/**
+  ******************************************************************************
+  * @file    usbd_pd_if.h
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Host loopback peripheral driver interface
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#ifndef __USBD_PD_IF_H_
+#define __USBD_PD_IF_H_
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#include <usbd_types.h>
+
+/** @addtogroup USBD_Exported_Macros
+ * @{ */
+
+/* Results of the host transfers besides the transferred length */
+#define USBD_PD_LOOPBACK_NAK            (-1) /* The device didn't provide a transfer */
+#define USBD_PD_LOOPBACK_STALL          (-2) /* The endpoint is halted */
+
+/** @} */
+
+/* Peripheral Driver interface, called by the device stack */
+void            USBD_PD_Init            (USBD_HandleType *dev,
+                                         const USBD_ConfigurationType *conf);
+void            USBD_PD_Deinit          (USBD_HandleType *dev);
+void            USBD_PD_Start           (USBD_HandleType *dev);
+void            USBD_PD_Stop            (USBD_HandleType *dev);
+void            USBD_PD_SetRemoteWakeup (USBD_HandleType *dev);
+void            USBD_PD_ClearRemoteWakeup(USBD_HandleType *dev);
+void            USBD_PD_SetAddress      (USBD_HandleType *dev,
+                                         uint8_t addr);
+void            USBD_PD_EpOpen          (USBD_HandleType *dev,
+                                         uint8_t addr,
+                                         USB_EndPointType type,
+                                         uint16_t mps);
+void            USBD_PD_EpClose         (USBD_HandleType *dev,
+                                         uint8_t addr);
+void            USBD_PD_EpSend          (USBD_HandleType *dev,
+                                         uint8_t addr,
+                                         const uint8_t *data,
+                                         uint16_t len);
+void            USBD_PD_EpReceive       (USBD_HandleType *dev,
+                                         uint8_t addr,
+                                         uint8_t *data,
+                                         uint16_t len);
+void            USBD_PD_EpSetStall      (USBD_HandleType *dev,
+                                         uint8_t addr);
+void            USBD_PD_EpClearStall    (USBD_HandleType *dev,
+                                         uint8_t addr);
+void            USBD_PD_EpFlush         (USBD_HandleType *dev,
+                                         uint8_t addr);
+
+/* usbd <- PD */
+void            USBD_ResetCallback      (USBD_HandleType *dev,
+                                         USB_SpeedType speed);
+
+#if (USBD_SOF_SUPPORT == 1)
+/* usbd <- PD */
+void            USBD_SofCallback        (USBD_HandleType *dev);
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+/* usbd <- PD */
+void            USBD_TraceLinkState     (USBD_HandleType *dev,
+                                         USB_LinkStateType state);
+#endif
+
+/* usbd_ctrl <- PD */
+void            USBD_SetupCallback      (USBD_HandleType *dev);
+
+/* usbd_ep <- PD */
+void            USBD_EpInCallback       (USBD_HandleType *dev,
+                                         USBD_EpHandleType *ep);
+void            USBD_EpOutCallback      (USBD_HandleType *dev,
+                                         USBD_EpHandleType *ep);
+
+/* Simulated host, called by the test application */
+void            USBD_PD_LoopbackReset   (USBD_HandleType *dev,
+                                         USB_SpeedType speed);
+void            USBD_PD_LoopbackSof     (USBD_HandleType *dev);
+void            USBD_PD_LoopbackSuspend (USBD_HandleType *dev);
+void            USBD_PD_LoopbackResume  (USBD_HandleType *dev);
+int             USBD_PD_LoopbackControl (USBD_HandleType *dev,
+                                         const USB_SetupRequestType *setup,
+                                         uint8_t *data);
+int             USBD_PD_LoopbackIn      (USBD_HandleType *dev,
+                                         uint8_t epAddr,
+                                         uint8_t *data,
+                                         uint32_t len);
+int             USBD_PD_LoopbackOut     (USBD_HandleType *dev,
+                                         uint8_t epAddr,
+                                         const uint8_t *data,
+                                         uint32_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif /* __USBD_PD_IF_H_ */
@@ -0,0 +1,206 @@
+/**
+  ******************************************************************************
+  * @file    usbd_pd_pma.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   Universal Serial Bus Device Driver
+  *          Packet memory layout planning of the USB FS core
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_internal.h>
+
+#if defined(USB)
+
+/* Each endpoint register has an 8 byte entry in the buffer descriptor table */
+#define USBD_PD_BTABLE_SIZE             (8 * USBD_MAX_EP_COUNT)
+
+/** @ingroup USBD
+ * @defgroup USBD_PD_Private_Functions_Pma USBD Packet Memory Planning
+ * @{ */
+
+/**
+ * @brief Calculates the packet memory size of an endpoint buffer.
+ *        Reception buffers above 62 bytes are allocated in 32 byte blocks.
+ * @param epAddr: endpoint address
+ * @param mps: endpoint maximal packet size
+ * @return The size of the buffer
+ */
+static uint16_t USBD_PD_PmaBufferSize(uint8_t epAddr, uint16_t mps)
+{
+    uint16_t size = (mps + 1) & ~1;
+
+    if ((epAddr < 0x80) && (size > 62))
+    {   size = (size + 31) & ~31; }
+
+    return size;
+}
+
+/**
+ * @brief Allocates a buffer from the free packet memory.
+ * @param next: the start of the free packet memory
+ * @param size: the size of the buffer
+ * @return The offset of the buffer, or 0 if the packet memory is exhausted
+ */
+static uint16_t USBD_PD_PmaAlloc(uint16_t *next, uint16_t size)
+{
+    uint16_t addr = 0;
+
+    if ((*next + size) <= USBD_PD_PMA_SIZE)
+    {
+        addr   = *next;
+        *next += size;
+    }
+    return addr;
+}
+
+/**
+ * @brief Lays out the endpoint registers and packet memory buffers
+ *        for all endpoints of the mounted interfaces.
+ *        Isochronous and bulk endpoints receive a dedicated endpoint register
+ *        where possible. Isochronous endpoints require both buffers, bulk endpoints
+ *        receive a second buffer in the remaining packet memory, to be used
+ *        when they are opened with @ref USBD_EP_OPT_DOUBLE_BUFFER.
+ * @param dev: USB Device handle reference
+ * @param desc: the configuration descriptor, or NULL when unconfigured
+ * @param len: the length of the configuration descriptor
+ */
+void USBD_PD_PmaPlan(USBD_HandleType *dev, const uint8_t *desc, uint16_t len)
+{
+    uint16_t mps[2][USBD_MAX_EP_COUNT] = {{0}};
+    uint8_t type[2][USBD_MAX_EP_COUNT] = {{0}};
+    uint8_t dedicated[2][USBD_MAX_EP_COUNT] = {{0}};
+    uint16_t regMask = 1, next = USBD_PD_BTABLE_SIZE;
+    uint16_t i;
+    uint8_t dir, num, reg;
+
+    /* Collect the largest packet size of each endpoint among the alternate settings */
+    for (i = 0; ((i + 1) < len) && (desc[i] > 0); i += desc[i])
+    {
+        const USB_EndpointDescType *epDesc = (const USB_EndpointDescType*)&desc[i];
+
+        if (epDesc->bDescriptorType == USB_DESC_TYPE_ENDPOINT)
+        {
+            dir = epDesc->bEndpointAddress >> 7;
+            num = epDesc->bEndpointAddress & 0xF;
+
+            if ((num < USBD_MAX_EP_COUNT) &&
+                ((epDesc->wMaxPacketSize & 0x7FF) > mps[dir][num]))
+            {
+                mps[dir][num]  = epDesc->wMaxPacketSize & 0x7FF;
+                type[dir][num] = epDesc->bmAttributes & 3;
+            }
+        }
+    }
+
+    /* Control endpoint buffers are placed after the descriptor table */
+    for (dir = 0; dir < 2; dir++)
+    {
+        USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, dir << 7);
+
+        ep->RegId         = 0;
+        ep->PmaAddress[0] = USBD_PD_PmaAlloc(&next,
+                USBD_PD_PmaBufferSize(dir << 7, USBD_EP0_MAX_PACKET_SIZE));
+        ep->PmaAddress[1] = 0;
+    }
+
+    /* Endpoints use the register of their number by default */
+    for (num = 1; num < USBD_MAX_EP_COUNT; num++)
+    {
+        dev->EP.OUT[num].RegId = dev->EP.IN[num].RegId = num;
+
+        if ((mps[0][num] > 0) || (mps[1][num] > 0))
+        {   regMask |= 1 << num; }
+    }
+
+    /* A register can be dedicated to one endpoint, possibly by moving
+     * the OUT endpoint of the same number to an unused register */
+    for (num = 1; num < USBD_MAX_EP_COUNT; num++)
+    {
+        uint8_t want = 0;
+
+        for (dir = 0; dir < 2; dir++)
+        {
+            if ((type[dir][num] == USB_EP_TYPE_ISOCHRONOUS) ||
+                (type[dir][num] == USB_EP_TYPE_BULK))
+            {   want = 1; }
+        }
+
+        if (want == 0)
+        {   continue; }
+
+        if ((mps[0][num] == 0) || (mps[1][num] == 0))
+        {
+            dedicated[0][num] = dedicated[1][num] = 1;
+        }
+        else
+        {
+            reg = 1;
+            while ((reg < USBD_MAX_EP_COUNT) && ((regMask & (1 << reg)) != 0))
+            {   reg++; }
+
+            if (reg < USBD_MAX_EP_COUNT)
+            {
+                dev->EP.OUT[num].RegId = reg;
+                regMask |= 1 << reg;
+                dedicated[0][num] = dedicated[1][num] = 1;
+            }
+        }
+    }
+
+    /* Allocate the mandatory buffers first */
+    for (num = 1; num < USBD_MAX_EP_COUNT; num++)
+    {
+        for (dir = 0; dir < 2; dir++)
+        {
+            USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, (dir << 7) | num);
+            uint16_t size = USBD_PD_PmaBufferSize(dir << 7, mps[dir][num]);
+
+            ep->PmaAddress[0] = ep->PmaAddress[1] = 0;
+
+            if (mps[dir][num] > 0)
+            {
+                ep->PmaAddress[0] = USBD_PD_PmaAlloc(&next, size);
+
+                if ((type[dir][num] == USB_EP_TYPE_ISOCHRONOUS) &&
+                    (dedicated[dir][num] != 0))
+                {
+                    ep->PmaAddress[1] = USBD_PD_PmaAlloc(&next, size);
+                }
+            }
+        }
+    }
+
+    /* Then the second buffers of the bulk endpoints, as long as memory is available */
+    for (num = 1; num < USBD_MAX_EP_COUNT; num++)
+    {
+        for (dir = 0; dir < 2; dir++)
+        {
+            USBD_EpHandleType *ep = USBD_EpAddr2Ref(dev, (dir << 7) | num);
+
+            if ((type[dir][num] == USB_EP_TYPE_BULK) &&
+                (dedicated[dir][num] != 0) && (ep->PmaAddress[0] != 0))
+            {
+                ep->PmaAddress[1] = USBD_PD_PmaAlloc(&next,
+                        USBD_PD_PmaBufferSize(dir << 7, mps[dir][num]));
+            }
+        }
+    }
+}
+
+/** @} */
+
+#endif /* defined(USB) */
@@ -64,8 +64,18 @@ extern "C"
 
 /* Peripheral Driver extension fields */
 #if defined(USB)
+
+/* Packet memory size in bytes */
+#ifndef USBD_PD_PMA_SIZE
+#define USBD_PD_PMA_SIZE                512
+#endif
+
+/* The endpoint register and packet memory layout is planned by
+ * USBD_PD_PmaPlan() for each configuration. The endpoint is double buffered
+ * if it is opened with USBD_EP_OPT_DOUBLE_BUFFER and PmaAddress[1] is set. */
 #define USBD_PD_EP_FIELDS                                           \
-    uint8_t             RegId;          /*!< Endpoint register ID */
+    uint8_t             RegId;          /*!< Endpoint register ID */\
+    uint16_t            PmaAddress[2];  /*!< Packet memory buffer offsets (0 if not allocated) */
 
 #if defined(USB_BCDR_DPPU)
 #define USBD_PD_DEV_FIELDS                                          \
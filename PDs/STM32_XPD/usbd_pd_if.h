@@ -33,6 +33,7 @@ extern "C"
 
 #if   defined(USB)
 #include <xpd_usb.h>
+#include <usbd_types.h>
 
 /** @addtogroup USBD_Exported_Macros
  * @{ */
@@ -45,6 +46,7 @@ extern "C"
 #define USBD_PD_ClearRemoteWakeup       USB_vClearRemoteWakeup
 #define USBD_PD_SetAddress              USB_vSetAddress
 #define USBD_PD_EpOpen                  USB_vEpOpen
+#define USBD_PD_EpPlan                  USBD_PD_PmaPlan
 #define USBD_PD_EpClose                 USB_vEpClose
 #define USBD_PD_EpSend                  USB_vEpSend
 #define USBD_PD_EpReceive               USB_vEpReceive
@@ -54,6 +56,10 @@ extern "C"
 
 /** @} */
 
+void            USBD_PD_PmaPlan         (USBD_HandleType *dev,
+                                         const uint8_t *desc,
+                                         uint16_t len);
+
 #elif defined(USB_OTG_FS)
 #include <xpd_usb_otg.h>
 
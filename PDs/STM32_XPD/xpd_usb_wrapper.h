@@ -46,6 +46,17 @@ typedef USBD_ConfigurationType  USB_InitType;
 void            USBD_ResetCallback      (USBD_HandleType *dev,
                                          USB_SpeedType speed);
 
+#if (USBD_SOF_SUPPORT == 1)
+/* usbd <- PD */
+void            USBD_SofCallback        (USBD_HandleType *dev);
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+/* usbd <- PD */
+void            USBD_TraceLinkState     (USBD_HandleType *dev,
+                                         USB_LinkStateType state);
+#endif
+
 /* usbd_ctrl <- PD */
 void            USBD_SetupCallback      (USBD_HandleType *dev);
 
@@ -59,6 +70,33 @@ void            USBD_EpOutCallback      (USBD_HandleType *dev,
 #define USB_vSetupCallback      USBD_SetupCallback
 #define USB_vDataInCallback     USBD_EpInCallback
 #define USB_vDataOutCallback    USBD_EpOutCallback
+#if (USBD_SOF_SUPPORT == 1)
+#define USB_vSOFCallback        USBD_SofCallback
+#endif
+
+#if (USBD_TRACE_SUPPORT == 1)
+/**
+ * @brief Records the suspension of the link in the device's trace.
+ *        Shall be set as the Suspend callback of the USB handle,
+ *        or called by the application's own Suspend callback.
+ * @param handle: USB Device handle reference
+ */
+static inline void USBD_PD_SuspendCallback(void *handle)
+{
+    USBD_TraceLinkState((USBD_HandleType*)handle, USB_LINK_STATE_SUSPEND);
+}
+
+/**
+ * @brief Records the resumption of the link in the device's trace.
+ *        Shall be set as the Resume callback of the USB handle,
+ *        or called by the application's own Resume callback.
+ * @param handle: USB Device handle reference
+ */
+static inline void USBD_PD_ResumeCallback(void *handle)
+{
+    USBD_TraceLinkState((USBD_HandleType*)handle, USB_LINK_STATE_ACTIVE);
+}
+#endif /* (USBD_TRACE_SUPPORT == 1) */
 
 /** @} */
 
@@ -16,7 +16,21 @@
   * After configuring it's endpoint numbers it can be mounted on a USB device.
   * Define PRINT_BUFFER_SIZE with an appropriate buffer size to enable output,
   * SCAN_BUFFER_SIZE to enable input functionality. (Twice the max packet size
-  * is recommended.)
+  * is recommended, the sizes shall be powers of 2. The input is only received
+  * while a whole packet of the connection speed fits in SCAN_BUFFER_SIZE.)
+  * The output behavior is configured by the following macros:
+  *  - PRINT_OVERFLOW_POLICY selects what happens when the output doesn't fit
+  *    in the buffer:
+  *      - PRINT_OVERFLOW_DROP (default) discards the output which doesn't fit
+  *      - PRINT_OVERFLOW_BLOCK waits until the buffer space is released
+  *        (not to be used from the USB device's processing context)
+  *      - PRINT_OVERFLOW_OVERWRITE discards the oldest output, unless it's
+  *        being transmitted
+  *  - PRINT_COALESCE_SIZE sets the amount of output to collect before starting
+  *    a transmission (default is 1 byte, i.e. transmit without delay)
+  *  - PRINT_COALESCE_FRAMES sets the timeout (in calls to console_if_tick(),
+  *    preferably made from the SOF callback) after which the collected output
+  *    is transmitted regardless of its size
   * The interface becomes operational after the serial port's line coding is set
   * (with any standard baudrate value).
   *
@@ -36,7 +50,7 @@
   * limitations under the License.
   */
 #include <usbd_cdc.h>
-#include <queues.h>
+#include <usbd_ring.h>
 
 #include <errno.h>
 #include <stdio.h>
@@ -48,26 +62,61 @@ extern int32_t errno;
 /** @defgroup console_if USB serial console interface template
  * @{ */
 
+#define PRINT_OVERFLOW_DROP         0
+#define PRINT_OVERFLOW_BLOCK        1
+#define PRINT_OVERFLOW_OVERWRITE    2
+
+#ifndef PRINT_OVERFLOW_POLICY
+#define PRINT_OVERFLOW_POLICY       PRINT_OVERFLOW_DROP
+#endif
+
+/* Shall not exceed PRINT_BUFFER_SIZE */
+#ifndef PRINT_COALESCE_SIZE
+#define PRINT_COALESCE_SIZE         1
+#endif
+
+#ifndef PRINT_COALESCE_FRAMES
+#define PRINT_COALESCE_FRAMES       0
+#endif
+
+/* The largest OUT packet, the reception uses the packet size of the actual speed */
+#if (USBD_HS_SUPPORT == 1)
+#define SCAN_PACKET_SIZE            USB_EP_BULK_HS_MPS
+#else
+#define SCAN_PACKET_SIZE            USB_EP_BULK_FS_MPS
+#endif
+
+#if (SCAN_BUFFER_SIZE > 0) && (SCAN_BUFFER_SIZE < USB_EP_BULK_FS_MPS)
+#error "SCAN_BUFFER_SIZE has to fit at least one full speed packet!"
+#endif
+
 static void console_if_init         (void);
+static void console_if_deinit       (void);
 static void console_if_ctrl         (USB_SetupRequestType * req, uint8_t* pbuf);
 
 #if (PRINT_BUFFER_SIZE > 0)
 static void console_if_in_cmplt     (uint8_t * pbuf, uint16_t length);
 static void console_if_send         (void);
-QUEUE_DEF(console_if_IN, uint8_t, PRINT_BUFFER_SIZE);
+USBD_RING_DEF(console_if_IN, PRINT_BUFFER_SIZE);
+static volatile uint8_t  console_if_IN_busy;    /* Transmission is ongoing */
+static volatile uint8_t  console_if_IN_writing; /* Output is being stored */
+static volatile uint8_t  console_if_IN_held;    /* A completion was held back by the writer */
+static volatile uint16_t console_if_IN_age;     /* Frames since the last transmission */
 #endif
 
 #if (SCAN_BUFFER_SIZE > 0)
 static void console_if_out_cmplt    (uint8_t * pbuf, uint16_t length);
 static void console_if_recv         (void);
-QUEUE_DEF(console_if_OUT, uint8_t, SCAN_BUFFER_SIZE);
+USBD_RING_DEF(console_if_OUT, SCAN_BUFFER_SIZE);
+static uint8_t console_if_packet[SCAN_PACKET_SIZE];
+static volatile uint8_t  console_if_OUT_busy;   /* Reception is ongoing */
 #endif
 
 static const USBD_CDC_AppType console_app =
 {
     .Name           = "Serial port as debug console",
     .Init           = console_if_init,
-    .Deinit         = console_if_init,
+    .Deinit         = console_if_deinit,
     .Control        = console_if_ctrl,
 #if (SCAN_BUFFER_SIZE > 0)
     .Received       = console_if_out_cmplt,
@@ -88,14 +137,36 @@ USBD_CDC_LineCodingType line_coding = {
         .DataBits = 8,
 };
 
+static int console_if_connected(void)
+{
+    return ((volatile USBD_CDC_LineCodingType*)&line_coding)->DTERate != (~0);
+}
+
 static void console_if_init(void)
 {
     line_coding.DTERate = ~0;
 #if (PRINT_BUFFER_SIZE > 0)
-    console_if_IN.head = console_if_IN.tail = 0;
+    USBD_RingInit(&console_if_IN, console_if_IN.Buffer, PRINT_BUFFER_SIZE);
+    console_if_IN_busy = 0;
+    console_if_IN_age = 0;
 #endif
 #if (SCAN_BUFFER_SIZE > 0)
-    console_if_OUT.head = console_if_OUT.tail = 0;
+    USBD_RingInit(&console_if_OUT, console_if_OUT.Buffer, SCAN_BUFFER_SIZE);
+    console_if_OUT_busy = 0;
+
+    /* Reception is continuous from the start */
+    console_if_recv();
+#endif
+}
+
+static void console_if_deinit(void)
+{
+    line_coding.DTERate = ~0;
+#if (PRINT_BUFFER_SIZE > 0)
+    console_if_IN_busy = 0;
+#endif
+#if (SCAN_BUFFER_SIZE > 0)
+    console_if_OUT_busy = 0;
 #endif
 }
 
@@ -110,55 +181,131 @@ static void console_if_ctrl(USB_SetupRequestType * req, uint8_t* pbuf)
 #if (PRINT_BUFFER_SIZE > 0)
 static void console_if_in_cmplt(uint8_t * pbuf, uint16_t length)
 {
-    console_if_send();
+    uint16_t mps = console_if->Base.Device->EP.IN[console_if->Config.InEpNum & 0xF].MaxPacketSize;
+
+    /* The transmitted data is released only now */
+    USBD_RingRelease(&console_if_IN, length);
+    console_if_IN_busy = 0;
+
+    /* The writer starts the transmission after storing its output */
+    if (console_if_IN_writing == 0)
+    {
+        console_if_send();
+
+        /* Terminate the transfer of full packets if no more data follows */
+        if ((console_if_IN_busy == 0) && (length > 0) && ((length % mps) == 0))
+        {
+            console_if_IN_busy = 1;
+            USBD_CDC_Transmit(console_if, pbuf, 0);
+        }
+    }
+    else
+    {
+        console_if_IN_held = 1;
+    }
 }
 
 static void console_if_send(void)
 {
-    if (!QUEUE_EMPTY(console_if_IN))
+    uint8_t *data;
+    uint16_t length = USBD_RingPeek(&console_if_IN, &data);
+
+    /* Transmit the contiguous data until the head or the end of the buffer,
+     * once enough is collected or it has waited enough */
+    if ((console_if_IN_busy == 0) && (length > 0) &&
+        ((USBD_RingCount(&console_if_IN) >= PRINT_COALESCE_SIZE) ||
+         (console_if_IN_age >= PRINT_COALESCE_FRAMES)))
     {
-        uint32_t newtail;
-        uint32_t length;
+        console_if_IN_busy = 1;
+        console_if_IN_age = 0;
 
-        /* If the head is ahead, transmit the new data */
-        if (console_if_IN.tail < console_if_IN.head)
-        {
-            length  = console_if_IN.head - console_if_IN.tail;
-            newtail = console_if_IN.head;
-        }
-        /* If the USB IN index is ahead, the buffer has wrapped,
-         * transmit until the end */
-        else
-        {
-            length  = console_if_IN.size - console_if_IN.tail;
-            newtail = 0;
-        }
+        USBD_CDC_Transmit(console_if, data, length);
+    }
+}
 
-        if (USBD_E_OK == USBD_CDC_Transmit(console_if,
-                &console_if_IN.buffer[console_if_IN.tail + 1], length))
-        {
-            console_if_IN.tail = newtail;
-        }
+/**
+ * @brief Advances the output coalescing timeout, shall be called periodically
+ *        (e.g. on each USB SOF) from the USB device's processing context.
+ */
+void console_if_tick(void)
+{
+    if ((console_if_IN_busy == 0) && (console_if_IN_writing == 0) &&
+        (USBD_RingCount(&console_if_IN) > 0))
+    {
+        if (console_if_IN_age < PRINT_COALESCE_FRAMES)
+        {   console_if_IN_age++; }
+
+        console_if_send();
     }
 }
 
 int _write(int32_t file, uint8_t *ptr, int32_t len)
 {
     int retval = -1;
-    if (line_coding.DTERate == (~0))
+    if (!console_if_connected())
     {
         errno = EIO;
     }
-    else if (QUEUE_SPACE(console_if_IN) < len)
-    {
-        errno = ENOMEM;
-    }
     else
     {
-        QUEUE_PUT_ARRAY(console_if_IN, ptr, len);
+        int32_t written = 0;
 
-        console_if_send();
-        retval = len;
+        do
+        {
+            uint32_t length = len - written;
+
+            /* Hold back the transmission start from the USB context */
+            console_if_IN_writing = 1;
+            console_if_IN_held = 0;
+
+#if (PRINT_OVERFLOW_POLICY == PRINT_OVERFLOW_OVERWRITE)
+            /* The buffer can only be rearranged while no transmission is ongoing */
+            if ((length > USBD_RingSpace(&console_if_IN)) && (console_if_IN_busy == 0))
+            {
+                /* Only the newest output that fits is kept */
+                if (length > PRINT_BUFFER_SIZE)
+                {
+                    written += length - PRINT_BUFFER_SIZE;
+                    length   = PRINT_BUFFER_SIZE;
+                }
+                USBD_RingRelease(&console_if_IN, length - USBD_RingSpace(&console_if_IN));
+            }
+#endif
+            if (length > PRINT_BUFFER_SIZE)
+            {   length = PRINT_BUFFER_SIZE; }
+
+            written += USBD_RingPut(&console_if_IN, &ptr[written], length);
+
+            /* The transmission is only started by one context at a time */
+            console_if_send();
+            console_if_IN_writing = 0;
+
+            /* Restart the transmission if it completed while it was held back */
+            while (console_if_IN_held != 0)
+            {
+                console_if_IN_writing = 1;
+                console_if_IN_held = 0;
+                console_if_send();
+                console_if_IN_writing = 0;
+            }
+        }
+#if (PRINT_OVERFLOW_POLICY == PRINT_OVERFLOW_BLOCK)
+        while ((written < len) && console_if_connected());
+#else
+        while (0);
+
+        /* The output which didn't fit is discarded */
+        written = len;
+#endif
+
+        if (written < len)
+        {
+            errno = EIO;
+        }
+        else
+        {
+            retval = written;
+        }
     }
     return retval;
 }
@@ -167,47 +314,44 @@ int _write(int32_t file, uint8_t *ptr, int32_t len)
 #if (SCAN_BUFFER_SIZE > 0)
 static void console_if_out_cmplt(uint8_t * pbuf, uint16_t length)
 {
-    console_if_OUT.head += length;
+    USBD_RingPut(&console_if_OUT, pbuf, length);
+    console_if_OUT_busy = 0;
+
     console_if_recv();
 }
 
 static void console_if_recv(void)
 {
-    if (!QUEUE_FULL(console_if_OUT))
-    {
-        uint32_t length;
+    uint16_t mps = console_if->Base.Device->EP.OUT[console_if->Config.OutEpNum & 0xF].MaxPacketSize;
 
-        if (console_if_OUT.tail > console_if_OUT.head)
-        {
-            length = console_if_OUT.tail - console_if_OUT.head - 1;
-        }
-        else
-        {
-            length = console_if_OUT.size - console_if_OUT.head;
-        }
+    /* The reception continues as long as a whole packet fits in the buffer */
+    if ((console_if_OUT_busy == 0) &&
+        (USBD_RingSpace(&console_if_OUT) >= mps))
+    {
+        console_if_OUT_busy = 1;
 
-        USBD_CDC_Transmit(console_if,
-                &console_if_OUT.buffer[console_if_OUT.head + 1], length);
+        USBD_CDC_Receive(console_if, console_if_packet, mps);
     }
 }
 
 int _read(int32_t file, uint8_t *ptr, int32_t len)
 {
     int retval = -1;
-    if (line_coding.DTERate == (~0))
+
+    /* Wait until any input is available */
+    while ((USBD_RingCount(&console_if_OUT) == 0) && console_if_connected())
     {
-        errno = EIO;
     }
-    else if (QUEUE_SPACE(console_if_OUT) < len)
+
+    if (USBD_RingCount(&console_if_OUT) == 0)
     {
-        errno = ENOMEM;
+        errno = EIO;
     }
     else
     {
-        QUEUE_GET_ARRAY(console_if_OUT, ptr, len);
+        retval = USBD_RingGet(&console_if_OUT, ptr, (len > 0xFFFF) ? 0xFFFF : len);
 
         console_if_recv();
-        retval = len;
     }
     return retval;
 }
@@ -0,0 +1,123 @@
+/**
+  ******************************************************************************
+  * @file    trace_if.c
+  * @author  Benedek Kupper
+  * @version 0.1
+  * @date    2026-10-14
+  * @brief   USB event trace interface template
+  *
+  * @details
+  * This vendor-specific interface drains the event trace of the USB device
+  * (enabled by USBD_TRACE_SUPPORT) to the host through a bulk IN pipe:
+  *     @code
+  *     #include <usbd_vnd.h>
+  *     extern USBD_VND_IfHandleType *const trace_if;
+  *     @endcode
+  * After configuring its IN endpoint number (Config.InEpNum[0]) it can be mounted
+  * on a USB device. trace_if_drain() shall be called periodically (e.g. on each SOF)
+  * from the USB device's processing context, it transmits the recorded entries
+  * in the USBD_TraceEntryType layout, at most TRACE_IF_ENTRIES at a time.
+  * The transfers of the interface itself are excluded from the trace.
+  *
+  *
+  * Copyright (c) 2026 Benedek Kupper
+  *
+  * Licensed under the Apache License, Version 2.0 (the "License");
+  * you may not use this file except in compliance with the License.
+  * You may obtain a copy of the License at
+  *
+  *     http://www.apache.org/licenses/LICENSE-2.0
+  *
+  * Unless required by applicable law or agreed to in writing, software
+  * distributed under the License is distributed on an "AS IS" BASIS,
+  * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+  * See the License for the specific language governing permissions and
+  * limitations under the License.
+  */
+#include <usbd_types.h>
+
+#if (USBD_TRACE_SUPPORT == 1)
+#include <usbd.h>
+#include <usbd_vnd.h>
+
+/** @defgroup trace_if USB event trace interface template
+ * @{ */
+
+#ifndef TRACE_IF_ENTRIES
+#define TRACE_IF_ENTRIES            16
+#endif
+
+static void trace_if_init           (void);
+static void trace_if_deinit         (void);
+static void trace_if_in_cmplt       (uint8_t pipe, uint8_t * pbuf, uint16_t length);
+
+static USBD_TraceEntryType trace_if_entries[TRACE_IF_ENTRIES];
+static volatile uint8_t trace_if_busy;      /* Transmission is ongoing */
+static volatile uint8_t trace_if_active;    /* The interface is configured */
+
+static const USBD_VND_AppType trace_app =
+{
+    .Name           = "USB event trace",
+    .Init           = trace_if_init,
+    .Deinit         = trace_if_deinit,
+    .Transmitted    = trace_if_in_cmplt,
+};
+
+USBD_VND_IfHandleType _trace_if = {
+    .App = &trace_app,
+    .Base.AltCount = 1,
+    .Config.InCount = 1,
+}, *const trace_if = &_trace_if;
+
+static void trace_if_init(void)
+{
+    /* The draining shall not appear in the traced traffic */
+    USBD_TraceIgnore(trace_if->Base.Device, trace_if->Config.InEpNum[0]);
+
+    trace_if_busy = 0;
+    trace_if_active = 1;
+}
+
+static void trace_if_deinit(void)
+{
+    trace_if_active = 0;
+}
+
+static void trace_if_in_cmplt(uint8_t pipe, uint8_t * pbuf, uint16_t length)
+{
+    uint16_t mps = trace_if->Base.Device->EP.IN[trace_if->Config.InEpNum[0] & 0xF].MaxPacketSize;
+
+    /* Terminate the transfer of full packets, so the host's read completes */
+    if ((length > 0) && ((length % mps) == 0))
+    {
+        USBD_VND_Transmit(trace_if, pipe, pbuf, 0);
+    }
+    else
+    {
+        trace_if_busy = 0;
+    }
+}
+
+/**
+ * @brief Transmits the recorded trace entries, shall be called periodically
+ *        (e.g. on each USB SOF) from the USB device's processing context.
+ */
+void trace_if_drain(void)
+{
+    if ((trace_if_active != 0) && (trace_if_busy == 0))
+    {
+        uint16_t count = USBD_TraceRead(trace_if->Base.Device,
+                trace_if_entries, TRACE_IF_ENTRIES);
+
+        if (count > 0)
+        {
+            trace_if_busy = 1;
+            USBD_VND_Transmit(trace_if, 0, (uint8_t*)trace_if_entries,
+                    count * sizeof(USBD_TraceEntryType));
+        }
+    }
+}
+
+/** @} */
+
+#endif /* (USBD_TRACE_SUPPORT == 1) */
@@ -49,6 +49,69 @@ extern "C"
  * amount of raw bytes to string BCD format and sent to the host. */
 #define USBD_SERIAL_BCD_SIZE        8
 
+/** @brief Set to 1 to allow linking request queues to endpoints,
+ * so transfers submitted to a busy endpoint are queued instead of rejected. */
+#define USBD_EP_QUEUE_SUPPORT       0
+
+/** @brief Set to 1 to enable sending multiple data segments as a single IN transfer.
+ * Only the packets spanning segment boundaries are copied to an intermediate buffer. */
+#define USBD_EP_VECTOR_SUPPORT      0
+
+/** @brief Set to 1 to defer the processing of the PD events (and therefore
+ * all class and application callbacks) to @ref USBD_Process calls,
+ * which shall be made periodically from the main loop or a task.
+ * The interrupt context only stores the events in a queue. */
+#define USBD_DEFERRED_PROCESSING    0
+
+/** @brief Set to 1 to keep the assembled configuration descriptor (per speed)
+ * until the mounted interfaces change, instead of assembling it for every request. */
+#define USBD_CONFIG_DESC_CACHE      0
+
+/** @brief Set to 1 to allow linking constant device, configuration and string descriptors
+ * (built with the macros of usbd_desc.h) to USBD_DescriptionType::Static.
+ * These are sent directly from flash, so USBD_EP0_BUFFER_SIZE doesn't need to fit them.
+ * Regardless of this setting, any name string can refer to a USBD_STRING_DESC()
+ * (via USBD_STRING_DESC_REF()) to be sent without conversion. */
+#define USBD_STATIC_DESCRIPTORS     0
+
+/** @brief Set to 1 to enable chunked control data stages (USBD_CtrlSendChunked() and
+ * USBD_CtrlReceiveChunked()), which are filled or consumed one CtrlData buffer at a time,
+ * so wLength can exceed USBD_EP0_BUFFER_SIZE (which must fit at least one EP0 packet).
+ * The HID class uses them for the control pipe reports when the application
+ * provides SetReportChunk() or GetReportChunk(). */
+#define USBD_CTRL_CHUNK_SUPPORT     0
+
+/** @brief Set to 1 to pass the start of (micro)frame events of the PD (USBD_SofCallback())
+ * to the interface classes, e.g. to schedule periodic HID reports. */
+#define USBD_SOF_SUPPORT            0
+
+/** @brief Set to 1 to provide a Microsoft OS 2.0 descriptor set through the BOS descriptor,
+ * which is assembled from the feature descriptors of the interface classes
+ * (e.g. the WinUSB compatible ID of the vendor class), so Windows binds their drivers
+ * without INF files. USBD_MS_VENDOR_CODE selects the vendor request of the set. */
+#define USBD_MS_OS_DESC_SUPPORT     0
+
+/** @brief When set to non-zero, the transfer buffers of the classes (e.g. MSC blocks)
+ * are allocated from a pool of this many USBD_ARENA_BLOCK_SIZE sized blocks,
+ * which is aligned for the peripheral's DMA and the data cache.
+ * USBD_ARENA_SECTION can place the pool in DMA reachable RAM. On cached cores
+ * USBD_DCACHE_LINE_SIZE, USBD_DCACHE_CLEAN(ADDR, LEN) and USBD_DCACHE_INVALIDATE(ADDR, LEN)
+ * shall be defined as well, e.g. to SCB_CleanDCache_by_Addr and SCB_InvalidateDCache_by_Addr. */
+#define USBD_ARENA_BLOCK_COUNT      0
+
+/** @brief Set to 1 to collect transfer statistics of each endpoint and duration profiles
+ * of the setup and transfer completion handling and the class callbacks (USBD_StatsGet()).
+ * The durations are measured by USBD_STATS_CYCLES(), e.g. defined to DWT->CYCCNT.
+ * When USBD_STATS_VENDOR_CODE is non-zero, the host can read them by that vendor request. */
+#define USBD_STATS_SUPPORT          0
+
+/** @brief Set to 1 to record the setup requests, transfer submissions and completions,
+ * stalls, resets and link state changes (USBD_TraceLinkState()) in a ring of
+ * USBD_TRACE_SIZE entries, stamped by USBD_TRACE_TIMESTAMP() and the SOF count.
+ * The entries are drained by USBD_TraceRead(), e.g. through a separate interface
+ * whose endpoints are excluded by USBD_TraceIgnore() (see trace_if.c). */
+#define USBD_TRACE_SUPPORT          0
+
 /* Any class-specific configuration may follow, e.g.
  *      USBD_HID_OUT_SUPPORT        1 */
 